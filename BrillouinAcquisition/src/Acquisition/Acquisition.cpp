@@ -55,6 +55,12 @@ void Acquisition::openFile(const StoragePath& path, int flag, bool forceOpen) {
 		this,
 		&Acquisition::finishedWritingToFile
 	);
+	connection = QWidget::connect(
+		m_storage.get(),
+		&StorageWrapper::s_statisticsChanged,
+		this,
+		&Acquisition::s_storageStatisticsChanged
+	);
 }
 
 void Acquisition::openFile(std::string filename, bool forceOpen) {
@@ -72,6 +78,7 @@ void Acquisition::newRepetition(ACQUISITION_MODE mode) {
 	if (m_storage == nullptr) {
 		openFile();
 	}
+	m_storage->setStorageSettings(getStorageSettings());
 	m_storage->newRepetition(mode);
 }
 
@@ -107,6 +114,16 @@ std::string Acquisition::getCurrentFilename() {
 	return m_path.filename;
 }
 
+void Acquisition::setStorageSettings(const STORAGE_SETTINGS& settings) {
+	std::lock_guard<std::mutex> lockGuard(m_storageSettingsMutex);
+	m_storageSettings = settings;
+}
+
+STORAGE_SETTINGS Acquisition::getStorageSettings() {
+	std::lock_guard<std::mutex> lockGuard(m_storageSettingsMutex);
+	return m_storageSettings;
+}
+
 bool Acquisition::isModeEnabled(ACQUISITION_MODE mode) {
 	return (bool)(m_enabledModes & mode);
 }
@@ -37,6 +37,13 @@ public slots:
 	std::string getCurrentFolder();
 
 	std::string getCurrentFilename();
+
+	/*
+	 * The storage settings are applied to the file when the next repetition starts,
+	 * so that the layout does not change within a repetition.
+	 */
+	void setStorageSettings(const STORAGE_SETTINGS& settings);
+	STORAGE_SETTINGS getStorageSettings();
 	
 	bool isModeEnabled(ACQUISITION_MODE mode);
 
@@ -48,6 +55,8 @@ private:
 	ACQUISITION_MODE m_enabledModes{ ACQUISITION_MODE::NONE };	// which mode is currently acquiring
 	Thread* m_storageThread;
 	bool m_writingToFile{ false };
+	STORAGE_SETTINGS m_storageSettings;
+	std::mutex m_storageSettingsMutex;
 
 private slots:
 	void checkFilename();
@@ -57,6 +66,7 @@ signals:
 	void s_enabledModes(ACQUISITION_MODE);	// which acquisition mode is running
 	void s_filenameChanged(std::string);
 	void s_openFileFailed();
+	void s_storageStatisticsChanged(STORAGE_STATISTICS);	// statistics of the writer of the open file
 };
 
 #endif //ACQUISITION_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Brillouin.h"
 #include "../../simplemath.h"
 #include "../../logger.h"
+#include "../../pipelineStage.h"
 #include "filesystem"
 
 using namespace std::filesystem;
@@ -20,6 +21,8 @@ Brillouin::Brillouin(QObject* parent, Acquisition* acquisition, Camera** andor,
 	);
 	// Emit the initial positions
 	updatePositions();
+
+	m_analysis.setCallback([this](const BRILLOUIN_SHIFT& shift) { emit(s_shiftMeasured(shift)); });
 }
 
 Brillouin::~Brillouin() {
@@ -142,32 +145,32 @@ void Brillouin::setStepNumberZ(int steps) {
 
 void Brillouin::setXMin(double xMin) {
 	m_settings.xMin = xMin;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setXMax(double xMax) {
 	m_settings.xMax = xMax;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setYMin(double yMin) {
 	m_settings.yMin = yMin;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setYMax(double yMax) {
 	m_settings.yMax = yMax;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setZMin(double zMin) {
 	m_settings.zMin = zMin;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setZMax(double zMax) {
 	m_settings.zMax = zMax;
-	updatePositions();
+	determineScanOrder();
 }
 
 void Brillouin::setSettings(const BRILLOUIN_SETTINGS& settings) {
@@ -231,6 +234,26 @@ void Brillouin::setScanOrderAuto(bool automatical) {
 	determineScanOrder();
 }
 
+void Brillouin::setScanPattern(SCAN_PATTERN pattern) {
+	m_settings.path.pattern = pattern;
+	determineScanOrder();
+}
+
+void Brillouin::setUnidirectionalApproach(bool unidirectional) {
+	m_settings.path.unidirectionalApproach = unidirectional;
+	determineScanOrder();
+}
+
+void Brillouin::setScanMask(const SCAN_MASK& mask) {
+	m_scanMask = mask;
+	updatePositions();
+}
+
+void Brillouin::setSparseScan(bool sparse) {
+	m_settings.sparseScan = sparse;
+	updatePositions();
+}
+
 void Brillouin::determineScanOrder() {
 	if (m_scanOrder.automatical) {
 		// determine scan order based on step numbers
@@ -246,6 +269,15 @@ void Brillouin::determineScanOrder() {
 		m_scanOrder.y = order[1];
 		m_scanOrder.z = order[2];
 
+		// the order by step numbers is kept, unless the stage travels less with another order
+		m_scanOrder = ScanPathPlanner::fastestOrder(
+			simplemath::linspace(m_settings.xMin, m_settings.xMax, m_settings.xSteps),
+			simplemath::linspace(m_settings.yMin, m_settings.yMax, m_settings.ySteps),
+			simplemath::linspace(m_settings.zMin, m_settings.zMax, m_settings.zSteps),
+			m_scanOrder,
+			m_settings.path,
+			getMotionModel()
+		);
 	}
 	emit(s_scanOrderChanged(m_scanOrder));
 }
@@ -277,6 +309,9 @@ void Brillouin::abortMode(std::unique_ptr <StorageWrapper>& storage) {
 
 	m_acquisition->disableMode(ACQUISITION_MODE::BRILLOUIN);
 
+	// the positions acquired before the abort are still evaluated
+	m_analysis.finish();
+
 	// Here we wait until the storage object indicate it finished to write to the file.
 	QEventLoop loop;
 	auto connection = QWidget::connect(
@@ -292,11 +327,14 @@ void Brillouin::abortMode(std::unique_ptr <StorageWrapper>& storage) {
 	);
 	loop.exec();
 
+	storeShiftMap(storage);
+
 	setAcquisitionStatus(ACQUISITION_STATUS::ABORTED);
 	emit(s_positionChanged({ 0 , 0, 0 }, 0));
 	emit(s_timeToCalibration(0));
 }
 
+template <typename T>
 void Brillouin::calibrate(std::unique_ptr <StorageWrapper>& storage) {
 	// announce calibration start
 	emit(s_calibrationRunning(true));
@@ -322,88 +360,51 @@ void Brillouin::calibrate(std::unique_ptr <StorageWrapper>& storage) {
 		(hsize_t)m_settings.camera.roi.width_binned
 	};
 
-	auto images = std::vector<std::byte>((int64_t)m_settings.camera.roi.bytesPerFrame * m_settings.nrCalibrationImages);
+	// the camera writes directly into the buffer which is later handed to the storage
+	auto bytesPerFrame = (int64_t)m_settings.camera.roi.bytesPerFrame;
+	auto images = storage->getFramePool<T>().get(bytesPerFrame * m_settings.nrCalibrationImages / sizeof(T));
+	auto imagesBuffer = reinterpret_cast<std::byte*>(images.data());
 	for (gsl::index mm{ 0 }; mm < m_settings.nrCalibrationImages; mm++) {
 		if (m_abort) {
 			this->abortMode(storage);
 			return;
 		}
 		// acquire images
-		auto pointerPos = (int64_t)m_settings.camera.roi.bytesPerFrame * mm;
+		auto pointerPos = bytesPerFrame * mm;
 
 		if (m_andor) {
-			(*m_andor)->getImageForAcquisition(&images[pointerPos]);
+			(*m_andor)->getImageForAcquisition(&imagesBuffer[pointerPos]);
 		}
 	}
 
+	// the following positions are converted with this calibration
+	if (m_settings.analysis.enabled) {
+		m_analysis.calibrate(
+			m_analysis.extractSpectra(images.data(), m_settings.nrCalibrationImages,
+				m_settings.camera.roi.width_binned, m_settings.camera.roi.height_binned),
+			shift
+		);
+	}
+
 	// the datetime has to be set here, otherwise it would be determined by the time the queue is processed
 	auto date = QDateTime::currentDateTime().toOffsetFromUtc(QDateTime::currentDateTime().offsetFromUtc())
 		.toString(Qt::ISODateWithMs).toStdString();
 
-	if (m_settings.camera.readout.dataType == "unsigned short") {
-		// cast the image to unsigned short
-		auto images_ = (std::vector<unsigned short> *) & images;
-		auto cal = new CALIBRATION<unsigned short>(
-			nrCalibrations,			// index
-			*images_,				// data
-			rank_cal,				// the rank of the calibration data
-			dims_cal,				// the dimension of the calibration data
-			m_settings.sample,		// the samplename
-			shift,					// the Brillouin shift of the sample
-			date,					// the datetime
-			m_settings.calibrationExposureTime, // the exposure time of the calibration
-			m_settings.camera.gain,
-			m_settings.camera.roi
-			);
-
-		QMetaObject::invokeMethod(
-			storage.get(),
-			[&storage = storage, cal]() { storage.get()->s_enqueueCalibration(cal); },
-			Qt::AutoConnection
-		);
-	} else if (m_settings.camera.readout.dataType == "unsigned char") {
-		// cast the image to unsigned char
-		auto images_ = (std::vector<unsigned char> *) & images;
-		auto cal = new CALIBRATION<unsigned char>(
-			nrCalibrations,			// index
-			*images_,				// data
-			rank_cal,				// the rank of the calibration data
-			dims_cal,				// the dimension of the calibration data
-			m_settings.sample,		// the samplename
-			shift,					// the Brillouin shift of the sample
-			date,					// the datetime
-			m_settings.calibrationExposureTime, // the exposure time of the calibration
-			m_settings.camera.gain,
-			m_settings.camera.roi
-			);
-
-		QMetaObject::invokeMethod(
-			storage.get(),
-			[&storage = storage, cal]() { storage.get()->s_enqueueCalibration(cal); },
-			Qt::AutoConnection
-		);
-	} else if (m_settings.camera.readout.dataType == "unsigned int") {
-		// cast the image to unsigned char
-		auto images_ = (std::vector<unsigned int> *) & images;
-		auto cal = new CALIBRATION<unsigned int>(
-			nrCalibrations,			// index
-			*images_,				// data
-			rank_cal,				// the rank of the calibration data
-			dims_cal,				// the dimension of the calibration data
-			m_settings.sample,		// the samplename
-			shift,					// the Brillouin shift of the sample
-			date,					// the datetime
-			m_settings.calibrationExposureTime, // the exposure time of the calibration
-			m_settings.camera.gain,
-			m_settings.camera.roi
-			);
+	auto cal = new CALIBRATION<T>(
+		nrCalibrations,			// index
+		std::move(images),		// data
+		rank_cal,				// the rank of the calibration data
+		dims_cal,				// the dimension of the calibration data
+		m_settings.sample,		// the samplename
+		shift,					// the Brillouin shift of the sample
+		date,					// the datetime
+		m_settings.calibrationExposureTime, // the exposure time of the calibration
+		m_settings.camera.gain,
+		m_settings.camera.roi
+	);
 
-		QMetaObject::invokeMethod(
-			storage.get(),
-			[&storage = storage, cal]() { storage.get()->s_enqueueCalibration(cal); },
-			Qt::AutoConnection
-		);
-	}
+	// blocks if the writer falls behind
+	storage->s_enqueueCalibration(cal);
 
 	nrCalibrations++;
 
@@ -423,56 +424,34 @@ void Brillouin::calibrate(std::unique_ptr <StorageWrapper>& storage) {
  * Construct positions vector with correct order of scan directions
  */
 void Brillouin::updatePositions() {
-	auto nrPositions = m_settings.xSteps * m_settings.ySteps * m_settings.zSteps;
+	auto path = ScanPathPlanner::plan(
+		simplemath::linspace(m_settings.xMin, m_settings.xMax, m_settings.xSteps),
+		simplemath::linspace(m_settings.yMin, m_settings.yMax, m_settings.ySteps),
+		simplemath::linspace(m_settings.zMin, m_settings.zMax, m_settings.zSteps),
+		m_scanOrder,
+		m_settings.path
+	);
+	// sparse scans skip the positions outside of the scan mask
+	if (m_settings.sparseScan && !ScanMask::isEmpty(m_scanMask)) {
+		path = ScanPathPlanner::select(path, ScanMask::select(m_scanMask, path.positions), m_settings.path);
+	}
+	m_scanPathCost = ScanPathPlanner::estimateCost(path, getMotionModel());
+
+	// all vectors are taken from the same path, so the indices and the
+	// positions a calibration is allowed at always match the positions
+	m_orderedPositionsRelative = std::move(path.positions);
+	m_orderedIndices = std::move(path.indices);
+	m_calibrationAllowed = std::move(path.calibrationAllowed);
 
-	// Adjust positions vector
+	auto nrPositions = m_orderedPositionsRelative.size();
 	m_orderedPositions.resize(nrPositions);
-	m_orderedPositionsRelative.resize(nrPositions);
-	m_orderedIndices.resize(nrPositions);
-	// vector indicating if a new line just started and a calibration is allowed
-	m_calibrationAllowed.resize(nrPositions);
-
-	// construct directions vector
-	std::vector<std::vector<double>> directions(3);
-	directions[m_scanOrder.x] = simplemath::linspace(m_settings.xMin, m_settings.xMax, m_settings.xSteps);
-	directions[m_scanOrder.y] = simplemath::linspace(m_settings.yMin, m_settings.yMax, m_settings.ySteps);
-	directions[m_scanOrder.z] = simplemath::linspace(m_settings.zMin, m_settings.zMax, m_settings.zSteps);
-
-	int ll{ 0 };
-	std::vector<double> position(3);
-	std::vector<int> indices(3);
-	for (gsl::index ii{ 0 }; ii < directions[2].size(); ii++) {
-		for (gsl::index jj{ 0 }; jj < directions[1].size(); jj++) {
-			for (gsl::index kk{ 0 }; kk < directions[0].size(); kk++) {
-
-				// construct indices vector
-				indices[0] = kk;
-				indices[1] = jj;
-				indices[2] = ii;
-
-				// construct position vector
-				position[0] = directions[0][kk];
-				position[1] = directions[1][jj];
-				position[2] = directions[2][ii];
-
-				// calculate stage positions
-				m_orderedPositionsRelative[ll] = POINT3{ position[m_scanOrder.x], position[m_scanOrder.y], position[m_scanOrder.z] };
-				m_orderedPositions[ll] = m_orderedPositionsRelative[ll] + m_startPosition;
-
-				// fill index vectors
-				m_orderedIndices[ll] = INDEX3{ indices[m_scanOrder.x], indices[m_scanOrder.y], indices[m_scanOrder.z] };
-
-				// set vector element to true if a new line started
-				if (kk == 0) {
-					m_calibrationAllowed[ll] = true;
-				} else {
-					m_calibrationAllowed[ll] = false;
-				}
-				ll++;
-			}
-		}
+	m_orderedApproachPositions.resize(nrPositions);
+	for (gsl::index ll{ 0 }; ll < (gsl::index)nrPositions; ll++) {
+		m_orderedPositions[ll] = m_orderedPositionsRelative[ll] + m_startPosition;
+		m_orderedApproachPositions[ll] = path.approachPositions[ll] + m_startPosition;
 	}
 	emit(s_orderedPositionsChanged(m_orderedPositionsRelative));
+	emit(s_scanPathCostChanged(m_scanPathCost));
 }
 
 std::string Brillouin::getRepetitionFilename() {
@@ -490,6 +469,34 @@ std::string Brillouin::getRepetitionFilename() {
 	return string.toStdString();
 }
 
+/*
+ * Writes the Brillouin shifts evaluated during the scan to the repetition, in the same order as the positions.
+ * Has to be called after the storage finished writing.
+ */
+void Brillouin::storeShiftMap(std::unique_ptr <StorageWrapper>& storage) {
+	auto map = m_analysis.takeShiftMap();
+	if (map.shift.empty()) {
+		return;
+	}
+
+	auto rank{ 3 };
+	hsize_t dims[3] = { (hsize_t)map.dimZ, (hsize_t)map.dimX, (hsize_t)map.dimY };
+	storage->setPositions("brillouinShift", map.shift, rank, dims);
+	storage->setPositions("brillouinShiftWidth", map.width, rank, dims);
+
+	auto info = QString("Evaluated the Brillouin shift of %1 positions during the scan, %2 positions were skipped.")
+		.arg(map.analyzedPositions)
+		.arg(map.skippedPositions).toStdString();
+	qInfo(logInfo()) << info.c_str();
+}
+
+MOTION_MODEL Brillouin::getMotionModel() {
+	if (m_scanControl && *m_scanControl) {
+		return (*m_scanControl)->getMotionModel();
+	}
+	return MOTION_MODEL{};
+}
+
 
 /*
  * Private slots
@@ -507,6 +514,17 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 		return;
 	}
 
+	if (m_settings.camera.readout.dataType == "unsigned short") {
+		__acquire<unsigned short>(storage);
+	} else if (m_settings.camera.readout.dataType == "unsigned char") {
+		__acquire<unsigned char>(storage);
+	} else if (m_settings.camera.readout.dataType == "unsigned int") {
+		__acquire<unsigned int>(storage);
+	}
+}
+
+template <typename T>
+void Brillouin::__acquire(std::unique_ptr <StorageWrapper>& storage) {
 	if (m_scanControl) {
 		QMetaObject::invokeMethod(
 			(*m_scanControl),
@@ -546,6 +564,27 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 	 * Update the positions vector
 	 */
 	updatePositions();
+	auto pathInfo = QString("Scanning %1 positions, the stage moves %2 times, estimated travel time %3 s.")
+		.arg(m_scanPathCost.positions)
+		.arg(m_scanPathCost.moves)
+		.arg(m_scanPathCost.travelTime, 0, 'f', 1).toStdString();
+	qInfo(logInfo()) << pathInfo.c_str();
+
+	// total number of positions to measure
+	auto nrPositions = (gsl::index)m_orderedPositions.size();
+	if (nrPositions == 0) {
+		qWarning(logWarning()) << "No position lies inside the scan mask.";
+		(*m_scanControl)->enableMeasurementMode(false);
+		m_abort = true;
+		return;
+	}
+	auto nrGridPositions = m_settings.xSteps * m_settings.ySteps * m_settings.zSteps;
+	if (nrPositions < nrGridPositions) {
+		auto maskInfo = QString("The sparse scan skips %1 of %2 positions outside of the scan mask.")
+			.arg(nrGridPositions - nrPositions)
+			.arg(nrGridPositions).toStdString();
+		qInfo(logInfo()) << maskInfo.c_str();
+	}
 
 	/*
 	 * Construct positions vector for H5 file with row-major order: z, x, y
@@ -555,11 +594,9 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 	auto directionsY{ simplemath::linspace(m_settings.yMin, m_settings.yMax, m_settings.ySteps) };
 	auto directionsZ{ simplemath::linspace(m_settings.zMin, m_settings.zMax, m_settings.zSteps) };
 
-	// total number of positions to measure
-	auto nrPositions = m_settings.xSteps * m_settings.ySteps * m_settings.zSteps;
-	auto positionsX = std::vector<double>(nrPositions);
-	auto positionsY = std::vector<double>(nrPositions);
-	auto positionsZ = std::vector<double>(nrPositions);
+	auto positionsX = std::vector<double>(nrGridPositions);
+	auto positionsY = std::vector<double>(nrGridPositions);
+	auto positionsZ = std::vector<double>(nrGridPositions);
 	auto posIndex{ 0 };
 	for (gsl::index ii{ 0 }; ii < m_settings.zSteps; ii++) {
 		for (gsl::index jj{ 0 }; jj < m_settings.xSteps; jj++) {
@@ -581,14 +618,18 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 	storage->setPositions("x", positionsX, rank, dims);
 	storage->setPositions("y", positionsY, rank, dims);
 	storage->setPositions("z", positionsZ, rank, dims);
+
+	// 1 for the acquired positions, 0 for the positions a sparse scan skips
+	auto acquired = std::vector<double>(nrGridPositions, 0);
+	for (const auto& index : m_orderedIndices) {
+		acquired[((gsl::index)index.z * m_settings.xSteps + index.x) * m_settings.ySteps + index.y] = 1;
+	}
+	storage->setPositions("mask", acquired, rank, dims);
 	delete[] dims;
 
 	// do actual measurement
-	QMetaObject::invokeMethod(
-		storage.get(),
-		[&storage = storage]() { storage.get()->startWritingQueues(); },
-		Qt::AutoConnection
-	);
+	// called directly, so that the queues are reset before the first payload is enqueued
+	storage->startWritingQueues();
 
 	auto rank_data{ 3 };
 	hsize_t dims_data[3] = {
@@ -596,12 +637,20 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 		(hsize_t)m_settings.camera.roi.height_binned,
 		(hsize_t)m_settings.camera.roi.width_binned
 	};
+	auto bytesPerImage = (int64_t)m_settings.camera.roi.bytesPerFrame * m_settings.camera.frameCount;
+
+	// start an empty shift map, the pre calibration already converts the first positions
+	if (m_settings.analysis.enabled) {
+		m_analysis.setSettings(m_settings.analysis);
+		m_analysis.reset(m_settings.xSteps, m_settings.ySteps, m_settings.zSteps,
+			m_settings.camera.roi.width_binned, m_settings.camera.roi.height_binned);
+	}
 
 	// reset number of calibrations
 	nrCalibrations = 1;
 	// do pre calibration
 	if (m_settings.preCalibration) {
-		calibrate(storage);
+		calibrate<T>(storage);
 	}
 
 	auto measurementTimer = QElapsedTimer{};
@@ -610,37 +659,57 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 	auto calibrationTimer = QElapsedTimer{};
 	calibrationTimer.start();
 
-	// move stage to first position, wait 50 ms for it to finish
+	// move stage to first position
 	if (m_scanControl) {
-		(*m_scanControl)->setPosition(m_orderedPositions[0]);
+		(*m_scanControl)->setPosition(m_orderedApproachPositions[0]);
 	} else {
 		m_abort = true;
 		return;
 	}
-	Sleep(50);
+
+	// Packaging and queueing the payload runs here, overlapped with the move to
+	// and the exposure at the next position.
+	auto payloadStage = PipelineStage{};
 
 	for (gsl::index ll{ 0 }; ll < nrPositions; ll++) {
 
 		// do live calibration if required and possible at the moment
 		if (m_settings.conCalibration && m_calibrationAllowed[ll]) {
 			if (calibrationTimer.elapsed() > (60e3 * m_settings.conCalibrationInterval)) {
-				calibrate(storage);
+				payloadStage.finish();
+				calibrate<T>(storage);
 				calibrationTimer.start();
 				// After we calibrated, we move back to the current position
 				if (m_scanControl) {
-					(*m_scanControl)->setPosition(m_orderedPositions[ll]);
+					(*m_scanControl)->setPosition(m_orderedApproachPositions[ll]);
 				} else {
 					m_abort = true;
 					return;
 				}
-				Sleep(100);
 			}
 		}
 
+		// wait for the stage to settle at the current position
+		if (m_scanControl) {
+			// positions approached from lower values are reached in a second move
+			if (abs(m_orderedApproachPositions[ll] - m_orderedPositions[ll]) > 0) {
+				(*m_scanControl)->waitForPosition(m_orderedApproachPositions[ll]);
+				(*m_scanControl)->setPosition(m_orderedPositions[ll]);
+			}
+			if (!(*m_scanControl)->waitForPosition(m_orderedPositions[ll])) {
+				qWarning(logWarning()) << "Stage did not reach position" << ll << "in time.";
+			}
+		} else {
+			m_abort = true;
+			return;
+		}
+
 		auto nextCalibration = int{ (int)(100 * (1e-3 * calibrationTimer.elapsed()) / (60 * m_settings.conCalibrationInterval)) };
 		emit(s_timeToCalibration(nextCalibration));
 
-		std::vector<std::byte> images(m_settings.camera.roi.bytesPerFrame * m_settings.camera.frameCount);
+		// the camera writes directly into the buffer which is then moved into the payload
+		auto images = storage->getFramePool<T>().get(bytesPerImage / sizeof(T));
+		auto imagesBuffer = reinterpret_cast<std::byte*>(images.data());
 
 		for (gsl::index mm{ 0 }; mm < m_settings.camera.frameCount; mm++) {
 			if (m_abort) {
@@ -652,103 +721,69 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 			auto pointerPos = (int64_t)m_settings.camera.roi.bytesPerFrame * mm;
 
 			if (m_andor) {
-				(*m_andor)->getImageForAcquisition(&images[pointerPos]);
+				(*m_andor)->getImageForAcquisition(&imagesBuffer[pointerPos]);
 			} else {
 				m_abort = true;
 				return;
 			}
 		}
 
-
-		// asynchronously write image to disk
 		// the datetime has to be set here, otherwise it would be determined by the time the queue is processed
 		auto date = QDateTime::currentDateTime().toOffsetFromUtc(QDateTime::currentDateTime().offsetFromUtc())
 			.toString(Qt::ISODateWithMs).toStdString();
 
-		if (m_settings.camera.readout.dataType == "unsigned short") {
-			// cast the image to unsigned short
-			auto images_ = (std::vector<unsigned short> *) & images;
-			auto img = new IMAGE<unsigned short>(
-				m_orderedIndices[ll].x,
-				m_orderedIndices[ll].y,
-				m_orderedIndices[ll].z,
-				rank_data,
-				dims_data,
-				date,
-				*images_,
-				m_settings.camera.exposureTime,
-				m_settings.camera.gain,
-				m_settings.camera.roi
-			);
+		// move stage to next position right after the exposure, so it travels while the payload is handled
+		if (ll < ((gsl::index)nrPositions - 1)) {
+			if (m_scanControl) {
+				(*m_scanControl)->setPosition(m_orderedApproachPositions[ll + 1]);
+			} else {
+				m_abort = true;
+				return;
+			}
+		}
 
-			QMetaObject::invokeMethod(
-				storage.get(),
-				[&storage = storage, img]() { storage.get()->s_enqueuePayload(img); },
-				Qt::AutoConnection
-			);
-		} else if (m_settings.camera.readout.dataType == "unsigned char") {
-			// cast the image to unsigned char
-			auto images_ = (std::vector<unsigned char> *) & images;
-			auto img = new IMAGE<unsigned char>(
-				m_orderedIndices[ll].x,
-				m_orderedIndices[ll].y,
-				m_orderedIndices[ll].z,
-				rank_data,
-				dims_data,
-				date,
-				*images_,
-				m_settings.camera.exposureTime,
-				m_settings.camera.gain,
-				m_settings.camera.roi
-			);
+		// asynchronously write image to disk
+		payloadStage.push([&, ll, date, images = std::move(images)]() mutable {
+			// the spectra are read before the frames move into the payload, the fits run on the analysis thread
+			if (m_settings.analysis.enabled) {
+				m_analysis.analyze(
+					m_orderedIndices[ll],
+					m_analysis.extractSpectra(images.data(), m_settings.camera.frameCount,
+						m_settings.camera.roi.width_binned, m_settings.camera.roi.height_binned)
+				);
+			}
 
-			QMetaObject::invokeMethod(
-				storage.get(),
-				[&storage = storage, img]() { storage.get()->s_enqueuePayload(img); },
-				Qt::AutoConnection
-			);
-		} else if (m_settings.camera.readout.dataType == "unsigned int") {
-			// cast the image to unsigned char
-			auto images_ = (std::vector<unsigned int> *) & images;
-			auto img = new IMAGE<unsigned int>(
+			auto img = new IMAGE<T>(
 				m_orderedIndices[ll].x,
 				m_orderedIndices[ll].y,
 				m_orderedIndices[ll].z,
 				rank_data,
 				dims_data,
 				date,
-				*images_,
+				std::move(images),
 				m_settings.camera.exposureTime,
 				m_settings.camera.gain,
 				m_settings.camera.roi
 			);
 
-			QMetaObject::invokeMethod(
-				storage.get(),
-				[&storage = storage, img]() { storage.get()->s_enqueuePayload(img); },
-				Qt::AutoConnection
-			);
-		}
-
-		// move stage to next position
-		if (ll < ((gsl::index)nrPositions - 1)) {
-			if (m_scanControl) {
-				(*m_scanControl)->setPosition(m_orderedPositions[ll + 1]);
-			} else {
-				m_abort = true;
-				return;
-			}
-		}
+			// blocks if the writer falls behind
+			storage->s_enqueuePayload(img);
+		});
 
 		auto percentage{ 100 * (double)(ll + 1) / nrPositions };
 		auto remaining{ (int)(1e-3 * measurementTimer.elapsed() / (ll + 1) * ((int64_t)nrPositions - ll + 1)) };
 		emit(s_repetitionProgress(percentage, remaining));
 	}
+	// calibrations have to be queued after all payloads
+	payloadStage.finish();
+
 	// do post calibration
 	if (m_settings.postCalibration) {
-		calibrate(storage);
+		calibrate<T>(storage);
 	}
 
+	m_analysis.finish();
+
 	// close camera libraries, clear buffers
 	if (m_andor) {
 		(*m_andor)->stopAcquisition();
@@ -788,6 +823,8 @@ void Brillouin::acquire(std::unique_ptr <StorageWrapper>& storage) {
 	);
 	loop.exec();
 
+	storeShiftMap(storage);
+
 	auto info = std::string{ "Acquisition finished." };
 	qInfo(logInfo()) << info.c_str();
 	emit(s_calibrationRunning(false));
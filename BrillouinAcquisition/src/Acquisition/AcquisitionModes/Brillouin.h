@@ -4,15 +4,9 @@
 #include "AcquisitionMode.h"
 #include "..\..\Devices\Cameras\Camera.h"
 #include "..\..\thread.h"
-#include "..\..\circularBuffer.h"
-
-
-struct SCAN_ORDER {
-	bool automatical{ true };
-	int x{ 0 };	// first scan in x-direction
-	int y{ 1 };	// then in y-direction
-	int z{ 2 };	// scan in z-direction last
-};
+#include "..\..\brillouinAnalysis.h"
+#include "ScanPathPlanner.h"
+#include "ScanMask.h"
 
 struct BRILLOUIN_SETTINGS {
 	// calibration parameters
@@ -38,7 +32,14 @@ struct BRILLOUIN_SETTINGS {
 	double zMax{ 0 };	// [m]	z maximum value
 	int zSteps{ 1 };	// [1]	z steps
 
+	// order in which the positions are visited
+	SCAN_PATH_SETTINGS path;
+	bool sparseScan{ false };	// only acquire the positions inside the scan mask
+
 	CAMERA_SETTINGS camera;
+
+	// evaluation of the spectra during the scan
+	BRILLOUIN_ANALYSIS_SETTINGS analysis;
 };
 
 class Brillouin : public AcquisitionMode {
@@ -78,6 +79,12 @@ public slots:
 
 	void setScanOrderAuto(bool automatical);
 
+	void setScanPattern(SCAN_PATTERN pattern);
+	void setUnidirectionalApproach(bool unidirectional);
+
+	void setScanMask(const SCAN_MASK& mask);
+	void setSparseScan(bool sparse);
+
 	void determineScanOrder();
 
 	std::vector<POINT3> getOrderedPositions();
@@ -85,10 +92,18 @@ public slots:
 private:
 	void abortMode(std::unique_ptr <StorageWrapper>& storage) override;
 
+	template <typename T>
 	void calibrate(std::unique_ptr <StorageWrapper>& storage);
 
+	template <typename T>
+	void __acquire(std::unique_ptr <StorageWrapper>& storage);
+
 	std::string getRepetitionFilename();
 
+	void storeShiftMap(std::unique_ptr <StorageWrapper>& storage);
+
+	MOTION_MODEL getMotionModel();
+
 	BRILLOUIN_SETTINGS m_settings;
 	SCAN_ORDER m_scanOrder;
 	Camera** m_andor{ nullptr };
@@ -105,8 +120,13 @@ private:
 
 	std::vector<POINT3> m_orderedPositions;	// The positions to measure in absolute values
 	std::vector<POINT3> m_orderedPositionsRelative;	// The positions to measure relative to start position
+	std::vector<POINT3> m_orderedApproachPositions;	// The positions to move to before the positions in absolute values
 	std::vector<INDEX3> m_orderedIndices;	// The associated indices
 	std::vector<bool> m_calibrationAllowed;	// If a calibration is allowed for this position
+	SCAN_PATH_COST m_scanPathCost;			// The estimated travel of the stage along the positions
+	SCAN_MASK m_scanMask;					// The positions outside of the mask are skipped in sparse scans
+
+	BrillouinAnalysis m_analysis;
 
 private slots:
 	void acquire(std::unique_ptr <StorageWrapper>& storage) override;
@@ -120,6 +140,8 @@ signals:
 	void s_calibrationRunning(bool);	// is calibration running
 	void s_scanOrderChanged(SCAN_ORDER);
 	void s_orderedPositionsChanged(std::vector<POINT3>);
+	void s_scanPathCostChanged(SCAN_PATH_COST);	// estimated travel of the stage along the ordered positions
+	void s_shiftMeasured(BRILLOUIN_SHIFT);	// emitted from the analysis thread for every analyzed position
 };
 
 #endif //BRILLOUIN_H
\ No newline at end of file
@@ -248,7 +248,8 @@ void Fluorescence::configureCamera() {
 		m_settings.camera.readout.triggerMode = L"Software";
 	}
 #endif
-	m_settings.camera.readout.cycleMode = L"Fixed";
+	// The camera keeps running across the channels
+	m_settings.camera.readout.cycleMode = L"Continuous";
 	m_settings.camera.frameCount = 1;
 }
 
@@ -267,21 +268,33 @@ void Fluorescence::__acquire(std::unique_ptr <StorageWrapper>& storage, std::vec
 
 	writeScaleCalibration(storage, ACQUISITION_MODE::FLUORESCENCE);
 
-	QMetaObject::invokeMethod(
-		storage.get(),
-		[&storage = storage]() { storage.get()->startWritingQueues(); },
-		Qt::AutoConnection
-	);
+	// called directly, so that the queues are reset before the first payload is enqueued
+	storage->startWritingQueues();
 
 	QElapsedTimer measurementTimer;
 	measurementTimer.start();
 
+	/*
+	 * Channels with the same exposure time and gain are acquired one after another,
+	 * so the camera only has to change its settings once per group.
+	 */
+	auto exposures = std::vector<CHANNEL_EXPOSURE>{};
+	for (auto const& channel : channels) {
+		exposures.push_back({ 1e-3 * channel->exposure, (double)channel->gain });
+	}
+	auto order = FluorescenceSequencer::acquisitionOrder(exposures);
+
+	auto sequencer = FluorescenceSequencer{ *m_camera };
+	sequencer.start(m_settings.camera);
+
 	int rank_data{ 3 };
 	// Loop through the different modes
 	int imageNumber{ 0 };
-	for (auto const& channel : channels) {
+	for (auto index : order) {
+		auto const& channel = channels[index];
 		// Abort if requested
 		if (m_abort) {
+			sequencer.stop();
 			this->abortMode(storage);
 			return;
 		}
@@ -291,70 +304,18 @@ void Fluorescence::__acquire(std::unique_ptr <StorageWrapper>& storage, std::vec
 			(*m_scanControl)->setPreset(channel->preset);
 		}
 
-		/*
-		 * We have to check if the exposure time or gain settings will change.
-		 * If they will, then we have to trash the first image after the change,
-		 * as the settings might not be applied already (valid for trigger mode).
-		 * Might be worse for free running mode.
-		 * See https://www.ptgrey.com/KB/10086
-		 */
-		auto changed{ false };
-		if (((int)(1e3 * m_settings.camera.exposureTime) != channel->exposure) || (m_settings.camera.gain != channel->gain)) {
-			changed = true;
-		}
-
-		m_settings.camera.exposureTime = 1e-3 * channel->exposure;
-		m_settings.camera.gain = channel->gain;
-
-		if (changed) {
-			m_settings.camera.frameCount = 2;
-			if (m_camera) {
-				(*m_camera)->startAcquisition(m_settings.camera);
-				// Settings might change after acquisition start (e.g. binning size and bytes per frame)
-				m_settings.camera = (*m_camera)->getSettings();
-				(*m_camera)->getImageForAcquisition(nullptr, false);
-				(*m_camera)->getImageForAcquisition(nullptr, false);
-				(*m_camera)->stopAcquisition();
-			}
-		}
-
-		// start image acquisition
-		m_settings.camera.frameCount = 1;
-		if (m_camera) {
-			(*m_camera)->startAcquisition(m_settings.camera);
-		}
+		// The camera keeps running if the exposure time and gain don't change
+		sequencer.setExposure(exposures[index]);
 
 		// Settings might change after acquisition start (e.g. binning size and bytes per frame)
-		if (m_camera) {
-			m_settings.camera = (*m_camera)->getSettings();
-		}
+		m_settings.camera = sequencer.getSettings();
 		hsize_t dims_data[3] = { 1, (hsize_t)m_settings.camera.roi.height_binned, (hsize_t)m_settings.camera.roi.width_binned };
 
-		// read images from camera
-		std::vector<std::byte> images(m_settings.camera.roi.bytesPerFrame);
-
-		// acquire images
-		if (m_camera) {
-			(*m_camera)->getImageForAcquisition(&images[0], true);
-		}
+		// read images from camera directly into the buffer handed to the storage
+		auto images = storage->getFramePool<T>().get(m_settings.camera.roi.bytesPerFrame / sizeof(T));
 
-		// cast the vector to unsigned short
-		auto images_ = (std::vector<T> *) & images;
-
-		// Sometimes the uEye camera returns a black image (only zeros), we try to catch this here by
-		// repeating the acquisition a maximum of 5 times
-		unsigned char sum = simplemath::sum(*images_);
-		int i{ 0 };
-		while (sum == 0 && 5 > i++) {
-			if (m_camera) {
-				(*m_camera)->getImageForAcquisition(&images[0], true);
-			}
-
-			// cast the vector type T
-			images_ = (std::vector<T> *) & images;
-
-			sum = simplemath::sum(*images_);
-		}
+		// acquire images, blank images are repeated
+		sequencer.acquire(images.data(), (gsl::index)images.size());
 
 		// store images
 		// asynchronously write image to disk
@@ -367,27 +328,21 @@ void Fluorescence::__acquire(std::unique_ptr <StorageWrapper>& storage, std::vec
 			dims_data,
 			date,
 			channel->name,
-			*images_,
+			std::move(images),
 			m_settings.camera.exposureTime,
 			m_settings.camera.gain,
 			m_settings.camera.roi
 		);
 
-		QMetaObject::invokeMethod(
-			storage.get(),
-			[&storage = storage, img]() { storage.get()->s_enqueuePayload(img); },
-			Qt::AutoConnection
-		);
+		// blocks if the writer falls behind
+		storage->s_enqueuePayload(img);
 
-		// configure camera for preview
-		if (m_camera) {
-			(*m_camera)->stopAcquisition();
-		}
 		imageNumber++;
 		double percentage = 100 * (double)imageNumber / channels.size();
 		int remaining = 1e-3 * measurementTimer.elapsed() / imageNumber * ((int64_t)channels.size() - imageNumber);
 		emit(s_repetitionProgress(percentage, remaining));
 	}
+	sequencer.stop();
 
 	// Here we wait until the storage object indicate it finished to write to the file.
 	QEventLoop loop;
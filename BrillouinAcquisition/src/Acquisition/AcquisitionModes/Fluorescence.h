@@ -2,6 +2,7 @@
 #define FLUORESCENCE_H
 
 #include "AcquisitionMode.h"
+#include "FluorescenceSequencer.h"
 #include "..\..\Devices\Cameras\Camera.h"
 #include "..\..\Devices\ScanControls\ScanControl.h"
 
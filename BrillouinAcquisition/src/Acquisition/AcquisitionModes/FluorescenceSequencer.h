@@ -0,0 +1,191 @@
+#ifndef FLUORESCENCESEQUENCER_H
+#define FLUORESCENCESEQUENCER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../../Devices/Cameras/Camera.h"
+
+struct CHANNEL_EXPOSURE {
+	double exposureTime{ 0 };	// [s]	exposure time
+	double gain{ 0 };			// [dB]	camera gain
+};
+
+/*
+ * Acquires the images of several fluorescence channels without restarting the camera per channel.
+ *
+ * The camera is armed when the first image is requested and stays armed until stop() is called,
+ * unless it can only take a limited number of images per acquisition.
+ * Changing the exposure time or gain is applied to the running acquisition if the camera
+ * supports it, otherwise the acquisition is restarted. In both cases the first frames after the
+ * change are discarded, as they might still be taken with the previous settings (valid for
+ * trigger mode, see https://www.ptgrey.com/KB/10086).
+ */
+class FluorescenceSequencer {
+
+public:
+	explicit FluorescenceSequencer(Camera* camera) : m_camera(camera) {};
+
+	/*
+	 * Order in which to acquire the channels, so that channels with the same exposure time and gain
+	 * follow each other. The groups keep the order of their first channel.
+	 */
+	static std::vector<gsl::index> acquisitionOrder(const std::vector<CHANNEL_EXPOSURE>& channels) {
+		auto order = std::vector<gsl::index>{};
+		auto assigned = std::vector<bool>(channels.size(), false);
+		for (gsl::index i{ 0 }; i < (gsl::index)channels.size(); i++) {
+			if (assigned[i]) {
+				continue;
+			}
+			for (gsl::index j{ i }; j < (gsl::index)channels.size(); j++) {
+				if (!assigned[j] && isEqual(channels[i], channels[j])) {
+					order.push_back(j);
+					assigned[j] = true;
+				}
+			}
+		}
+		return order;
+	}
+
+	static bool isEqual(const CHANNEL_EXPOSURE& lhs, const CHANNEL_EXPOSURE& rhs) {
+		return std::abs(lhs.exposureTime - rhs.exposureTime) < 1e-6 && std::abs(lhs.gain - rhs.gain) < 1e-6;
+	}
+
+	/*
+	 * Sometimes the uEye camera returns a black image (only zeros). A real image is never zero at
+	 * all of the sampled pixels, so it suffices to check a sparse grid of pixels instead of the whole image.
+	 */
+	template <typename T>
+	static bool isBlank(const T* image, gsl::index count, gsl::index samples = 1024) {
+		auto stride = std::max((gsl::index)1, count / std::max((gsl::index)1, samples));
+		for (gsl::index i{ stride / 2 }; i < count; i += stride) {
+			if (image[i] != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * Camera settings for the acquisition, the exposure time and gain are set per channel
+	 */
+	void start(const CAMERA_SETTINGS& settings) {
+		m_settings = settings;
+		m_exposure = { settings.exposureTime, settings.gain };
+		m_isArmed = false;
+		m_restarts = 0;
+		m_discardedFrames = 0;
+		m_blankFrames = 0;
+	}
+
+	void setExposure(const CHANNEL_EXPOSURE& exposure) {
+		// the camera might round the settings, so we compare the requested ones
+		auto changed = !isEqual(m_exposure, exposure);
+		if (m_isArmed && !changed) {
+			return;
+		}
+		m_exposure = exposure;
+		m_settings.exposureTime = exposure.exposureTime;
+		m_settings.gain = exposure.gain;
+
+		auto discard{ 0 };
+		if (!m_isArmed) {
+			arm();
+			discard = changed ? m_restartDiscardFrames : 0;
+		} else {
+			discard = m_camera->changeExposureDuringAcquisition(exposure.exposureTime, exposure.gain);
+			if (discard < 0) {
+				m_camera->stopAcquisition();
+				m_restarts++;
+				arm();
+				discard = m_restartDiscardFrames;
+			}
+		}
+		for (gsl::index i{ 0 }; i < discard; i++) {
+			getImage(nullptr, false);
+		}
+		m_discardedFrames += discard;
+	}
+
+	/*
+	 * Acquires an image with the current exposure into the buffer of count pixels,
+	 * blank images are repeated a maximum of 5 times
+	 */
+	template <typename T>
+	void acquire(T* image, gsl::index count) {
+		if (!m_isArmed) {
+			setExposure(m_exposure);
+		}
+		auto buffer = reinterpret_cast<std::byte*>(image);
+		getImage(buffer, true);
+
+		auto tryCount{ 0 };
+		while (isBlank(image, count) && 5 > tryCount++) {
+			m_blankFrames++;
+			getImage(buffer, true);
+		}
+	}
+
+	void stop() {
+		if (m_isArmed) {
+			m_camera->stopAcquisition();
+			m_isArmed = false;
+		}
+	}
+
+	/*
+	 * Settings of the running acquisition, the camera might adjust them (e.g. binning size and bytes per frame)
+	 */
+	CAMERA_SETTINGS getSettings() const {
+		return m_settings;
+	}
+
+	int restarts() const {
+		return m_restarts;
+	}
+
+	int discardedFrames() const {
+		return m_discardedFrames;
+	}
+
+	int blankFrames() const {
+		return m_blankFrames;
+	}
+
+private:
+	void arm() {
+		m_camera->startAcquisition(m_settings);
+		// Settings might change after acquisition start (e.g. binning size and bytes per frame)
+		m_settings = m_camera->getSettings();
+		m_isArmed = true;
+		m_imagesAcquired = 0;
+	}
+
+	void getImage(std::byte* buffer, bool preview) {
+		// Some cameras can only take a limited number of images per acquisition
+		auto maximumImages = m_camera->getMaximumAcquisitionImages();
+		if (maximumImages > 0 && m_imagesAcquired >= maximumImages) {
+			m_camera->stopAcquisition();
+			m_restarts++;
+			arm();
+		}
+		m_camera->getImageForAcquisition(buffer, preview);
+		m_imagesAcquired++;
+	}
+
+	Camera* m_camera{ nullptr };
+	CAMERA_SETTINGS m_settings;
+	CHANNEL_EXPOSURE m_exposure;		// exposure requested for the running acquisition
+	bool m_isArmed{ false };
+	int m_imagesAcquired{ 0 };			// [1]	images taken since the camera was started
+
+	int m_restartDiscardFrames{ 2 };	// [1]	frames discarded after starting the camera with changed settings
+	int m_restarts{ 0 };
+	int m_discardedFrames{ 0 };
+	int m_blankFrames{ 0 };
+};
+
+#endif // FLUORESCENCESEQUENCER_H
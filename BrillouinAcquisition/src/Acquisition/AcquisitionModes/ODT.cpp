@@ -301,11 +301,8 @@ template <typename T>
 void ODT::__acquire(std::unique_ptr <StorageWrapper> & storage) {
 	setAcquisitionStatus(ACQUISITION_STATUS::STARTED);
 
-	QMetaObject::invokeMethod(
-		storage.get(),
-		[&storage = storage]() { storage.get()->startWritingQueues(); },
-		Qt::AutoConnection
-	);
+	// called directly, so that the queues are reset before the first payload is enqueued
+	storage->startWritingQueues();
 
 	// move to ODT configuration
 	(*m_ODTControl)->setPreset(ScanPreset::SCAN_ODT);
@@ -341,8 +338,8 @@ void ODT::__acquire(std::unique_ptr <StorageWrapper> & storage) {
 	if (m_cameraSettings.roi.bytesPerFrame) {
 		for (gsl::index i{ 0 }; i < m_acqSettings.numberPoints; i++) {
 
-			// read images from camera
-			std::vector<std::byte> images(m_cameraSettings.roi.bytesPerFrame);
+			// read images from camera directly into the buffer handed to the storage
+			auto images = storage->getFramePool<T>().get(m_cameraSettings.roi.bytesPerFrame / sizeof(T));
 
 			if (m_abort) {
 				this->abortMode(storage);
@@ -350,7 +347,7 @@ void ODT::__acquire(std::unique_ptr <StorageWrapper> & storage) {
 			}
 
 			// acquire images
-			(*m_camera)->getImageForAcquisition(&images[0], false);
+			(*m_camera)->getImageForAcquisition(reinterpret_cast<std::byte*>(images.data()), false);
 
 
 			// store images
@@ -359,24 +356,19 @@ void ODT::__acquire(std::unique_ptr <StorageWrapper> & storage) {
 			std::string date = QDateTime::currentDateTime().toOffsetFromUtc(QDateTime::currentDateTime().offsetFromUtc())
 				.toString(Qt::ISODateWithMs).toStdString();
 
-			// cast the image to type T
-			auto images_ = (std::vector<T>*) & images;
 			auto img = new ODTIMAGE<T>(
 				(int)i,
 				rank_data,
 				dims_data,
 				date,
-				*images_,
+				std::move(images),
 				m_cameraSettings.exposureTime,
 				m_cameraSettings.gain,
 				m_cameraSettings.roi
 			);
 
-			QMetaObject::invokeMethod(
-				storage.get(),
-				[&storage = storage, img]() { storage.get()->s_enqueuePayload(img); },
-				Qt::AutoConnection
-			);
+			// blocks if the writer falls behind
+			storage->s_enqueuePayload(img);
 		}
 	}
 
@@ -4,7 +4,6 @@
 #include "AcquisitionMode.h"
 #include "..\..\Devices\Cameras\Camera.h"
 #include "..\..\Devices\ScanControls\ODTControl.h"
-#include "..\..\circularBuffer.h"
 
 enum class ODT_SETTING {
 	VOLTAGE,
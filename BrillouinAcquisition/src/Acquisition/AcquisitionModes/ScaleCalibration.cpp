@@ -4,9 +4,6 @@
 
 #include "../../h5/h5_helper.h"
 
-#include "opencv2/core.hpp"
-#include "opencv2/highgui.hpp"
-
 /*
  * Public definitions
  */
@@ -98,7 +95,7 @@ void ScaleCalibration::abortMode() {
 }
 
 template <typename T>
-void ScaleCalibration::save(std::vector<std::vector<T>> images, std::vector<POINT2> positions) {
+void ScaleCalibration::save(std::vector<std::vector<T>> images, std::vector<POINT2> positions, std::vector<IMAGE_SHIFT> shifts) {
 	/*
 	 * Construct the filepath
 	 */
@@ -150,7 +147,7 @@ void ScaleCalibration::save(std::vector<std::vector<T>> images, std::vector<POIN
 		(hsize_t)m_cameraSettings.roi.height_binned,
 		(hsize_t)m_cameraSettings.roi.width_binned
 	};
-	auto names = std::vector<std::string>{ "origin", "dx", "dy" };
+	auto names = std::vector<std::string>{ "origin", "dx", "dy", "-dx", "-dy" };
 	auto i = gsl::index{ 0 };
 	for (const auto& image : images) {
 		// Check that we don't run into trouble iterating over two arrays
@@ -172,6 +169,10 @@ void ScaleCalibration::save(std::vector<std::vector<T>> images, std::vector<POIN
 		writeAttribute(dataset, "dx", positions[i].x);
 		writeAttribute(dataset, "dy", positions[i].y);
 
+		writeAttribute(dataset, "shiftX", shifts[i].x);
+		writeAttribute(dataset, "shiftY", shifts[i].y);
+		writeAttribute(dataset, "confidence", shifts[i].confidence);
+
 		dataset.close();
 		++i;
 	}
@@ -254,11 +255,11 @@ void ScaleCalibration::__acquire() {
 	m_startPosition = (*m_scanControl)->getPosition();
 
 	/*
-	 * We acquire three images here, one at the origin, and one each shifted in x- and y-direction.
+	 * We acquire five images here, one at the origin, and one each shifted in positive and negative x- and y-direction.
 	 */
 	auto hysteresisCompensation{ 10.0 };// [µm] distance for compensation of the stage hysteresis
 	// Construct the positions
-	auto positions = std::vector<POINT2>{ { 0, 0 }, { m_Ds.x, 0 }, { 0, m_Ds.y } };
+	auto positions = std::vector<POINT2>{ { 0, 0 }, { m_Ds.x, 0 }, { 0, m_Ds.y }, { -m_Ds.x, 0 }, { 0, -m_Ds.y } };
 
 	// Acquire memory for image acquisition
 	auto images = std::vector<std::vector<std::byte>>(positions.size());
@@ -315,68 +316,39 @@ void ScaleCalibration::__acquire() {
 	// Stop the camera acquisition
 	(*m_camera)->stopAcquisition();
 
-	// Create input matrices for OpenCV from camera images
-	auto imagesCV = std::vector<cv::Mat>(images.size());
-	for (gsl::index i{ 0 }; i < images.size(); i++) {
-		imagesCV[i] = cv::Mat(m_cameraSettings.roi.height_binned, m_cameraSettings.roi.width_binned, CV_8UC1, &(images[i])[0]);
-	}
-
 	/*
-	 * Determine the shift in pixels
+	 * Determine the shift in pixels of every image against the origin image
 	 */
-
-#ifdef _DEBUG
-	 // Show the input images for debugging
-	cv::imshow("Origin", imagesCV[0]);
-	cv::imshow("Dx", imagesCV[1]);
-	cv::imshow("Dy", imagesCV[2]);
-#endif
-
-	// We use template matching, so we have to create a template from the origin image
-	auto padding = 200.0;
-	auto size = imagesCV[0].size();
-	auto templateROI = cv::Rect(padding, padding, size.width - 2 * padding, size.height - 2 * padding);
-	auto templ = imagesCV[0](templateROI);
-
-#ifdef _DEBUG
-	cv::imshow("Template", templ);
-#endif
-
-	auto outputX = cv::Mat{};
-	cv::matchTemplate(imagesCV[1], templ, outputX, cv::TemplateMatchModes::TM_SQDIFF);
-	auto outputY = cv::Mat{};
-	cv::matchTemplate(imagesCV[2], templ, outputY, cv::TemplateMatchModes::TM_SQDIFF);
-
-	cv::normalize(outputX, outputX, 0, 1, cv::NORM_MINMAX, -1, cv::Mat());
-	cv::normalize(outputY, outputY, 0, 1, cv::NORM_MINMAX, -1, cv::Mat());
-
-	auto minValX = double{};
-	auto maxValX = double{};
-	auto minLocX = cv::Point{};
-	auto maxLocX = cv::Point{};
-	cv::minMaxLoc(outputX, &minValX, &maxValX, &minLocX, &maxLocX, cv::Mat());
-	auto shiftDx = minLocX - cv::Point(padding, padding);
-
-	auto minValY = double{};
-	auto maxValY = double{};
-	auto minLocY = cv::Point{};
-	auto maxLocY = cv::Point{};
-	cv::minMaxLoc(outputY, &minValY, &maxValY, &minLocY, &maxLocY, cv::Mat());
-	auto shiftDy = minLocY - cv::Point(padding, padding);
-
-	/*
-	 * Construct the scale calibration
-	 */
-	m_scaleCalibration.micrometerToPixX = { -1 * shiftDx.x / m_Ds.x, shiftDx.y / m_Ds.x };
-	m_scaleCalibration.micrometerToPixY = { -1 * shiftDy.x / m_Ds.y, shiftDy.y / m_Ds.y };
+	auto dim_x = m_cameraSettings.roi.width_binned;
+	auto dim_y = m_cameraSettings.roi.height_binned;
+	auto minConfidence{ 10.0 };	// [1]	minimum height of the correlation peak to use a shift
+	auto shifts = std::vector<IMAGE_SHIFT>(images.size());
+	auto translations = std::vector<POINT2>{};
+	auto pixelShifts = std::vector<POINT2>{};
 	try {
-		// Can throw an exception (if the provided calibration is invalid):
-		ScaleCalibrationHelper::initializeCalibrationFromMicrometer(&m_scaleCalibration);
+		auto registration = ImageRegistration{};
+		registration.setReference((T*)&(images[0])[0], dim_x, dim_y);
+		for (gsl::index i{ 0 }; i < (gsl::index)images.size(); i++) {
+			shifts[i] = registration.measureShift((T*)&(images[i])[0], dim_x, dim_y);
+			// Images without distinct structures give no reliable shift
+			if (shifts[i].confidence < minConfidence) {
+				continue;
+			}
+			translations.push_back(positions[i]);
+			// The calibration counts shifts in x-direction the other way round
+			pixelShifts.push_back({ -1 * shifts[i].x, shifts[i].y });
+		}
+
+		/*
+		 * Construct the scale calibration
+		 */
+		// Can throw an exception (if the translations with a reliable shift are not sufficient):
+		ScaleCalibrationHelper::fitCalibrationFromShifts(&m_scaleCalibration, translations, pixelShifts);
 
 		// Store the calibration in a file
 
 		auto images_ = (std::vector<std::vector<T>> *) &images;
-		save((*images_), positions);
+		save((*images_), positions, shifts);
 
 		emit(s_scaleCalibrationChanged(m_scaleCalibration));
 
@@ -5,10 +5,9 @@
 #include <gsl/gsl>
 #include "H5Cpp.h"
 
-#include "opencv2/imgproc.hpp"
-
 #include "AcquisitionMode.h"
 #include "ScaleCalibrationHelper.h"
+#include "../../imageRegistration.h"
 #include "../../Devices/Cameras/Camera.h"
 #include "../../Devices/ScanControls/ScanControl.h"
 
@@ -51,7 +50,7 @@ private:
 	void abortMode();
 
 	template <typename T>
-	void save(std::vector<std::vector<T>> images, std::vector<POINT2> positions);
+	void save(std::vector<std::vector<T>> images, std::vector<POINT2> positions, std::vector<IMAGE_SHIFT> shifts);
 
 	void writePoint(H5::Group group, std::string name, POINT2 point);
 	POINT2 readPoint(H5::Group group, const std::string& name);
@@ -1,6 +1,10 @@
 #ifndef SCALECALIBRATIONHELPER_H
 #define SCALECALIBRATIONHELPER_H
 
+#include <cmath>
+#include <vector>
+
+#include <gsl/gsl>
 #include "../../POINTS.h"
 
 struct ScaleCalibrationData {
@@ -51,6 +55,53 @@ public:
 		calibration->micrometerToPixY = POINT2{ inverted.b, inverted.d };
 	}
 
+	/*
+	 * Least-squares fit of the micrometer to pixel matrix to the pixel shifts measured for
+	 * the given stage translations. The fit includes an offset common to all shifts, so the
+	 * reference position does not need to be one of the translations.
+	 * Returns the root mean square of the residual shifts [pix].
+	 */
+	static double fitCalibrationFromShifts(ScaleCalibrationData* calibration, const std::vector<POINT2>& translations, const std::vector<POINT2>& shifts) {
+		if (translations.size() != shifts.size()) {
+			throw std::exception("The number of translations and shifts differ.");
+		}
+		auto count = (double)translations.size();
+		auto meanTranslation = POINT2{};
+		auto meanShift = POINT2{};
+		for (gsl::index i{ 0 }; i < (gsl::index)translations.size(); i++) {
+			meanTranslation += translations[i] / count;
+			meanShift += shifts[i] / count;
+		}
+
+		// Covariances of the translations and of the shifts with the translations
+		auto translationCovariance = Matrix2{};
+		auto shiftCovariance = Matrix2{};
+		for (gsl::index i{ 0 }; i < (gsl::index)translations.size(); i++) {
+			auto t = POINT2{ translations[i] } - meanTranslation;
+			auto s = POINT2{ shifts[i] } - meanShift;
+			translationCovariance = add(translationCovariance, { t.x * t.x, t.x * t.y, t.y * t.x, t.y * t.y });
+			shiftCovariance = add(shiftCovariance, { s.x * t.x, s.x * t.y, s.y * t.x, s.y * t.y });
+		}
+		// The translations have to span the plane
+		if (!isBasis({ translationCovariance.a, translationCovariance.c }, { translationCovariance.b, translationCovariance.d })) {
+			throw std::exception("Provided translations do not span the plane.");
+		}
+
+		auto micrometerToPix = multiply(shiftCovariance, invert(translationCovariance));
+		calibration->micrometerToPixX = POINT2{ micrometerToPix.a, micrometerToPix.c };
+		calibration->micrometerToPixY = POINT2{ micrometerToPix.b, micrometerToPix.d };
+		initializeCalibrationFromMicrometer(calibration);
+
+		auto squaredResidual{ 0.0 };
+		for (gsl::index i{ 0 }; i < (gsl::index)translations.size(); i++) {
+			auto t = POINT2{ translations[i] } - meanTranslation;
+			auto s = POINT2{ shifts[i] } - meanShift;
+			auto residual = s - POINT2{ micrometerToPix.a * t.x + micrometerToPix.b * t.y, micrometerToPix.c * t.x + micrometerToPix.d * t.y };
+			squaredResidual += residual.x * residual.x + residual.y * residual.y;
+		}
+		return sqrt(squaredResidual / count);
+	}
+
 	static bool isBasis(POINT2 e_0, POINT2 e_1) {
 		// Check that the absolute value of the determinant is not zero
 		return abs(determinate({ e_0.x, e_1.x, e_0.y, e_1.y })) > 1e-10;
@@ -60,6 +111,17 @@ public:
 		return matrix.a * matrix.d - matrix.b * matrix.c;
 	}
 
+	static Matrix2 add(Matrix2 lhs, Matrix2 rhs) {
+		return Matrix2{ lhs.a + rhs.a, lhs.b + rhs.b, lhs.c + rhs.c, lhs.d + rhs.d };
+	}
+
+	static Matrix2 multiply(Matrix2 lhs, Matrix2 rhs) {
+		return Matrix2{
+			lhs.a * rhs.a + lhs.b * rhs.c, lhs.a * rhs.b + lhs.b * rhs.d,
+			lhs.c * rhs.a + lhs.d * rhs.c, lhs.c * rhs.b + lhs.d * rhs.d
+		};
+	}
+
 	static Matrix2 invert(Matrix2 matrix) {
 		auto det = determinate(matrix);
 		auto a = matrix.d / det;
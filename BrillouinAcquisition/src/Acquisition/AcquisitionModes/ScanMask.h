@@ -0,0 +1,256 @@
+#ifndef SCANMASK_H
+#define SCANMASK_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../../POINTS.h"
+
+/*
+ * Binary mask on the brightfield image, the pixels of the mask cover the image pixel by pixel.
+ * Only the positions of a scan inside the mask are acquired.
+ */
+struct SCAN_MASK {
+	int width{ 0 };							// [pix]	number of mask pixels in x-direction
+	int height{ 0 };						// [pix]	number of mask pixels in y-direction
+	POINT2 first{ 0, 0 };					// [pix]	camera pixel of the first mask pixel of the first row
+	POINT2 last{ 0, 0 };					// [pix]	camera pixel of the last mask pixel of the last row
+	std::vector<unsigned char> pixels;		// [1]	row by row, 1 inside the mask
+
+	// conversion of the positions relative to the start position to camera pixels,
+	// taken from the scale calibration when the mask is created
+	POINT2 micrometerToPixX{ 0, 0 };		// [pix/micrometer]
+	POINT2 micrometerToPixY{ 0, 0 };		// [pix/micrometer]
+	POINT2 originPix{ 0, 0 };				// [pix]	camera pixel of the start position
+};
+
+class ScanMask {
+
+public:
+	static bool isEmpty(const SCAN_MASK& mask) {
+		return mask.pixels.empty() || std::none_of(mask.pixels.begin(), mask.pixels.end(), [](unsigned char pixel) { return pixel; });
+	}
+
+	/*
+	 * Sets the pixels inside the polygon with the given vertices [pix], following the even-odd rule
+	 */
+	static void fillPolygon(SCAN_MASK& mask, const std::vector<POINT2>& vertices) {
+		mask.pixels.assign((size_t)mask.width * mask.height, 0);
+		if (vertices.size() < 3) {
+			return;
+		}
+		auto corners = std::vector<POINT2>(vertices.size());
+		std::transform(vertices.begin(), vertices.end(), corners.begin(), [&mask](const POINT2& vertex) { return toMaskPixel(mask, vertex); });
+
+		auto crossings = std::vector<double>{};
+		for (gsl::index y{ 0 }; y < mask.height; y++) {
+			// x-values at which the edges cross the center of the row
+			crossings.clear();
+			for (gsl::index i{ 0 }; i < (gsl::index)corners.size(); i++) {
+				const auto& start = corners[i];
+				const auto& end = corners[(i + 1) % corners.size()];
+				if ((start.y <= y) != (end.y <= y)) {
+					crossings.push_back(start.x + (y - start.y) / (end.y - start.y) * (end.x - start.x));
+				}
+			}
+			std::sort(crossings.begin(), crossings.end());
+			for (gsl::index i{ 0 }; i + 1 < (gsl::index)crossings.size(); i += 2) {
+				auto begin = std::max((gsl::index)0, (gsl::index)std::ceil(crossings[i]));
+				auto end = std::min((gsl::index)mask.width - 1, (gsl::index)std::floor(crossings[i + 1]));
+				for (gsl::index x{ begin }; x <= end; x++) {
+					mask.pixels[y * mask.width + x] = 1;
+				}
+			}
+		}
+	}
+
+	/*
+	 * Sets the pixels of the image which belong to the sample. The image has the size of the mask.
+	 *
+	 * The image is smoothed with a box filter first, so noise does not split the mask. Otsu's method
+	 * then separates the pixels into two classes of values, the sample is assumed to be the smaller one
+	 * (e.g. a cell darker than the background in brightfield or with a larger phase in ODT images).
+	 * Pixels which are not a number belong to the background.
+	 * Returns the threshold of the smoothed image.
+	 */
+	template <typename T>
+	static double threshold(SCAN_MASK& mask, const T* image, int radius = 3) {
+		auto count = (gsl::index)mask.width * mask.height;
+		mask.pixels.assign(count, 0);
+		if (count == 0) {
+			return 0;
+		}
+		auto smoothed = boxFilter(image, mask.width, mask.height, radius);
+
+		auto minimum = INFINITY;
+		auto maximum = -INFINITY;
+		for (auto value : smoothed) {
+			// NaN fails both comparisons and is skipped
+			minimum = value < minimum ? value : minimum;
+			maximum = value > maximum ? value : maximum;
+		}
+		if (!(maximum > minimum)) {
+			return minimum;
+		}
+
+		constexpr int bins{ 256 };
+		auto histogram = std::vector<double>(bins, 0);
+		auto binWidth = (maximum - minimum) / bins;
+		auto total{ 0.0 };
+		for (auto value : smoothed) {
+			if (!std::isnan(value)) {
+				histogram[std::min(bins - 1, (int)((value - minimum) / binWidth))]++;
+				total++;
+			}
+		}
+
+		// maximize the variance between the two classes
+		auto sum{ 0.0 };
+		for (gsl::index i{ 0 }; i < bins; i++) {
+			sum += i * histogram[i];
+		}
+		auto sumBelow{ 0.0 };
+		auto countBelow{ 0.0 };
+		auto bestVariance{ -1.0 };
+		auto bestBin{ 0 };
+		for (gsl::index i{ 0 }; i < bins - 1; i++) {
+			countBelow += histogram[i];
+			sumBelow += i * histogram[i];
+			auto countAbove = total - countBelow;
+			if (countBelow == 0 || countAbove == 0) {
+				continue;
+			}
+			auto difference = sumBelow / countBelow - (sum - sumBelow) / countAbove;
+			auto variance = countBelow * countAbove * difference * difference;
+			if (variance > bestVariance) {
+				bestVariance = variance;
+				bestBin = (int)i;
+			}
+		}
+		auto level = minimum + (bestBin + 1) * binWidth;
+
+		auto above{ 0.0 };
+		for (gsl::index i{ 0 }; i < count; i++) {
+			mask.pixels[i] = (smoothed[i] >= level);
+			above += mask.pixels[i];
+		}
+		if (above > total / 2) {
+			for (gsl::index i{ 0 }; i < count; i++) {
+				mask.pixels[i] = !mask.pixels[i] && !std::isnan(smoothed[i]);
+			}
+		}
+		return level;
+	}
+
+	/*
+	 * Camera pixel of a position relative to the start position [micrometer]
+	 */
+	static POINT2 toPix(const SCAN_MASK& mask, const POINT3& position) {
+		return position.x * mask.micrometerToPixX + position.y * mask.micrometerToPixY + POINT2{ mask.originPix };
+	}
+
+	/*
+	 * Whether the camera pixel lies inside the mask, pixels outside of the image are outside of the mask
+	 */
+	static bool contains(const SCAN_MASK& mask, const POINT2& positionPix) {
+		auto pixel = toMaskPixel(mask, positionPix);
+		auto x = (gsl::index)std::lround(pixel.x);
+		auto y = (gsl::index)std::lround(pixel.y);
+		if (x < 0 || x >= mask.width || y < 0 || y >= mask.height || mask.pixels.empty()) {
+			return false;
+		}
+		return mask.pixels[y * mask.width + x];
+	}
+
+	/*
+	 * Which of the positions relative to the start position lie inside the mask, independent of z
+	 */
+	static std::vector<bool> select(const SCAN_MASK& mask, const std::vector<POINT3>& positions) {
+		auto selected = std::vector<bool>(positions.size());
+		for (gsl::index i{ 0 }; i < (gsl::index)positions.size(); i++) {
+			selected[i] = contains(mask, toPix(mask, positions[i]));
+		}
+		return selected;
+	}
+
+private:
+	/*
+	 * Mask pixel of a camera pixel, the mask pixels are spread evenly from the first to the last one
+	 */
+	static POINT2 toMaskPixel(const SCAN_MASK& mask, const POINT2& positionPix) {
+		auto scale = [](double position, double first, double last, int size) {
+			return (size > 1 && last != first) ? (position - first) / (last - first) * (size - 1.0) : 0.0;
+		};
+		return POINT2{
+			scale(positionPix.x, mask.first.x, mask.last.x, mask.width),
+			scale(positionPix.y, mask.first.y, mask.last.y, mask.height)
+		};
+	}
+
+	/*
+	 * Mean of the values in a square of (2 * radius + 1) pixels, skipping values which are not a number
+	 */
+	template <typename T>
+	static std::vector<double> boxFilter(const T* image, int width, int height, int radius) {
+		// sums and counts of the rows first, then of the columns
+		auto rowSums = std::vector<double>((size_t)width * height, 0);
+		auto rowCounts = std::vector<double>((size_t)width * height, 0);
+		for (gsl::index y{ 0 }; y < height; y++) {
+			auto row = &image[y * width];
+			auto sum{ 0.0 };
+			auto count{ 0.0 };
+			auto add = [&](gsl::index x, double sign) {
+				auto value = (double)row[x];
+				if (!std::isnan(value)) {
+					sum += sign * value;
+					count += sign;
+				}
+			};
+			for (gsl::index x{ 0 }; x < std::min(radius, width); x++) {
+				add(x, 1);
+			}
+			for (gsl::index x{ 0 }; x < width; x++) {
+				if (x + radius < width) {
+					add(x + radius, 1);
+				}
+				if (x - radius - 1 >= 0) {
+					add(x - radius - 1, -1);
+				}
+				rowSums[y * width + x] = sum;
+				rowCounts[y * width + x] = count;
+			}
+		}
+
+		auto smoothed = std::vector<double>((size_t)width * height, NAN);
+		auto sums = std::vector<double>(width, 0);
+		auto counts = std::vector<double>(width, 0);
+		auto add = [&](gsl::index y, double sign) {
+			for (gsl::index x{ 0 }; x < width; x++) {
+				sums[x] += sign * rowSums[y * width + x];
+				counts[x] += sign * rowCounts[y * width + x];
+			}
+		};
+		for (gsl::index y{ 0 }; y < std::min(radius, height); y++) {
+			add(y, 1);
+		}
+		for (gsl::index y{ 0 }; y < height; y++) {
+			if (y + radius < height) {
+				add(y + radius, 1);
+			}
+			if (y - radius - 1 >= 0) {
+				add(y - radius - 1, -1);
+			}
+			for (gsl::index x{ 0 }; x < width; x++) {
+				if (counts[x] > 0.5) {
+					smoothed[y * width + x] = sums[x] / counts[x];
+				}
+			}
+		}
+		return smoothed;
+	}
+};
+
+#endif // SCANMASK_H
@@ -0,0 +1,242 @@
+#ifndef SCANPATHPLANNER_H
+#define SCANPATHPLANNER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../../POINTS.h"
+
+struct SCAN_ORDER {
+	bool automatical{ true };
+	int x{ 0 };	// first scan in x-direction
+	int y{ 1 };	// then in y-direction
+	int z{ 2 };	// scan in z-direction last
+};
+
+enum class SCAN_PATTERN {
+	RASTER,		// every line starts at the minimum of the fastest axis
+	SERPENTINE	// every line is scanned in the opposite direction of the previous one
+};
+
+struct SCAN_PATH_SETTINGS {
+	SCAN_PATTERN pattern{ SCAN_PATTERN::RASTER };
+	bool unidirectionalApproach{ false };	// approach every position from lower x- and y-values
+	double hysteresisCompensation{ 10 };	// [m]	distance the stage moves past a position before approaching it
+};
+
+struct AXIS_MOTION {
+	double velocity{ 1 };		// [m/ms]	travel velocity
+	double settleTime{ 50 };	// [ms]		time to settle after a move
+};
+
+/*
+ * Approximate travel times of the axes of a scan control, only used to plan the scan
+ */
+struct MOTION_MODEL {
+	AXIS_MOTION x;
+	AXIS_MOTION y;
+	AXIS_MOTION z;
+};
+
+struct SCAN_PATH {
+	std::vector<POINT3> positions;			// [m]	positions relative to the start position in the order of the scan
+	std::vector<POINT3> approachPositions;	// [m]	positions moved to before the position, equal to it if it is approached directly
+	std::vector<INDEX3> indices;			// [1]	indices of the positions
+	std::vector<bool> calibrationAllowed;	// a new line starts at the position, so a calibration is allowed
+};
+
+struct SCAN_PATH_COST {
+	int positions{ 0 };			// [1]	number of positions
+	int moves{ 0 };				// [1]	number of moves, including the approach moves and the return to the start position
+	double distance{ 0 };		// [m]	travelled distance
+	double travelTime{ 0 };		// [s]	time the stage moves and settles
+};
+
+/*
+ * Plans the order in which the positions of a scan are visited.
+ *
+ * The positions are scanned line by line along the fastest axis. A raster starts every line at the
+ * minimum of the fastest axis, so the stage travels back across the whole line in between. A serpentine
+ * scans every line in the opposite direction of the previous one, which removes this move.
+ *
+ * Stages with a hysteresis reach a position slightly differently depending on the direction they come from.
+ * With the unidirectional approach every position is approached from lower x- and y-values, like the
+ * scale calibration does, by first moving below positions the stage would otherwise reach from above.
+ */
+class ScanPathPlanner {
+
+public:
+	/*
+	 * The coordinates along each axis are relative to the start position
+	 */
+	static SCAN_PATH plan(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+		const SCAN_ORDER& order, const SCAN_PATH_SETTINGS& settings) {
+
+		// the coordinates of the fastest axis first
+		std::vector<const std::vector<double>*> directions(3);
+		directions[order.x] = &x;
+		directions[order.y] = &y;
+		directions[order.z] = &z;
+
+		auto count0 = (gsl::index)directions[0]->size();
+		auto count1 = (gsl::index)directions[1]->size();
+		auto count2 = (gsl::index)directions[2]->size();
+		auto nrPositions = count0 * count1 * count2;
+
+		auto path = SCAN_PATH{};
+		path.positions.resize(nrPositions);
+		path.approachPositions.resize(nrPositions);
+		path.indices.resize(nrPositions);
+		path.calibrationAllowed.resize(nrPositions);
+
+		auto serpentine = (settings.pattern == SCAN_PATTERN::SERPENTINE);
+		gsl::index ll{ 0 };
+		std::vector<double> position(3);
+		std::vector<int> indices(3);
+		for (gsl::index ii{ 0 }; ii < count2; ii++) {
+			for (gsl::index jj{ 0 }; jj < count1; jj++) {
+				// the lines are numbered across the planes, so consecutive lines always alternate
+				auto line = ii * count1 + jj;
+				for (gsl::index kk{ 0 }; kk < count0; kk++) {
+					indices[0] = (int)((serpentine && line % 2) ? count0 - 1 - kk : kk);
+					indices[1] = (int)((serpentine && ii % 2) ? count1 - 1 - jj : jj);
+					indices[2] = (int)ii;
+
+					for (gsl::index level{ 0 }; level < 3; level++) {
+						position[level] = (*directions[level])[indices[level]];
+					}
+
+					path.positions[ll] = POINT3{ position[order.x], position[order.y], position[order.z] };
+					path.indices[ll] = INDEX3{ indices[order.x], indices[order.y], indices[order.z] };
+					// a calibration is allowed at the first position of every line, independent of its direction
+					path.calibrationAllowed[ll] = (kk == 0);
+					ll++;
+				}
+			}
+		}
+
+		setApproachPositions(path, settings);
+		return path;
+	}
+
+	/*
+	 * Only keeps the selected positions of the path, in the same order. A calibration is allowed at a kept
+	 * position if a line started at it or at one of the skipped positions before it.
+	 */
+	static SCAN_PATH select(const SCAN_PATH& path, const std::vector<bool>& selected, const SCAN_PATH_SETTINGS& settings) {
+		auto selection = SCAN_PATH{};
+		auto lineStarted{ false };
+		for (gsl::index ll{ 0 }; ll < (gsl::index)path.positions.size(); ll++) {
+			lineStarted = lineStarted || path.calibrationAllowed[ll];
+			if (!selected[ll]) {
+				continue;
+			}
+			selection.positions.push_back(path.positions[ll]);
+			selection.indices.push_back(path.indices[ll]);
+			selection.calibrationAllowed.push_back(lineStarted);
+			lineStarted = false;
+		}
+		// the approach of a position depends on the previous position, which might be skipped now
+		selection.approachPositions.resize(selection.positions.size());
+		setApproachPositions(selection, settings);
+		return selection;
+	}
+
+	/*
+	 * Estimates the travel of the stage from the start position along the path and back
+	 */
+	static SCAN_PATH_COST estimateCost(const SCAN_PATH& path, const MOTION_MODEL& model) {
+		auto cost = SCAN_PATH_COST{};
+		cost.positions = (int)path.positions.size();
+
+		auto current = POINT3{ 0, 0, 0 };
+		auto moveTo = [&](const POINT3& target) {
+			auto time = moveTime(current, target, model);
+			if (time > 0) {
+				cost.moves++;
+				cost.travelTime += 1e-3 * time;
+				cost.distance += abs(POINT3{ target.x - current.x, target.y - current.y, target.z - current.z });
+			}
+			current = target;
+		};
+		for (gsl::index ll{ 0 }; ll < (gsl::index)path.positions.size(); ll++) {
+			moveTo(path.approachPositions[ll]);
+			moveTo(path.positions[ll]);
+		}
+		moveTo(POINT3{ 0, 0, 0 });
+		return cost;
+	}
+
+	/*
+	 * Order of the axes with the shortest travel time. The preferred order is kept,
+	 * unless another order is faster.
+	 */
+	static SCAN_ORDER fastestOrder(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+		const SCAN_ORDER& preferred, const SCAN_PATH_SETTINGS& settings, const MOTION_MODEL& model) {
+
+		auto best = preferred;
+		auto bestTime = estimateCost(plan(x, y, z, preferred, settings), model).travelTime;
+		for (int first{ 0 }; first < 3; first++) {
+			for (int second{ 0 }; second < 3; second++) {
+				if (second == first) {
+					continue;
+				}
+				auto order = preferred;
+				order.x = first;
+				order.y = second;
+				order.z = 3 - first - second;
+				auto time = estimateCost(plan(x, y, z, order, settings), model).travelTime;
+				if (time < bestTime * (1 - 1e-9)) {
+					best = order;
+					bestTime = time;
+				}
+			}
+		}
+		return best;
+	}
+
+	/*
+	 * [ms]	the axes move simultaneously, the move ends when the slowest axis has settled
+	 */
+	static double moveTime(const POINT3& from, const POINT3& to, const MOTION_MODEL& model) {
+		auto travel{ 0.0 };
+		auto settle{ 0.0 };
+		auto axis = [&](double distance, const AXIS_MOTION& motion) {
+			if (std::abs(distance) > m_tolerance) {
+				travel = std::max(travel, std::abs(distance) / motion.velocity);
+				settle = std::max(settle, motion.settleTime);
+			}
+		};
+		axis(to.x - from.x, model.x);
+		axis(to.y - from.y, model.y);
+		axis(to.z - from.z, model.z);
+		return travel + settle;
+	}
+
+private:
+	static void setApproachPositions(SCAN_PATH& path, const SCAN_PATH_SETTINGS& settings) {
+		// the stage starts at the start position
+		auto previous = POINT3{ 0, 0, 0 };
+		for (gsl::index ll{ 0 }; ll < (gsl::index)path.positions.size(); ll++) {
+			auto target = path.positions[ll];
+			auto approach = target;
+			if (settings.unidirectionalApproach) {
+				if (target.x < previous.x - m_tolerance) {
+					approach.x -= settings.hysteresisCompensation;
+				}
+				if (target.y < previous.y - m_tolerance) {
+					approach.y -= settings.hysteresisCompensation;
+				}
+			}
+			path.approachPositions[ll] = approach;
+			previous = target;
+		}
+	}
+
+	static constexpr double m_tolerance{ 1e-6 };	// [m]	positions closer than this are equal
+};
+
+#endif // SCANPATHPLANNER_H
@@ -2,6 +2,7 @@
 #include "filesystem"
 #include "VoltageCalibration.h"
 #include "../../simplemath.h"
+#include "../../pipelineStage.h"
 
 /*
  * Public definitions
@@ -69,6 +70,10 @@ void VoltageCalibration::setCameraSetting(CAMERA_SETTING type, double value) {
 	emit(s_cameraSettingsChanged(m_cameraSettings));
 }
 
+void VoltageCalibration::setSpotSettings(SPOT_SETTINGS settings) {
+	m_acqSettings.spot = settings;
+}
+
 void VoltageCalibration::load(std::string filepath) {
 
 	using namespace std::filesystem;
@@ -241,84 +246,53 @@ void VoltageCalibration::__acquire() {
 		}
 	}
 
-	// We splite the requested amount of calibration positions into chunks of maximum 100 images,
-	// since the PointGrey camera can't handle more without completely hanging.
-	int nrImages{ 100 };
-	int nrChunks = ceil(m_acqSettings.voltages.size() / double(nrImages));
-
-	for (gsl::index chunk{ 0 }; chunk < nrChunks; chunk++) {
-
-		(*m_camera)->startAcquisition(m_cameraSettings);
-
-		int chunkBegin = chunk * nrImages;
-		int chunkEnd = (chunk + 1) * nrImages - 1;
-		if (chunkEnd > m_acqSettings.voltages.size() - 1) {
-			chunkEnd = m_acqSettings.voltages.size() - 1;
-		}
-		int chunkSize = chunkEnd - chunkBegin + 1;
-
-		// Set first mirror voltage already
-		(*m_ODTControl)->setVoltage(m_acqSettings.voltages[chunkBegin]);
-		Sleep(100);
-
-		ACQ_VOLTAGES voltages;
-
-		/*
-			* Set the mirror voltage and trigger the camera
-			*/
-			// Construct the analog voltage vector and the trigger vector
-		int samplesPerAngle{ 10 };
-		int numberChannels{ 2 };
-		voltages.numberSamples = chunkSize * samplesPerAngle;
-		voltages.trigger = std::vector<uInt8>(voltages.numberSamples, 0);
-		voltages.mirror = std::vector<float64>((float64)voltages.numberSamples * numberChannels, 0);
-		for (gsl::index i{ 0 }; i < chunkSize; i++) {
-			voltages.trigger[i * samplesPerAngle + 2] = 1;
-			voltages.trigger[i * samplesPerAngle + 3] = 1;
-			std::fill_n(voltages.mirror.begin() + i * samplesPerAngle, samplesPerAngle, m_acqSettings.voltages[i + chunkBegin].Ux);
-			std::fill_n(voltages.mirror.begin() + i * samplesPerAngle + (size_t)chunkSize * samplesPerAngle, samplesPerAngle, m_acqSettings.voltages[i + chunkBegin].Uy);
+	int dim_x = m_cameraSettings.roi.width_binned;
+	int dim_y = m_cameraSettings.roi.height_binned;
+
+	auto runner = VoltageCalibrationRunner{ *m_camera, *m_ODTControl };
+
+	auto detection = spotDetection{};
+	detection.setSettings(m_acqSettings.spot);
+	if (m_acqSettings.spot.subtractBackground) {
+		// Acquire an image without laser light to subtract from every image
+		(*m_ODTControl)->setPreset(ScanPreset::SCAN_LASEROFF);
+		auto background = std::vector<std::byte>{};
+		auto completed = runner.run(m_cameraSettings, { m_acqSettings.voltages[0] },
+			[&background](gsl::index, std::vector<std::byte> image) { background = std::move(image); }, m_abort);
+		if (!completed) {
+			this->abortMode();
+			return;
 		}
-		// Apply voltages to NIDAQ board
-		(*m_ODTControl)->setAcquisitionVoltages(voltages);
-
-		int rank_data{ 3 };
-		hsize_t dims_data[3] = { 1, (hsize_t)m_cameraSettings.roi.height_binned, (hsize_t)m_cameraSettings.roi.width_binned };
-		for (gsl::index i{ 0 }; i < chunkSize; i++) {
-
-			// read images from camera
-			std::vector<std::byte> images(m_cameraSettings.roi.bytesPerFrame);
+		detection.setBackground(reinterpret_cast<T*>(&background[0]), dim_x, dim_y);
+		(*m_ODTControl)->setPreset(ScanPreset::SCAN_BRILLOUIN);
+	}
 
-			for (gsl::index mm{ 0 }; mm < 1; mm++) {
-				if (m_abort) {
-					this->abortMode();
-					return;
-				}
+	// The spots are located on a separate thread, while the next images are acquired
+	auto spots = std::vector<SPOT>(m_acqSettings.voltages.size());
+	auto detectionStage = PipelineStage{ 8 };
 
-				// acquire images
-				int64_t pointerPos = (int64_t)m_cameraSettings.roi.bytesPerFrame * mm;
-				(*m_camera)->getImageForAcquisition(&images[pointerPos], false);
-			}
+	auto completed = runner.run(m_cameraSettings, m_acqSettings.voltages,
+		[&spots, &detection, &detectionStage, dim_x, dim_y](gsl::index index, std::vector<std::byte> image) {
+			// Extract spot position from camera image
+			detectionStage.push([&spots, &detection, dim_x, dim_y, index, image = std::move(image)]() {
+				spots[index] = detection.locate(reinterpret_cast<const T*>(&image[0]), dim_x, dim_y);
+			});
+		}, m_abort);
+	if (!completed) {
+		this->abortMode();
+		return;
+	}
+	detectionStage.finish();
 
-			// cast the image to type T
-			auto images_ = (std::vector<T> *) &images;
+	for (gsl::index i{ 0 }; i < spots.size(); i++) {
+		if (spots[i].intensity > m_minimalIntensity) {
+			POINT2 pos = (*m_ODTControl)->pixToMicroMeter({ spots[i].x, dim_y - spots[i].y });
 
-			// Extract spot position from camera image
-			auto iterator_max = std::max_element((*images_).begin(), (*images_).end());
-			auto index = std::distance((*images_).begin(), iterator_max);
-			if (*iterator_max > m_minimalIntensity) {
-				int y = m_cameraSettings.roi.height_binned - floor(index / m_cameraSettings.roi.width_binned);
-				int x = index % m_cameraSettings.roi.width_binned;
-
-				POINT2 pos = (*m_ODTControl)->pixToMicroMeter({ (double)x, (double)y });
-
-				Ux_valid.push_back(m_acqSettings.voltages[i + chunkBegin].Ux);
-				Uy_valid.push_back(m_acqSettings.voltages[i + chunkBegin].Uy);
-				x_valid.push_back(pos.x);
-				y_valid.push_back(pos.y);
-			}
+			Ux_valid.push_back(m_acqSettings.voltages[i].Ux);
+			Uy_valid.push_back(m_acqSettings.voltages[i].Uy);
+			x_valid.push_back(pos.x);
+			y_valid.push_back(pos.y);
 		}
-
-		(*m_camera)->stopAcquisition();
 	}
 
 	// Construct spatial calibration object
@@ -7,6 +7,8 @@
 
 #include "AcquisitionMode.h"
 #include "VoltageCalibrationHelper.h"
+#include "VoltageCalibrationRunner.h"
+#include "../../spotDetection.h"
 #include "../../Devices/Cameras/Camera.h"
 #include "../../Devices/ScanControls/ODTControl.h"
 
@@ -18,6 +20,7 @@ struct CALIBRATION_SETTINGS {
 	double Uy_max{ 0.17 };			// [V]	maximum voltage for y-direction
 	int Uy_steps{ 20 };				// [1]	number of steps in x-direction
 	std::vector<VOLTAGE2> voltages;	// [V]	voltages to apply
+	SPOT_SETTINGS spot;				// how the laser spot is located in the images
 };
 
 class VoltageCalibration : public AcquisitionMode {
@@ -31,6 +34,7 @@ public slots:
 	void startRepetitions() override;
 
 	void setCameraSetting(CAMERA_SETTING, double);
+	void setSpotSettings(SPOT_SETTINGS settings);
 	void load(std::string filepath);
 
 private:
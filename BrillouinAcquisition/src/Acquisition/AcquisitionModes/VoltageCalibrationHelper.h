@@ -32,22 +32,25 @@ public:
 		if (calibration->positions.x.size() == 0) {
 			return;
 		}
-		Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> x = Eigen::Map<Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>>(&calibration->positions.x[0], calibration->positions.x.size(), 1);
-		Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> y = Eigen::Map<Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>>(&calibration->positions.y[0], calibration->positions.y.size(), 1);
-		Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> Ux = Eigen::Map<Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>>(&calibration->voltages.Ux[0], calibration->voltages.Ux.size(), 1);
-		Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> Uy = Eigen::Map<Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>>(&calibration->voltages.Uy[0], calibration->voltages.Uy.size(), 1);
+		const auto& x = calibration->positions.x;
+		const auto& y = calibration->positions.y;
+		const auto& Ux = calibration->voltages.Ux;
+		const auto& Uy = calibration->voltages.Uy;
 
 		/*
-		 * Calculate the position weights
+		 * Calculate the position weights,
+		 * both share the factorization of the positions' Green's matrix
 		 */
-		calibration->positions_weights.x = interpolation::biharmonic_spline_calculate_weights(x, y, Ux);
-		calibration->positions_weights.y = interpolation::biharmonic_spline_calculate_weights(x, y, Uy);
+		auto positions = BiharmonicSplineFitter<double>{ x, y };
+		calibration->positions_weights.x = positions.fit(Ux);
+		calibration->positions_weights.y = positions.fit(Uy);
 
 		/*
 		 * Calculate the voltage weights
 		 */
-		calibration->voltages_weights.x = interpolation::biharmonic_spline_calculate_weights(Ux, Uy, x);
-		calibration->voltages_weights.y = interpolation::biharmonic_spline_calculate_weights(Ux, Uy, y);
+		auto voltages = BiharmonicSplineFitter<double>{ Ux, Uy };
+		calibration->voltages_weights.x = voltages.fit(x);
+		calibration->voltages_weights.y = voltages.fit(y);
 	}
 
 
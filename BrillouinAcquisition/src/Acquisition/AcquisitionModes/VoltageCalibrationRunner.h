@@ -0,0 +1,132 @@
+#ifndef VOLTAGECALIBRATIONRUNNER_H
+#define VOLTAGECALIBRATIONRUNNER_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../../Devices/Cameras/Camera.h"
+#include "../../Devices/ScanControls/ODTControl.h"
+
+struct CALIBRATION_CHUNK {
+	gsl::index begin{ 0 };		// [1]	index of the first voltage of the chunk
+	gsl::index end{ 0 };		// [1]	index behind the last voltage of the chunk
+	ACQ_VOLTAGES voltages;		// [V]	mirror waveform and camera trigger of the chunk
+};
+
+/*
+ * Acquires one camera image per mirror voltage.
+ *
+ * The voltages are split into chunks, whose waveforms are all calculated before the
+ * acquisition starts. The camera stays armed across the chunks, unless it can only take
+ * a limited number of images per acquisition. Then the chunks are at most as large as this
+ * limit and the capture is restarted when it is reached, e.g. every 100 images for PointGrey.
+ * The images are handed to a callback which
+ * should return quickly, e.g. by pushing the processing to a PipelineStage, so that the
+ * waveform of the next chunk is loaded while the images of the previous one are processed.
+ */
+class VoltageCalibrationRunner {
+
+public:
+	VoltageCalibrationRunner(Camera* camera, ODTControl* ODTControl) : m_camera(camera), m_ODTControl(ODTControl) {};
+
+	void setChunkSize(int chunkSize) {
+		m_chunkSize = std::max(1, chunkSize);
+	}
+
+	void setSettleTime(int settleTime) {
+		m_settleTime = std::max(0, settleTime);
+	}
+
+	/*
+	 * Mirror voltages and camera triggers for the voltages [begin, end)
+	 */
+	static ACQ_VOLTAGES createAcquisitionVoltages(const std::vector<VOLTAGE2>& voltages, gsl::index begin, gsl::index end) {
+		ACQ_VOLTAGES acqVoltages;
+
+		// Construct the analog voltage vector and the trigger vector
+		int numberChannels{ 2 };
+		auto count = end - begin;
+		acqVoltages.numberSamples = (int)(count * samplesPerVoltage);
+		acqVoltages.trigger = std::vector<uInt8>(acqVoltages.numberSamples, 0);
+		acqVoltages.mirror = std::vector<float64>((size_t)acqVoltages.numberSamples * numberChannels, 0);
+		for (gsl::index i{ 0 }; i < count; i++) {
+			acqVoltages.trigger[i * samplesPerVoltage + 2] = 1;
+			acqVoltages.trigger[i * samplesPerVoltage + 3] = 1;
+			std::fill_n(acqVoltages.mirror.begin() + i * samplesPerVoltage, samplesPerVoltage, voltages[i + begin].Ux);
+			std::fill_n(acqVoltages.mirror.begin() + i * samplesPerVoltage + (size_t)count * samplesPerVoltage, samplesPerVoltage, voltages[i + begin].Uy);
+		}
+		return acqVoltages;
+	}
+
+	static std::vector<CALIBRATION_CHUNK> createChunks(const std::vector<VOLTAGE2>& voltages, int chunkSize) {
+		auto chunks = std::vector<CALIBRATION_CHUNK>{};
+		for (gsl::index begin{ 0 }; begin < (gsl::index)voltages.size(); begin += chunkSize) {
+			auto end = std::min(begin + chunkSize, (gsl::index)voltages.size());
+			chunks.push_back({ begin, end, createAcquisitionVoltages(voltages, begin, end) });
+		}
+		return chunks;
+	}
+
+	/*
+	 * Calls handleImage(index, image) for every voltage, returns false if the acquisition was aborted
+	 */
+	bool run(const CAMERA_SETTINGS& settings, const std::vector<VOLTAGE2>& voltages,
+		const std::function<void(gsl::index, std::vector<std::byte>)>& handleImage, const bool& abort) {
+		if (voltages.empty()) {
+			return true;
+		}
+		auto chunkSize = m_chunkSize;
+		auto maximumImages = m_camera->getMaximumAcquisitionImages();
+		if (maximumImages > 0) {
+			chunkSize = std::min(chunkSize, maximumImages);
+		}
+		auto chunks = createChunks(voltages, chunkSize);
+
+		// The mirror only has to settle before the first chunk,
+		// it stays at the last voltage of a chunk until the next one starts.
+		m_ODTControl->setVoltage(voltages[0]);
+		auto settled = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_settleTime);
+		m_camera->startAcquisition(settings);
+		std::this_thread::sleep_until(settled);
+
+		auto imagesAcquired{ 0 };
+		for (auto& chunk : chunks) {
+			auto count = (int)(chunk.end - chunk.begin);
+			if (maximumImages > 0 && imagesAcquired + count > maximumImages) {
+				m_camera->restartAcquisition(settings);
+				imagesAcquired = 0;
+			}
+			// Apply voltages to NIDAQ board
+			m_ODTControl->setAcquisitionVoltages(std::move(chunk.voltages));
+
+			for (gsl::index i{ chunk.begin }; i < chunk.end; i++) {
+				if (abort) {
+					m_camera->stopAcquisition();
+					return false;
+				}
+				auto image = std::vector<std::byte>(settings.roi.bytesPerFrame);
+				m_camera->getImageForAcquisition(&image[0], false);
+				handleImage(i, std::move(image));
+			}
+			imagesAcquired += count;
+		}
+		m_camera->stopAcquisition();
+		return true;
+	}
+
+	static constexpr int samplesPerVoltage{ 10 };	// [1]	waveform samples per voltage, the camera is triggered at the third
+
+private:
+	Camera* m_camera{ nullptr };
+	ODTControl* m_ODTControl{ nullptr };
+
+	int m_chunkSize{ 100 };		// [1]	maximum number of voltages per waveform
+	int m_settleTime{ 100 };	// [ms]	time the mirror needs to settle at the first voltage
+};
+
+#endif // VOLTAGECALIBRATIONRUNNER_H
@@ -59,6 +59,14 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 		[this](std::string filename) { updateFilename(filename); }
 	);
 
+	// slot to show the write queue of the storage
+	connection = QWidget::connect(
+		m_acquisition,
+		&Acquisition::s_storageStatisticsChanged,
+		this,
+		[this](STORAGE_STATISTICS statistics) { showStorageStatistics(statistics); }
+	);
+
 	// slot to show current acquisition progress
 	connection = QWidget::connect(
 		m_acquisition,
@@ -131,6 +139,22 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 		[this](std::vector<POINT3> orderedPositions) { AOI_changed(orderedPositions); }
 	);
 
+	// slot to show the estimated duration of the scan
+	connection = QWidget::connect(
+		m_Brillouin,
+		&Brillouin::s_scanPathCostChanged,
+		this,
+		[this](SCAN_PATH_COST cost) { showScanPathCost(cost); }
+	);
+
+	// slot to show the Brillouin shift evaluated during the scan
+	connection = QWidget::connect(
+		m_Brillouin,
+		&Brillouin::s_shiftMeasured,
+		this,
+		[this](BRILLOUIN_SHIFT shift) { showBrillouinShift(shift); }
+	);
+
 	m_Brillouin->determineScanOrder();
 
 	qRegisterMetaType<std::string>("std::string");
@@ -174,14 +198,19 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 	qRegisterMetaType<FLUORESCENCE_SETTINGS>("FLUORESCENCE_SETTINGS");
 	qRegisterMetaType<FLUORESCENCE_MODE>("FLUORESCENCE_MODE");
 	qRegisterMetaType<PLOT_SETTINGS*>("PLOT_SETTINGS*");
+	qRegisterMetaType<PREVIEW_IMAGE>("PREVIEW_IMAGE");
+	qRegisterMetaType<PREVIEW_STATISTICS>("PREVIEW_STATISTICS");
 	qRegisterMetaType<PreviewBuffer<unsigned short>*>("PreviewBuffer<unsigned short>*");
 	qRegisterMetaType<PreviewBuffer<unsigned char>*>("PreviewBuffer<unsigned char>*");
 	qRegisterMetaType<unsigned char*>("unsigned char*");
 	qRegisterMetaType<unsigned short*>("unsigned short*");
 	qRegisterMetaType<bool*>("bool*");
 	qRegisterMetaType<VoltageCalibrationData>("VoltageCalibrationData");
+	qRegisterMetaType<STORAGE_STATISTICS>("STORAGE_STATISTICS");
+	qRegisterMetaType<BRILLOUIN_SHIFT>("BRILLOUIN_SHIFT");
 	qRegisterMetaType<ScaleCalibrationData>("ScaleCalibrationData");
 	qRegisterMetaType<SCAN_ORDER>("SCAN_ORDER");
+	qRegisterMetaType<SCAN_PATH_COST>("SCAN_PATH_COST");
 	
 	// Set up icons
 	m_icons.disconnected.addFile(":/BrillouinAcquisition/assets/00disconnected10px.png", QSize(10, 10));
@@ -250,35 +279,18 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 	ui->actionEnable_Cooling->setEnabled(false);
 	ui->autoscalePlot->setChecked(m_BrillouinPlot.autoscale);
 
-	connection = QWidget::connect<void(converter::*)(PLOT_SETTINGS*, long long, long long, std::vector<unsigned char>)>(
-		m_converter,
-		&converter::s_converted,
-		this,
-		[this](PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned char> unpackedBuffer) { plot(plotSettings, dim_x, dim_y, unpackedBuffer); }
-	);
-	connection = QWidget::connect<void(converter::*)(PLOT_SETTINGS*, long long, long long, std::vector<unsigned short>)>(
-		m_converter,
-		&converter::s_converted,
-		this,
-		[this](PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned short> unpackedBuffer) { plot(plotSettings, dim_x, dim_y, unpackedBuffer); }
-	);
-	connection = QWidget::connect<void(converter::*)(PLOT_SETTINGS*, long long, long long, std::vector<double>)>(
-		m_converter,
-		&converter::s_converted,
-		this,
-		[this](PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<double> unpackedBuffer) { plot(plotSettings, dim_x, dim_y, unpackedBuffer); }
-	);
-	connection = QWidget::connect<void(converter::*)(PLOT_SETTINGS*, long long, long long, std::vector<float>)>(
+	connection = QWidget::connect(
 		m_converter,
-		&converter::s_converted,
+		&converter::s_rendered,
 		this,
-		[this](PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<float> unpackedBuffer) { plot(plotSettings, dim_x, dim_y, unpackedBuffer); }
+		[this](PLOT_SETTINGS* plotSettings, PREVIEW_IMAGE image) { plot(plotSettings, image); }
 	);
-	connection = QWidget::connect<void(converter::*)(PLOT_SETTINGS*, long long, long long, std::vector<int>)>(
+
+	connection = QWidget::connect(
 		m_converter,
-		&converter::s_converted,
+		&converter::s_previewStatistics,
 		this,
-		[this](PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<int> unpackedBuffer) { plot(plotSettings, dim_x, dim_y, unpackedBuffer); }
+		[this](PLOT_SETTINGS* plotSettings, PREVIEW_STATISTICS statistics) { showPreviewStatistics(plotSettings, statistics); }
 	);
 
 	// start acquisition thread
@@ -291,7 +303,7 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 	// set up the QCPColorMap:
 	m_BrillouinPlot = {
 		ui->customplot,
-		new QCPColorMap(ui->customplot->xAxis, ui->customplot->yAxis),
+		new PreviewColorMap(ui->customplot->xAxis, ui->customplot->yAxis),
 		{ 100, 300 },
 		ui->rangeLower,
 		ui->rangeUpper,
@@ -304,7 +316,7 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 
 	m_ODTPlot = {
 		ui->customplot_brightfield,
-		new QCPColorMap(ui->customplot_brightfield->xAxis, ui->customplot_brightfield->yAxis),
+		new PreviewColorMap(ui->customplot_brightfield->xAxis, ui->customplot_brightfield->yAxis),
 		{ 0, 100 },
 		ui->rangeLowerODT,
 		ui->rangeUpperODT,
@@ -315,6 +327,23 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 		CustomGradientPreset::gpGrayscale
 	};
 
+	// the frames are rendered to images on the plotting thread
+	m_BrillouinPlot.renderer = new ColormapRenderer();
+	m_ODTPlot.renderer = new ColormapRenderer();
+	// only the latest frame is converted, at most with the preview rate
+	m_BrillouinPlot.scheduler = new PreviewScheduler(m_previewRate);
+	m_ODTPlot.scheduler = new PreviewScheduler(m_previewRate);
+	m_BrillouinPlot.statisticsLabel = new QLabel();
+	m_ODTPlot.statisticsLabel = new QLabel();
+	ui->statusBar->addPermanentWidget(m_BrillouinPlot.statisticsLabel);
+	ui->statusBar->addPermanentWidget(m_ODTPlot.statisticsLabel);
+	m_shiftLabel = new QLabel();
+	ui->statusBar->addPermanentWidget(m_shiftLabel);
+	m_scanPathLabel = new QLabel();
+	ui->statusBar->addPermanentWidget(m_scanPathLabel);
+	m_storageLabel = new QLabel();
+	ui->statusBar->addPermanentWidget(m_storageLabel);
+
 	// set up the camera image plot
 	BrillouinAcquisition::initializePlot(m_BrillouinPlot);
 	BrillouinAcquisition::initializePlot(m_ODTPlot);
@@ -331,6 +360,7 @@ BrillouinAcquisition::BrillouinAcquisition(QWidget *parent) noexcept :
 
 	// First read device settings then init devices
 	readSettings();
+	updateStorageSettings();
 	initCameraBrillouin();
 	initScanControl();
 	initCamera();
@@ -424,6 +454,10 @@ BrillouinAcquisition::~BrillouinAcquisition() {
 	m_acquisitionThread.wait();
 	m_plottingThread.exit();
 	m_plottingThread.wait();
+	delete m_BrillouinPlot.renderer;
+	delete m_ODTPlot.renderer;
+	delete m_BrillouinPlot.scheduler;
+	delete m_ODTPlot.scheduler;
 	qInfo(logInfo()) << "BrillouinAcquisition closed.";
 	delete ui;
 }
@@ -463,6 +497,18 @@ void BrillouinAcquisition::plotClick(QMouseEvent* event) {
 
 	auto positionInPix = POINT2{ posX, posY };
 
+	// While the scan mask is drawn, the clicks add its vertices
+	if (m_drawScanMask) {
+		auto xRange = m_ODTPlot.plotHandle->xAxis->range();
+		auto yRange = m_ODTPlot.plotHandle->yAxis->range();
+
+		if (xRange.contains(posX) && yRange.contains(posY)) {
+			m_scanMaskVertices.push_back(positionInPix);
+			update_scanMask_preview();
+		}
+		return;
+	}
+
 	// If we currently select the new focus, don't move there
 	if (m_locatePositionScanner) {
 		m_scanControl->locatePositionScanner(positionInPix);
@@ -512,12 +558,14 @@ void BrillouinAcquisition::on_autoscalePlot_stateChanged(int state) {
 	m_BrillouinPlot.autoscale = (bool)state;
 	ui->rangeLower->setDisabled(state);
 	ui->rangeUpper->setDisabled(state);
+	rerender(m_BrillouinPlot);
 }
 
 void BrillouinAcquisition::on_autoscalePlot_brightfield_stateChanged(int state) {
 	m_ODTPlot.autoscale = (bool)state;
 	ui->rangeLowerODT->setDisabled(state);
 	ui->rangeUpperODT->setDisabled(state);
+	rerender(m_ODTPlot);
 }
 
 void BrillouinAcquisition::setPreset(ScanPreset preset) {
@@ -914,6 +962,26 @@ void BrillouinAcquisition::on_camera_displayMode_currentIndexChanged(const QStri
 	applyGradient(m_ODTPlot);
 }
 
+void BrillouinAcquisition::on_camera_phaseUnwrapping_currentIndexChanged(const QString & text) {
+	auto settings = UNWRAP_SETTINGS{};
+	if (text == "Downsampled") {
+		settings.mode = UNWRAP_MODE::DOWNSAMPLED;
+	} else if (text == "Pyramid") {
+		settings.mode = UNWRAP_MODE::PYRAMID;
+	} else if (text == "Full resolution") {
+		settings.mode = UNWRAP_MODE::FULL;
+	} else {
+		settings.mode = UNWRAP_MODE::ADAPTIVE;
+	}
+	QMetaObject::invokeMethod(
+		m_converter,
+		[&m_converter = m_converter, settings]() {
+			m_converter->setUnwrapSettings(settings);
+		},
+		Qt::AutoConnection
+	);
+}
+
 void BrillouinAcquisition::on_setBackground_clicked() {
 	QMetaObject::invokeMethod(
 		m_converter,
@@ -1204,6 +1272,7 @@ void BrillouinAcquisition::showBrillouinStatus(ACQUISITION_STATUS status) {
 	ui->calibrationExposureTime->setDisabled(running);
 	ui->repetitionInterval->setDisabled(running);
 	ui->repetitionCount->setDisabled(running);
+	ui->brillouinAnalysis->setDisabled(running);
 }
 
 void BrillouinAcquisition::showBrillouinProgress(double progress, int seconds) {
@@ -1217,6 +1286,67 @@ void BrillouinAcquisition::showBrillouinProgress(double progress, int seconds) {
 	ui->progressBar->setFormat(string);
 }
 
+void BrillouinAcquisition::showBrillouinShift(BRILLOUIN_SHIFT shift) {
+	auto value = std::isnan(shift.shift)
+		? QString("%1 pix (not calibrated)").arg(shift.distance, 0, 'f', 2)
+		: QString("%1 GHz").arg(shift.shift, 0, 'f', 3);
+	m_shiftLabel->setText(QString("Brillouin shift: %1, %2 positions analyzed")
+		.arg(value)
+		.arg(shift.analyzedPositions));
+	m_shiftLabel->setToolTip(QString("Position (%1, %2, %3), peaks found in %4 images, linewidth %5 GHz, %6 positions skipped.")
+		.arg(shift.index.x)
+		.arg(shift.index.y)
+		.arg(shift.index.z)
+		.arg(shift.validFrames)
+		.arg(shift.width, 0, 'f', 3)
+		.arg(shift.skippedPositions));
+}
+
+void BrillouinAcquisition::showScanPathCost(SCAN_PATH_COST cost) {
+	m_scanPathCost = cost;
+	updateScanPathLabel();
+}
+
+void BrillouinAcquisition::updateScanPathLabel() {
+	if (!m_scanPathLabel) {
+		return;
+	}
+	// the calibrations are not included
+	auto acquisitionTime = m_scanPathCost.positions * m_BrillouinSettings.camera.frameCount * m_BrillouinSettings.camera.exposureTime;
+	auto nrGridPositions = m_BrillouinSettings.xSteps * m_BrillouinSettings.ySteps * m_BrillouinSettings.zSteps;
+	auto positions = QString::number(m_scanPathCost.positions);
+	// sparse scans skip the positions outside of the scan mask
+	if (m_scanPathCost.positions < nrGridPositions) {
+		positions = QString("%1 of %2").arg(m_scanPathCost.positions).arg(nrGridPositions);
+	}
+	m_scanPathLabel->setText(QString("Scan: %1 positions, about %2")
+		.arg(positions)
+		.arg(formatSeconds((int)round(acquisitionTime + m_scanPathCost.travelTime))));
+	m_scanPathLabel->setToolTip(QString("The stage moves %1 times over %2 mm in about %3, the camera acquires for %4.")
+		.arg(m_scanPathCost.moves)
+		.arg(1e-3 * m_scanPathCost.distance, 0, 'f', 2)
+		.arg(formatSeconds((int)round(m_scanPathCost.travelTime)))
+		.arg(formatSeconds((int)round(acquisitionTime))));
+}
+
+void BrillouinAcquisition::showStorageStatistics(STORAGE_STATISTICS statistics) {
+	if (!m_storageLabel) {
+		return;
+	}
+	m_storageLabel->setText(QString("Storage: %1 payloads written, %2 waiting")
+		.arg(statistics.writtenPayloads)
+		.arg(statistics.queueDepth));
+	m_storageLabel->setToolTip(QString("%1 MB waiting in memory, at most %2 payloads waited at once, %3 payloads spilled to disk, %4 payloads failed. Write latency %5 ms, at most %6 ms.")
+		.arg(1e-6 * statistics.queuedBytes, 0, 'f', 1)
+		.arg(statistics.maxQueueDepth)
+		.arg(statistics.spilledPayloads)
+		.arg(statistics.failedPayloads)
+		.arg(statistics.meanWriteLatency, 0, 'f', 1)
+		.arg(statistics.maxWriteLatency, 0, 'f', 1));
+	// payloads which could not be written are lost
+	m_storageLabel->setStyleSheet(statistics.failedPayloads > 0 ? "QLabel { color: red; }" : "");
+}
+
 void BrillouinAcquisition::showODTStatus(ACQUISITION_STATUS status) {
 	QString string;
 	if (status == ACQUISITION_STATUS::ABORTED) {
@@ -1421,7 +1551,7 @@ void BrillouinAcquisition::plotODTVoltage(VOLTAGE2 voltage, ODT_MODE mode) {
 	plot->replot();
 }
 
-void BrillouinAcquisition::initializePlot(PLOT_SETTINGS plotSettings) {
+void BrillouinAcquisition::initializePlot(PLOT_SETTINGS& plotSettings) {
 	// configure axis rect
 
 	plotSettings.plotHandle->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom); // this will also allow rescaling the color scale by dragging/zooming
@@ -1454,7 +1584,14 @@ void BrillouinAcquisition::initializePlot(PLOT_SETTINGS plotSettings) {
 		plotSettings.colorMap,
 		&QCPColorMap::dataRangeChanged,
 		this,
-		[this, plotSettings](QCPRange newRange) { (plotSettings.dataRangeCallback)(newRange); }
+		[this, &plotSettings](QCPRange newRange) {
+			// the color scale was dragged or zoomed, the image has to follow
+			if (newRange != plotSettings.cLim) {
+				plotSettings.cLim = newRange;
+				rerender(plotSettings);
+			}
+			(plotSettings.dataRangeCallback)(newRange);
+		}
 	);
 
 	// set the color gradient of the color map to one of the presets:
@@ -1479,10 +1616,12 @@ void BrillouinAcquisition::initializePlot(PLOT_SETTINGS plotSettings) {
 	plotSettings.plotHandle->rescaleAxes();
 }
 
-void BrillouinAcquisition::applyGradient(PLOT_SETTINGS plotSettings) {
+void BrillouinAcquisition::applyGradient(PLOT_SETTINGS& plotSettings) {
 	QCPColorGradient gradient = QCPColorGradient();
 	setColormap(&gradient, plotSettings.gradient);
 	plotSettings.colorMap->setGradient(gradient);
+	plotSettings.renderer->setPalette(PreviewColorMap::palette(gradient));
+	rerender(plotSettings);
 }
 
 void BrillouinAcquisition::initializeLaserPositionLocation() {
@@ -1554,8 +1693,9 @@ void BrillouinAcquisition::on_rangeUpperODT_valueChanged(int value) {
 	updatePlot(m_ODTPlot);
 }
 
-void BrillouinAcquisition::updatePlot(PLOT_SETTINGS plotSettings) {
+void BrillouinAcquisition::updatePlot(PLOT_SETTINGS& plotSettings) {
 	plotSettings.colorMap->setDataRange(plotSettings.cLim);
+	rerender(plotSettings);
 	plotSettings.plotHandle->replot();
 	updateCLimRange(plotSettings.lowerBox, plotSettings.upperBox, plotSettings.cLim);
 }
@@ -1838,6 +1978,10 @@ void BrillouinAcquisition::updateImageODT() {
 
 template <typename T>
 void BrillouinAcquisition::updateImage(PreviewBuffer<T>* previewBuffer, PLOT_SETTINGS *plotSettings) {
+	// a conversion is already pending, it will take the latest frame
+	if (!plotSettings->scheduler->request()) {
+		return;
+	}
 	QMetaObject::invokeMethod(
 		m_converter,
 		[&m_converter = m_converter, previewBuffer, plotSettings]() {
@@ -1847,42 +1991,38 @@ void BrillouinAcquisition::updateImage(PreviewBuffer<T>* previewBuffer, PLOT_SET
 	);
 }
 
-void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned char> unpackedBuffer) {
-	plotting(plotSettings, dim_x, dim_y, unpackedBuffer);
-}
-
-void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned short> unpackedBuffer) {
-	plotting(plotSettings, dim_x, dim_y, unpackedBuffer);
-}
-
-void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<double> unpackedBuffer) {
-	plotting(plotSettings, dim_x, dim_y, unpackedBuffer);
-}
-
-void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<float> unpackedBuffer) {
-	plotting(plotSettings, dim_x, dim_y, unpackedBuffer);
+void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, PREVIEW_IMAGE image) {
+	// the image is already rendered, only the pointer is swapped
+	plotSettings->colorMap->setImage(image.image);
+	if (plotSettings->autoscale) {
+		plotSettings->cLim = QCPRange(image.lower, image.upper);
+		plotSettings->colorMap->setDataRange(plotSettings->cLim);
+	}
+	plotSettings->plotHandle->replot();
 }
 
-void BrillouinAcquisition::plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<int> unpackedBuffer) {
-	plotting(plotSettings, dim_x, dim_y, unpackedBuffer);
+void BrillouinAcquisition::showPreviewStatistics(PLOT_SETTINGS* plotSettings, PREVIEW_STATISTICS statistics) {
+	auto name = (plotSettings == &m_BrillouinPlot) ? "Brillouin" : "ODT";
+	plotSettings->statisticsLabel->setText(QString("%1 preview: %2 of %3 Hz, %4 frames dropped")
+		.arg(name)
+		.arg(statistics.displayRate, 0, 'f', 1)
+		.arg(statistics.cameraRate, 0, 'f', 1)
+		.arg(statistics.droppedFrames));
+	plotSettings->statisticsLabel->setToolTip(QString("Shown %1 frames, the preview is updated with at most %2 Hz.")
+		.arg(statistics.displayedFrames)
+		.arg(statistics.targetRate, 0, 'f', 0));
 }
 
-template <typename T>
-void BrillouinAcquisition::plotting(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<T> unpackedBuffer) {
-	// images are given row by row, starting at the top left
-	int tIndex{ 0 };
-	for (gsl::index yIndex{ 0 }; yIndex < dim_y; ++yIndex) {
-		for (gsl::index xIndex{ 0 }; xIndex < dim_x; ++xIndex) {
-			tIndex = yIndex * dim_x + xIndex;
-			plotSettings->colorMap->data()->setCell(xIndex, dim_y - yIndex - 1, unpackedBuffer[tIndex]);
-		}
-	}
-	if (plotSettings->autoscale) {
-		plotSettings->colorMap->rescaleDataRange(true);
-		plotSettings->cLim = plotSettings->colorMap->dataRange();
-		(plotSettings->dataRangeCallback)(plotSettings->cLim);
-	}
-	plotSettings->plotHandle->replot();
+void BrillouinAcquisition::rerender(PLOT_SETTINGS& plotSettings) {
+	// the converter gets a copy, so it never reads the settings while they are changed here
+	auto settings = RENDER_SETTINGS{ plotSettings.cLim, plotSettings.autoscale, plotSettings.mode };
+	QMetaObject::invokeMethod(
+		m_converter,
+		[&m_converter = m_converter, plotSettings = &plotSettings, settings]() {
+			m_converter->rerender(plotSettings, settings);
+		},
+		Qt::QueuedConnection
+	);
 }
 
 void BrillouinAcquisition::on_actionConnect_Camera_triggered() {
@@ -2049,6 +2189,10 @@ void BrillouinAcquisition::on_camera_playPause_brightfield_clicked() {
 
 void BrillouinAcquisition::on_actionSettings_Stage_triggered() {
 	m_scanControlDropdown->setCurrentIndex((int)m_scanControllerType);
+	m_storageLayoutDropdown->setCurrentIndex((int)m_storageSettings.layout);
+	m_storageCompressionInput->setValue(m_storageSettings.compression);
+	m_storagePolicyDropdown->setCurrentIndex((int)m_storageSettings.policy);
+	m_storageQueueCapacityInput->setValue(m_storageSettings.queueCapacity);
 	m_settingsDialog->show();
 }
 
@@ -2066,6 +2210,8 @@ void BrillouinAcquisition::saveSettings() {
 		m_cameraBrillouinType = m_cameraBrillouinTypeTemporary;
 		initCameraBrillouin();
 	}
+	m_storageSettings = m_storageSettingsTemporary;
+	updateStorageSettings();
 	m_settingsDialog->hide();
 }
 
@@ -2073,6 +2219,7 @@ void BrillouinAcquisition::cancelSettings() {
 	m_scanControllerTypeTemporary = m_scanControllerType;
 	m_cameraTypeTemporary = m_cameraType;
 	m_cameraBrillouinTypeTemporary = m_cameraBrillouinType;
+	m_storageSettingsTemporary = m_storageSettings;
 	m_settingsDialog->hide();
 }
 
@@ -2195,6 +2342,102 @@ void BrillouinAcquisition::initSettingsDialog() {
 		[this](int index) { selectCameraDevice(index); }
 	);
 
+	/*
+	 * Widget for the storage settings
+	 */
+	m_storageSettingsTemporary = m_storageSettings;
+
+	QWidget* storageWidget = new QWidget();
+	storageWidget->setMinimumHeight(60);
+	storageWidget->setMinimumWidth(250);
+	QGroupBox* storageBox = new QGroupBox(storageWidget);
+	storageBox->setTitle("Storage");
+	storageBox->setMinimumHeight(50);
+	storageBox->setMinimumWidth(250);
+
+	vLayout->addWidget(storageWidget);
+
+	QHBoxLayout* storageLayout = new QHBoxLayout(storageBox);
+
+	QLabel* storageLayoutLabel = new QLabel("Brillouin payloads");
+	storageLayout->addWidget(storageLayoutLabel);
+
+	m_storageLayoutDropdown = new QComboBox();
+	m_storageLayoutDropdown->insertItem((int)STORAGE_LAYOUT::PER_POSITION, "One dataset per position");
+	m_storageLayoutDropdown->insertItem((int)STORAGE_LAYOUT::CHUNKED, "One dataset per repetition");
+	m_storageLayoutDropdown->setCurrentIndex((int)m_storageSettings.layout);
+	storageLayout->addWidget(m_storageLayoutDropdown);
+
+	QLabel* storageCompressionLabel = new QLabel("Compression");
+	storageCompressionLabel->setToolTip("Compression level of the datasets per repetition, 0 disables the compression");
+	storageLayout->addWidget(storageCompressionLabel);
+
+	m_storageCompressionInput = new QSpinBox();
+	m_storageCompressionInput->setRange(0, 9);
+	m_storageCompressionInput->setValue(m_storageSettings.compression);
+	storageLayout->addWidget(m_storageCompressionInput);
+
+	connection = QWidget::connect<void(QComboBox::*)(int)>(
+		m_storageLayoutDropdown,
+		&QComboBox::currentIndexChanged,
+		this,
+		[this](int index) { selectStorageLayout(index); }
+	);
+
+	connection = QWidget::connect<void(QSpinBox::*)(int)>(
+		m_storageCompressionInput,
+		&QSpinBox::valueChanged,
+		this,
+		[this](int level) { selectStorageCompression(level); }
+	);
+
+	/*
+	 * Widget for the write queue of the storage
+	 */
+	QWidget* queueWidget = new QWidget();
+	queueWidget->setMinimumHeight(60);
+	queueWidget->setMinimumWidth(250);
+	QGroupBox* queueBox = new QGroupBox(queueWidget);
+	queueBox->setTitle("Write queue");
+	queueBox->setMinimumHeight(50);
+	queueBox->setMinimumWidth(250);
+
+	vLayout->addWidget(queueWidget);
+
+	QHBoxLayout* queueLayout = new QHBoxLayout(queueBox);
+
+	QLabel* queueCapacityLabel = new QLabel("Capacity [MB]");
+	queueCapacityLabel->setToolTip("Image data held in memory before the queue is full");
+	queueLayout->addWidget(queueCapacityLabel);
+
+	m_storageQueueCapacityInput = new QSpinBox();
+	m_storageQueueCapacityInput->setRange(16, 65536);
+	m_storageQueueCapacityInput->setValue(m_storageSettings.queueCapacity);
+	queueLayout->addWidget(m_storageQueueCapacityInput);
+
+	QLabel* queuePolicyLabel = new QLabel("If full");
+	queueLayout->addWidget(queuePolicyLabel);
+
+	m_storagePolicyDropdown = new QComboBox();
+	m_storagePolicyDropdown->insertItem((int)BACKPRESSURE_POLICY::BLOCK, "Wait for the writer");
+	m_storagePolicyDropdown->insertItem((int)BACKPRESSURE_POLICY::SPILL, "Move to a spill file");
+	m_storagePolicyDropdown->setCurrentIndex((int)m_storageSettings.policy);
+	queueLayout->addWidget(m_storagePolicyDropdown);
+
+	connection = QWidget::connect<void(QSpinBox::*)(int)>(
+		m_storageQueueCapacityInput,
+		&QSpinBox::valueChanged,
+		this,
+		[this](int capacity) { selectStorageQueueCapacity(capacity); }
+	);
+
+	connection = QWidget::connect<void(QComboBox::*)(int)>(
+		m_storagePolicyDropdown,
+		&QComboBox::currentIndexChanged,
+		this,
+		[this](int index) { selectStoragePolicy(index); }
+	);
+
 	/*
 	 * Ok and Cancel buttons
 	 */
@@ -2246,6 +2489,29 @@ void BrillouinAcquisition::selectCameraBrillouinDevice(int index) {
 	m_cameraBrillouinTypeTemporary = (CAMERA_BRILLOUIN_DEVICE)index;
 }
 
+void BrillouinAcquisition::selectStorageLayout(int index) {
+	m_storageSettingsTemporary.layout = (STORAGE_LAYOUT)index;
+}
+
+void BrillouinAcquisition::selectStorageCompression(int level) {
+	m_storageSettingsTemporary.compression = level;
+}
+
+void BrillouinAcquisition::selectStoragePolicy(int index) {
+	m_storageSettingsTemporary.policy = (BACKPRESSURE_POLICY)index;
+}
+
+void BrillouinAcquisition::selectStorageQueueCapacity(int capacity) {
+	m_storageSettingsTemporary.queueCapacity = capacity;
+}
+
+/*
+ * Hand the storage settings to the acquisition, they apply from the next repetition on
+ */
+void BrillouinAcquisition::updateStorageSettings() {
+	m_acquisition->setStorageSettings(m_storageSettings);
+}
+
 void BrillouinAcquisition::on_action_Voltage_calibration_acquire_triggered() {
 	QMetaObject::invokeMethod(
 		m_voltageCalibration,
@@ -2262,6 +2528,47 @@ void BrillouinAcquisition::on_action_Voltage_calibration_load_triggered() {
 	m_voltageCalibration->load(m_voltageCalibrationFilePath);
 }
 
+void BrillouinAcquisition::on_action_Voltage_calibration_subtractBackground_toggled(bool subtract) {
+	m_spotSettings.subtractBackground = subtract;
+	updateSpotSettings();
+}
+
+void BrillouinAcquisition::on_action_Voltage_calibration_refinementNone_triggered() {
+	m_spotSettings.refinement = SPOT_REFINEMENT::NONE;
+	updateSpotSettings();
+}
+
+void BrillouinAcquisition::on_action_Voltage_calibration_refinementCentroid_triggered() {
+	m_spotSettings.refinement = SPOT_REFINEMENT::CENTROID;
+	updateSpotSettings();
+}
+
+void BrillouinAcquisition::on_action_Voltage_calibration_refinementGaussian_triggered() {
+	m_spotSettings.refinement = SPOT_REFINEMENT::GAUSSIAN;
+	updateSpotSettings();
+}
+
+/*
+ * Show the spot detection settings in the menu and hand them to the voltage calibration
+ */
+void BrillouinAcquisition::updateSpotSettings() {
+	ui->action_Voltage_calibration_subtractBackground->setChecked(m_spotSettings.subtractBackground);
+	ui->action_Voltage_calibration_refinementNone->setChecked(m_spotSettings.refinement == SPOT_REFINEMENT::NONE);
+	ui->action_Voltage_calibration_refinementCentroid->setChecked(m_spotSettings.refinement == SPOT_REFINEMENT::CENTROID);
+	ui->action_Voltage_calibration_refinementGaussian->setChecked(m_spotSettings.refinement == SPOT_REFINEMENT::GAUSSIAN);
+
+	if (!m_voltageCalibration) {
+		return;
+	}
+	QMetaObject::invokeMethod(
+		m_voltageCalibration,
+		[voltageCalibration = m_voltageCalibration, settings = m_spotSettings]() {
+			voltageCalibration->setSpotSettings(settings);
+		},
+		Qt::AutoConnection
+	);
+}
+
 void BrillouinAcquisition::on_action_Scale_calibration_acquire_triggered() {
 	if (!m_scaleCalibrationDialog) {
 		m_scaleCalibrationDialog = new QDialog(this, Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
@@ -2715,6 +3022,11 @@ void BrillouinAcquisition::initScanControl() {
 		case ScanControl::SCAN_DEVICE::ZEISSMTBERLANGEN:
 			m_scanControl = new ZeissMTB_Erlangen();
 			break;
+#ifdef _DEBUG
+		case ScanControl::SCAN_DEVICE::MOCK:
+			m_scanControl = new MockScanControl();
+			break;
+#endif
 		default:
 			m_scanControl = new ZeissECU();
 			break;
@@ -2902,6 +3214,7 @@ void BrillouinAcquisition::initVoltageCalibration() {
 		// start Calibration thread
 		m_acquisitionThread.startWorker(m_voltageCalibration);
 	}
+	updateSpotSettings();
 }
 
 void BrillouinAcquisition::initScaleCalibration() {
@@ -3391,6 +3704,9 @@ void BrillouinAcquisition::updateBrillouinSettings() {
 	ui->stepsX->setValue(m_BrillouinSettings.xSteps);
 	ui->stepsY->setValue(m_BrillouinSettings.ySteps);
 	ui->stepsZ->setValue(m_BrillouinSettings.zSteps);
+	ui->serpentineScan->setChecked(m_BrillouinSettings.path.pattern == SCAN_PATTERN::SERPENTINE);
+	ui->unidirectionalApproach->setChecked(m_BrillouinSettings.path.unidirectionalApproach);
+	ui->sparseScan->setChecked(m_BrillouinSettings.sparseScan);
 
 	// calibration settings
 	ui->preCalibration->setChecked(m_BrillouinSettings.preCalibration);
@@ -3405,6 +3721,16 @@ void BrillouinAcquisition::updateBrillouinSettings() {
 	ui->repetitionCount->setValue(m_BrillouinSettings.repetitions.count);
 	ui->repetitionInterval->setValue(m_BrillouinSettings.repetitions.interval);
 	ui->repetitionNewFile->setChecked(m_BrillouinSettings.repetitions.filePerRepetition);
+
+	// evaluation settings
+	ui->analysisEnabled->setChecked(m_BrillouinSettings.analysis.enabled);
+	ui->analysisStartX->setValue(m_BrillouinSettings.analysis.startX);
+	ui->analysisStartY->setValue(m_BrillouinSettings.analysis.startY);
+	ui->analysisEndX->setValue(m_BrillouinSettings.analysis.endX);
+	ui->analysisEndY->setValue(m_BrillouinSettings.analysis.endY);
+	ui->analysisLineWidth->setValue(m_BrillouinSettings.analysis.lineWidth);
+	ui->analysisFitRadius->setValue(m_BrillouinSettings.analysis.fitRadius);
+	ui->analysisRayleighExclusion->setValue(m_BrillouinSettings.analysis.rayleighExclusion);
 }
 
 void BrillouinAcquisition::on_startX_valueChanged(double value) {
@@ -3575,6 +3901,42 @@ void BrillouinAcquisition::showRepProgress(int repNumber, int timeToNext) {
 	ui->repetitionProgress->setFormat(string);
 }
 
+/*
+ * Functions regarding the evaluation during the scan.
+ */
+
+void BrillouinAcquisition::on_analysisEnabled_stateChanged(int enabled) {
+	m_BrillouinSettings.analysis.enabled = (bool)enabled;
+}
+
+void BrillouinAcquisition::on_analysisStartX_valueChanged(double value) {
+	m_BrillouinSettings.analysis.startX = value;
+}
+
+void BrillouinAcquisition::on_analysisStartY_valueChanged(double value) {
+	m_BrillouinSettings.analysis.startY = value;
+}
+
+void BrillouinAcquisition::on_analysisEndX_valueChanged(double value) {
+	m_BrillouinSettings.analysis.endX = value;
+}
+
+void BrillouinAcquisition::on_analysisEndY_valueChanged(double value) {
+	m_BrillouinSettings.analysis.endY = value;
+}
+
+void BrillouinAcquisition::on_analysisLineWidth_valueChanged(int value) {
+	m_BrillouinSettings.analysis.lineWidth = value;
+}
+
+void BrillouinAcquisition::on_analysisFitRadius_valueChanged(int value) {
+	m_BrillouinSettings.analysis.fitRadius = value;
+}
+
+void BrillouinAcquisition::on_analysisRayleighExclusion_valueChanged(int value) {
+	m_BrillouinSettings.analysis.rayleighExclusion = value;
+}
+
 void BrillouinAcquisition::on_savePosition_clicked() {
 	QMetaObject::invokeMethod(
 		m_scanControl,
@@ -3709,12 +4071,136 @@ void BrillouinAcquisition::scanOrderChanged(SCAN_ORDER scanOrder) {
 	ui->scanDirZ2->setDisabled(scanOrder.automatical);
 }
 
+void BrillouinAcquisition::on_serpentineScan_stateChanged(int serpentine) {
+	m_BrillouinSettings.path.pattern = serpentine ? SCAN_PATTERN::SERPENTINE : SCAN_PATTERN::RASTER;
+	m_Brillouin->setScanPattern(m_BrillouinSettings.path.pattern);
+}
+
+void BrillouinAcquisition::on_unidirectionalApproach_stateChanged(int unidirectional) {
+	m_BrillouinSettings.path.unidirectionalApproach = (bool)unidirectional;
+	m_Brillouin->setUnidirectionalApproach((bool)unidirectional);
+}
+
+/*
+ *	Scan mask for sparse scans
+ */
+
+void BrillouinAcquisition::on_sparseScan_stateChanged(int sparse) {
+	m_BrillouinSettings.sparseScan = (bool)sparse;
+	m_Brillouin->setSparseScan((bool)sparse);
+}
+
+void BrillouinAcquisition::on_drawScanMask_toggled(bool draw) {
+	m_drawScanMask = draw;
+	if (draw) {
+		m_scanMaskVertices.clear();
+		update_scanMask_preview();
+		return;
+	}
+	// The mask is applied when the drawing is finished
+	if (m_scanMaskVertices.size() < 3) {
+		return;
+	}
+	auto mask = createScanMask();
+	ScanMask::fillPolygon(mask, m_scanMaskVertices);
+	m_Brillouin->setScanMask(mask);
+}
+
+void BrillouinAcquisition::on_thresholdScanMask_clicked() {
+	auto dim_x{ 0 };
+	auto dim_y{ 0 };
+	auto frame = m_ODTPlot.renderer->lastFrame(&dim_x, &dim_y);
+
+	auto mask = createScanMask();
+	if (frame.empty() || dim_x != mask.width || dim_y != mask.height) {
+		qWarning(logWarning()) << "There is no brightfield or ODT image to create the scan mask from.";
+		return;
+	}
+	// The mask follows the image as it is shown, e.g. the phase in ODT mode
+	ScanMask::threshold(mask, frame.data());
+
+	ui->drawScanMask->setChecked(false);
+	m_scanMaskVertices.clear();
+	update_scanMask_preview();
+	m_Brillouin->setScanMask(mask);
+}
+
+void BrillouinAcquisition::on_clearScanMask_clicked() {
+	ui->drawScanMask->setChecked(false);
+	m_scanMaskVertices.clear();
+	update_scanMask_preview();
+	m_Brillouin->setScanMask(SCAN_MASK{});
+}
+
+/*
+ * Empty mask covering the brightfield image, with the conversion of the positions to pixels as they are shown
+ */
+SCAN_MASK BrillouinAcquisition::createScanMask() {
+	auto mask = SCAN_MASK{};
+	auto data = m_ODTPlot.colorMap->data();
+	mask.width = data->keySize();
+	mask.height = data->valueSize();
+	// the first row of the image is the top of the map
+	mask.first = POINT2{ data->keyRange().lower, data->valueRange().upper };
+	mask.last = POINT2{ data->keyRange().upper, data->valueRange().lower };
+	mask.pixels.assign((size_t)mask.width * mask.height, 0);
+
+	// During the preview the positions are shown relative to the scanner position.
+	// The position last announced by the scan control is used, the device must not be queried from the GUI thread.
+	auto scaleCalibration = m_scanControl->getScaleCalibration();
+	mask.micrometerToPixX = scaleCalibration.micrometerToPixX;
+	mask.micrometerToPixY = scaleCalibration.micrometerToPixY;
+	mask.originPix = m_positionScanner;
+	return mask;
+}
+
+/*
+ * Update the outline of the scan mask drawn on the brightfield preview
+ */
+void BrillouinAcquisition::update_scanMask_preview() {
+	if (m_scanMaskVertices.empty()) {
+		if (m_scanMaskMarker && ui->customplot_brightfield->removePlottable(m_scanMaskMarker)) {
+			m_scanMaskMarker = nullptr;
+			ui->customplot_brightfield->replot();
+		}
+		return;
+	}
+	// The outline is closed
+	QVector<double> xPos(m_scanMaskVertices.size() + 1);
+	QVector<double> yPos(m_scanMaskVertices.size() + 1);
+	int index{ 0 };
+	for (auto const& vertex : m_scanMaskVertices) {
+		xPos[index] = vertex.x;
+		yPos[index] = vertex.y;
+		++index;
+	}
+	xPos[index] = m_scanMaskVertices.front().x;
+	yPos[index] = m_scanMaskVertices.front().y;
+
+	if (!m_scanMaskMarker) {
+		m_scanMaskMarker = new QCPCurve(ui->customplot_brightfield->xAxis, ui->customplot_brightfield->yAxis);
+		QPen pen;
+		pen.setColor(Qt::yellow);
+		pen.setWidth(2);
+		m_scanMaskMarker->setPen(pen);
+		QCPScatterStyle scatterStyle;
+		scatterStyle.setShape(QCPScatterStyle::ssCircle);
+		scatterStyle.setPen(pen);
+		scatterStyle.setSize(6);
+		m_scanMaskMarker->setScatterStyle(scatterStyle);
+	}
+	m_scanMaskMarker->setData(xPos, yPos);
+	ui->customplot_brightfield->replot();
+}
+
 void BrillouinAcquisition::on_exposureTime_valueChanged(double value) {
 	m_BrillouinSettings.camera.exposureTime = value;
+	updateScanPathLabel();
 }
 
 void BrillouinAcquisition::on_frameCount_valueChanged(int value) {
 	m_BrillouinSettings.camera.frameCount = value;
+	updateScanPathLabel();
 }
 
 StoragePath BrillouinAcquisition::splitFilePath(QString fullPath) {
@@ -3885,6 +4371,11 @@ void BrillouinAcquisition::writeSettings() {
 		case ScanControl::SCAN_DEVICE::ZEISSMTBERLANGEN:
 			stage = "zeiss-mtb-erlangen";
 			break;
+#ifdef _DEBUG
+		case ScanControl::SCAN_DEVICE::MOCK:
+			stage = "mock";
+			break;
+#endif
 		default:
 			stage = "zeiss-ecu";
 			break;
@@ -3898,6 +4389,33 @@ void BrillouinAcquisition::writeSettings() {
 	settings.beginGroup("scale-calibration");
 	settings.setValue("file-path", QString::fromStdString(m_scaleCalibrationFilePath));
 	settings.endGroup();
+	settings.beginGroup("voltage-calibration");
+	settings.setValue("subtract-background", m_spotSettings.subtractBackground);
+	settings.setValue("spot-refinement", (int)m_spotSettings.refinement);
+	settings.setValue("spot-radius", m_spotSettings.radius);
+	settings.endGroup();
+	settings.beginGroup("brillouin-analysis");
+	settings.setValue("enabled", m_BrillouinSettings.analysis.enabled);
+	settings.setValue("start-x", m_BrillouinSettings.analysis.startX);
+	settings.setValue("start-y", m_BrillouinSettings.analysis.startY);
+	settings.setValue("end-x", m_BrillouinSettings.analysis.endX);
+	settings.setValue("end-y", m_BrillouinSettings.analysis.endY);
+	settings.setValue("line-width", m_BrillouinSettings.analysis.lineWidth);
+	settings.setValue("fit-radius", m_BrillouinSettings.analysis.fitRadius);
+	settings.setValue("rayleigh-exclusion", m_BrillouinSettings.analysis.rayleighExclusion);
+	settings.endGroup();
+	settings.beginGroup("scan-path");
+	settings.setValue("serpentine", m_BrillouinSettings.path.pattern == SCAN_PATTERN::SERPENTINE);
+	settings.setValue("unidirectional-approach", m_BrillouinSettings.path.unidirectionalApproach);
+	settings.setValue("hysteresis-compensation", m_BrillouinSettings.path.hysteresisCompensation);
+	settings.setValue("sparse-scan", m_BrillouinSettings.sparseScan);
+	settings.endGroup();
+	settings.beginGroup("storage");
+	settings.setValue("layout", m_storageSettings.layout == STORAGE_LAYOUT::CHUNKED ? "chunked" : "per-position");
+	settings.setValue("compression", m_storageSettings.compression);
+	settings.setValue("policy", m_storageSettings.policy == BACKPRESSURE_POLICY::SPILL ? "spill" : "block");
+	settings.setValue("queue-capacity", m_storageSettings.queueCapacity);
+	settings.endGroup();
 }
 
 void BrillouinAcquisition::readSettings() {
@@ -3948,7 +4466,13 @@ void BrillouinAcquisition::readSettings() {
 		m_scanControllerType = ScanControl::SCAN_DEVICE::ZEISSMTB;
 	} else if (stage == "zeiss-mtb-erlangen") {
 		m_scanControllerType = ScanControl::SCAN_DEVICE::ZEISSMTBERLANGEN;
-	} else {
+	}
+#ifdef _DEBUG
+	else if (stage == "mock") {
+		m_scanControllerType = ScanControl::SCAN_DEVICE::MOCK;
+	}
+#endif
+	else {
 		m_scanControllerType = ScanControl::SCAN_DEVICE::ZEISSECU;
 	}
 
@@ -3958,4 +4482,44 @@ void BrillouinAcquisition::readSettings() {
 	QVariant filePath = settings.value("file-path");
 	m_scaleCalibrationFilePath = filePath.toString().toStdString();
 	settings.endGroup();
+
+	settings.beginGroup("voltage-calibration");
+	m_spotSettings.subtractBackground = settings.value("subtract-background", m_spotSettings.subtractBackground).toBool();
+	auto refinement = settings.value("spot-refinement", (int)m_spotSettings.refinement).toInt();
+	if (refinement >= (int)SPOT_REFINEMENT::NONE && refinement <= (int)SPOT_REFINEMENT::GAUSSIAN) {
+		m_spotSettings.refinement = (SPOT_REFINEMENT)refinement;
+	}
+	m_spotSettings.radius = settings.value("spot-radius", m_spotSettings.radius).toInt();
+	settings.endGroup();
+
+	// the line the spectrum is read along, the middle row of the image if not set
+	auto& analysis = m_BrillouinSettings.analysis;
+	settings.beginGroup("brillouin-analysis");
+	analysis.enabled = settings.value("enabled", analysis.enabled).toBool();
+	analysis.startX = settings.value("start-x", analysis.startX).toDouble();
+	analysis.startY = settings.value("start-y", analysis.startY).toDouble();
+	analysis.endX = settings.value("end-x", analysis.endX).toDouble();
+	analysis.endY = settings.value("end-y", analysis.endY).toDouble();
+	analysis.lineWidth = settings.value("line-width", analysis.lineWidth).toInt();
+	analysis.fitRadius = settings.value("fit-radius", analysis.fitRadius).toInt();
+	analysis.rayleighExclusion = settings.value("rayleigh-exclusion", analysis.rayleighExclusion).toInt();
+	settings.endGroup();
+
+	auto& path = m_BrillouinSettings.path;
+	settings.beginGroup("scan-path");
+	auto serpentine = settings.value("serpentine", path.pattern == SCAN_PATTERN::SERPENTINE).toBool();
+	path.pattern = serpentine ? SCAN_PATTERN::SERPENTINE : SCAN_PATTERN::RASTER;
+	path.unidirectionalApproach = settings.value("unidirectional-approach", path.unidirectionalApproach).toBool();
+	path.hysteresisCompensation = settings.value("hysteresis-compensation", path.hysteresisCompensation).toDouble();
+	m_BrillouinSettings.sparseScan = settings.value("sparse-scan", m_BrillouinSettings.sparseScan).toBool();
+	settings.endGroup();
+
+	settings.beginGroup("storage");
+	auto layout = settings.value("layout");
+	m_storageSettings.layout = (layout == "chunked") ? STORAGE_LAYOUT::CHUNKED : STORAGE_LAYOUT::PER_POSITION;
+	m_storageSettings.compression = settings.value("compression", m_storageSettings.compression).toInt();
+	auto policy = settings.value("policy");
+	m_storageSettings.policy = (policy == "spill") ? BACKPRESSURE_POLICY::SPILL : BACKPRESSURE_POLICY::BLOCK;
+	m_storageSettings.queueCapacity = settings.value("queue-capacity", m_storageSettings.queueCapacity).toInt();
+	settings.endGroup();
 }
\ No newline at end of file
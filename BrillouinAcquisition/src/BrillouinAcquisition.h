@@ -18,6 +18,9 @@
 #include "Devices/ScanControls/ZeissMTB.h"
 #include "Devices/ScanControls/ZeissMTB_Erlangen.h"
 #include "Devices/ScanControls/NIDAQ.h"
+#ifdef _DEBUG
+	#include "Devices/ScanControls/MockScanControl.h"
+#endif
 
 #include "Acquisition/Acquisition.h"
 #include "external/qcustomplot/qcustomplot.h"
@@ -93,13 +96,18 @@ Q_DECLARE_METATYPE(FLUOIMAGE<unsigned short>*);
 Q_DECLARE_METATYPE(FLUORESCENCE_SETTINGS);
 Q_DECLARE_METATYPE(FLUORESCENCE_MODE);
 Q_DECLARE_METATYPE(PLOT_SETTINGS*);
+Q_DECLARE_METATYPE(PREVIEW_IMAGE);
+Q_DECLARE_METATYPE(PREVIEW_STATISTICS);
 Q_DECLARE_METATYPE(PreviewBuffer<unsigned char>*);
 Q_DECLARE_METATYPE(unsigned char*);
 Q_DECLARE_METATYPE(unsigned short*);
 Q_DECLARE_METATYPE(bool*);
 Q_DECLARE_METATYPE(VoltageCalibrationData);
+Q_DECLARE_METATYPE(STORAGE_STATISTICS);
 Q_DECLARE_METATYPE(ScaleCalibrationData);
 Q_DECLARE_METATYPE(SCAN_ORDER);
+Q_DECLARE_METATYPE(SCAN_PATH_COST);
+Q_DECLARE_METATYPE(BRILLOUIN_SHIFT);
 
 class BrillouinAcquisition : public QMainWindow {
 	Q_OBJECT
@@ -127,8 +135,8 @@ private:
 	template <typename T>
 	void updateImage(PreviewBuffer<T>* previewBuffer, PLOT_SETTINGS* plotSettings);
 
-	template<typename T>
-	void plotting(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<T> unpackedBuffer);
+	// Renders the last frame of the plot again on the plotting thread
+	void rerender(PLOT_SETTINGS& plotSettings);
 
 	Ui::BrillouinAcquisitionClass* ui;
 	ScanControl::SCAN_DEVICE m_scanControllerType = ScanControl::SCAN_DEVICE::ZEISSECU;
@@ -175,6 +183,10 @@ private:
 	std::vector<POINT2> m_positionsPixel;		// [pix]	Positions to raster
 	bool m_showPositions{ true };
 
+	bool m_drawScanMask{ false };				// clicks on the brightfield image add vertices to the scan mask
+	std::vector<POINT2> m_scanMaskVertices;		// [pix]	vertices of the scan mask drawn on the brightfield image
+	QCPCurve* m_scanMaskMarker{ nullptr };
+
 	CAMERA_DEVICE m_cameraType{ CAMERA_DEVICE::UEYE };
 	CAMERA_DEVICE m_cameraTypeTemporary = m_cameraType;
 
@@ -183,6 +195,12 @@ private:
 	QComboBox* m_scanControlDropdown;
 	QComboBox* m_cameraDropdown;
 	QComboBox* m_cameraBrillouinDropdown;
+	STORAGE_SETTINGS m_storageSettings;		// applied to the file when the next repetition starts
+	STORAGE_SETTINGS m_storageSettingsTemporary = m_storageSettings;
+	QComboBox* m_storageLayoutDropdown;
+	QSpinBox* m_storageCompressionInput;
+	QComboBox* m_storagePolicyDropdown;
+	QSpinBox* m_storageQueueCapacityInput;
 	std::string m_voltageCalibrationFilePath;
 	std::string m_scaleCalibrationFilePath;
 
@@ -207,10 +225,16 @@ private:
 	ODT* m_ODT{ nullptr };
 	Fluorescence* m_Fluorescence{ nullptr };
 	VoltageCalibration* m_voltageCalibration{ nullptr };
+	SPOT_SETTINGS m_spotSettings;	// how the voltage calibration locates the laser spot
 	ScaleCalibration* m_scaleCalibration{ nullptr };
 
 	PLOT_SETTINGS m_BrillouinPlot;
 	PLOT_SETTINGS m_ODTPlot;
+	double m_previewRate{ 30 };		// [Hz]	maximum rate the preview plots are updated with
+	QLabel* m_shiftLabel{ nullptr };	// shows the Brillouin shift of the last analyzed position
+	QLabel* m_scanPathLabel{ nullptr };	// shows the estimated duration of the Brillouin scan
+	QLabel* m_storageLabel{ nullptr };	// shows the write queue of the storage
+	SCAN_PATH_COST m_scanPathCost;
 
 	converter* m_converter = new converter();
 
@@ -254,7 +278,7 @@ private slots:
 	void on_rangeUpper_valueChanged(int);
 	void on_rangeLowerODT_valueChanged(int);
 	void on_rangeUpperODT_valueChanged(int);
-	void updatePlot(PLOT_SETTINGS plotSettings);
+	void updatePlot(PLOT_SETTINGS& plotSettings);
 	void updateCLimRange(QSpinBox*, QSpinBox*, QCPRange);
 
 	void initializeLaserPositionLocation();
@@ -285,9 +309,19 @@ private slots:
 	void selectScanningDevice(int index);
 	void selectCameraDevice(int index);
 	void selectCameraBrillouinDevice(int index);
+	void selectStorageLayout(int index);
+	void selectStorageCompression(int level);
+	void selectStoragePolicy(int index);
+	void selectStorageQueueCapacity(int capacity);
+	void updateStorageSettings();
 
 	void on_action_Voltage_calibration_acquire_triggered();
 	void on_action_Voltage_calibration_load_triggered();
+	void on_action_Voltage_calibration_subtractBackground_toggled(bool subtract);
+	void on_action_Voltage_calibration_refinementNone_triggered();
+	void on_action_Voltage_calibration_refinementCentroid_triggered();
+	void on_action_Voltage_calibration_refinementGaussian_triggered();
+	void updateSpotSettings();
 
 	void on_action_Scale_calibration_acquire_triggered();
 	void on_action_Scale_calibration_load_triggered();
@@ -325,13 +359,10 @@ private slots:
 	void updateImageBrillouin();
 	void updateImageODT();
 
-	void plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned char> unpackedBuffer);
-	void plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned short> unpackedBuffer);
-	void plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<double> unpackedBuffer);
-	void plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<float> unpackedBuffer);
-	void plot(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<int> unpackedBuffer);
+	void plot(PLOT_SETTINGS* plotSettings, PREVIEW_IMAGE image);
+	void showPreviewStatistics(PLOT_SETTINGS* plotSettings, PREVIEW_STATISTICS statistics);
 
-	void initializePlot(PLOT_SETTINGS plotSettings);
+	void initializePlot(PLOT_SETTINGS& plotSettings);
 
 	void drawPositionScannerMarker(POINT2 positionScanner);
 
@@ -393,6 +424,10 @@ private slots:
 	void showEnabledModes(ACQUISITION_MODE mode);
 	void showBrillouinStatus(ACQUISITION_STATUS state);
 	void showBrillouinProgress(double progress, int seconds);
+	void showBrillouinShift(BRILLOUIN_SHIFT shift);
+	void showScanPathCost(SCAN_PATH_COST cost);
+	void showStorageStatistics(STORAGE_STATISTICS statistics);
+	void updateScanPathLabel();
 	void showODTStatus(ACQUISITION_STATUS state);
 	void showODTProgress(double progress, int seconds);
 	void showFluorescenceStatus(ACQUISITION_STATUS state);
@@ -416,9 +451,10 @@ private slots:
 	void on_pixelEncodingODT_currentIndexChanged(const QString& text);
 
 	void on_camera_displayMode_currentIndexChanged(const QString &text);
+	void on_camera_phaseUnwrapping_currentIndexChanged(const QString &text);
 	void on_setBackground_clicked();
 
-	void applyGradient(PLOT_SETTINGS plotSettings);
+	void applyGradient(PLOT_SETTINGS& plotSettings);
 
 	/*
 	 * Fluorescence slots
@@ -500,6 +536,16 @@ private slots:
 	void on_repetitionNewFile_stateChanged(int);
 	void showRepProgress(int repNumber, int timeToNext);
 
+	// evaluation during the scan
+	void on_analysisEnabled_stateChanged(int);
+	void on_analysisStartX_valueChanged(double);
+	void on_analysisStartY_valueChanged(double);
+	void on_analysisEndX_valueChanged(double);
+	void on_analysisEndY_valueChanged(double);
+	void on_analysisLineWidth_valueChanged(int);
+	void on_analysisFitRadius_valueChanged(int);
+	void on_analysisRayleighExclusion_valueChanged(int);
+
 	// manual stage control
 	void on_savePosition_clicked();
 	void on_setHome_clicked();
@@ -520,6 +566,19 @@ private slots:
 
 	void scanOrderChanged(SCAN_ORDER scanOrder);
 
+	void on_serpentineScan_stateChanged(int);
+	void on_unidirectionalApproach_stateChanged(int);
+
+	/*
+	 *	Scan mask for sparse scans
+	 */
+	void on_sparseScan_stateChanged(int);
+	void on_drawScanMask_toggled(bool);
+	void on_thresholdScanMask_clicked();
+	void on_clearScanMask_clicked();
+	SCAN_MASK createScanMask();
+	void update_scanMask_preview();
+
 	/*
 	 * Save and restore application settings
 	 */
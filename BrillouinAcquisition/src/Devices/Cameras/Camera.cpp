@@ -65,15 +65,16 @@ void Camera::getImageForPreview() {
 			return;
 		}
 
-		// if no image is ready return immediately
-		if (!m_previewBuffer->m_buffer->m_freeBuffers->tryAcquire()) {
+		// if the preview buffer is not set up yet return immediately
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (!slot) {
 			std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
 			QMetaObject::invokeMethod(this, [this]() { getImageForPreview(); }, Qt::QueuedConnection);
 			return;
 		}
-		acquireImage(m_previewBuffer->m_buffer->getWriteBuffer());
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
+		acquireImage(slot.get());
+		slot.commit();
 		emit(s_imageReady());
 
 		QMetaObject::invokeMethod(this, [this]() { getImageForPreview(); }, Qt::QueuedConnection);
@@ -41,6 +41,20 @@ public:
 	CAMERA_OPTIONS getOptions();
 	CAMERA_SETTINGS getSettings();
 
+	// Number of images the camera can take between starting and stopping an acquisition, 0 if unlimited
+	virtual int getMaximumAcquisitionImages() { return 0; };
+
+	// Restarts a running acquisition after the maximum number of images,
+	// cameras which keep their settings only have to restart the capture
+	virtual void restartAcquisition(const CAMERA_SETTINGS& settings) {
+		stopAcquisition();
+		startAcquisition(settings);
+	};
+
+	// Changes exposure time and gain of the running acquisition, returns the number of frames
+	// to discard until the new settings apply, or -1 if the acquisition has to be restarted
+	virtual int changeExposureDuringAcquisition(double exposureTime, double gain) { return -1; };
+
 	bool m_isPreviewRunning{ false };
 	bool m_isAcquisitionRunning{ false };
 
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "MockCamera.h"
 
+#include <algorithm>
+#include <cmath>
 #include <thread>
 #include <limits>
 
@@ -13,6 +15,14 @@ MockCamera::~MockCamera() {
 	disconnectDevice();
 }
 
+int MockCamera::changeExposureDuringAcquisition(double exposureTime, double gain) {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_settings.exposureTime = exposureTime;
+	m_settings.gain = gain;
+	// the next frame is taken with the new settings
+	return 0;
+}
+
 /*
  * Public slots
  */
@@ -68,6 +78,8 @@ void MockCamera::startAcquisition(const CAMERA_SETTINGS& settings) {
 
 	emit(s_previewBufferSettingsChanged());
 
+	std::this_thread::sleep_for(std::chrono::milliseconds(m_startDelay));
+
 	m_isAcquisitionRunning = true;
 	emit(s_acquisitionRunning(m_isAcquisitionRunning));
 }
@@ -88,10 +100,13 @@ void MockCamera::getImageForAcquisition(std::byte* buffer, bool preview) {
 	acquireImage(buffer);
 
 	if (preview && buffer != nullptr) {
-		// write image to preview buffer
-		memcpy(m_previewBuffer->m_buffer->getWriteBuffer(), buffer, m_settings.roi.bytesPerFrame);
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
-		emit(s_imageReady());
+		// write image to preview buffer, it replaces a frame the preview did not show yet
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (slot) {
+			memcpy(slot.get(), buffer, m_settings.roi.bytesPerFrame);
+			slot.commit();
+			emit(s_imageReady());
+		}
 	}
 }
 
@@ -99,10 +114,44 @@ void MockCamera::setCalibrationExposureTime(double exposureTime) {
 	m_settings.exposureTime = exposureTime;
 }
 
+void MockCamera::setImageType(MOCK_IMAGE_TYPE imageType) {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_imageType = imageType;
+	prepareImage();
+}
+
+void MockCamera::setSeed(unsigned int seed) {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_seed = seed;
+	m_frameNumber = 0;
+}
+
+void MockCamera::setMaxRate(bool maxRate) {
+	m_maxRate = maxRate;
+}
+
+void MockCamera::setStartDelay(int startDelay) {
+	m_startDelay = std::max(0, startDelay);
+}
+
 /*
  * Private definitions
  */
 
+/*
+ * Counter based random numbers: the hash of a key and a counter, so that every pixel
+ * can be computed independently (and vectorized) and a frame is reproducible from the seed.
+ */
+static inline unsigned int counterHash(unsigned int key, unsigned int counter) {
+	auto x = counter * 0x9E3779B9u ^ key;
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
 template <typename T>
 int MockCamera::acquireImage(std::byte* buffer) {
 
@@ -110,38 +159,35 @@ int MockCamera::acquireImage(std::byte* buffer) {
 		return 0;
 	}
 
-	auto rangeMax{ 0 };
-	if (m_settings.readout.pixelEncoding == L"16 bit") {
-		rangeMax = 65536;
-	} else if (m_settings.readout.pixelEncoding == L"12 bit") {
-		rangeMax = 4096;
-	} else if (m_settings.readout.pixelEncoding == L"8 bit") {
-		rangeMax = 255;
-	} else {
-		rangeMax = 255;
+	auto width = m_settings.roi.width_binned;
+	auto height = m_settings.roi.height_binned;
+	if ((gsl::index)m_columnProfile.size() != width || (gsl::index)m_rowOffset.size() != height) {
+		prepareImage();
 	}
 
-	// Create test image
-	auto incX{ 0.35 * rangeMax / m_options.ROIWidthLimits[1] * m_settings.roi.binX };
-	auto incY{ 0.35 * rangeMax / m_options.ROIHeightLimits[1] * m_settings.roi.binY };
-
-	auto noiseLvl{ 0.1 };
-	auto scaling{ noiseLvl * rangeMax / RAND_MAX };
-
-	auto typeSize = sizeof(T);
-	auto value = T{};
-	for (gsl::index xx{ 0 }; xx < m_settings.roi.width_binned; xx++) {
-		for (gsl::index yy{ 0 }; yy < m_settings.roi.height_binned; yy++) {
-
-			value = (T)(0.1 * rangeMax + (xx + m_settings.roi.left / m_settings.roi.binX) * incX +
-				(yy + m_settings.roi.top / m_settings.roi.binY) * incY + scaling * std::rand());
-
-			memcpy(&buffer[typeSize * (yy * m_settings.roi.width_binned + xx)], &value, typeSize);
+	auto image = reinterpret_cast<T*>(buffer);
+	auto maxValue = std::min(m_rangeMax - 1, (float)std::numeric_limits<T>::max());
+	// the upper 24 bit of the hash are mapped to [0, 1)
+	auto noiseScale = m_noiseAmplitude / 16777216.0f;
+	auto key = counterHash(m_seed, m_frameNumber++);
+	const auto* profile = m_columnProfile.data();
+
+	// Create test image row by row, the inner loop has no dependencies between pixels
+	for (gsl::index yy{ 0 }; yy < height; yy++) {
+		auto row = &image[yy * width];
+		auto offset = m_rowOffset[yy];
+		auto scale = m_rowScale[yy];
+		auto counter = (unsigned int)(yy * width);
+		for (gsl::index xx{ 0 }; xx < width; xx++) {
+			auto noise = noiseScale * (float)(counterHash(key, counter + (unsigned int)xx) >> 8);
+			row[xx] = (T)std::min(offset + scale * profile[xx] + noise, maxValue);
 		}
 	}
 
 	// Sleep for exposure time
-	std::this_thread::sleep_for(std::chrono::milliseconds((int)(1e3 * m_settings.exposureTime)));
+	if (!m_maxRate) {
+		std::this_thread::sleep_for(std::chrono::milliseconds((int)(1e3 * m_settings.exposureTime)));
+	}
 	return 1;
 }
 
@@ -223,6 +269,8 @@ void MockCamera::applySettings(const CAMERA_SETTINGS& settings) {
 		m_settings.roi.bytesPerFrame *= sizeof(unsigned char);
 	}
 
+	prepareImage();
+
 	// Read back the settings
 	readSettings();
 
@@ -247,4 +295,65 @@ void MockCamera::preparePreviewBuffer() {
 	auto bufferSettings = BUFFER_SETTINGS{ 5, (unsigned int)m_settings.roi.bytesPerFrame, m_settings.readout.dataType, m_settings.roi };
 	m_previewBuffer->initializeBuffer(bufferSettings);
 	emit(s_previewBufferSettingsChanged());
+}
+
+/*
+ * Precomputes everything of the test image which does not change between frames,
+ * so that acquiring a frame only adds noise.
+ */
+void MockCamera::prepareImage() {
+	if (m_settings.readout.pixelEncoding == L"16 bit") {
+		m_rangeMax = 65536;
+	} else if (m_settings.readout.pixelEncoding == L"12 bit") {
+		m_rangeMax = 4096;
+	} else {
+		m_rangeMax = 255;
+	}
+
+	auto width = (gsl::index)std::max(0LL, m_settings.roi.width_binned);
+	auto height = (gsl::index)std::max(0LL, m_settings.roi.height_binned);
+	m_columnProfile.resize(width);
+	m_rowOffset.resize(height);
+	m_rowScale.resize(height);
+
+	// position of the first binned pixel in binned sensor coordinates
+	auto left = m_settings.roi.left / std::max(1LL, m_settings.roi.binX);
+	auto top = m_settings.roi.top / std::max(1LL, m_settings.roi.binY);
+
+	if (m_imageType == MOCK_IMAGE_TYPE::BRILLOUIN) {
+		// Spectrum along the rows in physical sensor pixels: two Rayleigh peaks one free
+		// spectral range apart with the Stokes and anti-Stokes peaks of water in between
+		auto sensorWidth = (double)m_options.ROIWidthLimits[1];
+		auto rayleigh = std::vector<double>{ 0.2 * sensorWidth, 0.8 * sensorWidth };
+		auto shift = 0.3 * (rayleigh[1] - rayleigh[0]);
+		auto lorentzian = [](double x, double x0, double gamma) {
+			return gamma * gamma / ((x - x0) * (x - x0) + gamma * gamma);
+		};
+		for (gsl::index xx{ 0 }; xx < width; xx++) {
+			auto x = (double)(xx + left) * m_settings.roi.binX;
+			auto value = 0.6 * (lorentzian(x, rayleigh[0], 0.006 * sensorWidth) + lorentzian(x, rayleigh[1], 0.006 * sensorWidth))
+				+ 0.15 * (lorentzian(x, rayleigh[0] + shift, 0.012 * sensorWidth) + lorentzian(x, rayleigh[1] - shift, 0.012 * sensorWidth));
+			m_columnProfile[xx] = (float)(value * m_rangeMax);
+		}
+		// Gaussian beam profile across the rows
+		auto sensorHeight = (double)m_options.ROIHeightLimits[1];
+		auto sigma = 0.15 * sensorHeight;
+		for (gsl::index yy{ 0 }; yy < height; yy++) {
+			auto y = (double)(yy + top) * m_settings.roi.binY - 0.5 * sensorHeight;
+			m_rowOffset[yy] = (float)(0.05 * m_rangeMax);
+			m_rowScale[yy] = (float)exp(-y * y / (2 * sigma * sigma));
+		}
+		m_noiseAmplitude = (float)(0.02 * m_rangeMax);
+	} else {
+		auto incX{ 0.35 * m_rangeMax / m_options.ROIWidthLimits[1] * m_settings.roi.binX };
+		auto incY{ 0.35 * m_rangeMax / m_options.ROIHeightLimits[1] * m_settings.roi.binY };
+		for (gsl::index xx{ 0 }; xx < width; xx++) {
+			m_columnProfile[xx] = (float)((xx + left) * incX);
+		}
+		for (gsl::index yy{ 0 }; yy < height; yy++) {
+			m_rowOffset[yy] = (float)(0.1 * m_rangeMax + (yy + top) * incY);
+			m_rowScale[yy] = 1;
+		}
+		m_noiseAmplitude = (float)(0.1 * m_rangeMax);
+	}
 }
\ No newline at end of file
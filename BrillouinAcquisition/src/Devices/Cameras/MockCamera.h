@@ -3,6 +3,11 @@
 
 #include "Camera.h"
 
+enum class MOCK_IMAGE_TYPE {
+	GRADIENT,		// intensity gradient across the sensor
+	BRILLOUIN		// Rayleigh and Stokes/anti-Stokes peaks of two orders of a Brillouin spectrum
+};
+
 class MockCamera : public Camera {
 	Q_OBJECT
 
@@ -10,6 +15,8 @@ public:
 	MockCamera() noexcept {};
 	~MockCamera();
 
+	int changeExposureDuringAcquisition(double exposureTime, double gain) override;
+
 public slots:
 	void init() override {};
 	void connectDevice() override;
@@ -23,6 +30,17 @@ public slots:
 
 	void setCalibrationExposureTime(double exposureTime) override;
 
+	void setImageType(MOCK_IMAGE_TYPE imageType);
+	/*
+	 * The noise of a frame only depends on the seed and the number of frames
+	 * acquired since the seed was set, so repeated runs produce identical data.
+	 */
+	void setSeed(unsigned int seed);
+	// Return the frames as fast as they are generated instead of waiting for the exposure time
+	void setMaxRate(bool maxRate);
+	// Time starting an acquisition takes, like arming a real camera
+	void setStartDelay(int startDelay);
+
 private:
 	int acquireImage(std::byte* buffer) override;
 
@@ -35,6 +53,21 @@ private:
 
 	void preparePreview();
 	void preparePreviewBuffer();
+
+	void prepareImage();
+
+	MOCK_IMAGE_TYPE m_imageType{ MOCK_IMAGE_TYPE::GRADIENT };
+	unsigned int m_seed{ 0 };
+	unsigned int m_frameNumber{ 0 };
+	bool m_maxRate{ false };
+	int m_startDelay{ 0 };		// [ms]	time starting an acquisition takes
+
+	// a pixel is m_rowOffset[y] + m_rowScale[y] * m_columnProfile[x] + noise
+	std::vector<float> m_columnProfile;
+	std::vector<float> m_rowOffset;
+	std::vector<float> m_rowScale;
+	float m_noiseAmplitude{ 0 };
+	float m_rangeMax{ 255 };
 };
 
 #endif // MOCKCAMERA_H
\ No newline at end of file
@@ -10,6 +10,16 @@ PointGrey::~PointGrey() {
 	disconnectDevice();
 }
 
+int PointGrey::changeExposureDuringAcquisition(double exposureTime, double gain) {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_settings.exposureTime = exposureTime;
+	m_settings.gain = gain;
+	applyExposureAndGain();
+	// In trigger mode the first image after the change might still be taken with the previous settings,
+	// see https://www.ptgrey.com/KB/10086
+	return 1;
+}
+
 /*
  * Public slots
  */
@@ -107,6 +117,14 @@ void PointGrey::stopAcquisition() {
 	}
 }
 
+void PointGrey::restartAcquisition(const CAMERA_SETTINGS& settings) {
+	// The settings and the buffers stay configured and the preview stays stopped,
+	// only the capture has to be restarted so that the camera does not hang.
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	auto i_retCode = m_camera.StopCapture();
+	i_retCode = m_camera.StartCapture();
+}
+
 void PointGrey::getImageForAcquisition(std::byte* buffer, bool preview) {
 	std::lock_guard<std::mutex> lockGuard(m_mutex);
 	if (m_settings.readout.triggerMode == L"Software") {
@@ -115,10 +133,13 @@ void PointGrey::getImageForAcquisition(std::byte* buffer, bool preview) {
 	acquireImage(buffer);
 
 	if (preview && buffer != nullptr) {
-		// write image to preview buffer
-		memcpy(m_previewBuffer->m_buffer->getWriteBuffer(), buffer, m_settings.roi.bytesPerFrame);
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
-		emit(s_imageReady());
+		// write image to preview buffer, it replaces a frame the preview did not show yet
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (slot) {
+			memcpy(slot.get(), buffer, m_settings.roi.bytesPerFrame);
+			slot.commit();
+			emit(s_imageReady());
+		}
 	}
 }
 
@@ -254,39 +275,7 @@ void PointGrey::applySettings(const CAMERA_SETTINGS& settings) {
 		m_settings.readout.dataType = "unsigned char";
 	}
 
-	/*
-	* Set the exposure time
-	*/
-	auto prop = FlyCapture2::Property{};
-	//Define the property to adjust.
-	prop.type = FlyCapture2::SHUTTER;
-	//Ensure the property is on.
-	prop.onOff = true;
-	// Ensure auto - adjust mode is off.
-	prop.autoManualMode = false;
-	//Ensure the property is set up to use absolute value control.
-	prop.absControl = true;
-	//Set the absolute value of shutter
-	prop.absValue = 1e3 * m_settings.exposureTime;
-	//Set the property.
-	auto i_retCode = m_camera.SetProperty(&prop);
-
-
-	/*
-	 * Set the camera gain
-	 */
-	auto propGain = FlyCapture2::Property{};
-	// Define the property to adjust.
-	propGain.type = FlyCapture2::GAIN;
-	// Ensure auto-adjust mode is off.
-	propGain.autoManualMode = false;
-	// Ensure the property is set up to use absolute value control.
-	propGain.absControl = true;
-	//Set the absolute value of gain to 10.5 dB.
-	propGain.absValue = m_settings.gain;
-	//Set the property.
-	i_retCode = m_camera.SetProperty(&propGain);
-
+	applyExposureAndGain();
 
 	/*
 	* Set region of interest and pixel format
@@ -325,7 +314,7 @@ void PointGrey::applySettings(const CAMERA_SETTINGS& settings) {
 
 	auto fmt7PacketInfo = FlyCapture2::Format7PacketInfo{};
 	auto valid{ false };
-	i_retCode = m_camera.ValidateFormat7Settings(&fmt7ImageSettings, &valid, &fmt7PacketInfo);
+	auto i_retCode = m_camera.ValidateFormat7Settings(&fmt7ImageSettings, &valid, &fmt7PacketInfo);
 	if (valid) {
 		i_retCode = m_camera.SetFormat7Configuration(&fmt7ImageSettings, fmt7PacketInfo.recommendedBytesPerPacket);
 	}
@@ -374,6 +363,44 @@ void PointGrey::applySettings(const CAMERA_SETTINGS& settings) {
 	readSettings();
 }
 
+/*
+ * Exposure time and gain can be changed while the camera is capturing
+ */
+void PointGrey::applyExposureAndGain() {
+	/*
+	* Set the exposure time
+	*/
+	auto prop = FlyCapture2::Property{};
+	//Define the property to adjust.
+	prop.type = FlyCapture2::SHUTTER;
+	//Ensure the property is on.
+	prop.onOff = true;
+	// Ensure auto - adjust mode is off.
+	prop.autoManualMode = false;
+	//Ensure the property is set up to use absolute value control.
+	prop.absControl = true;
+	//Set the absolute value of shutter
+	prop.absValue = 1e3 * m_settings.exposureTime;
+	//Set the property.
+	auto i_retCode = m_camera.SetProperty(&prop);
+
+
+	/*
+	 * Set the camera gain
+	 */
+	auto propGain = FlyCapture2::Property{};
+	// Define the property to adjust.
+	propGain.type = FlyCapture2::GAIN;
+	// Ensure auto-adjust mode is off.
+	propGain.autoManualMode = false;
+	// Ensure the property is set up to use absolute value control.
+	propGain.absControl = true;
+	//Set the absolute value of gain to 10.5 dB.
+	propGain.absValue = m_settings.gain;
+	//Set the property.
+	i_retCode = m_camera.SetProperty(&propGain);
+}
+
 void PointGrey::preparePreview() {
 	// set ROI and readout parameters to default preview values, exposure time and gain will be kept
 	m_settings.roi.left = 0;
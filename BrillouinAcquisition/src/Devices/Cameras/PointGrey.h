@@ -14,6 +14,12 @@ public:
 	PointGrey() noexcept {};
 	~PointGrey();
 
+	// The camera hangs completely if more images are acquired without restarting the capture
+	int getMaximumAcquisitionImages() override { return 100; };
+	void restartAcquisition(const CAMERA_SETTINGS& settings) override;
+
+	int changeExposureDuringAcquisition(double exposureTime, double gain) override;
+
 public slots:
 	void init() override {};
 	void connectDevice() override;
@@ -31,6 +37,7 @@ private:
 	void readOptions() override;
 	void readSettings() override;
 	void applySettings(const CAMERA_SETTINGS& settings) override;
+	void applyExposureAndGain();
 
 	void preparePreview();
 
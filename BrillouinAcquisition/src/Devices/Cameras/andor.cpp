@@ -115,10 +115,13 @@ void Andor::getImageForAcquisition(std::byte* buffer, bool preview) {
 	acquireImage(buffer);
 
 	if (preview) {
-		// write image to preview buffer
-		memcpy(m_previewBuffer->m_buffer->getWriteBuffer(), buffer, m_settings.roi.bytesPerFrame);
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
-		emit(s_imageReady());
+		// write image to preview buffer, it replaces a frame the preview did not show yet
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (slot) {
+			memcpy(slot.get(), buffer, m_settings.roi.bytesPerFrame);
+			slot.commit();
+			emit(s_imageReady());
+		}
 	}
 }
 
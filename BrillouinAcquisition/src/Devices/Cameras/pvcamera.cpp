@@ -128,10 +128,13 @@ void PVCamera::getImageForAcquisition(std::byte* buffer, bool preview) {
 	PVCam::pl_exp_finish_seq(m_camera, m_acquisitionBuffer, 0);
 
 	if (preview && m_acquisitionBuffer) {
-		// write image to preview buffer
-		memcpy(m_previewBuffer->m_buffer->getWriteBuffer(), buffer, m_settings.roi.bytesPerFrame);
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
-		emit(s_imageReady());
+		// write image to preview buffer, it replaces a frame the preview did not show yet
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (slot) {
+			memcpy(slot.get(), buffer, m_settings.roi.bytesPerFrame);
+			slot.commit();
+			emit(s_imageReady());
+		}
 	}
 }
 
@@ -665,14 +668,15 @@ void PVCamera::getImageForPreview() {
 			return;
 		}
 
-		// if no image is ready return immediately
-		if (!m_previewBuffer->m_buffer->m_freeBuffers->tryAcquire()) {
+		// if the preview buffer is not set up yet return immediately
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (!slot) {
 			Sleep(50);
 			return;
 		}
 
-		acquireImage(m_previewBuffer->m_buffer->getWriteBuffer());
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
+		acquireImage(slot.get());
+		slot.commit();
 		emit(s_imageReady());
 	}
 }
@@ -10,6 +10,17 @@ uEyeCam::~uEyeCam() {
 	disconnectDevice();
 }
 
+int uEyeCam::changeExposureDuringAcquisition(double exposureTime, double gain) {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_settings.exposureTime = exposureTime;
+	// The gain is not set for this camera
+	m_settings.gain = gain;
+	auto exposureTemp = (double)1e3 * m_settings.exposureTime;
+	uEye::is_Exposure(m_camera, uEye::IS_EXPOSURE_CMD_SET_EXPOSURE, (void*)&exposureTemp, sizeof(exposureTemp));
+	// The first image after the change might still be taken with the previous exposure time
+	return 1;
+}
+
 /*
  * Public slots
  */
@@ -152,10 +163,13 @@ void uEyeCam::getImageForAcquisition(std::byte* buffer, bool preview) {
 	acquireImage(buffer);
 
 	if (preview && buffer != nullptr) {
-		// write image to preview buffer
-		memcpy(m_previewBuffer->m_buffer->getWriteBuffer(), buffer, m_settings.roi.bytesPerFrame);
-		m_previewBuffer->m_buffer->m_usedBuffers->release();
-		emit(s_imageReady());
+		// write image to preview buffer, it replaces a frame the preview did not show yet
+		auto slot = m_previewBuffer->m_buffer->tryWrite();
+		if (slot) {
+			memcpy(slot.get(), buffer, m_settings.roi.bytesPerFrame);
+			slot.commit();
+			emit(s_imageReady());
+		}
 	}
 }
 
@@ -14,6 +14,8 @@ public:
 	uEyeCam() noexcept {};
 	~uEyeCam();
 
+	int changeExposureDuringAcquisition(double exposureTime, double gain) override;
+
 public slots:
 	void init() override {};
 	void connectDevice() override;
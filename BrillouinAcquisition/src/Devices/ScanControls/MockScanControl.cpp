@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "MockScanControl.h"
+
+#include <thread>
+
+/*
+ * Public definitions
+ */
+
+MockScanControl::MockScanControl() noexcept {
+
+	m_deviceElements = {
+		{ "Beam Block",		2, (int)DEVICE_ELEMENT::BEAMBLOCK, { "Close", "Open" } },
+		{ "Calibration",	2, (int)DEVICE_ELEMENT::CALIBRATION, { "Sample", "Reference" } }
+	};
+
+	m_presets = {
+		{ "Brillouin",		ScanPreset::SCAN_BRILLOUIN,		{ {2}, {1} }	},	// Brillouin
+		{ "Calibration",	ScanPreset::SCAN_CALIBRATION,	{ {2}, {2} }	},	// Calibration
+		{ "Brightfield",	ScanPreset::SCAN_BRIGHTFIELD,	{ {1},  {} }	},	// Brightfield
+		{ "ODT",			ScanPreset::SCAN_ODT,			{ {1},  {} }	},	// ODT
+		{ "Fluo Blue",		ScanPreset::SCAN_EPIFLUOBLUE,	{ {1},  {} }	},	// Fluorescence blue
+		{ "Fluo Green",		ScanPreset::SCAN_EPIFLUOGREEN,	{ {1},  {} }	},	// Fluorescence green
+		{ "Fluo Red",		ScanPreset::SCAN_EPIFLUORED,	{ {1},  {} }	},	// Fluorescence red
+		{ "Laser off",		ScanPreset::SCAN_LASEROFF,		{ {1},  {} }	}	// Laser off
+	};
+
+	m_elementPositions = std::vector<double>((int)DEVICE_ELEMENT::COUNT, 1);
+
+	registerCapability(Capabilities::TranslationStage);
+	registerCapability(Capabilities::ODT);
+
+	m_motionModel = { { m_velocity, m_settleTime }, { m_velocity, m_settleTime }, { m_velocity, m_settleTime } };
+
+	m_moveStart = std::chrono::steady_clock::now();
+	m_moveEnd = m_moveStart;
+}
+
+MockScanControl::~MockScanControl() {
+	disconnectDevice();
+}
+
+void MockScanControl::setPosition(POINT2 position) {
+	setPosition(POINT3{ position.x, position.y, m_positionFocus });
+}
+
+void MockScanControl::setPosition(POINT3 position) {
+	{
+		std::lock_guard<std::mutex> lockGuard(m_moveMutex);
+		auto now = std::chrono::steady_clock::now();
+		// a new move starts from wherever the stage currently is
+		auto current = m_moveTarget;
+		if (now < m_moveEnd) {
+			auto fraction = (double)(now - m_moveStart).count() / (m_moveEnd - m_moveStart).count();
+			current = m_moveOrigin + (m_moveTarget - m_moveOrigin) * fraction;
+		}
+		auto distance = std::max({ std::abs(position.x - current.x), std::abs(position.y - current.y), std::abs(position.z - current.z) });
+		auto duration = (distance > 1e-6) ? distance / m_velocity + m_settleTime : 0;
+
+		m_moveOrigin = current;
+		m_moveTarget = position;
+		m_moveStart = now;
+		m_moveEnd = now + std::chrono::microseconds((long long)(1e3 * duration));
+	}
+	m_positionStage = POINT2{ position.x, position.y } - m_positionScanner;
+	m_positionFocus = position.z;
+
+	calculateCurrentPositionBounds(position);
+	announcePositions();
+}
+
+POINT3 MockScanControl::getPosition(PositionType positionType) {
+	std::lock_guard<std::mutex> lockGuard(m_moveMutex);
+	auto now = std::chrono::steady_clock::now();
+	if (now >= m_moveEnd) {
+		return ScanControl::getPosition(positionType);
+	}
+	auto fraction = (double)(now - m_moveStart).count() / (m_moveEnd - m_moveStart).count();
+	auto position = m_moveOrigin + (m_moveTarget - m_moveOrigin) * fraction;
+	if (positionType == PositionType::SCANNER) {
+		return POINT3{ m_positionScanner.x, m_positionScanner.y, position.z };
+	}
+	return position;
+}
+
+bool MockScanControl::waitForPosition(const POINT3& position, int timeout) {
+	auto moveEnd = std::chrono::steady_clock::time_point{};
+	{
+		std::lock_guard<std::mutex> lockGuard(m_moveMutex);
+		moveEnd = m_moveEnd;
+	}
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	if (moveEnd > deadline) {
+		std::this_thread::sleep_until(deadline);
+		return false;
+	}
+	std::this_thread::sleep_until(moveEnd);
+	return true;
+}
+
+void MockScanControl::setVoltage(VOLTAGE2 voltages) {
+	m_voltages = voltages;
+}
+
+void MockScanControl::setMoveTimes(double velocity, double settleTime) {
+	std::lock_guard<std::mutex> lockGuard(m_moveMutex);
+	m_velocity = velocity;
+	m_settleTime = settleTime;
+	m_motionModel = { { velocity, settleTime }, { velocity, settleTime }, { velocity, settleTime } };
+}
+
+/*
+ * Public slots
+ */
+
+void MockScanControl::connectDevice() {
+	m_isConnected = true;
+	m_isCompatible = true;
+	calculateBounds();
+	emit(connectedDevice(m_isConnected && m_isCompatible));
+}
+
+void MockScanControl::disconnectDevice() {
+	m_isConnected = false;
+	m_isCompatible = false;
+	emit(connectedDevice(m_isConnected && m_isCompatible));
+}
+
+void MockScanControl::setElement(DeviceElement element, double position) {
+	m_elementPositions[element.index] = position;
+	checkPresets();
+	emit(elementPositionChanged(element, position));
+}
+
+int MockScanControl::getElement(const DeviceElement& element) {
+	return (int)m_elementPositions[element.index];
+}
+
+void MockScanControl::getElements() {
+	checkPresets();
+	emit(elementPositionsChanged(m_elementPositions));
+}
+
+void MockScanControl::setAcquisitionVoltages(ACQ_VOLTAGES voltages) {
+	if (voltages.numberSamples > 0) {
+		m_voltages = { voltages.mirror[voltages.numberSamples - 1], voltages.mirror[2 * voltages.numberSamples - 1] };
+	}
+}
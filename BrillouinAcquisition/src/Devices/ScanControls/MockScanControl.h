@@ -0,0 +1,56 @@
+#ifndef MOCKSCANCONTROL_H
+#define MOCKSCANCONTROL_H
+
+#include "ODTControl.h"
+
+#include <chrono>
+#include <mutex>
+
+/*
+ * Scan control without hardware, for testing and benchmarking.
+ * A move takes a time proportional to the travelled distance plus a settle time,
+ * so waiting for the position behaves like a real translation stage.
+ * The galvo voltages for ODT are accepted but not applied anywhere.
+ */
+class MockScanControl: public ODTControl {
+	Q_OBJECT
+
+public:
+	MockScanControl() noexcept;
+	~MockScanControl();
+
+	void setPosition(POINT2 position) override;
+	void setPosition(POINT3 position) override;
+	POINT3 getPosition(PositionType positionType = PositionType::BOTH) override;
+	bool waitForPosition(const POINT3& position, int timeout = 1000) override;
+	void setVoltage(VOLTAGE2 voltages) override;
+
+	// velocity [m/ms], settle time [ms], the motion model is set accordingly
+	void setMoveTimes(double velocity, double settleTime);
+
+public slots:
+	void init() override {};
+	void connectDevice() override;
+	void disconnectDevice() override;
+	void setElement(DeviceElement element, double position) override;
+	int getElement(const DeviceElement& element) override;
+	void getElements() override;
+	void setAcquisitionVoltages(ACQ_VOLTAGES voltages) override;
+
+private:
+	std::mutex m_moveMutex;
+	double m_velocity{ 1 };			// [m/ms]	travel velocity of the stage
+	double m_settleTime{ 2 };		// [ms]		time the stage needs to settle after a move
+	POINT3 m_moveOrigin{ 0, 0, 0 };	// [m]		position the current move started at
+	POINT3 m_moveTarget{ 0, 0, 0 };	// [m]		position the current move ends at
+	std::chrono::steady_clock::time_point m_moveStart;
+	std::chrono::steady_clock::time_point m_moveEnd;
+
+	enum class DEVICE_ELEMENT {
+		BEAMBLOCK,
+		CALIBRATION,
+		COUNT
+	};
+};
+
+#endif // MOCKSCANCONTROL_H
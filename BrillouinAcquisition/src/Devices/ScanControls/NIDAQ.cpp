@@ -32,6 +32,7 @@ NIDAQ::NIDAQ() noexcept {
 	};
 
 	VoltageCalibrationHelper::calculateCalibrationWeights(&m_voltageCalibration);
+	updateCalibrationSplines();
 
 	m_elementPositions = std::vector<double>((int)DEVICE_ELEMENT::COUNT, -1);
 
@@ -40,6 +41,9 @@ NIDAQ::NIDAQ() noexcept {
 	registerCapability(Capabilities::VoltageCalibration);
 	registerCapability(Capabilities::LaserScanner);
 
+	// The galvo scanners settle within a millisecond, the focus is not moved
+	m_motionModel = { { 100, 1 }, { 100, 1 }, { 100, 0 } };
+
 	/*
 	 * Initialize the scale calibration
 	 */
@@ -116,18 +120,24 @@ void NIDAQ::setPosition(POINT3 position) {
 	setPosition(POINT2{ position.x, position.y });
 }
 
+bool NIDAQ::waitForPosition(const POINT3& position, int timeout) {
+	// The voltages are applied synchronously and the galvo scanners settle
+	// much faster than a camera exposure, so the position is always reached.
+	return true;
+}
+
 VOLTAGE2 NIDAQ::positionToVoltage(POINT2 position) {
 
-	auto Uxr = interpolation::biharmonic_spline_calculate_values(m_voltageCalibration.positions_weights.x, position.x, position.y);
-	auto Uyr = interpolation::biharmonic_spline_calculate_values(m_voltageCalibration.positions_weights.y, position.x, position.y);
+	auto Uxr = m_positionToVoltage.x(position.x, position.y);
+	auto Uyr = m_positionToVoltage.y(position.x, position.y);
 
 	return VOLTAGE2{ Uxr, Uyr };
 }
 
 POINT2 NIDAQ::voltageToPosition(VOLTAGE2 voltage) {
 
-	auto xr = interpolation::biharmonic_spline_calculate_values(m_voltageCalibration.voltages_weights.x, voltage.Ux, voltage.Uy);
-	auto yr = interpolation::biharmonic_spline_calculate_values(m_voltageCalibration.voltages_weights.y, voltage.Ux, voltage.Uy);
+	auto xr = m_voltageToPosition.x(voltage.Ux, voltage.Uy);
+	auto yr = m_voltageToPosition.y(voltage.Ux, voltage.Uy);
 
 	return POINT2{ xr, yr };
 }
@@ -299,6 +309,7 @@ void NIDAQ::getElements() {
 
 void NIDAQ::setVoltageCalibration(VoltageCalibrationData voltageCalibration) {
 	m_voltageCalibration = voltageCalibration;
+	updateCalibrationSplines();
 
 	centerPosition();
 	calculateHomePositionBounds();
@@ -354,6 +365,13 @@ void NIDAQ::applyPosition() {
 	announcePosition();
 }
 
+void NIDAQ::updateCalibrationSplines() {
+	m_positionToVoltage.x = BiharmonicSpline<double>{ m_voltageCalibration.positions_weights.x };
+	m_positionToVoltage.y = BiharmonicSpline<double>{ m_voltageCalibration.positions_weights.y };
+	m_voltageToPosition.x = BiharmonicSpline<double>{ m_voltageCalibration.voltages_weights.x };
+	m_voltageToPosition.y = BiharmonicSpline<double>{ m_voltageCalibration.voltages_weights.y };
+}
+
 void NIDAQ::centerPosition() {
 	// Set current focus position to zero
 	Thorlabs_TIM::TIM_Home(m_serialNo_TIM, m_channelPosZ);
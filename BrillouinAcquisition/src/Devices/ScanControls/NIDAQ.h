@@ -31,6 +31,7 @@ public:
 
 	void setPosition(POINT2 position) override;
 	void setPosition(POINT3 position) override;
+	bool waitForPosition(const POINT3& position, int timeout = 1000) override;
 
 	VOLTAGE2 positionToVoltage(POINT2 position);
 	POINT2 voltageToPosition(VOLTAGE2 position);
@@ -55,6 +56,9 @@ private:
 	void applyPosition();
 	void centerPosition();
 
+	// Prepares the evaluation of the voltage calibration
+	void updateCalibrationSplines();
+
 	void setFilter(FilterMount* device, int position);
 	int getFilter(FilterMount* device);
 
@@ -72,6 +76,9 @@ private:
 	double getLowerObjective();
 
 	double m_positionLowerObjective{ 0 };	// position of the lower objective
+
+	SPLINE2<double> m_positionToVoltage;	// voltages for positions of the voltage calibration
+	SPLINE2<double> m_voltageToPosition;	// positions for voltages of the voltage calibration
 	
 	// TODO: make the following parameters changeable:
 	char const* m_serialNo_TIM{ "65864438" };	// serial number of the TCube Inertial motor controller device (can be found in Kinesis)
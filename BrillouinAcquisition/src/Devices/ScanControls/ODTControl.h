@@ -33,7 +33,7 @@ public:
 	ODTControl() noexcept {};
 	~ODTControl() {};
 
-	void setVoltage(VOLTAGE2 voltages);
+	virtual void setVoltage(VOLTAGE2 voltages);
 
 public slots:
 	void connectDevice();
@@ -42,7 +42,7 @@ public slots:
 	void setLEDLamp(bool enabled);
 	int getLEDLamp();
 
-	void setAcquisitionVoltages(ACQ_VOLTAGES voltages);
+	virtual void setAcquisitionVoltages(ACQ_VOLTAGES voltages);
 	virtual void setVoltageCalibration(VoltageCalibrationData voltageCalibration) {};
 
 protected:
@@ -40,6 +40,26 @@ POINT3 ScanControl::getPosition(PositionType positionType) {
 	return POINT3{ pos.x, pos.y, m_positionFocus };
 }
 
+bool ScanControl::waitForPosition(const POINT3& position, int timeout) {
+	auto timer = QElapsedTimer{};
+	timer.start();
+	while (true) {
+		auto deviation = getPosition() - position;
+		if (abs(deviation.x) <= m_positionTolerance && abs(deviation.y) <= m_positionTolerance
+			&& abs(deviation.z) <= m_positionTolerance) {
+			return true;
+		}
+		if (timer.elapsed() > timeout) {
+			return false;
+		}
+		QThread::msleep(2);
+	}
+}
+
+MOTION_MODEL ScanControl::getMotionModel() {
+	return m_motionModel;
+}
+
 /*
  * Public slots
  */
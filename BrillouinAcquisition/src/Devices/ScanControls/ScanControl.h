@@ -5,6 +5,7 @@
 #include "../../../external/h5bm/TypesafeBitmask.h"
 #include "../../POINTS.h"
 #include "../../Acquisition/AcquisitionModes/ScaleCalibrationHelper.h"
+#include "../../Acquisition/AcquisitionModes/ScanPathPlanner.h"
 
 enum class ScanPreset {
 	SCAN_NULL			= 0x0,
@@ -127,14 +128,30 @@ public:
 	void movePosition(POINT2 distance);
 	void movePosition(const POINT3& distance);
 	virtual POINT3 getPosition(PositionType positionType = PositionType::BOTH);
+	// Blocks until the given position is reached or the timeout [ms] elapsed.
+	// Returns false if the position was not reached in time.
+	virtual bool waitForPosition(const POINT3& position, int timeout = 1000);
+	// Approximate travel times of the axes, used to plan the scans
+	MOTION_MODEL getMotionModel();
 
 	typedef enum class enScanDevice {
 		ZEISSECU = 0,
 		NIDAQ = 1,
 		ZEISSMTB = 2,
 		ZEISSMTBERLANGEN = 3
+#ifdef _DEBUG
+		, MOCK = 4
+#endif
 	} SCAN_DEVICE;
-	inline static std::vector<std::string> SCAN_DEVICE_NAMES = { "Zeiss ECU", "NI-DAQmx", "Zeiss MTB", "Zeiss MTB Erlangen" };
+	inline static std::vector<std::string> SCAN_DEVICE_NAMES = {
+		"Zeiss ECU",
+		"NI-DAQmx",
+		"Zeiss MTB",
+		"Zeiss MTB Erlangen"
+#ifdef _DEBUG
+		, "Mock Scan Control"
+#endif
+	};
 
 	std::vector<DeviceElement> m_deviceElements;
 	std::vector<double> m_elementPositions;
@@ -205,6 +222,8 @@ protected:
 	std::vector<Capabilities> m_capabilities;
 
 	double m_positionFocus{ 0 };			// [m]	position of the focus (z-position)
+	double m_positionTolerance{ 0.5 };		// [m]	maximum deviation from the target position for it to count as reached
+	MOTION_MODEL m_motionModel;			// travel times of the axes, the backends set their own
 	POINT2 m_positionStage{ 0, 0 };			// [m]	position of the stage (x-y-position)
 	POINT2 m_positionScanner{ 0, 0 };		// [m]	position of the scanner (x-y-position)
 
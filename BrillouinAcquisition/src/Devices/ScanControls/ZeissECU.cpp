@@ -36,6 +36,9 @@ ZeissECU::ZeissECU() noexcept {
 	registerCapability(Capabilities::TranslationStage);
 	registerCapability(Capabilities::ScaleCalibration);
 
+	// Approximate travel times of the stage and the focus drive, used to plan the scans
+	m_motionModel = { { 1, 50 }, { 1, 50 }, { 0.5, 50 } };
+
 	/*
 	 * Initialize the scale calibration with default values (determined for a 40x objective)
 	 */
@@ -102,15 +105,41 @@ void ZeissECU::setPosition(POINT3 position) {
 
 POINT3 ZeissECU::getPosition(PositionType positionType) {
 	// Update the positions from the hardware
-	m_positionStage.x = m_mcu->getX();
-	m_positionStage.y = m_mcu->getY();
-
-	m_positionFocus = m_focus->getZ();
+	auto reply = requestPosition();
+	m_comObject->waitForReply(reply);
 
 	// Return the current position
 	return ScanControl::getPosition(positionType);
 }
 
+bool ZeissECU::waitForPosition(const POINT3& position, int timeout) {
+	auto timer = QElapsedTimer{};
+	timer.start();
+	while (true) {
+		// The serial port may only be used from the thread it lives in,
+		// so the position is queried there and the caller waits for the answer.
+		auto current = POINT3{};
+		if (QThread::currentThread() == thread()) {
+			current = getPosition();
+		} else {
+			QMetaObject::invokeMethod(
+				this,
+				[this, &current]() { current = getPosition(); },
+				Qt::BlockingQueuedConnection
+			);
+		}
+		auto deviation = current - position;
+		if (abs(deviation.x) <= m_positionTolerance && abs(deviation.y) <= m_positionTolerance
+			&& abs(deviation.z) <= m_positionTolerance) {
+			return true;
+		}
+		if (timer.elapsed() > timeout) {
+			return false;
+		}
+		QThread::msleep(2);
+	}
+}
+
 void ZeissECU::setDevice(com* device) {
 	if (m_comObject) {
 		m_comObject->deleteLater();
@@ -145,7 +174,7 @@ void ZeissECU::init() {
 		m_positionTimer,
 		&QTimer::timeout,
 		this,
-		&ZeissECU::announcePosition
+		&ZeissECU::pollPosition
 	);
 
 	m_elementPositionTimer = new QTimer();
@@ -153,7 +182,7 @@ void ZeissECU::init() {
 		m_elementPositionTimer,
 		&QTimer::timeout,
 		this,
-		&ZeissECU::getElements
+		&ZeissECU::pollElements
 	);
 	calculateHomePositionBounds();
 }
@@ -273,28 +302,82 @@ int ZeissECU::getElement(const DeviceElement& element) {
 }
 
 void ZeissECU::getElements() {
-	m_elementPositionsTmp = m_elementPositions;
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::BEAMBLOCK] = getBeamBlock();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::REFLECTOR] = m_stand->getReflector();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::OBJECTIVE] = m_stand->getObjective();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::TUBELENS] = m_stand->getTubelens();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::BASEPORT] = m_stand->getBaseport();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::SIDEPORT] = m_stand->getSideport();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::RLSHUTTER] = m_stand->getRLShutter();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::MIRROR] = m_stand->getMirror();
-	m_elementPositionsTmp[(int)DEVICE_ELEMENT::LAMP] = m_stand->getLamp();
-	// We only emit changed positions
-	if (m_elementPositionsTmp != m_elementPositions) {
-		m_elementPositions = m_elementPositionsTmp;
-		checkPresets();
-		emit(elementPositionsChanged(m_elementPositions));
-	}
+	auto reply = requestElements();
+	m_comObject->waitForReply(reply);
 }
 
 /*
  * Private definitions
  */
 
+std::future<std::string> ZeissECU::requestPosition() {
+	m_positionPollPending = true;
+	m_mcu->getX([this](double position) {
+		if (!std::isnan(position)) {
+			m_positionStage.x = position;
+		}
+	});
+	m_mcu->getY([this](double position) {
+		if (!std::isnan(position)) {
+			m_positionStage.y = position;
+		}
+	});
+	// the answers arrive in order, so this is the last one
+	return m_focus->getZ([this](double position) {
+		if (!std::isnan(position)) {
+			m_positionFocus = position;
+		}
+		m_positionPollPending = false;
+		emit(currentPosition(ScanControl::getPosition() - m_homePosition));
+	});
+}
+
+std::future<std::string> ZeissECU::requestElements() {
+	m_elementPollPending = true;
+	m_elementPositionsTmp = m_elementPositions;
+	m_elementPositionsTmp[(int)DEVICE_ELEMENT::BEAMBLOCK] = getBeamBlock();
+
+	auto store = [this](DEVICE_ELEMENT element) {
+		return [this, element](int position) {
+			m_elementPositionsTmp[(int)element] = position;
+		};
+	};
+	m_stand->getReflector(store(DEVICE_ELEMENT::REFLECTOR));
+	m_stand->getObjective(store(DEVICE_ELEMENT::OBJECTIVE));
+	m_stand->getTubelens(store(DEVICE_ELEMENT::TUBELENS));
+	m_stand->getBaseport(store(DEVICE_ELEMENT::BASEPORT));
+	m_stand->getSideport(store(DEVICE_ELEMENT::SIDEPORT));
+	m_stand->getRLShutter(store(DEVICE_ELEMENT::RLSHUTTER));
+	m_stand->getMirror(store(DEVICE_ELEMENT::MIRROR));
+	// the answers arrive in order, so this is the last one
+	return m_stand->getLamp([this](int position) {
+		m_elementPositionsTmp[(int)DEVICE_ELEMENT::LAMP] = position;
+		m_elementPollPending = false;
+		// We only emit changed positions
+		if (m_elementPositionsTmp != m_elementPositions) {
+			m_elementPositions = m_elementPositionsTmp;
+			checkPresets();
+			emit(elementPositionsChanged(m_elementPositions));
+		}
+	});
+}
+
+void ZeissECU::pollPosition() {
+	// Don't pile up requests if the device answers slower than the timer
+	if (m_positionPollPending) {
+		return;
+	}
+	requestPosition();
+}
+
+void ZeissECU::pollElements() {
+	// Don't pile up requests if the device answers slower than the timer
+	if (m_elementPollPending) {
+		return;
+	}
+	requestElements();
+}
+
 void ZeissECU::setBeamBlock(int position) {
 	Thorlabs_FF::FF_MoveToPosition(m_serialNo_FF2, (Thorlabs_FF::FF_Positions)position);
 	auto i{ 0 };
@@ -331,21 +414,30 @@ bool Element::checkCompatibility() {
  */
 
 std::string Element::receive(const std::string& request) {
-	auto answer = m_comObject->receive(m_prefix + "P" + request);
+	auto answer = m_comObject->receive(m_prefix + "P" + request, "P" + m_prefix);
 	return helper::parse(answer, m_prefix);
 }
 
+std::future<std::string> Element::receiveAsync(const std::string& request, const std::function<void(const std::string&)>& callback) {
+	auto prefix = m_prefix;
+	return m_comObject->receiveAsync(m_prefix + "P" + request, [prefix, callback](const std::string& answer) {
+		callback(helper::parse(answer, prefix));
+	}, "P" + m_prefix);
+}
+
 void Element::send(const std::string& message) {
 	m_comObject->send(m_prefix + "P" + message);
 }
 
 void Element::clear() {
-	m_comObject->clear();
+	// clearing the port would discard the answers other requests are waiting for
+	if (!m_comObject->hasPendingReplies()) {
+		m_comObject->clear();
+	}
 }
 
 std::string Element::requestVersion() {
-	auto answer = m_comObject->receive(m_prefix + "P" + "Tv");
-	return helper::parse(answer, m_prefix);
+	return receive("Tv");
 }
 
 
@@ -368,6 +460,10 @@ int Stand::getReflector() {
 	return getElementPosition("1");
 }
 
+std::future<std::string> Stand::getReflector(const std::function<void(int)>& callback) {
+	return getElementPosition("1", "r", callback);
+}
+
 void Stand::setObjective(int position, bool block) {
 	if (position > 0 && position < 7) {
 		setElementPosition("2", position);
@@ -379,6 +475,10 @@ int Stand::getObjective() {
 	return getElementPosition("2");
 }
 
+std::future<std::string> Stand::getObjective(const std::function<void(int)>& callback) {
+	return getElementPosition("2", "r", callback);
+}
+
 void Stand::setTubelens(int position, bool block) {
 	if (position > 0 && position < 4) {
 		setElementPosition("36", position);
@@ -390,6 +490,10 @@ int Stand::getTubelens() {
 	return getElementPosition("36");
 }
 
+std::future<std::string> Stand::getTubelens(const std::function<void(int)>& callback) {
+	return getElementPosition("36", "r", callback);
+}
+
 void Stand::setBaseport(int position, bool block) {
 	if (position > 0 && position < 4) {
 		setElementPosition("38", position);
@@ -401,6 +505,10 @@ int Stand::getBaseport() {
 	return getElementPosition("38");
 }
 
+std::future<std::string> Stand::getBaseport(const std::function<void(int)>& callback) {
+	return getElementPosition("38", "r", callback);
+}
+
 void Stand::setSideport(int position, bool block) {
 	if (position > 0 && position < 4) {
 		setElementPosition("39", position);
@@ -412,6 +520,10 @@ int Stand::getSideport() {
 	return getElementPosition("39");
 }
 
+std::future<std::string> Stand::getSideport(const std::function<void(int)>& callback) {
+	return getElementPosition("39", "r", callback);
+}
+
 void Stand::setRLShutter(int position, bool block) {
 	if (position > 0 && position < 4) {
 		setElementPosition("1", position, "K");
@@ -423,6 +535,10 @@ int Stand::getRLShutter() {
 	return getElementPosition("1", "k");
 }
 
+std::future<std::string> Stand::getRLShutter(const std::function<void(int)>& callback) {
+	return getElementPosition("1", "k", callback);
+}
+
 void Stand::setMirror(int position, bool block) {
 	if (position > 0 && position < 3) {
 		setElementPosition("51", position);
@@ -434,6 +550,10 @@ int Stand::getMirror() {
 	return getElementPosition("51");
 }
 
+std::future<std::string> Stand::getMirror(const std::function<void(int)>& callback) {
+	return getElementPosition("51", "r", callback);
+}
+
 void Stand::setLamp(int position, bool block) {
 	if (position > 100) position = 100;
 	if (position < 0) position = 0;
@@ -447,6 +567,12 @@ int Stand::getLamp() {
 	return (int)(getElementPosition("1", "v") / 2.55);
 }
 
+std::future<std::string> Stand::getLamp(const std::function<void(int)>& callback) {
+	return getElementPosition("1", "v", [callback](int position) {
+		callback(position < 0 ? position : (int)(position / 2.55));
+	});
+}
+
 /*
  * Private definitions
  */
@@ -456,7 +582,16 @@ void Stand::setElementPosition(const std::string& device, int position, const st
 }
 
 int Stand::getElementPosition(const std::string& device, const std::string& identifier) {
-	std::string answer = receive("C" + identifier + device + ",1");
+	return elementPositionFromAnswer(receive("C" + identifier + device + ",1"));
+}
+
+std::future<std::string> Stand::getElementPosition(const std::string& device, const std::string& identifier, const std::function<void(int)>& callback) {
+	return receiveAsync("C" + identifier + device + ",1", [callback](const std::string& answer) {
+		callback(elementPositionFromAnswer(answer));
+	});
+}
+
+int Stand::elementPositionFromAnswer(const std::string& answer) {
 	if (answer.empty()) {
 		return -1;
 	}
@@ -498,15 +633,13 @@ void Focus::setZ(double position) {
 }
 
 double Focus::getZ() {
-	auto position = "0x" + receive("Zp");
-	auto pos = helper::hex2dec(position);
-	// The actual travel range of the focus is significantly smaller than the theoretically possible maximum increment value (FFFFFF or 16777215).
-	// When the microscope starts, it sets it home position to (0, 0, 0). Values in the negative range are then adressed as (16777215 - positionInInc).
-	// Hence, we consider all values > 16777215/2 to actually be negative and wrap them accordingly (similar to what positive_modulo(...,...) for the setPosition() functions does).
-	if (pos > m_rangeFocus / 2) {
-		pos -= m_rangeFocus;
-	}
-	return pos * m_umperinc;
+	return positionFromAnswer(receive("Zp"));
+}
+
+std::future<std::string> Focus::getZ(const std::function<void(double)>& callback) {
+	return receiveAsync("Zp", [this, callback](const std::string& answer) {
+		callback(answer.empty() ? NAN : positionFromAnswer(answer));
+	});
 }
 
 void Focus::setVelocityZ(double velocity) {
@@ -544,6 +677,21 @@ void Focus::move2Work() {
 	send("ZW1");
 }
 
+/*
+ * Private definitions
+ */
+
+double Focus::positionFromAnswer(const std::string& answer) {
+	auto pos = helper::hex2dec("0x" + answer);
+	// The actual travel range of the focus is significantly smaller than the theoretically possible maximum increment value (FFFFFF or 16777215).
+	// When the microscope starts, it sets it home position to (0, 0, 0). Values in the negative range are then adressed as (16777215 - positionInInc).
+	// Hence, we consider all values > 16777215/2 to actually be negative and wrap them accordingly (similar to what positive_modulo(...,...) for the setPosition() functions does).
+	if (pos > m_rangeFocus / 2) {
+		pos -= m_rangeFocus;
+	}
+	return pos * m_umperinc;
+}
+
 
 /*
  * Functions regarding the stage of the microscope
@@ -557,6 +705,10 @@ double MCU::getX() {
 	return getPosition("X");
 }
 
+std::future<std::string> MCU::getX(const std::function<void(double)>& callback) {
+	return getPosition("X", callback);
+}
+
 void MCU::setX(double position) {
 	setPosition("X", position);
 }
@@ -565,6 +717,10 @@ double MCU::getY() {
 	return getPosition("Y");
 }
 
+std::future<std::string> MCU::getY(const std::function<void(double)>& callback) {
+	return getPosition("Y", callback);
+}
+
 void MCU::setY(double position) {
 	setPosition("Y", position);
 }
@@ -598,8 +754,17 @@ void MCU::setPosition(const std::string& axis, double position) {
 }
 
 double MCU::getPosition(const std::string& axis) {
-	auto position = receive(axis + "p");
-	auto pos = helper::hex2dec(position);
+	return positionFromAnswer(receive(axis + "p"));
+}
+
+std::future<std::string> MCU::getPosition(const std::string& axis, const std::function<void(double)>& callback) {
+	return receiveAsync(axis + "p", [this, callback](const std::string& answer) {
+		callback(answer.empty() ? NAN : positionFromAnswer(answer));
+	});
+}
+
+double MCU::positionFromAnswer(const std::string& answer) {
+	auto pos = helper::hex2dec(answer);
 	// The actual travel range of the stage is significantly smaller than the theoretically possible maximum increment value (FFFFFF or 16777215).
 	// When the microscope starts, it sets it home position to (0, 0, 0). Values in the negative range are then adressed as (16777215 - positionInInc).
 	// Hence, we consider all values > 16777215/2 to actually be negative and wrap them accordingly (similar to what positive_modulo(...,...) for the setPosition() functions does).
@@ -19,6 +19,8 @@ public:
 
 protected:
 	std::string receive(const std::string& request);
+	// Sends the request without waiting, the parsed answer is handed to the callback when it arrives
+	std::future<std::string> receiveAsync(const std::string& request, const std::function<void(const std::string&)>& callback);
 	void send(const std::string& message);
 	void clear();
 	std::string requestVersion();
@@ -55,9 +57,21 @@ public:
 	void setLamp(int position, bool block = false);
 	int getLamp();
 
+	// Request the position without waiting, the callback gets -1 if there is no answer
+	std::future<std::string> getReflector(const std::function<void(int)>& callback);
+	std::future<std::string> getObjective(const std::function<void(int)>& callback);
+	std::future<std::string> getTubelens(const std::function<void(int)>& callback);
+	std::future<std::string> getBaseport(const std::function<void(int)>& callback);
+	std::future<std::string> getSideport(const std::function<void(int)>& callback);
+	std::future<std::string> getRLShutter(const std::function<void(int)>& callback);
+	std::future<std::string> getMirror(const std::function<void(int)>& callback);
+	std::future<std::string> getLamp(const std::function<void(int)>& callback);
+
 private:
 	void setElementPosition(const std::string& device, int position, const std::string& identifier = "R");
 	int getElementPosition(const std::string& device, const std::string& identifier = "r");
+	std::future<std::string> getElementPosition(const std::string& device, const std::string& identifier, const std::function<void(int)>& callback);
+	static int elementPositionFromAnswer(const std::string& answer);
 	void blockUntilPositionReached(bool block, const std::string& elementNr, const std::string& identifier = "r");
 };
 
@@ -68,6 +82,8 @@ public:
 
 	void setZ(double position);
 	double getZ();
+	// Requests the position without waiting, the callback gets NaN if there is no answer
+	std::future<std::string> getZ(const std::function<void(double)>& callback);
 
 	void setVelocityZ(double velocity);
 
@@ -80,6 +96,8 @@ public:
 	void move2Work();
 
 private:
+	double positionFromAnswer(const std::string& answer);
+
 	double m_umperinc{ 0.025 };		// [m per increment] constant for converting m to increments of focus z-position
 	int m_rangeFocus{ 16777215 };	// number of focus increments
 };
@@ -95,6 +113,10 @@ public:
 	void setY(double position);
 	double getY();
 
+	// Request the position without waiting, the callback gets NaN if there is no answer
+	std::future<std::string> getX(const std::function<void(double)>& callback);
+	std::future<std::string> getY(const std::function<void(double)>& callback);
+
 	void setVelocityX(int velocity);
 	void setVelocityY(int velocity);
 
@@ -104,6 +126,8 @@ public:
 private:
 	void setPosition(const std::string& axis, double position);
 	double getPosition(const std::string& axis);
+	std::future<std::string> getPosition(const std::string& axis, const std::function<void(double)>& callback);
+	double positionFromAnswer(const std::string& answer);
 
 	void setVelocity(const std::string& axis, int velocity);
 
@@ -121,6 +145,7 @@ public:
 	void setPosition(POINT3 position) override;
 	void setPosition(POINT2 position) override;
 	POINT3 getPosition(PositionType positionType = PositionType::BOTH) override;
+	bool waitForPosition(const POINT3& position, int timeout = 1000) override;
 
 	void setDevice(com *device);
 
@@ -133,6 +158,13 @@ public slots:
 	void getElements() override;
 
 private:
+	// Send all requests at once, the last callback announces the result
+	std::future<std::string> requestPosition();
+	std::future<std::string> requestElements();
+	// Update the positions from the timers without waiting for the answers
+	void pollPosition();
+	void pollElements();
+
 	void setBeamBlock(int position);
 	int getBeamBlock();
 
@@ -146,6 +178,9 @@ private:
 
 	char const* m_serialNo_FF2{ "37000251" };
 
+	bool m_positionPollPending{ false };	// a position request is waiting for its answers
+	bool m_elementPollPending{ false };		// an element request is waiting for its answers
+
 	enum class DEVICE_ELEMENT {
 		BEAMBLOCK,
 		OBJECTIVE,
@@ -36,6 +36,9 @@ ZeissMTB::ZeissMTB() noexcept {
 	registerCapability(Capabilities::TranslationStage);
 	registerCapability(Capabilities::ScaleCalibration);
 
+	// Approximate travel times of the stage and the focus drive, used to plan the scans
+	m_motionModel = { { 1, 50 }, { 1, 50 }, { 0.5, 50 } };
+
 	/*
 	 * Initialize the scale calibration with default values (determined for a 40x objective)
 	 */
@@ -97,6 +100,11 @@ void ZeissMTB::setPosition(POINT3 position) {
 	setPosition(POINT2{ position.x, position.y });
 }
 
+bool ZeissMTB::waitForPosition(const POINT3& position, int timeout) {
+	// The MTB moves synchronously, setPosition only returns after the position was reached.
+	return true;
+}
+
 POINT3 ZeissMTB::getPosition(PositionType positionType) {
 	// Update the positions from the hardware
 	if (m_stageX && m_stageY) {
@@ -21,6 +21,7 @@ public:
 	void setPosition(POINT2 position) override;
 	void setPosition(POINT3 position) override;
 	POINT3 getPosition(PositionType positionType = PositionType::BOTH) override;
+	bool waitForPosition(const POINT3& position, int timeout = 1000) override;
 
 public slots:
 	void init() override;
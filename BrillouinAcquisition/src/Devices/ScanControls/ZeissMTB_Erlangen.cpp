@@ -35,6 +35,9 @@ ZeissMTB_Erlangen::ZeissMTB_Erlangen() noexcept {
 	registerCapability(Capabilities::TranslationStage);
 	registerCapability(Capabilities::ScaleCalibration);
 
+	// Approximate travel times of the stage and the focus drive, used to plan the scans
+	m_motionModel = { { 1, 50 }, { 1, 50 }, { 0.5, 50 } };
+
 	/*
 	 * Initialize the scale calibration with default values (determined for a 20x objective)
 	 */
@@ -101,6 +104,11 @@ void ZeissMTB_Erlangen::setPosition(POINT3 position) {
 	setPosition(POINT2{ position.x, position.y });
 }
 
+bool ZeissMTB_Erlangen::waitForPosition(const POINT3& position, int timeout) {
+	// The MTB moves synchronously, setPosition only returns after the position was reached.
+	return true;
+}
+
 POINT3 ZeissMTB_Erlangen::getPosition(PositionType positionType) {
 	if (m_stageX && m_stageY) {
 		m_positionStage.x = m_stageX->GetPosition("m");
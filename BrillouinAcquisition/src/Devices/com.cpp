@@ -6,36 +6,84 @@
 *
 */
 
-std::string com::receive(std::string request) {
-	request = request + m_terminator;
-	writeToDevice(request.c_str());
+com::com(const std::string& terminator) : m_terminator(terminator), m_commands(terminator) {
+	// the replies are framed as soon as they arrive
+	QObject::connect(this, &QSerialPort::readyRead, this, [this]() { handleData(readAll()); });
 
-	std::string response = "";
-	if (waitForBytesWritten(1000)) {
-		// read response
-		if (waitForReady(1000)) {
-			QByteArray responseData = readAll();
-			while (waitForReady(50))
-				responseData += readAll();
+	m_expiryTimer.setSingleShot(true);
+	QObject::connect(&m_expiryTimer, &QTimer::timeout, this, [this]() {
+		m_commands.expire();
+		scheduleExpiry();
+	});
+}
 
-			response = responseData;
-		}
-	}
+std::string com::receive(std::string request, const std::string& replyPrefix) {
+	auto reply = enqueue(std::move(request), nullptr, replyPrefix);
+	return waitForReply(reply);
+}
 
-	return response;
+std::future<std::string> com::receiveAsync(std::string request, CommandQueue::Callback callback, const std::string& replyPrefix) {
+	auto reply = enqueue(std::move(request), std::move(callback), replyPrefix);
+	scheduleExpiry();
+	return reply;
 }
 
-bool com::waitForReady(int timeout) {
-	waitForReadyRead(5);
-	QElapsedTimer elapsed;
-	elapsed.start();
-	while (bytesAvailable() == 0 && elapsed.elapsed() < timeout) {
-		waitForReadyRead(5);
+std::string com::waitForReply(std::future<std::string>& reply) {
+	while (reply.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		waitForData(std::max(m_commands.timeUntilExpiry(), 1));
+		m_commands.expire();
 	}
-	if (elapsed.elapsed() < timeout) {
+	scheduleExpiry();
+	return reply.get();
+}
+
+bool com::hasPendingReplies() const {
+	return m_commands.pending() > 0;
+}
+
+void com::close() {
+	m_expiryTimer.stop();
+	m_commands.clear();
+	QSerialPort::close();
+}
+
+bool com::waitForData(int timeout) {
+	// data which arrived without being handled yet
+	if (bytesAvailable() > 0) {
+		handleData(readAll());
 		return true;
 	}
-	return false;
+	if (!isOpen()) {
+		QThread::msleep(timeout);
+		return false;
+	}
+	// emits readyRead when data arrives
+	return waitForReadyRead(timeout);
+}
+
+void com::handleData(const QByteArray& data) {
+	if (data.isEmpty()) {
+		return;
+	}
+	m_commands.receive(data.constData(), data.size());
+	scheduleExpiry();
+}
+
+std::future<std::string> com::enqueue(std::string request, CommandQueue::Callback callback, const std::string& replyPrefix) {
+	// register before writing, the reply might be handled while writing
+	auto reply = m_commands.expectReply(replyPrefix, std::chrono::milliseconds(m_timeout), std::move(callback));
+	request = request + m_terminator;
+	writeToDevice(request.c_str());
+	return reply;
+}
+
+void com::scheduleExpiry() {
+	auto timeout = m_commands.timeUntilExpiry();
+	if (timeout < 0) {
+		m_expiryTimer.stop();
+	} else {
+		m_expiryTimer.start(timeout);
+	}
 }
 
 void com::send(std::string message) {
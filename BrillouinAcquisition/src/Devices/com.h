@@ -9,19 +9,49 @@
 #include <QtCore>
 #include <gsl/gsl>
 
+#include "commandQueue.h"
+
+/*
+ * Serial port which frames the replies by the terminator.
+ *
+ * The replies are handled as soon as the port signals new data, so several requests
+ * can be in flight and a request returns as soon as its reply is complete.
+ * All functions have to be called from the thread the port lives in.
+ */
 class com : public QSerialPort {
 public:
-	com() {};
-	explicit com(const std::string& terminator) : m_terminator(terminator) {};
+	com() : com("\r") {};
+	explicit com(const std::string& terminator);
 
 	virtual qint64 writeToDevice(const char* data);
 
-	std::string receive(std::string request);
+	// Sends the request and waits for the reply, returns an empty string on timeout
+	std::string receive(std::string request, const std::string& replyPrefix = "");
 	void send(std::string message);
 
+	// Sends the request without waiting, the reply completes the future and is handed to the callback.
+	// A reply which does not start with the replyPrefix is not taken as the reply of this request.
+	std::future<std::string> receiveAsync(std::string request, CommandQueue::Callback callback = nullptr, const std::string& replyPrefix = "");
+	// Waits for the reply of an asynchronous request, the replies of earlier requests are handled meanwhile
+	std::string waitForReply(std::future<std::string>& reply);
+	bool hasPendingReplies() const;
+
+	void close() override;
+
 protected:
+	// Waits for new data and hands it to handleData(), returns false on timeout
+	virtual bool waitForData(int timeout);
+	void handleData(const QByteArray& data);
+
 	std::string m_terminator{ "\r" };
-	bool waitForReady(int timeout);
+	int m_timeout{ 1000 };	// [ms]	time a request waits for its reply
+
+private:
+	std::future<std::string> enqueue(std::string request, CommandQueue::Callback callback, const std::string& replyPrefix);
+	void scheduleExpiry();
+
+	CommandQueue m_commands;
+	QTimer m_expiryTimer;
 };
 
 class helper {
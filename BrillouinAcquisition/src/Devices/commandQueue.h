@@ -0,0 +1,126 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+
+/*
+ * Matches the replies of a serial device to the commands waiting for them.
+ *
+ * Commands are written right away and wait here for their reply, so several of them can
+ * be in flight. The received bytes are split into replies at the terminator and every reply
+ * completes the oldest waiting command, the device answers in order. A reply which does not
+ * start with the prefix the command expects is a late reply of a command which timed out
+ * and is dropped. A command without a reply in time completes with an empty reply.
+ *
+ * The queue does no I/O itself, the owner feeds it the received bytes.
+ */
+class CommandQueue {
+
+public:
+	typedef std::function<void(const std::string& reply)> Callback;
+
+	explicit CommandQueue(std::string terminator = "\r") : m_terminator(std::move(terminator)) {};
+
+	/*
+	 * Registers a command which was just written, the reply includes the terminator
+	 */
+	std::future<std::string> expectReply(const std::string& prefix, std::chrono::milliseconds timeout, Callback callback = nullptr) {
+		auto command = WAITING_COMMAND{ prefix, std::chrono::steady_clock::now() + timeout, std::promise<std::string>{}, std::move(callback) };
+		auto reply = command.reply.get_future();
+		m_waiting.push_back(std::move(command));
+		return reply;
+	}
+
+	/*
+	 * Splits the received bytes into replies, returns the number of completed commands
+	 */
+	int receive(const char* data, size_t length) {
+		m_partial.append(data, length);
+		auto completed{ 0 };
+		size_t end{ 0 };
+		while ((end = m_partial.find(m_terminator)) != std::string::npos) {
+			auto reply = m_partial.substr(0, end + m_terminator.size());
+			m_partial.erase(0, end + m_terminator.size());
+			if (m_waiting.empty() || reply.compare(0, m_waiting.front().prefix.size(), m_waiting.front().prefix) != 0) {
+				m_droppedReplies++;
+				continue;
+			}
+			completeFirst(reply);
+			completed++;
+		}
+		return completed;
+	}
+
+	/*
+	 * Completes the commands waiting longer than their timeout with an empty reply
+	 */
+	int expire(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+		auto expired{ 0 };
+		while (!m_waiting.empty() && m_waiting.front().deadline <= now) {
+			// an incomplete reply would garble the next one
+			m_partial.clear();
+			completeFirst("");
+			expired++;
+		}
+		return expired;
+	}
+
+	/*
+	 * [ms]	time until the oldest command times out, -1 if no command is waiting
+	 */
+	int timeUntilExpiry(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+		if (m_waiting.empty()) {
+			return -1;
+		}
+		auto remaining = std::chrono::ceil<std::chrono::milliseconds>(m_waiting.front().deadline - now).count();
+		return (int)std::max(remaining, decltype(remaining){ 0 });
+	}
+
+	/*
+	 * Completes all waiting commands with an empty reply, e.g. when the port is closed
+	 */
+	void clear() {
+		m_partial.clear();
+		while (!m_waiting.empty()) {
+			completeFirst("");
+		}
+	}
+
+	size_t pending() const {
+		return m_waiting.size();
+	}
+
+	int droppedReplies() const {
+		return m_droppedReplies;
+	}
+
+private:
+	struct WAITING_COMMAND {
+		std::string prefix;
+		std::chrono::steady_clock::time_point deadline;
+		std::promise<std::string> reply;
+		Callback callback;
+	};
+
+	void completeFirst(const std::string& reply) {
+		// the callback might already send the next command
+		auto command = std::move(m_waiting.front());
+		m_waiting.pop_front();
+		command.reply.set_value(reply);
+		if (command.callback) {
+			command.callback(reply);
+		}
+	}
+
+	std::string m_terminator;
+	std::string m_partial;
+	std::deque<WAITING_COMMAND> m_waiting;
+	int m_droppedReplies{ 0 };
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,343 @@
+#include "stdafx.h"
+#include "acquisitionBenchmark.h"
+#include "version.h"
+#include "Acquisition/Acquisition.h"
+#include "Acquisition/AcquisitionModes/Brillouin.h"
+#include "Acquisition/AcquisitionModes/ODT.h"
+#include "Acquisition/AcquisitionModes/Fluorescence.h"
+#include "Devices/Cameras/MockCamera.h"
+#include "Devices/ScanControls/MockScanControl.h"
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+namespace {
+	long long workingSetSize() {
+		auto counters = PROCESS_MEMORY_COUNTERS{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return 0;
+		}
+		return (long long)counters.WorkingSetSize;
+	}
+
+	// nearest-rank percentile of sorted values
+	double percentile(const std::vector<double>& sorted, double p) {
+		if (sorted.empty()) {
+			return 0;
+		}
+		auto rank = (size_t)std::ceil(p / 100 * sorted.size());
+		return sorted[std::clamp(rank, (size_t)1, sorted.size()) - 1];
+	}
+
+	QString modeName(ACQUISITION_MODE mode) {
+		switch (mode) {
+			case ACQUISITION_MODE::ODT:
+				return "odt";
+			case ACQUISITION_MODE::FLUORESCENCE:
+				return "fluorescence";
+			default:
+				return "brillouin";
+		}
+	}
+
+	// parses "100x200" or "10x10x1" into its numbers
+	std::vector<int> parseSize(const QString& value) {
+		auto size = std::vector<int>{};
+		for (const auto& part : value.split('x')) {
+			size.push_back(part.toInt());
+		}
+		return size;
+	}
+}
+
+/*
+ * Public definitions
+ */
+
+BENCHMARK_RESULT AcquisitionBenchmark::measure(const BENCHMARK_SETTINGS& settings) {
+	auto result = BENCHMARK_RESULT{};
+	result.settings = settings;
+
+	auto path = StoragePath{ "Benchmark_" + std::to_string(m_runNumber++) + ".h5", m_folder };
+	QFile::remove(QString::fromStdString(path.fullPath()));
+
+	// sample the working set while the acquisition runs
+	auto sampling = std::atomic<bool>{ true };
+	auto peakRSS = std::atomic<long long>{ workingSetSize() };
+	auto sampler = std::thread([&sampling, &peakRSS]() {
+		while (sampling) {
+			peakRSS = std::max(peakRSS.load(), workingSetSize());
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	});
+
+	auto acquisition = new Acquisition(nullptr);
+	acquisition->newFile(path);
+	auto storageSettings = acquisition->getStorageSettings();
+	storageSettings.layout = settings.layout;
+	storageSettings.recordTimings = true;
+	acquisition->setStorageSettings(storageSettings);
+
+	Camera* camera = new MockCamera();
+	camera->connectDevice();
+	auto cameraSettings = CAMERA_SETTINGS{ settings.exposureTime, 0 };
+	cameraSettings.roi.width_physical = settings.roiWidth;
+	cameraSettings.roi.height_physical = settings.roiHeight;
+	cameraSettings.frameCount = settings.frameCount;
+	cameraSettings.readout.pixelEncoding = (settings.bitDepth == 8) ? L"8 bit" : L"16 bit";
+	camera->setSettings(cameraSettings);
+	cameraSettings = camera->getSettings();
+
+	ScanControl* scanControl = new MockScanControl();
+	scanControl->connectDevice();
+
+	AcquisitionMode* mode{ nullptr };
+	switch (settings.mode) {
+		case ACQUISITION_MODE::ODT: {
+			auto odt = new ODT(nullptr, acquisition, &camera, (ODTControl**)&scanControl);
+			odt->init();
+			odt->setSettings(ODT_SETTINGS{ 0.3, settings.odtPoints, 100, {} });
+			odt->setCameraSetting(CAMERA_SETTING::EXPOSURE, settings.exposureTime);
+			mode = odt;
+			break;
+		}
+		case ACQUISITION_MODE::FLUORESCENCE: {
+			auto fluorescence = new Fluorescence(nullptr, acquisition, &camera, &scanControl);
+			for (auto channel : { FLUORESCENCE_MODE::BLUE, FLUORESCENCE_MODE::GREEN, FLUORESCENCE_MODE::RED, FLUORESCENCE_MODE::BRIGHTFIELD }) {
+				fluorescence->setExposure(channel, (int)(1e3 * settings.exposureTime));
+			}
+			mode = fluorescence;
+			break;
+		}
+		default: {
+			auto brillouin = new Brillouin(nullptr, acquisition, &camera, &scanControl);
+			auto brillouinSettings = BRILLOUIN_SETTINGS{};
+			brillouinSettings.preCalibration = false;
+			brillouinSettings.postCalibration = false;
+			brillouinSettings.conCalibration = false;
+			brillouinSettings.xMax = settings.xSteps - 1.0;
+			brillouinSettings.xSteps = settings.xSteps;
+			brillouinSettings.yMax = settings.ySteps - 1.0;
+			brillouinSettings.ySteps = settings.ySteps;
+			brillouinSettings.zMax = settings.zSteps - 1.0;
+			brillouinSettings.zSteps = settings.zSteps;
+			brillouinSettings.camera = cameraSettings;
+			brillouin->setSettings(brillouinSettings);
+			mode = brillouin;
+			break;
+		}
+	}
+
+	// the modes report the end of the acquisition after the storage finished writing
+	QEventLoop loop;
+	QWidget::connect(
+		mode,
+		&AcquisitionMode::s_acquisitionStatus,
+		&loop,
+		[&loop](ACQUISITION_STATUS status) {
+			if (status == ACQUISITION_STATUS::FINISHED || status == ACQUISITION_STATUS::ABORTED) {
+				loop.quit();
+			}
+		}
+	);
+	auto timer = QElapsedTimer{};
+	timer.start();
+	QTimer::singleShot(0, mode, [mode]() { mode->startRepetitions(); });
+	loop.exec();
+	result.duration = 1e-9 * timer.nsecsElapsed();
+
+	auto timings = acquisition->m_storage->takeWriteTimings();
+	// the ROI might have been changed by the mode
+	auto bytesPerFrame = (long long)camera->getSettings().roi.bytesPerFrame;
+
+	delete mode;
+	delete scanControl;
+	delete camera;
+	delete acquisition;
+
+	sampling = false;
+	sampler.join();
+	result.peakRSS = peakRSS;
+
+	auto latencies = std::vector<double>{};
+	latencies.reserve(timings.size());
+	auto first = std::chrono::steady_clock::time_point::max();
+	auto last = std::chrono::steady_clock::time_point::min();
+	for (const auto& timing : timings) {
+		if (timing.kind == PAYLOAD_KIND::CALIBRATION) {
+			continue;
+		}
+		latencies.push_back(1e-6 * std::chrono::duration_cast<std::chrono::nanoseconds>(timing.written - timing.enqueued).count());
+		result.bytesWritten += timing.bytes;
+		result.payloads++;
+		first = std::min(first, timing.enqueued);
+		last = std::max(last, timing.written);
+	}
+	std::sort(latencies.begin(), latencies.end());
+	result.latencyP50 = percentile(latencies, 50);
+	result.latencyP90 = percentile(latencies, 90);
+	result.latencyP99 = percentile(latencies, 99);
+	result.latencyMax = latencies.empty() ? 0 : latencies.back();
+
+	if (bytesPerFrame > 0) {
+		result.frames = result.bytesWritten / bytesPerFrame;
+	}
+	if (result.payloads > 0 && last > first) {
+		result.framesPerSecond = result.frames / (1e-9 * std::chrono::duration_cast<std::chrono::nanoseconds>(last - first).count());
+	}
+
+	result.fileSize = QFileInfo(QString::fromStdString(path.fullPath())).size();
+	QFile::remove(QString::fromStdString(path.fullPath()));
+
+	return result;
+}
+
+QJsonObject AcquisitionBenchmark::toJson(const BENCHMARK_RESULT& result) {
+	const auto& settings = result.settings;
+	auto json = QJsonObject{};
+	json["mode"] = modeName(settings.mode);
+	json["roiWidth"] = settings.roiWidth;
+	json["roiHeight"] = settings.roiHeight;
+	json["bitDepth"] = settings.bitDepth;
+	json["map"] = QJsonArray{ settings.xSteps, settings.ySteps, settings.zSteps };
+	json["frameCount"] = settings.frameCount;
+	json["odtPoints"] = settings.odtPoints;
+	json["exposureTime"] = settings.exposureTime;
+	json["layout"] = (settings.layout == STORAGE_LAYOUT::CHUNKED) ? "chunked" : "per-position";
+
+	json["frames"] = result.frames;
+	json["payloads"] = result.payloads;
+	json["duration"] = result.duration;
+	json["framesPerSecond"] = result.framesPerSecond;
+	json["latencyP50"] = result.latencyP50;
+	json["latencyP90"] = result.latencyP90;
+	json["latencyP99"] = result.latencyP99;
+	json["latencyMax"] = result.latencyMax;
+	json["bytesWritten"] = result.bytesWritten;
+	json["fileSize"] = result.fileSize;
+	json["peakRSS"] = result.peakRSS;
+	return json;
+}
+
+/*
+ * Options:
+ *	--mode		brillouin, odt or fluorescence
+ *	--roi		ROI size as <width>x<height>, Brillouin only
+ *	--bits		pixel encoding, 8 or 16
+ *	--map		map size as <x>x<y>x<z>, Brillouin only
+ *	--frames	frames per Brillouin position
+ *	--points	number of ODT illumination angles
+ *	--exposure	exposure time [ms]
+ *	--layout	per-position or chunked
+ *	--repeat	runs per configuration
+ *	--folder	folder for the temporary files
+ *	--output	file to write the JSON results to, printed if omitted
+ *
+ * --mode, --roi, --bits and --map take comma separated lists.
+ */
+int AcquisitionBenchmark::run(const QStringList& arguments) {
+	auto parser = QCommandLineParser{};
+	parser.addOptions({
+		{ "benchmark", "Run the acquisition benchmark." },
+		{ "mode", "Acquisition modes.", "modes", "brillouin" },
+		{ "roi", "ROI sizes.", "sizes", "100x100" },
+		{ "bits", "Pixel encodings.", "bits", "16" },
+		{ "map", "Map sizes.", "sizes", "10x10x1" },
+		{ "frames", "Frames per position.", "count", "2" },
+		{ "points", "ODT illumination angles.", "count", "150" },
+		{ "exposure", "Exposure time [ms].", "time", "0" },
+		{ "layout", "Storage layout.", "layout", "per-position" },
+		{ "repeat", "Runs per configuration.", "count", "1" },
+		{ "folder", "Folder for the temporary files.", "folder", QDir::tempPath() },
+		{ "output", "File to write the results to.", "file" }
+	});
+	if (!parser.parse(arguments)) {
+		std::cerr << parser.errorText().toStdString() << std::endl;
+		return 1;
+	}
+
+	auto modes = std::vector<ACQUISITION_MODE>{};
+	for (const auto& mode : parser.value("mode").split(',')) {
+		if (mode == "odt") {
+			modes.push_back(ACQUISITION_MODE::ODT);
+		} else if (mode == "fluorescence") {
+			modes.push_back(ACQUISITION_MODE::FLUORESCENCE);
+		} else {
+			modes.push_back(ACQUISITION_MODE::BRILLOUIN);
+		}
+	}
+
+	auto configurations = std::vector<BENCHMARK_SETTINGS>{};
+	for (auto mode : modes) {
+		for (const auto& roi : parser.value("roi").split(',')) {
+			for (const auto& bits : parser.value("bits").split(',')) {
+				for (const auto& map : parser.value("map").split(',')) {
+					auto settings = BENCHMARK_SETTINGS{};
+					settings.mode = mode;
+					auto roiSize = parseSize(roi);
+					if (roiSize.size() == 2) {
+						settings.roiWidth = roiSize[0];
+						settings.roiHeight = roiSize[1];
+					}
+					settings.bitDepth = bits.toInt();
+					auto mapSize = parseSize(map);
+					if (mapSize.size() == 3) {
+						settings.xSteps = mapSize[0];
+						settings.ySteps = mapSize[1];
+						settings.zSteps = mapSize[2];
+					}
+					settings.frameCount = parser.value("frames").toInt();
+					settings.odtPoints = parser.value("points").toInt();
+					settings.exposureTime = 1e-3 * parser.value("exposure").toDouble();
+					settings.layout = (parser.value("layout") == "chunked") ? STORAGE_LAYOUT::CHUNKED : STORAGE_LAYOUT::PER_POSITION;
+					configurations.push_back(settings);
+				}
+			}
+		}
+	}
+
+	auto benchmark = AcquisitionBenchmark{ parser.value("folder").toStdString() };
+	auto results = QJsonArray{};
+	auto repeat = std::max(1, parser.value("repeat").toInt());
+	for (const auto& settings : configurations) {
+		for (gsl::index i{ 0 }; i < repeat; i++) {
+			auto result = benchmark.measure(settings);
+			results.append(toJson(result));
+
+			auto summary = QString("%1 %2x%3 %4 bit: %5 frames/s, latency p50 %6 ms, p99 %7 ms, peak RSS %8 MB")
+				.arg(modeName(settings.mode))
+				.arg(settings.roiWidth)
+				.arg(settings.roiHeight)
+				.arg(settings.bitDepth)
+				.arg(result.framesPerSecond, 0, 'f', 1)
+				.arg(result.latencyP50, 0, 'f', 2)
+				.arg(result.latencyP99, 0, 'f', 2)
+				.arg(1e-6 * result.peakRSS, 0, 'f', 1);
+			std::cerr << summary.toStdString() << std::endl;
+		}
+	}
+
+	auto output = QJsonObject{};
+	output["version"] = QString("%1.%2.%3").arg(Version::MAJOR).arg(Version::MINOR).arg(Version::PATCH);
+	output["commit"] = QString::fromStdString(Version::Commit);
+	output["date"] = QDateTime::currentDateTime().toOffsetFromUtc(QDateTime::currentDateTime().offsetFromUtc())
+		.toString(Qt::ISODateWithMs);
+	output["results"] = results;
+	auto document = QJsonDocument{ output }.toJson();
+
+	if (parser.isSet("output")) {
+		auto file = QFile{ parser.value("output") };
+		if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+			std::cerr << "Could not write " << parser.value("output").toStdString() << std::endl;
+			return 1;
+		}
+		file.write(document);
+	} else {
+		std::cout << document.toStdString() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ACQUISITIONBENCHMARK_H
+#define ACQUISITIONBENCHMARK_H
+
+#include "storageWrapper.h"
+
+#include <QJsonObject>
+#include <QStringList>
+
+struct BENCHMARK_SETTINGS {
+	ACQUISITION_MODE mode{ ACQUISITION_MODE::BRILLOUIN };
+	int roiWidth{ 100 };			// [pix]	width of the camera ROI, Brillouin only
+	int roiHeight{ 100 };			// [pix]	height of the camera ROI, Brillouin only
+	int bitDepth{ 16 };				// [bit]	pixel encoding of the camera, 8 or 16
+	int xSteps{ 10 };				// [1]		Brillouin map size in x-direction
+	int ySteps{ 10 };				// [1]		Brillouin map size in y-direction
+	int zSteps{ 1 };				// [1]		Brillouin map size in z-direction
+	int frameCount{ 2 };			// [1]		frames per Brillouin position
+	int odtPoints{ 150 };			// [1]		number of ODT illumination angles
+	double exposureTime{ 0 };		// [s]		exposure time of the mock camera
+	STORAGE_LAYOUT layout{ STORAGE_LAYOUT::PER_POSITION };
+};
+
+struct BENCHMARK_RESULT {
+	BENCHMARK_SETTINGS settings;
+	long long frames{ 0 };			// [1]		frames written to the file
+	long long payloads{ 0 };		// [1]		payloads written to the file
+	double duration{ 0 };			// [s]		from starting the mode until the file was written
+	double framesPerSecond{ 0 };	// [1/s]	frames written between the first payload queued and the last one written
+	double latencyP50{ 0 };			// [ms]		time from queueing a payload until it was written
+	double latencyP90{ 0 };			// [ms]
+	double latencyP99{ 0 };			// [ms]
+	double latencyMax{ 0 };			// [ms]
+	long long bytesWritten{ 0 };	// [B]		image data written
+	long long fileSize{ 0 };		// [B]		size of the resulting file
+	long long peakRSS{ 0 };			// [B]		largest working set of the process during the run
+};
+
+/*
+ * Runs complete acquisitions with the mock camera and the mock scan control
+ * and measures how fast the frames end up in the file.
+ *
+ * Started with "BrillouinAcquisition.exe --benchmark", see run() for the options.
+ * The results are written as JSON, so they can be compared between releases.
+ */
+class AcquisitionBenchmark {
+
+public:
+	explicit AcquisitionBenchmark(const std::string& folder) : m_folder(folder) {};
+
+	BENCHMARK_RESULT measure(const BENCHMARK_SETTINGS& settings);
+
+	static QJsonObject toJson(const BENCHMARK_RESULT& result);
+
+	/*
+	 * Parses the command line, runs every combination of the given options and
+	 * writes the results. Returns the exit code of the application.
+	 */
+	static int run(const QStringList& arguments);
+
+private:
+	std::string m_folder;
+	int m_runNumber{ 0 };
+};
+
+#endif // ACQUISITIONBENCHMARK_H
@@ -0,0 +1,485 @@
+#ifndef BRILLOUINANALYSIS_H
+#define BRILLOUINANALYSIS_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../external/eigen/Eigen/Dense"
+#include "POINTS.h"
+#include "pipelineStage.h"
+#include "threadPool.h"
+
+struct BRILLOUIN_ANALYSIS_SETTINGS {
+	bool enabled{ true };				// [bool]	evaluate the spectra during the scan
+	// The spectrum is read along the line from the start to the end point in the binned camera image.
+	// If both points are equal, the middle row of the image is used.
+	double startX{ 0 };					// [pix]
+	double startY{ 0 };					// [pix]
+	double endX{ 0 };					// [pix]
+	double endY{ 0 };					// [pix]
+	int lineWidth{ 3 };					// [pix]	pixels perpendicular to the line which are averaged
+	int fitRadius{ 8 };					// [pix]	half width of the range fitted around a peak
+	int rayleighExclusion{ 10 };		// [pix]	half width around the Rayleigh peak not searched for the Brillouin peak
+	int queueCapacity{ 16 };			// [1]		positions waiting for the analysis before further positions are skipped
+};
+
+struct SPECTRAL_PEAK {
+	double position{ NAN };				// [pix]	center along the spectrum
+	double width{ NAN };				// [pix]	full width at half maximum
+	double amplitude{ NAN };			// [1]		height above the offset
+	double offset{ NAN };				// [1]		background below the peak
+	bool valid{ false };
+};
+
+struct SPECTRUM_PEAKS {
+	SPECTRAL_PEAK rayleigh;
+	SPECTRAL_PEAK brillouin;
+	double distance{ NAN };				// [pix]	distance between the Rayleigh and the Brillouin peak
+};
+
+/*
+ * Result of one position of the scan
+ */
+struct BRILLOUIN_SHIFT {
+	INDEX3 index;						// [1]		indices of the position
+	double shift{ NAN };				// [GHz]	Brillouin shift, NaN without a calibration
+	double width{ NAN };				// [GHz]	full width at half maximum of the Brillouin peak
+	double distance{ NAN };				// [pix]	distance between the Rayleigh and the Brillouin peak
+	int validFrames{ 0 };				// [1]		frames of the position with both peaks found
+	int analyzedPositions{ 0 };			// [1]		positions analyzed in this scan
+	int skippedPositions{ 0 };			// [1]		positions skipped because the analysis fell behind
+};
+
+/*
+ * Brillouin shifts of all positions of a scan, in the same order as the positions in the file:
+ * index = (z * dimX + x) * dimY + y. Positions which were not analyzed (yet) are NaN.
+ */
+struct SHIFT_MAP {
+	int dimX{ 0 };
+	int dimY{ 0 };
+	int dimZ{ 0 };
+	std::vector<double> shift;			// [GHz]
+	std::vector<double> width;			// [GHz]
+	int analyzedPositions{ 0 };
+	int skippedPositions{ 0 };
+
+	double& at(std::vector<double>& values, const INDEX3& index) {
+		return values[((size_t)index.z * dimX + index.x) * dimY + index.y];
+	}
+};
+
+/*
+ * Samples the spectrum along a line of the camera image.
+ *
+ * The pixels and bilinear weights of every sample are calculated once per line,
+ * so reading a spectrum is a short weighted sum per sample.
+ */
+class SpectrumLine {
+
+public:
+	void setLine(const BRILLOUIN_ANALYSIS_SETTINGS& settings, int dim_x, int dim_y) {
+		m_dim_x = dim_x;
+		m_dim_y = dim_y;
+		auto startX = settings.startX;
+		auto startY = settings.startY;
+		auto endX = settings.endX;
+		auto endY = settings.endY;
+		if (startX == endX && startY == endY) {
+			startX = 0;
+			endX = dim_x - 1.0;
+			startY = endY = floor((dim_y - 1) / 2.0);
+		}
+		auto lineLength = sqrt(pow(endX - startX, 2) + pow(endY - startY, 2));
+		m_length = std::max(1, (int)round(lineLength) + 1);
+		m_lineWidth = std::max(1, settings.lineWidth);
+
+		// unit vectors along and perpendicular to the line
+		auto directionX = (lineLength > 0) ? (endX - startX) / lineLength : 1.0;
+		auto directionY = (lineLength > 0) ? (endY - startY) / lineLength : 0.0;
+		auto step = (m_length > 1) ? lineLength / (m_length - 1.0) : 0.0;
+
+		auto taps = (size_t)m_length * m_lineWidth * 4;
+		m_indices.assign(taps, 0);
+		m_weights.assign(taps, 0);
+		auto tap = size_t{ 0 };
+		for (gsl::index ii{ 0 }; ii < m_length; ii++) {
+			for (gsl::index kk{ 0 }; kk < m_lineWidth; kk++) {
+				auto offset = kk - (m_lineWidth - 1) / 2.0;
+				auto x = startX + ii * step * directionX - offset * directionY;
+				auto y = startY + ii * step * directionY + offset * directionX;
+				// samples outside of the image are taken from its border
+				x = std::clamp(x, 0.0, dim_x - 1.0);
+				y = std::clamp(y, 0.0, dim_y - 1.0);
+				auto x0 = std::min((int)x, dim_x - 1);
+				auto y0 = std::min((int)y, dim_y - 1);
+				auto x1 = std::min(x0 + 1, dim_x - 1);
+				auto y1 = std::min(y0 + 1, dim_y - 1);
+				auto fx = x - x0;
+				auto fy = y - y0;
+				auto weight = 1.0 / m_lineWidth;
+				m_indices[tap] = y0 * dim_x + x0;
+				m_weights[tap++] = (float)(weight * (1 - fx) * (1 - fy));
+				m_indices[tap] = y0 * dim_x + x1;
+				m_weights[tap++] = (float)(weight * fx * (1 - fy));
+				m_indices[tap] = y1 * dim_x + x0;
+				m_weights[tap++] = (float)(weight * (1 - fx) * fy);
+				m_indices[tap] = y1 * dim_x + x1;
+				m_weights[tap++] = (float)(weight * fx * fy);
+			}
+		}
+	}
+
+	int length() const {
+		return m_length;
+	}
+
+	bool fits(int dim_x, int dim_y) const {
+		return m_dim_x == dim_x && m_dim_y == dim_y;
+	}
+
+	template <typename T>
+	void extract(const T* image, double* spectrum) const {
+		auto tapsPerSample = (size_t)m_lineWidth * 4;
+		for (gsl::index ii{ 0 }; ii < m_length; ii++) {
+			auto indices = &m_indices[ii * tapsPerSample];
+			auto weights = &m_weights[ii * tapsPerSample];
+			auto value{ 0.0f };
+			for (size_t tap{ 0 }; tap < tapsPerSample; tap++) {
+				value += weights[tap] * (float)image[indices[tap]];
+			}
+			spectrum[ii] = value;
+		}
+	}
+
+private:
+	int m_dim_x{ 0 };
+	int m_dim_y{ 0 };
+	int m_length{ 0 };
+	int m_lineWidth{ 1 };
+	std::vector<int> m_indices;
+	std::vector<float> m_weights;
+};
+
+/*
+ * Evaluates the Brillouin spectra while the scan is running.
+ *
+ * The spectra are read from the frames of a position before they are moved into the payload,
+ * so the frames are neither copied nor held back from the storage. The peaks are fitted on
+ * a separate thread, the frames of a position are split across a thread pool. The distance
+ * between the Rayleigh and the Brillouin peak is converted to a frequency with the most recent
+ * calibration, linearly around the Brillouin shift of the calibration sample.
+ * Positions which arrive while the analysis is busy with too many others are skipped,
+ * the acquisition never waits for the analysis.
+ */
+class BrillouinAnalysis {
+
+public:
+	typedef std::function<void(const BRILLOUIN_SHIFT& shift)> Callback;
+
+	explicit BrillouinAnalysis(int threadCount = ThreadPool::defaultThreadCount())
+		: m_threadPool(threadCount), m_stage(std::make_unique<PipelineStage>(m_settings.queueCapacity)) {};
+
+	/*
+	 * Has to be called while no analysis is running
+	 */
+	void setSettings(const BRILLOUIN_ANALYSIS_SETTINGS& settings) {
+		m_stage->finish();
+		if (settings.queueCapacity != m_settings.queueCapacity) {
+			m_stage = std::make_unique<PipelineStage>(std::max(1, settings.queueCapacity));
+		}
+		m_settings = settings;
+		m_line = SpectrumLine{};
+	}
+
+	BRILLOUIN_ANALYSIS_SETTINGS getSettings() const {
+		return m_settings;
+	}
+
+	/*
+	 * Called on the analysis thread for every analyzed position
+	 */
+	void setCallback(Callback callback) {
+		m_callback = std::move(callback);
+	}
+
+	/*
+	 * Starts an empty shift map, the calibration is kept.
+	 * Has to be called while no analysis is running.
+	 */
+	void reset(int dimX, int dimY, int dimZ, int frameWidth, int frameHeight) {
+		m_stage->finish();
+		m_line.setLine(m_settings, frameWidth, frameHeight);
+
+		std::lock_guard<std::mutex> lockGuard(m_mapMutex);
+		m_map = SHIFT_MAP{ dimX, dimY, dimZ };
+		auto size = (size_t)dimX * dimY * dimZ;
+		m_map.shift.assign(size, NAN);
+		m_map.width.assign(size, NAN);
+	}
+
+	int spectrumLength() const {
+		return m_line.length();
+	}
+
+	/*
+	 * Reads the spectra of consecutive frames, called before the frames are handed to the storage
+	 */
+	template <typename T>
+	std::vector<double> extractSpectra(const T* frames, int frameCount, int frameWidth, int frameHeight) {
+		if (!m_line.fits(frameWidth, frameHeight)) {
+			// the queued spectra were read along the previous line
+			m_stage->finish();
+			m_line.setLine(m_settings, frameWidth, frameHeight);
+		}
+		auto length = (size_t)m_line.length();
+		auto spectra = std::vector<double>(length * frameCount);
+		auto frameSize = (size_t)frameWidth * frameHeight;
+		for (gsl::index mm{ 0 }; mm < frameCount; mm++) {
+			m_line.extract(&frames[mm * frameSize], &spectra[mm * length]);
+		}
+		return spectra;
+	}
+
+	/*
+	 * Takes the spectra of a calibration sample with the given Brillouin shift [GHz] as the new calibration.
+	 * Positions queued before keep the previous calibration.
+	 */
+	void calibrate(std::vector<double>&& spectra, double shift) {
+		m_stage->push([this, spectra = std::move(spectra), length = m_line.length(), shift]() {
+			auto peaks = analyzeSpectra(spectra, length);
+			auto distance = meanDistance(peaks);
+			if (std::isfinite(distance) && distance > 0) {
+				m_frequencyPerPixel = shift / distance;
+			}
+		});
+	}
+
+	/*
+	 * Queues the spectra of a position, returns false if the position was skipped
+	 */
+	bool analyze(INDEX3 index, std::vector<double>&& spectra) {
+		auto queued = m_stage->tryPush([this, index, spectra = std::move(spectra), length = m_line.length()]() {
+			auto peaks = analyzeSpectra(spectra, length);
+
+			auto result = BRILLOUIN_SHIFT{ index };
+			result.distance = meanDistance(peaks, &result.validFrames);
+			auto width{ 0.0 };
+			for (const auto& peak : peaks) {
+				if (std::isfinite(peak.distance)) {
+					width += peak.brillouin.width;
+				}
+			}
+			result.shift = result.distance * m_frequencyPerPixel;
+			result.width = width / result.validFrames * m_frequencyPerPixel;
+			{
+				std::lock_guard<std::mutex> lockGuard(m_mapMutex);
+				m_map.at(m_map.shift, index) = result.shift;
+				m_map.at(m_map.width, index) = result.width;
+				result.analyzedPositions = ++m_map.analyzedPositions;
+				result.skippedPositions = m_map.skippedPositions;
+			}
+			if (m_callback) {
+				m_callback(result);
+			}
+		});
+		if (!queued) {
+			std::lock_guard<std::mutex> lockGuard(m_mapMutex);
+			m_map.skippedPositions++;
+		}
+		return queued;
+	}
+
+	/*
+	 * Blocks until all queued positions are analyzed
+	 */
+	void finish() {
+		m_stage->finish();
+	}
+
+	SHIFT_MAP getShiftMap() {
+		std::lock_guard<std::mutex> lockGuard(m_mapMutex);
+		return m_map;
+	}
+
+	/*
+	 * Returns the shift map after all queued positions are analyzed and clears it,
+	 * so that the map of a scan is only stored once. Call reset before the next scan.
+	 */
+	SHIFT_MAP takeShiftMap() {
+		m_stage->finish();
+		std::lock_guard<std::mutex> lockGuard(m_mapMutex);
+		auto map = SHIFT_MAP{};
+		std::swap(map, m_map);
+		return map;
+	}
+
+	/*
+	 * [GHz/pix]	conversion of the peak distance, NaN before the first calibration
+	 */
+	double getFrequencyPerPixel() {
+		m_stage->finish();
+		return m_frequencyPerPixel;
+	}
+
+	/*
+	 * Finds the Rayleigh peak as the brightest value and the Brillouin peak as the brightest value
+	 * outside of the range around the Rayleigh peak, both are fitted with a Lorentzian
+	 */
+	static SPECTRUM_PEAKS findPeaks(const double* spectrum, int length, int fitRadius, int rayleighExclusion) {
+		auto peaks = SPECTRUM_PEAKS{};
+		if (length < 3) {
+			return peaks;
+		}
+		auto rayleigh = (int)(std::max_element(spectrum, spectrum + length) - spectrum);
+		auto brillouin{ -1 };
+		for (gsl::index ii{ 0 }; ii < length; ii++) {
+			if (std::abs(ii - rayleigh) > rayleighExclusion && (brillouin < 0 || spectrum[ii] > spectrum[brillouin])) {
+				brillouin = (int)ii;
+			}
+		}
+		peaks.rayleigh = fitLorentzian(spectrum, length, rayleigh, fitRadius);
+		if (brillouin >= 0) {
+			peaks.brillouin = fitLorentzian(spectrum, length, brillouin, fitRadius);
+		}
+		if (peaks.rayleigh.valid && peaks.brillouin.valid) {
+			peaks.distance = std::abs(peaks.brillouin.position - peaks.rayleigh.position);
+		}
+		return peaks;
+	}
+
+	/*
+	 * Least squares fit of offset + amplitude / (1 + ((x - position) / (width / 2))^2)
+	 * to the values around the guess, with Levenberg-Marquardt iterations
+	 */
+	static SPECTRAL_PEAK fitLorentzian(const double* spectrum, int length, int guess, int radius) {
+		auto peak = SPECTRAL_PEAK{};
+		auto begin = std::max(0, guess - radius);
+		auto end = std::min(length, guess + radius + 1);
+		auto count = end - begin;
+		if (count < 5) {
+			return peak;
+		}
+
+		// initial values from the data
+		auto offset = *std::min_element(&spectrum[begin], &spectrum[end]);
+		auto amplitude = spectrum[guess] - offset;
+		if (amplitude <= 0) {
+			return peak;
+		}
+		auto aboveHalf{ 0 };
+		for (gsl::index ii{ begin }; ii < end; ii++) {
+			aboveHalf += (spectrum[ii] - offset > amplitude / 2);
+		}
+		// parameters: amplitude, position, half width, offset
+		auto parameters = Eigen::Vector4d{ amplitude, (double)guess, std::max(0.5, aboveHalf / 2.0), offset };
+
+		auto residuals = [&](const Eigen::Vector4d& p) {
+			auto sum{ 0.0 };
+			for (gsl::index ii{ begin }; ii < end; ii++) {
+				auto u = (ii - p[1]) / p[2];
+				auto residual = spectrum[ii] - (p[3] + p[0] / (1 + u * u));
+				sum += residual * residual;
+			}
+			return sum;
+		};
+
+		auto lambda{ 1e-3 };
+		auto error = residuals(parameters);
+		auto converged{ false };
+		for (gsl::index iteration{ 0 }; iteration < 50 && !converged; iteration++) {
+			auto normal = Eigen::Matrix4d::Zero().eval();
+			auto gradient = Eigen::Vector4d::Zero().eval();
+			for (gsl::index ii{ begin }; ii < end; ii++) {
+				auto u = (ii - parameters[1]) / parameters[2];
+				auto denominator = 1 / (1 + u * u);
+				auto jacobian = Eigen::Vector4d{
+					denominator,
+					2 * parameters[0] * u * denominator * denominator / parameters[2],
+					2 * parameters[0] * u * u * denominator * denominator / parameters[2],
+					1
+				};
+				auto residual = spectrum[ii] - (parameters[3] + parameters[0] * denominator);
+				normal.noalias() += jacobian * jacobian.transpose();
+				gradient += residual * jacobian;
+			}
+			// increase the damping until the step reduces the error
+			while (true) {
+				auto damped = normal;
+				damped.diagonal() *= (1 + lambda);
+				Eigen::Vector4d step = damped.ldlt().solve(gradient);
+				Eigen::Vector4d candidate = parameters + step;
+				candidate[2] = std::abs(candidate[2]);
+				auto candidateError = residuals(candidate);
+				if (std::isfinite(candidateError) && candidateError <= error) {
+					converged = (error - candidateError) <= 1e-10 * error
+						|| step.cwiseAbs().maxCoeff() < 1e-6;
+					parameters = candidate;
+					error = candidateError;
+					lambda = std::max(lambda / 10, 1e-12);
+					break;
+				}
+				lambda *= 10;
+				if (lambda > 1e10) {
+					converged = true;
+					break;
+				}
+			}
+		}
+
+		peak.amplitude = parameters[0];
+		peak.position = parameters[1];
+		peak.width = 2 * parameters[2];
+		peak.offset = parameters[3];
+		peak.valid = std::isfinite(peak.position) && peak.amplitude > 0
+			&& peak.position >= begin && peak.position <= end - 1 && peak.width < 2.0 * count;
+		return peak;
+	}
+
+private:
+	std::vector<SPECTRUM_PEAKS> analyzeSpectra(const std::vector<double>& spectra, int length) {
+		auto frameCount = (length > 0) ? (gsl::index)(spectra.size() / length) : 0;
+		auto peaks = std::vector<SPECTRUM_PEAKS>(frameCount);
+		m_threadPool.parallelFor(frameCount, [&](gsl::index begin, gsl::index end) {
+			for (gsl::index mm{ begin }; mm < end; mm++) {
+				peaks[mm] = findPeaks(&spectra[mm * length], length, m_settings.fitRadius, m_settings.rayleighExclusion);
+			}
+		});
+		return peaks;
+	}
+
+	static double meanDistance(const std::vector<SPECTRUM_PEAKS>& peaks, int* validFrames = nullptr) {
+		auto sum{ 0.0 };
+		auto count{ 0 };
+		for (const auto& peak : peaks) {
+			if (std::isfinite(peak.distance)) {
+				sum += peak.distance;
+				count++;
+			}
+		}
+		if (validFrames) {
+			*validFrames = count;
+		}
+		return count ? sum / count : NAN;
+	}
+
+	BRILLOUIN_ANALYSIS_SETTINGS m_settings;
+	SpectrumLine m_line;
+	double m_frequencyPerPixel{ NAN };		// [GHz/pix]	only accessed on the analysis thread
+	Callback m_callback{ nullptr };
+
+	std::mutex m_mapMutex;
+	SHIFT_MAP m_map;
+
+	ThreadPool m_threadPool;
+	// destroyed first, so the remaining positions are analyzed while the members above still exist
+	std::unique_ptr<PipelineStage> m_stage;
+};
+
+#endif // BRILLOUINANALYSIS_H
@@ -0,0 +1,91 @@
+#include "stdafx.h"
+#include "chunkedPayload.h"
+
+/*
+ * Public definitions
+ */
+
+H5::Group ChunkedPayload::createRepetition(H5::H5File& file, const std::string& parent, const std::string& repetitionParent) {
+	auto root = file.openGroup("/");
+	auto parentGroup = H5::Group{};
+	if (root.nameExists(parent)) {
+		parentGroup = root.openGroup(parent);
+	} else {
+		parentGroup = root.createGroup(parent);
+	}
+	auto name = std::to_string(parentGroup.getNumObjs());
+	auto group = parentGroup.createGroup(name);
+
+	// H5BM names the repetitions by their number, the latest one is being acquired
+	if (root.nameExists(repetitionParent)) {
+		auto repetitions = root.openGroup(repetitionParent);
+		auto count = repetitions.getNumObjs();
+		if (count > 0) {
+			auto repetition = repetitions.openGroup(std::to_string(count - 1));
+			auto target = "/" + parent + "/" + name;
+			if (H5Lcreate_soft(target.c_str(), repetition.getId(), "payloadChunked", H5P_DEFAULT, H5P_DEFAULT) < 0) {
+				throw H5::GroupIException("ChunkedPayload::createRepetition", "Could not link the chunked payload.");
+			}
+			writeAttribute(repetition, "layoutVersion", LAYOUT_VERSION);
+		}
+	}
+	return group;
+}
+
+/*
+ * Private definitions
+ */
+
+H5::DSetCreatPropList ChunkedPayload::chunkedProperties(int rank, const hsize_t* chunk, bool compress) {
+	auto properties = H5::DSetCreatPropList{};
+	properties.setChunk(rank, chunk);
+	if (compress) {
+		// Shuffling the bytes groups the mostly constant high bytes of the pixels
+		properties.setShuffle();
+		if (H5Zfilter_avail(FILTER_LZ4) > 0) {
+			// LZ4 is much faster than deflate, but only available if the plugin is installed
+			properties.setFilter(FILTER_LZ4, H5Z_FLAG_OPTIONAL, 0, nullptr);
+		} else {
+			properties.setDeflate(m_compression);
+		}
+	}
+	return properties;
+}
+
+H5::DataSet ChunkedPayload::createExtensible(const std::string& name, const H5::DataType& type, int rank,
+	const hsize_t* chunk, bool compress) {
+
+	auto dims = std::vector<hsize_t>(chunk, chunk + rank);
+	auto maxDims = dims;
+	dims[0] = 0;
+	maxDims[0] = H5S_UNLIMITED;
+	auto dataspace = H5::DataSpace(rank, dims.data(), maxDims.data());
+
+	return m_group.createDataSet(name, type, dataspace, chunkedProperties(rank, chunk, compress));
+}
+
+void ChunkedPayload::appendRows(H5::DataSet& dataset, const H5::DataType& type, hsize_t offset, hsize_t rows, const void* buffer) {
+	auto fileSpace = dataset.getSpace();
+	auto rank = fileSpace.getSimpleExtentNdims();
+	auto dims = std::vector<hsize_t>(rank);
+	fileSpace.getSimpleExtentDims(dims.data());
+
+	dims[0] = offset + rows;
+	dataset.extend(dims.data());
+
+	fileSpace = dataset.getSpace();
+	auto start = std::vector<hsize_t>(rank, 0);
+	start[0] = offset;
+	auto count = dims;
+	count[0] = rows;
+	fileSpace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+	auto memorySpace = H5::DataSpace(rank, count.data());
+
+	dataset.write(buffer, type, memorySpace, fileSpace);
+}
+
+void ChunkedPayload::writeAttribute(H5::H5Object& parent, const std::string& name, int value) {
+	auto dataspace = H5::DataSpace(H5S_SCALAR);
+	auto attribute = parent.createAttribute(name, H5::PredType::NATIVE_INT, dataspace);
+	attribute.write(H5::PredType::NATIVE_INT, &value);
+}
@@ -0,0 +1,154 @@
+#ifndef CHUNKEDPAYLOAD_H
+#define CHUNKEDPAYLOAD_H
+
+#include "../external/h5bm/h5bm.h"
+#include "H5Cpp.h"
+
+#include <gsl/gsl>
+#include <string>
+#include <vector>
+
+/*
+ * Writes all Brillouin payloads of one repetition into a single extensible, chunked dataset
+ * instead of one dataset per position. Every chunk holds the frames of one position.
+ *
+ * Datasets of the repetition group:
+ *	data		[N, frameCount, height, width]	image data
+ *	indices		[N, 3]							x, y and z index of the position
+ *	date		[N]								acquisition date
+ *	exposure	[N]								[s]	exposure time
+ *	gain		[N]								[1]	gain
+ *
+ * The repetition of H5BM gets the "layoutVersion" attribute, which readers distinguish this layout by,
+ * and the soft link "payloadChunked" to the group of the datasets.
+ */
+class ChunkedPayload {
+
+public:
+	static constexpr int LAYOUT_VERSION{ 1 };
+	// Filter id of the LZ4 plugin registered with the HDF Group
+	static constexpr H5Z_filter_t FILTER_LZ4{ 32004 };
+
+	ChunkedPayload(const H5::Group& group, int compression) : m_group(group), m_compression(compression) {};
+
+	template <typename T>
+	void append(const std::vector<IMAGE<T>*>& images);
+
+	hsize_t size() const {
+		return m_count;
+	};
+
+	/*
+	 * Creates the next repetition group below the given parent group and links it
+	 * from the latest repetition of H5BM below the group repetitionParent.
+	 */
+	static H5::Group createRepetition(H5::H5File& file, const std::string& parent, const std::string& repetitionParent);
+
+private:
+	template <typename T>
+	static const H5::PredType& dataType();
+
+	template <typename T>
+	void create(const IMAGE<T>* image);
+
+	H5::DSetCreatPropList chunkedProperties(int rank, const hsize_t* chunk, bool compress);
+	H5::DataSet createExtensible(const std::string& name, const H5::DataType& type, int rank,
+		const hsize_t* chunk, bool compress = false);
+	void appendRows(H5::DataSet& dataset, const H5::DataType& type, hsize_t offset, hsize_t rows, const void* buffer);
+
+	static void writeAttribute(H5::H5Object& parent, const std::string& name, int value);
+
+	H5::Group m_group;
+	int m_compression{ 1 };				// [1]	deflate level, 0 disables compression
+
+	H5::DataSet m_data;
+	H5::DataSet m_indices;
+	H5::DataSet m_dates;
+	H5::DataSet m_exposures;
+	H5::DataSet m_gains;
+
+	bool m_created{ false };
+	hsize_t m_count{ 0 };				// [1]	positions written
+	hsize_t m_frameDims[3]{ 0, 0, 0 };	// [pix]	frameCount, height, width
+};
+
+template <>
+inline const H5::PredType& ChunkedPayload::dataType<unsigned char>() {
+	return H5::PredType::NATIVE_UCHAR;
+}
+
+template <>
+inline const H5::PredType& ChunkedPayload::dataType<unsigned short>() {
+	return H5::PredType::NATIVE_USHORT;
+}
+
+template <>
+inline const H5::PredType& ChunkedPayload::dataType<unsigned int>() {
+	return H5::PredType::NATIVE_UINT;
+}
+
+template <typename T>
+void ChunkedPayload::append(const std::vector<IMAGE<T>*>& images) {
+	if (images.empty()) {
+		return;
+	}
+	if (!m_created) {
+		create(images.front());
+	}
+
+	auto offset = m_count;
+	auto rows = (hsize_t)images.size();
+	m_count += rows;
+
+	// Extend once for the whole batch, the positions share one dataset
+	hsize_t size[4] = { m_count, m_frameDims[0], m_frameDims[1], m_frameDims[2] };
+	m_data.extend(size);
+
+	auto fileSpace = m_data.getSpace();
+	hsize_t count[4] = { 1, m_frameDims[0], m_frameDims[1], m_frameDims[2] };
+	auto memorySpace = H5::DataSpace(4, count);
+	for (gsl::index i{ 0 }; i < (gsl::index)images.size(); i++) {
+		hsize_t start[4] = { offset + i, 0, 0, 0 };
+		fileSpace.selectHyperslab(H5S_SELECT_SET, count, start);
+		m_data.write(images[i]->data.data(), dataType<T>(), memorySpace, fileSpace);
+	}
+
+	auto indices = std::vector<int>(3 * images.size());
+	auto dates = std::vector<const char*>(images.size());
+	auto exposures = std::vector<double>(images.size());
+	auto gains = std::vector<double>(images.size());
+	for (gsl::index i{ 0 }; i < (gsl::index)images.size(); i++) {
+		indices[3 * i] = images[i]->indX;
+		indices[3 * i + 1] = images[i]->indY;
+		indices[3 * i + 2] = images[i]->indZ;
+		dates[i] = images[i]->date.c_str();
+		exposures[i] = images[i]->exposure;
+		gains[i] = images[i]->gain;
+	}
+	appendRows(m_indices, H5::PredType::NATIVE_INT, offset, rows, indices.data());
+	appendRows(m_dates, H5::StrType(H5::PredType::C_S1, H5T_VARIABLE), offset, rows, dates.data());
+	appendRows(m_exposures, H5::PredType::NATIVE_DOUBLE, offset, rows, exposures.data());
+	appendRows(m_gains, H5::PredType::NATIVE_DOUBLE, offset, rows, gains.data());
+}
+
+template <typename T>
+void ChunkedPayload::create(const IMAGE<T>* image) {
+	m_frameDims[0] = image->dims[0];
+	m_frameDims[1] = image->dims[1];
+	m_frameDims[2] = image->dims[2];
+
+	// One chunk per position, so every position is written and compressed on its own
+	hsize_t chunk[4] = { 1, m_frameDims[0], m_frameDims[1], m_frameDims[2] };
+	m_data = createExtensible("data", dataType<T>(), 4, chunk, m_compression > 0);
+
+	hsize_t indexChunk[2] = { 1024, 3 };
+	m_indices = createExtensible("indices", H5::PredType::NATIVE_INT, 2, indexChunk);
+	hsize_t rowChunk[1] = { 1024 };
+	m_dates = createExtensible("date", H5::StrType(H5::PredType::C_S1, H5T_VARIABLE), 1, rowChunk);
+	m_exposures = createExtensible("exposure", H5::PredType::NATIVE_DOUBLE, 1, rowChunk);
+	m_gains = createExtensible("gain", H5::PredType::NATIVE_DOUBLE, 1, rowChunk);
+
+	m_created = true;
+}
+
+#endif // CHUNKEDPAYLOAD_H
@@ -0,0 +1,225 @@
+#ifndef COLORMAPRENDERER_H
+#define COLORMAPRENDERER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <QImage>
+#include <gsl/gsl>
+
+#include "threadPool.h"
+
+struct PREVIEW_IMAGE {
+	std::shared_ptr<const QImage> image{ nullptr };
+	double lower{ 0 };		// [1]	value mapped to the first color of the palette
+	double upper{ 0 };		// [1]	value mapped to the last color of the palette
+};
+
+/*
+ * Renders camera frames through a color palette into an ARGB image.
+ *
+ * Values are mapped to the palette the same way QCPColorGradient does, so the image
+ * matches the color scale next to it. 8 and 16 bit frames are mapped with a lookup table
+ * from the raw value to the color, which is only rebuilt if the limits or the palette
+ * change. Other types are scaled in a loop the compiler vectorizes.
+ *
+ * Two images are rendered into alternately. An image still referenced by the GUI is
+ * never written to, a new one is allocated instead.
+ */
+class ColormapRenderer {
+
+public:
+	explicit ColormapRenderer(int threadCount = ThreadPool::defaultThreadCount()) : m_threadPool(threadCount) {};
+
+	ColormapRenderer(const ColormapRenderer&) = delete;
+	ColormapRenderer& operator=(const ColormapRenderer&) = delete;
+
+	/*
+	 * Colors from the lower to the upper limit, might be called from another thread
+	 */
+	void setPalette(std::vector<QRgb> palette) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_palette = std::move(palette);
+		m_lut.clear();
+	}
+
+	/*
+	 * Renders a frame, with the limits taken from the frame if autoscale is set
+	 */
+	template <typename T>
+	PREVIEW_IMAGE render(const T* frame, int dim_x, int dim_y, double lower, double upper, bool autoscale) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		// keep the frame, to render it again with other limits while the preview is paused
+		auto bytes = reinterpret_cast<const std::byte*>(frame);
+		m_frame.assign(bytes, bytes + sizeof(T) * dim_x * dim_y);
+		m_rerender = [this, dim_x, dim_y](double lower, double upper, bool autoscale) {
+			return map(reinterpret_cast<const T*>(m_frame.data()), dim_x, dim_y, lower, upper, autoscale);
+		};
+		m_values = [this, dim_x, dim_y]() {
+			auto frame = reinterpret_cast<const T*>(m_frame.data());
+			return std::vector<double>(frame, frame + (size_t)dim_x * dim_y);
+		};
+		m_dim_x = dim_x;
+		m_dim_y = dim_y;
+		return map(frame, dim_x, dim_y, lower, upper, autoscale);
+	}
+
+	/*
+	 * Renders the last frame again, returns an empty image if there is none
+	 */
+	PREVIEW_IMAGE rerender(double lower, double upper, bool autoscale) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		if (!m_rerender) {
+			return PREVIEW_IMAGE{};
+		}
+		return m_rerender(lower, upper, autoscale);
+	}
+
+	/*
+	 * Values of the last frame row by row, empty if there is none
+	 */
+	std::vector<double> lastFrame(int* dim_x, int* dim_y) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		if (!m_values) {
+			return {};
+		}
+		*dim_x = m_dim_x;
+		*dim_y = m_dim_y;
+		return m_values();
+	}
+
+private:
+	template <typename T>
+	PREVIEW_IMAGE map(const T* frame, int dim_x, int dim_y, double lower, double upper, bool autoscale) {
+		if (m_palette.empty() || dim_x <= 0 || dim_y <= 0) {
+			return PREVIEW_IMAGE{};
+		}
+		if (autoscale) {
+			std::tie(lower, upper) = limits(frame, dim_x, dim_y);
+		}
+		auto image = nextImage(dim_x, dim_y);
+
+		if constexpr (std::is_same_v<T, unsigned char> || std::is_same_v<T, unsigned short>) {
+			updateLUT<T>(lower, upper);
+			auto lut = m_lut.data();
+			m_threadPool.parallelFor(dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+				for (gsl::index y{ y_begin }; y < y_end; y++) {
+					auto row = &frame[y * dim_x];
+					auto line = reinterpret_cast<QRgb*>(image->scanLine((int)y));
+					for (gsl::index x{ 0 }; x < dim_x; x++) {
+						line[x] = lut[row[x]];
+					}
+				}
+			});
+		} else {
+			auto palette = m_palette.data();
+			auto top = (float)(m_palette.size() - 1);
+			auto offset = (float)lower;
+			auto factor = upper > lower ? (float)(top / (upper - lower)) : 0.0f;
+			m_threadPool.parallelFor(dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+				auto indices = std::vector<int>(dim_x);
+				for (gsl::index y{ y_begin }; y < y_end; y++) {
+					auto row = &frame[y * dim_x];
+					// NaN ends up at the first color
+					for (gsl::index x{ 0 }; x < dim_x; x++) {
+						indices[x] = (int)std::max(0.0f, std::min(((float)row[x] - offset) * factor, top));
+					}
+					auto line = reinterpret_cast<QRgb*>(image->scanLine((int)y));
+					for (gsl::index x{ 0 }; x < dim_x; x++) {
+						line[x] = palette[indices[x]];
+					}
+				}
+			});
+		}
+		return PREVIEW_IMAGE{ image, lower, upper };
+	}
+
+	/*
+	 * Minimum and maximum of the frame
+	 */
+	template <typename T>
+	std::pair<double, double> limits(const T* frame, int dim_x, int dim_y) {
+		using T_min = std::conditional_t<std::is_integral_v<T>, T, float>;
+		auto minimum = std::numeric_limits<T_min>::max();
+		auto maximum = std::numeric_limits<T_min>::lowest();
+		std::mutex mutex;
+		m_threadPool.parallelFor(dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			auto blockMinimum = std::numeric_limits<T_min>::max();
+			auto blockMaximum = std::numeric_limits<T_min>::lowest();
+			for (gsl::index i{ y_begin * dim_x }; i < y_end * dim_x; i++) {
+				// NaN fails both comparisons and is skipped
+				blockMinimum = (T_min)frame[i] < blockMinimum ? (T_min)frame[i] : blockMinimum;
+				blockMaximum = (T_min)frame[i] > blockMaximum ? (T_min)frame[i] : blockMaximum;
+			}
+			std::lock_guard<std::mutex> lockGuard(mutex);
+			minimum = std::min(minimum, blockMinimum);
+			maximum = std::max(maximum, blockMaximum);
+		});
+		if (minimum > maximum) {
+			return { 0, 0 };
+		}
+		return { (double)minimum, (double)maximum };
+	}
+
+	/*
+	 * Color of every raw value, calculated as QCPColorGradient::colorize() does
+	 */
+	template <typename T>
+	void updateLUT(double lower, double upper) {
+		auto size = (size_t)std::numeric_limits<T>::max() + 1;
+		if (m_lut.size() == size && m_lutLower == lower && m_lutUpper == upper) {
+			return;
+		}
+		m_lut.resize(size);
+		m_lutLower = lower;
+		m_lutUpper = upper;
+		auto top = (int)m_palette.size() - 1;
+		auto factor = upper > lower ? top / (upper - lower) : 0.0;
+		for (gsl::index value{ 0 }; value < (gsl::index)size; value++) {
+			auto index = (int)std::clamp((value - lower) * factor, 0.0, (double)top);
+			m_lut[value] = m_palette[index];
+		}
+	}
+
+	/*
+	 * The image which is not shown at the moment
+	 */
+	std::shared_ptr<QImage> nextImage(int dim_x, int dim_y) {
+		m_front = 1 - m_front;
+		auto& image = m_images[m_front];
+		// the GUI holds a reference as long as it shows the image
+		if (!image || image.use_count() > 1 || image->width() != dim_x || image->height() != dim_y) {
+			// all colors are opaque, so premultiplied is the same and the fastest to draw
+			image = std::make_shared<QImage>(dim_x, dim_y, QImage::Format_ARGB32_Premultiplied);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return image;
+	}
+
+	ThreadPool m_threadPool;
+	std::mutex m_mutex;
+
+	std::vector<QRgb> m_palette;
+	std::vector<QRgb> m_lut;
+	double m_lutLower{ 0 };
+	double m_lutUpper{ 0 };
+
+	std::array<std::shared_ptr<QImage>, 2> m_images;
+	gsl::index m_front{ 0 };		// [1]	index of the image rendered last
+
+	std::vector<std::byte> m_frame;
+	std::function<PREVIEW_IMAGE(double, double, bool)> m_rerender;
+	std::function<std::vector<double>()> m_values;
+	int m_dim_x{ 0 };				// [pix]	size of the last frame
+	int m_dim_y{ 0 };				// [pix]
+};
+
+#endif // COLORMAPRENDERER_H
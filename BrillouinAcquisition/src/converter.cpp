@@ -12,28 +12,45 @@ converter::~converter() {
 }
 
 void converter::init() {
+	// the FFT plans are measured once per image size and remembered between sessions
+	auto folder = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+	QDir().mkpath(folder);
+	FFTWPlanCache::instance().setWisdomFile((folder + "/fftw-wisdom").toStdString());
+
 	m_phase = new phase();
 }
 
 void converter::convert(PreviewBuffer<std::byte>* previewBuffer, PLOT_SETTINGS* plotSettings) {
+	auto scheduler = plotSettings->scheduler;
+	auto delay = scheduler->delay();
+	if (delay > 0) {
+		// the request stays pending, frames arriving meanwhile replace the one waiting
+		QTimer::singleShot(delay, this, [this, previewBuffer, plotSettings]() { convert(previewBuffer, plotSettings); });
+		return;
+	}
+	scheduler->beginConversion();
 	{
 		std::lock_guard<std::mutex> lockGuard(previewBuffer->m_mutex);
-		// if no image is ready return immediately
-		if (!previewBuffer->m_buffer->m_usedBuffers->tryAcquire()) {
+		// if no new image is ready return immediately
+		auto slot = previewBuffer->m_buffer->tryRead();
+		if (!slot) {
 			return;
 		}
 
 		if (previewBuffer->m_bufferSettings.bufferType == "unsigned short") {
-			auto unpackedBuffer = reinterpret_cast<unsigned short*>(previewBuffer->m_buffer->getReadBuffer());
+			auto unpackedBuffer = reinterpret_cast<unsigned short*>(slot.get());
 			conv(previewBuffer, plotSettings, unpackedBuffer);
 		} else if (previewBuffer->m_bufferSettings.bufferType == "unsigned char") {
-			auto unpackedBuffer = reinterpret_cast<unsigned char*>(previewBuffer->m_buffer->getReadBuffer());
+			auto unpackedBuffer = reinterpret_cast<unsigned char*>(slot.get());
 			conv(previewBuffer, plotSettings, unpackedBuffer);
 		} else if (previewBuffer->m_bufferSettings.bufferType == "unsigned int") {
-			auto unpackedBuffer = reinterpret_cast<unsigned int*>(previewBuffer->m_buffer->getReadBuffer());
+			auto unpackedBuffer = reinterpret_cast<unsigned int*>(slot.get());
 			conv(previewBuffer, plotSettings, unpackedBuffer);
 		}
-
+		// the buffer stays with the converter until the next frame is read
+		if (scheduler->frameShown(slot.frameNumber(), slot.droppedFrames())) {
+			emit(s_previewStatistics(plotSettings, scheduler->getStatistics()));
+		}
 	}
 }
 
@@ -41,22 +58,47 @@ void converter::updateBackground() {
 	m_phase->m_updateBackground = true;
 }
 
+void converter::rerender(PLOT_SETTINGS* plotSettings, RENDER_SETTINGS settings) {
+	m_renderSettings[plotSettings] = settings;
+	auto image = plotSettings->renderer->rerender(settings.cLim.lower, settings.cLim.upper, settings.autoscale);
+	if (image.image) {
+		emit(s_rendered(plotSettings, image));
+	}
+}
+
+void converter::setUnwrapSettings(const UNWRAP_SETTINGS& settings) {
+	m_phase->setUnwrapSettings(settings);
+}
+
 template <typename T>
 void converter::conv(PreviewBuffer<std::byte>* previewBuffer, PLOT_SETTINGS* plotSettings, T* unpackedBuffer) {
 	auto dim_x = previewBuffer->m_bufferSettings.roi.width_binned;
 	auto dim_y = previewBuffer->m_bufferSettings.roi.height_binned;
 
-	std::vector<float> converted(unpackedBuffer, unpackedBuffer + (size_t)dim_x*dim_y);
-	switch (plotSettings->mode) {
+	// only the copy is read here, the GUI thread writes the plot settings
+	auto& settings = m_renderSettings[plotSettings];
+	auto lower = settings.cLim.lower;
+	auto upper = settings.cLim.upper;
+	auto autoscale = settings.autoscale;
+
+	// the intensity is rendered straight from the preview buffer
+	auto image = PREVIEW_IMAGE{};
+	switch (settings.mode) {
 	case DISPLAY_MODE::PHASE:
-		m_phase->calculatePhase(unpackedBuffer, &converted, dim_x, dim_y);
+		m_converted.resize((size_t)dim_x * dim_y);
+		m_phase->calculatePhase(unpackedBuffer, &m_converted, dim_x, dim_y);
+		image = plotSettings->renderer->render(m_converted.data(), dim_x, dim_y, lower, upper, autoscale);
 		break;
 	case DISPLAY_MODE::SPECTRUM:
-		m_phase->calculateSpectrum(unpackedBuffer, &converted, dim_x, dim_y);
+		m_converted.resize((size_t)dim_x * dim_y);
+		m_phase->calculateSpectrum(unpackedBuffer, &m_converted, dim_x, dim_y);
+		image = plotSettings->renderer->render(m_converted.data(), dim_x, dim_y, lower, upper, autoscale);
 		break;
 	default:
+		image = plotSettings->renderer->render(unpackedBuffer, dim_x, dim_y, lower, upper, autoscale);
 		break;
 	}
-	previewBuffer->m_buffer->m_freeBuffers->release();
-	emit(s_converted(plotSettings, dim_x, dim_y, converted));
+	if (image.image) {
+		emit(s_rendered(plotSettings, image));
+	}
 }
\ No newline at end of file
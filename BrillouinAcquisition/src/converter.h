@@ -1,12 +1,17 @@
 #ifndef PLOTTER_H
 #define PLOTTER_H
 
+#include <map>
+
 #include <QtCore>
 #include <gsl/gsl>
 
 #include "previewBuffer.h"
 #include "external/qcustomplot/qcustomplot.h"
 #include "phase.h"
+#include "colormapRenderer.h"
+#include "previewColorMap.h"
+#include "previewScheduler.h"
 
 enum class CustomGradientPreset {
 	gpViridis,
@@ -23,9 +28,18 @@ typedef enum class displayMode {
 	PHASE
 } DISPLAY_MODE;
 
+/*
+ * Copy of the plot settings the converter renders with, as the GUI changes PLOT_SETTINGS meanwhile
+ */
+struct RENDER_SETTINGS {
+	QCPRange cLim = { 100, 300 };
+	bool autoscale{ false };
+	DISPLAY_MODE mode{ DISPLAY_MODE::INTENSITY };
+};
+
 struct PLOT_SETTINGS {
 	QCustomPlot* plotHandle{ nullptr };
-	QCPColorMap* colorMap{ nullptr };
+	PreviewColorMap* colorMap{ nullptr };
 	QCPRange cLim = { 100, 300 };
 	QSpinBox* lowerBox{ nullptr };
 	QSpinBox* upperBox{ nullptr };
@@ -33,6 +47,9 @@ struct PLOT_SETTINGS {
 	bool autoscale{ false };
 	CustomGradientPreset gradient = CustomGradientPreset::gpViridis;
 	DISPLAY_MODE mode{ DISPLAY_MODE::INTENSITY };
+	ColormapRenderer* renderer{ nullptr };
+	PreviewScheduler* scheduler{ nullptr };
+	QLabel* statisticsLabel{ nullptr };
 };
 
 class converter : public QObject {
@@ -45,22 +62,27 @@ public:
 public slots:
 	void init();
 
+	// Converts the latest frame, as soon as the target rate of the preview allows it
 	void convert(PreviewBuffer<std::byte>* previewBuffer, PLOT_SETTINGS* plotSettings);
 
 	void updateBackground();
 
+	// Takes over the settings changed in the GUI and renders the last frame again
+	void rerender(PLOT_SETTINGS* plotSettings, RENDER_SETTINGS settings);
+
+	void setUnwrapSettings(const UNWRAP_SETTINGS& settings);
+
 private:
 	phase* m_phase{ nullptr };
+	std::vector<float> m_converted;
+	std::map<PLOT_SETTINGS*, RENDER_SETTINGS> m_renderSettings;
 
 	template <typename T = double>
 	void conv(PreviewBuffer<std::byte>* previewBuffer, PLOT_SETTINGS* plotSettings, T* unpackedBuffer);
 
 signals:
-	void s_converted(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned char> unpackedBuffer);
-	void s_converted(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<unsigned short> unpackedBuffer);
-	void s_converted(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<double> unpackedBuffer);
-	void s_converted(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<float> unpackedBuffer);
-	void s_converted(PLOT_SETTINGS* plotSettings, long long dim_x, long long dim_y, std::vector<int> unpackedBuffer);
+	void s_rendered(PLOT_SETTINGS* plotSettings, PREVIEW_IMAGE image);
+	void s_previewStatistics(PLOT_SETTINGS* plotSettings, PREVIEW_STATISTICS statistics);
 
 };
 
@@ -0,0 +1,106 @@
+#ifndef FFTWPLANCACHE_H
+#define FFTWPLANCACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "../external/fftw/fftw3.h"
+
+typedef enum class fftDirection {
+	FORWARD,	// real-to-complex, in-place with padded rows
+	BACKWARD	// complex-to-complex, in-place
+} FFT_DIRECTION;
+
+/*
+ * Keeps the FFTW plans for every image size and direction used during the session.
+ *
+ * Plans are created with FFTW_MEASURE by default, which is slow the first time an image
+ * size is seen. The wisdom FFTW gathers doing so is written to disk and imported on the
+ * next start, so that re-planning is fast across sessions.
+ *
+ * The plans are created on scratch arrays, so they must only be run with the new-array
+ * execute functions (fftw_execute_dft_r2c, fftw_execute_dft) on arrays allocated with
+ * fftw_malloc. The FFTW planner is not thread-safe, executing a plan is.
+ *
+ * Plans for more than one thread split a single transform across FFTW's own threads.
+ */
+class FFTWPlanCache {
+
+public:
+	static FFTWPlanCache& instance() {
+		static FFTWPlanCache cache;
+		return cache;
+	}
+
+	FFTWPlanCache(const FFTWPlanCache&) = delete;
+	FFTWPlanCache& operator=(const FFTWPlanCache&) = delete;
+
+	/*
+	 * Imports the wisdom stored in the given file and writes new wisdom back to it
+	 */
+	void setWisdomFile(const std::string& wisdomFile) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_wisdomFile = wisdomFile;
+		// the file does not exist on the first start
+		fftw_import_wisdom_from_filename(m_wisdomFile.c_str());
+	}
+
+	/*
+	 * FFTW_ESTIMATE, FFTW_MEASURE or FFTW_PATIENT, only applies to plans created afterwards
+	 */
+	void setPlannerFlags(unsigned int flags) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_flags = flags;
+	}
+
+	fftw_plan getPlan(int dim_x, int dim_y, FFT_DIRECTION direction, int threads = 1) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		auto key = std::make_tuple(dim_x, dim_y, direction, threads);
+		auto plan = m_plans.find(key);
+		if (plan != m_plans.end()) {
+			return plan->second;
+		}
+
+		// FFTW_MEASURE overwrites the arrays while planning, so we plan on scratch arrays
+		auto N = (size_t)dim_y * (direction == FFT_DIRECTION::FORWARD ? (dim_x / 2 + 1) : dim_x);
+		auto scratch = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
+		if (threads > 1 && !m_threadsInitialized) {
+			m_threadsInitialized = fftw_init_threads() != 0;
+		}
+		if (m_threadsInitialized) {
+			fftw_plan_with_nthreads(threads);
+		}
+		auto newPlan = fftw_plan{ nullptr };
+		if (direction == FFT_DIRECTION::FORWARD) {
+			newPlan = fftw_plan_dft_r2c_2d(dim_y, dim_x, reinterpret_cast<double*>(scratch), scratch, m_flags);
+		} else {
+			newPlan = fftw_plan_dft_2d(dim_y, dim_x, scratch, scratch, FFTW_BACKWARD, m_flags);
+		}
+		fftw_free(scratch);
+
+		m_plans[key] = newPlan;
+		if (!m_wisdomFile.empty()) {
+			fftw_export_wisdom_to_filename(m_wisdomFile.c_str());
+		}
+		return newPlan;
+	}
+
+private:
+	FFTWPlanCache() {};
+
+	~FFTWPlanCache() {
+		for (auto& [key, plan] : m_plans) {
+			fftw_destroy_plan(plan);
+		}
+	};
+
+	std::map<std::tuple<int, int, FFT_DIRECTION, int>, fftw_plan> m_plans;
+	unsigned int m_flags{ FFTW_MEASURE };
+	bool m_threadsInitialized{ false };
+	std::string m_wisdomFile;
+	std::mutex m_mutex;
+};
+
+#endif // FFTWPLANCACHE_H
@@ -0,0 +1,84 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <mutex>
+#include <vector>
+
+struct FRAMEPOOL_STATISTICS {
+	long long allocatedFrames{ 0 };		// [1]	frames which had to be newly allocated
+	long long reusedFrames{ 0 };		// [1]	frames which were taken from the pool
+	long long allocatedBytes{ 0 };		// [B]	bytes newly allocated (and zero-initialized)
+	int pooledFrames{ 0 };				// [1]	frames currently waiting in the pool
+};
+
+/*
+ * Pool of frame buffers which are filled by the camera and whose ownership
+ * moves into the payload written to the file. After the payload is written,
+ * the storage hands the buffer back, so the next frame can reuse it without
+ * allocating and zero-initializing it again.
+ *
+ * Frames are taken on the acquisition thread and recycled on the storage thread,
+ * so all accesses are guarded by a mutex.
+ */
+template <typename T>
+class FramePool {
+
+public:
+	explicit FramePool(int maxPooledFrames = 32) : m_maxPooledFrames(maxPooledFrames) {};
+
+	/*
+	 * Returns a buffer holding exactly frameSize elements.
+	 * The content of a reused buffer is undefined, it has to be overwritten by the caller.
+	 */
+	std::vector<T> get(size_t frameSize) {
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			for (auto it = m_frames.rbegin(); it != m_frames.rend(); it++) {
+				if (it->size() == frameSize) {
+					auto frame = std::move(*it);
+					m_frames.erase(std::next(it).base());
+					m_statistics.reusedFrames++;
+					return frame;
+				}
+			}
+			m_statistics.allocatedFrames++;
+			m_statistics.allocatedBytes += frameSize * sizeof(T);
+		}
+		return std::vector<T>(frameSize);
+	}
+
+	/*
+	 * Hands a buffer back to the pool. Buffers exceeding the pool size are freed.
+	 */
+	void recycle(std::vector<T>&& frame) {
+		if (frame.empty()) {
+			return;
+		}
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		if ((int)m_frames.size() >= m_maxPooledFrames) {
+			// drop the oldest buffer, it most likely has an outdated size
+			m_frames.erase(m_frames.begin());
+		}
+		m_frames.push_back(std::move(frame));
+	}
+
+	void clear() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_frames.clear();
+	}
+
+	FRAMEPOOL_STATISTICS getStatistics() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		auto statistics = m_statistics;
+		statistics.pooledFrames = (int)m_frames.size();
+		return statistics;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::vector<std::vector<T>> m_frames;
+	int m_maxPooledFrames{ 32 };
+	FRAMEPOOL_STATISTICS m_statistics;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,305 @@
+#ifndef IMAGEREGISTRATION_H
+#define IMAGEREGISTRATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "../external/fftw/fftw3.h"
+#include "fftwPlanCache.h"
+#include "threadPool.h"
+
+struct IMAGE_SHIFT {
+	double x{ 0 };			// [pix]	displacement of the image content against the reference
+	double y{ 0 };			// [pix]	displacement of the image content against the reference
+	double confidence{ 0 };	// [1]		height of the correlation peak above the mean in standard deviations
+};
+
+/*
+ * Measures the translation of images against a reference image by phase correlation.
+ *
+ * Both images are windowed with a Hann window, so the edges of the image do not correlate.
+ * The normalized cross-power spectrum is weighted with a Gaussian, which makes the correlation
+ * peak a sampled Gaussian. A parabola through the logarithm of the peak and its neighbours
+ * then gives the sub-pixel position exactly for a pure translation.
+ *
+ * The spectrum of the reference is kept, so measuring the drift of many images against
+ * the same reference costs one forward and one inverse transform per image.
+ */
+class ImageRegistration {
+
+public:
+	explicit ImageRegistration(int threadCount = ThreadPool::defaultThreadCount()) : m_threadPool(threadCount) {};
+
+	~ImageRegistration() {
+		fftw_free(m_reference);
+		fftw_free(m_spectrum);
+		fftw_free(m_correlation);
+	};
+
+	ImageRegistration(const ImageRegistration&) = delete;
+	ImageRegistration& operator=(const ImageRegistration&) = delete;
+
+	/*
+	 * [pix]	width of the correlation peak, larger values suppress fine structures and noise
+	 */
+	void setPeakWidth(double peakWidth) {
+		m_peakWidth = peakWidth;
+		updateWeights();
+	}
+
+	template <typename T>
+	void setReference(const T* image, int dim_x, int dim_y) {
+		initialize(dim_x, dim_y);
+		transform(image);
+		memcpy(m_reference, m_spectrum, sizeof(fftw_complex) * m_dim_spectrum_x * m_dim_y);
+		m_hasReference = true;
+	}
+
+	/*
+	 * The image needs to have the size of the reference
+	 */
+	template <typename T>
+	IMAGE_SHIFT measureShift(const T* image, int dim_x, int dim_y) {
+		if (!m_hasReference) {
+			throw std::logic_error("No reference image set.");
+		}
+		if (dim_x != m_dim_x || dim_y != m_dim_y) {
+			throw std::invalid_argument("The image size does not match the reference.");
+		}
+		transform(image);
+		correlate();
+		auto shift = findPeak();
+
+		// A window fixed to the image pulls the peak towards zero, because the image content moved
+		// against it. Moving the window with the content weights it like the reference content.
+		auto window_x = (int)round(shift.x);
+		auto window_y = (int)round(shift.y);
+		if (window_x != 0 || window_y != 0) {
+			transform(image, window_x, window_y);
+			correlate();
+			shift = findPeak();
+		}
+		return shift;
+	}
+
+private:
+	void initialize(int dim_x, int dim_y) {
+		if (dim_x < 3 || dim_y < 3) {
+			throw std::invalid_argument("The image is too small to register.");
+		}
+		if (m_dim_x == dim_x && m_dim_y == dim_y) {
+			return;
+		}
+		m_dim_x = dim_x;
+		m_dim_y = dim_y;
+		m_dim_spectrum_x = dim_x / 2 + 1;
+		m_hasReference = false;
+
+		fftw_free(m_reference);
+		fftw_free(m_spectrum);
+		fftw_free(m_correlation);
+		m_reference = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * m_dim_spectrum_x * m_dim_y);
+		m_spectrum = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * m_dim_spectrum_x * m_dim_y);
+		m_correlation = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * m_dim_x * m_dim_y);
+
+		auto& plans = FFTWPlanCache::instance();
+		m_FFT = plans.getPlan(m_dim_x, m_dim_y, FFT_DIRECTION::FORWARD, m_threadPool.threadCount());
+		m_IFFT = plans.getPlan(m_dim_x, m_dim_y, FFT_DIRECTION::BACKWARD, m_threadPool.threadCount());
+
+		// the window and the weights of the cross-power spectrum are separable
+		auto pi = 3.14159265358979323846;
+		auto hann = [pi](int dim) {
+			auto window = std::vector<double>(dim);
+			for (gsl::index i{ 0 }; i < dim; i++) {
+				window[i] = 0.5 - 0.5 * cos(2 * pi * i / (dim - 1.0));
+			}
+			return window;
+		};
+		m_window_x = hann(m_dim_x);
+		m_window_y = hann(m_dim_y);
+
+		updateWeights();
+	}
+
+	void updateWeights() {
+		auto pi = 3.14159265358979323846;
+		auto gaussian = [this, pi](int dim) {
+			auto weights = std::vector<double>(dim);
+			for (gsl::index i{ 0 }; i < dim; i++) {
+				auto frequency = (double)(i <= dim / 2 ? i : i - dim) / dim;
+				weights[i] = exp(-2 * pow(pi * m_peakWidth * frequency, 2));
+			}
+			return weights;
+		};
+		m_weights_x = gaussian(m_dim_x);
+		m_weights_y = gaussian(m_dim_y);
+	}
+
+	/*
+	 * Calculates the half spectrum of the windowed image without its mean value,
+	 * the window is moved by the given number of pixels
+	 */
+	template <typename T>
+	void transform(const T* image, int window_x = 0, int window_y = 0) {
+		auto N = (gsl::index)m_dim_x * m_dim_y;
+		auto sum{ 0.0 };
+		for (gsl::index i{ 0 }; i < N; i++) {
+			sum += image[i];
+		}
+		auto mean = sum / N;
+
+		// the rows of the in-place real input are padded to the size of the complex output
+		auto input = reinterpret_cast<double*>(m_spectrum);
+		auto stride = 2 * (gsl::index)m_dim_spectrum_x;
+		auto window = [](const std::vector<double>& values, gsl::index index) {
+			return (index >= 0 && index < (gsl::index)values.size()) ? values[index] : 0.0;
+		};
+		m_threadPool.parallelFor(m_dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				auto weight_y = window(m_window_y, y - window_y);
+				for (gsl::index x{ 0 }; x < m_dim_x; x++) {
+					input[x + stride * y] = (image[x + (gsl::index)m_dim_x * y] - mean) * window(m_window_x, x - window_x) * weight_y;
+				}
+			}
+		});
+
+		fftw_execute_dft_r2c(m_FFT, input, m_spectrum);
+	}
+
+	/*
+	 * Transforms the weighted, normalized cross-power spectrum back to the correlation
+	 */
+	void correlate() {
+		// normalize the half spectrum in-place
+		m_threadPool.parallelFor(m_dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				for (gsl::index x{ 0 }; x < m_dim_spectrum_x; x++) {
+					auto jj = x + m_dim_spectrum_x * y;
+					auto re = m_spectrum[jj][0] * m_reference[jj][0] + m_spectrum[jj][1] * m_reference[jj][1];
+					auto im = m_spectrum[jj][1] * m_reference[jj][0] - m_spectrum[jj][0] * m_reference[jj][1];
+					auto magnitude = sqrt(re * re + im * im);
+					auto weight = magnitude > 1e-12 ? m_weights_x[x] * m_weights_y[y] / magnitude : 0.0;
+					m_spectrum[jj][0] = re * weight;
+					m_spectrum[jj][1] = im * weight;
+				}
+			}
+		});
+
+		// the cross-power spectrum of real images is hermitian, F(-x, -y) = conj(F(x, y))
+		m_threadPool.parallelFor(m_dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				auto y_mirrored = (m_dim_y - y) % m_dim_y;
+				for (gsl::index x{ 0 }; x < m_dim_x; x++) {
+					auto& value = m_correlation[x + (gsl::index)m_dim_x * y];
+					if (x < m_dim_spectrum_x) {
+						auto& source = m_spectrum[x + m_dim_spectrum_x * y];
+						value[0] = source[0];
+						value[1] = source[1];
+					} else {
+						auto& source = m_spectrum[(m_dim_x - x) + m_dim_spectrum_x * y_mirrored];
+						value[0] = source[0];
+						value[1] = -source[1];
+					}
+				}
+			}
+		});
+
+		fftw_execute_dft(m_IFFT, m_correlation, m_correlation);
+	}
+
+	IMAGE_SHIFT findPeak() {
+		struct STATISTICS {
+			double maximum{ -INFINITY };
+			gsl::index index{ 0 };
+			double sum{ 0 };
+			double sumSquares{ 0 };
+		} statistics;
+		std::mutex mutex;
+		auto N = (gsl::index)m_dim_x * m_dim_y;
+		m_threadPool.parallelFor(N, [&](gsl::index begin, gsl::index end) {
+			auto block = STATISTICS{};
+			for (gsl::index i{ begin }; i < end; i++) {
+				auto value = m_correlation[i][0];
+				block.sum += value;
+				block.sumSquares += value * value;
+				if (value > block.maximum) {
+					block.maximum = value;
+					block.index = i;
+				}
+			}
+			std::lock_guard<std::mutex> lockGuard(mutex);
+			statistics.sum += block.sum;
+			statistics.sumSquares += block.sumSquares;
+			if (block.maximum > statistics.maximum) {
+				statistics.maximum = block.maximum;
+				statistics.index = block.index;
+			}
+		});
+
+		auto peak_x = statistics.index % m_dim_x;
+		auto peak_y = statistics.index / m_dim_x;
+		auto at = [this](gsl::index x, gsl::index y) {
+			x = (x % m_dim_x + m_dim_x) % m_dim_x;
+			y = (y % m_dim_y + m_dim_y) % m_dim_y;
+			return m_correlation[x + (gsl::index)m_dim_x * y][0];
+		};
+
+		auto shift = IMAGE_SHIFT{};
+		shift.x = peak_x + refinePeak(at(peak_x - 1, peak_y), statistics.maximum, at(peak_x + 1, peak_y));
+		shift.y = peak_y + refinePeak(at(peak_x, peak_y - 1), statistics.maximum, at(peak_x, peak_y + 1));
+		// the correlation is periodic, shifts beyond half the image size are negative
+		if (shift.x > m_dim_x / 2.0) {
+			shift.x -= m_dim_x;
+		}
+		if (shift.y > m_dim_y / 2.0) {
+			shift.y -= m_dim_y;
+		}
+
+		auto mean = statistics.sum / N;
+		auto deviation = sqrt(std::max(0.0, statistics.sumSquares / N - mean * mean));
+		shift.confidence = deviation > 0 ? (statistics.maximum - mean) / deviation : 0;
+		return shift;
+	}
+
+	/*
+	 * Offset of the vertex of the parabola through the logarithm of three equidistant values,
+	 * which is the center of a Gaussian through them
+	 */
+	static double refinePeak(double left, double center, double right) {
+		if (left > 0 && center > 0 && right > 0) {
+			left = log(left);
+			center = log(center);
+			right = log(right);
+		}
+		auto curvature = left - 2 * center + right;
+		if (curvature >= 0) {
+			return 0;
+		}
+		return std::clamp(0.5 * (left - right) / curvature, -0.5, 0.5);
+	}
+
+	fftw_complex* m_reference{ nullptr };	// half spectrum of the windowed reference image
+	fftw_complex* m_spectrum{ nullptr };	// the real input is transformed in-place to the half spectrum
+	fftw_complex* m_correlation{ nullptr };	// the full cross-power spectrum is transformed in-place to the correlation
+	fftw_plan m_FFT{ nullptr };				// owned by the FFTWPlanCache
+	fftw_plan m_IFFT{ nullptr };
+	int m_dim_x{ 0 }, m_dim_y{ 0 };
+	int m_dim_spectrum_x{ 0 };				// [pix]	width of the half spectrum
+	bool m_hasReference{ false };
+
+	double m_peakWidth{ 1.5 };				// [pix]	standard deviation of the Gaussian correlation peak
+	std::vector<double> m_window_x;
+	std::vector<double> m_window_y;
+	std::vector<double> m_weights_x;
+	std::vector<double> m_weights_y;
+
+	ThreadPool m_threadPool;
+};
+
+#endif // IMAGEREGISTRATION_H
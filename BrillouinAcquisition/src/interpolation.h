@@ -5,6 +5,9 @@
 
 #include <complex>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 #include "../external/eigen/Eigen/Dense"
 
 template <typename T = double>
@@ -124,4 +127,238 @@ public:
 	}
 };
 
+
+/*
+ * Fits the weights of biharmonic splines through a fixed set of points.
+ *
+ * The Green's matrix only depends on the positions of the points, so it is built and
+ * factorized once and shared by all value sets fitted on the same points. Points added or
+ * removed afterwards update the inverse of the Green's matrix in O(n^2) instead of
+ * factorizing it again.
+ */
+template <typename T = double>
+class BiharmonicSplineFitter {
+
+	using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+	using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+public:
+	BiharmonicSplineFitter(const std::vector<T>& x, const std::vector<T>& y) : m_x(x), m_y(y) {
+		if (m_x.size() != m_y.size()) {
+			throw std::invalid_argument("The number of x and y positions differ.");
+		}
+		factorize();
+	};
+
+	gsl::index size() const {
+		return m_x.size();
+	}
+
+	/*
+	 * Weights of the spline through the given values at the points
+	 */
+	WEIGHTS<T> fit(const std::vector<T>& values) const {
+		if ((gsl::index)values.size() != size()) {
+			throw std::invalid_argument("The number of values does not match the number of points.");
+		}
+		WEIGHTS<T> weights;
+		weights.xy_vec.resize(1, size());
+		for (gsl::index i{ 0 }; i < size(); i++) {
+			weights.xy_vec(i) = std::complex<T>(m_x[i], m_y[i]);
+		}
+		if (size() == 0) {
+			weights.weights.resize(0);
+			return weights;
+		}
+		auto values_vec = Eigen::Map<const Vector>(values.data(), values.size());
+		if (m_hasInverse) {
+			weights.weights = m_inverse * values_vec;
+		} else if (m_singular) {
+			weights.weights = m_qr.solve(values_vec);
+		} else {
+			weights.weights = m_lu.solve(values_vec);
+		}
+		return weights;
+	}
+
+	void addPoint(T x, T y) {
+		if (!prepareUpdate()) {
+			m_x.push_back(x);
+			m_y.push_back(y);
+			factorize();
+			return;
+		}
+		auto n = size();
+		Vector b(n);
+		for (gsl::index i{ 0 }; i < n; i++) {
+			b(i) = green(pow(m_x[i] - x, 2) + pow(m_y[i] - y, 2));
+		}
+		// Schur complement of the bordered matrix [G b; b' 0]
+		Vector u = m_inverse * b;
+		T schur = -b.dot(u);
+		m_x.push_back(x);
+		m_y.push_back(y);
+		if (std::abs(schur) < m_tolerance * b.cwiseAbs().maxCoeff() * u.cwiseAbs().maxCoeff()) {
+			// the new point coincides with an existing one
+			factorize();
+			return;
+		}
+		Matrix inverse(n + 1, n + 1);
+		inverse.topLeftCorner(n, n) = m_inverse + u * u.transpose() / schur;
+		inverse.topRightCorner(n, 1) = -u / schur;
+		inverse.bottomLeftCorner(1, n) = -u.transpose() / schur;
+		inverse(n, n) = 1 / schur;
+		m_inverse.swap(inverse);
+	}
+
+	void removePoint(gsl::index index) {
+		if (index < 0 || index >= size()) {
+			throw std::out_of_range("The point to remove does not exist.");
+		}
+		if (!prepareUpdate() || std::abs(m_inverse(index, index)) < m_tolerance * m_inverse.cwiseAbs().maxCoeff()) {
+			m_x.erase(m_x.begin() + index);
+			m_y.erase(m_y.begin() + index);
+			factorize();
+			return;
+		}
+		// the inverse of G without the point is the Schur complement of the point in the inverse
+		Vector a = m_inverse.col(index);
+		m_inverse -= a * a.transpose() / a(index);
+		auto n = size();
+		auto tail = n - index - 1;
+		Matrix inverse(n - 1, n - 1);
+		inverse.topLeftCorner(index, index) = m_inverse.topLeftCorner(index, index);
+		inverse.topRightCorner(index, tail) = m_inverse.topRightCorner(index, tail);
+		inverse.bottomLeftCorner(tail, index) = m_inverse.bottomLeftCorner(tail, index);
+		inverse.bottomRightCorner(tail, tail) = m_inverse.bottomRightCorner(tail, tail);
+		m_inverse.swap(inverse);
+		m_x.erase(m_x.begin() + index);
+		m_y.erase(m_y.begin() + index);
+	}
+
+private:
+	static T green(T r2) {
+		return r2 > 0 ? r2 * (T(0.5) * log(r2) - 1) : T(0);
+	}
+
+	void factorize() {
+		m_hasInverse = false;
+		m_singular = false;
+		auto n = size();
+		Matrix g(n, n);
+		for (gsl::index col{ 0 }; col < n; col++) {
+			g(col, col) = 0;
+			for (gsl::index row{ col + 1 }; row < n; row++) {
+				g(row, col) = green(pow(m_x[row] - m_x[col], 2) + pow(m_y[row] - m_y[col], 2));
+				g(col, row) = g(row, col);
+			}
+		}
+		if (n == 0) {
+			return;
+		}
+		m_lu.compute(g);
+		// points at the same position make the matrix singular, the pivoted QR decomposition
+		// still gives a solution then. The condition estimate is unreliable for exactly
+		// singular matrices, so the pivots are checked as well.
+		auto pivots = m_lu.matrixLU().diagonal().cwiseAbs();
+		if (!(m_lu.rcond() > m_tolerance) || !(pivots.minCoeff() > m_tolerance * pivots.maxCoeff())) {
+			m_singular = true;
+			m_qr.compute(g);
+		}
+	}
+
+	/*
+	 * Computes the inverse the updates work on, returns false if the matrix is singular
+	 */
+	bool prepareUpdate() {
+		if (m_singular || size() == 0) {
+			return false;
+		}
+		if (!m_hasInverse) {
+			m_inverse = m_lu.inverse();
+			m_hasInverse = true;
+		}
+		return true;
+	}
+
+	std::vector<T> m_x;
+	std::vector<T> m_y;
+
+	Eigen::PartialPivLU<Matrix> m_lu;
+	Eigen::ColPivHouseholderQR<Matrix> m_qr;
+	bool m_singular{ false };
+	Matrix m_inverse;
+	bool m_hasInverse{ false };
+
+	static constexpr T m_tolerance{ 1e-12 };
+};
+
+/*
+ * Evaluates a biharmonic spline with fixed weights.
+ *
+ * The calibration points are kept as separate real arrays, so that the Green's function
+ * can be evaluated for all points at once without complex temporaries.
+ */
+template <typename T = double>
+class BiharmonicSpline {
+
+public:
+	BiharmonicSpline() {};
+
+	explicit BiharmonicSpline(const WEIGHTS<T>& weights) {
+		auto count = weights.weights.size();
+		m_x.resize(count);
+		m_y.resize(count);
+		m_weights.resize(count);
+		for (gsl::index i{ 0 }; i < count; i++) {
+			m_x(i) = weights.xy_vec(i).real();
+			m_y(i) = weights.xy_vec(i).imag();
+			m_weights(i) = weights.weights(i);
+		}
+	};
+
+	T operator()(T x, T y) const {
+		if (m_weights.size() == 0) {
+			return 0.0;
+		}
+		// r^2 (log r - 1) expressed with r^2 to avoid the square root, adding the smallest
+		// positive number sets the Green's function to zero at the calibration points
+		auto r2 = (m_x - x).square() + (m_y - y).square();
+		return (r2 * (T(0.5) * (r2 + std::numeric_limits<T>::min()).log() - 1) * m_weights).sum();
+	}
+
+	/*
+	 * Evaluates the spline for all points of a trajectory
+	 */
+	void evaluate(const T* x, const T* y, T* values, gsl::index count) const {
+		for (gsl::index i{ 0 }; i < count; i++) {
+			values[i] = (*this)(x[i], y[i]);
+		}
+	}
+
+	Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic> evaluate(
+		const Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>& xr,
+		const Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>& yr
+	) const {
+		Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic> values(xr.rows(), xr.cols());
+		evaluate(xr.data(), yr.data(), values.data(), values.size());
+		return values;
+	}
+
+	gsl::index size() const {
+		return m_weights.size();
+	}
+
+private:
+	Eigen::Array<T, Eigen::Dynamic, 1> m_x;
+	Eigen::Array<T, Eigen::Dynamic, 1> m_y;
+	Eigen::Array<T, Eigen::Dynamic, 1> m_weights;
+};
+
+template <typename T = double>
+struct SPLINE2 {
+	BiharmonicSpline<T> x;
+	BiharmonicSpline<T> y;
+};
+
 #endif //INTERPOLATION_H
\ No newline at end of file
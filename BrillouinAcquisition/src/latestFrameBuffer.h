@@ -0,0 +1,194 @@
+#ifndef LATESTFRAMEBUFFER_H
+#define LATESTFRAMEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <gsl/gsl>
+
+/*
+ * Lock-free single-producer/single-consumer buffer which only keeps the latest frame.
+ *
+ * Three buffers are used: the writer fills one, the reader holds one and the third one
+ * holds the latest finished frame. Committing a frame swaps it with the finished one,
+ * so the writer never waits for the reader. A finished frame the reader did not pick up
+ * in time is overwritten and counted as dropped.
+ *
+ * A write slot only publishes its frame when it is committed. A slot which goes out of
+ * scope without a commit, e.g. because reading the camera failed, keeps the previous frame.
+ */
+template<class T> class LatestFrameBuffer {
+
+public:
+	LatestFrameBuffer() noexcept {};
+	explicit LatestFrameBuffer(const int bufferSize);
+	~LatestFrameBuffer();
+
+	LatestFrameBuffer(const LatestFrameBuffer&) = delete;
+	LatestFrameBuffer& operator=(const LatestFrameBuffer&) = delete;
+
+	class WriteSlot {
+	public:
+		WriteSlot() noexcept {};
+		WriteSlot(WriteSlot&& other) noexcept;
+		WriteSlot& operator=(WriteSlot&& other) noexcept;
+		~WriteSlot();
+
+		T* get() const noexcept { return m_data; };
+		explicit operator bool() const noexcept { return m_data != nullptr; };
+
+		// publish the frame to the reader
+		void commit() noexcept;
+		// keep the previous frame, also done when the slot goes out of scope without a commit
+		void discard() noexcept;
+
+	private:
+		friend class LatestFrameBuffer<T>;
+		WriteSlot(LatestFrameBuffer<T>* buffer, T* data) noexcept : m_buffer(buffer), m_data(data) {};
+
+		LatestFrameBuffer<T>* m_buffer{ nullptr };
+		T* m_data{ nullptr };
+	};
+
+	class ReadSlot {
+	public:
+		ReadSlot() noexcept {};
+
+		T* get() const noexcept { return m_data; };
+		explicit operator bool() const noexcept { return m_data != nullptr; };
+
+		// [1]	number of the frame, counted from one since the buffer was created
+		unsigned long long frameNumber() const noexcept { return m_frameNumber; };
+		// [1]	frames overwritten since the previous read
+		unsigned long long droppedFrames() const noexcept { return m_droppedFrames; };
+
+	private:
+		friend class LatestFrameBuffer<T>;
+		ReadSlot(T* data, unsigned long long frameNumber, unsigned long long droppedFrames) noexcept :
+			m_data(data), m_frameNumber(frameNumber), m_droppedFrames(droppedFrames) {};
+
+		T* m_data{ nullptr };
+		unsigned long long m_frameNumber{ 0 };
+		unsigned long long m_droppedFrames{ 0 };
+	};
+
+	// Returns an empty slot only if the buffer has no memory, never blocks.
+	WriteSlot tryWrite();
+	// Returns an empty slot if no new frame was committed since the last read, never blocks.
+	// The data stays valid until the next call.
+	ReadSlot tryRead();
+
+	int bufferSize() const noexcept;
+
+private:
+	void publish() noexcept;
+
+	static constexpr unsigned int m_indexMask{ 0b011 };
+	static constexpr unsigned int m_newFrame{ 0b100 };
+
+	std::array<T*, 3> m_buffers{ nullptr, nullptr, nullptr };
+	// Only written by the current owner of the buffer
+	std::array<unsigned long long, 3> m_frameNumbers{ 0, 0, 0 };
+	const int m_bufferSize{ 0 };
+
+	// Owned by the producer, padded to its own cache line
+	alignas(64) unsigned int m_back{ 0 };
+	unsigned long long m_writeCount{ 0 };
+	// Index of the latest finished frame and whether it is new
+	alignas(64) std::atomic<unsigned int> m_latest{ 1 };
+	// Owned by the consumer, padded to its own cache line
+	alignas(64) unsigned int m_front{ 2 };
+	unsigned long long m_lastFrameNumber{ 0 };
+};
+
+template<class T>
+inline LatestFrameBuffer<T>::LatestFrameBuffer(const int bufferSize) : m_bufferSize(bufferSize) {
+	for (auto& buffer : m_buffers) {
+		buffer = new T[m_bufferSize]{};
+	}
+}
+
+template<class T>
+inline LatestFrameBuffer<T>::~LatestFrameBuffer() {
+	for (auto& buffer : m_buffers) {
+		delete[] buffer;
+		buffer = nullptr;
+	}
+}
+
+template<class T>
+inline typename LatestFrameBuffer<T>::WriteSlot LatestFrameBuffer<T>::tryWrite() {
+	if (m_buffers[m_back] == nullptr) {
+		return WriteSlot{};
+	}
+	return WriteSlot{ this, m_buffers[m_back] };
+}
+
+template<class T>
+inline typename LatestFrameBuffer<T>::ReadSlot LatestFrameBuffer<T>::tryRead() {
+	if (!(m_latest.load(std::memory_order_relaxed) & m_newFrame)) {
+		return ReadSlot{};
+	}
+	// hand our buffer back and acquire the latest frame together with its content
+	m_front = m_latest.exchange(m_front, std::memory_order_acq_rel) & m_indexMask;
+
+	auto frameNumber = m_frameNumbers[m_front];
+	auto droppedFrames = frameNumber - m_lastFrameNumber - 1;
+	m_lastFrameNumber = frameNumber;
+	return ReadSlot{ m_buffers[m_front], frameNumber, droppedFrames };
+}
+
+template<class T>
+inline int LatestFrameBuffer<T>::bufferSize() const noexcept {
+	return m_bufferSize;
+}
+
+template<class T>
+inline void LatestFrameBuffer<T>::publish() noexcept {
+	m_frameNumbers[m_back] = ++m_writeCount;
+	// release the frame content and take over the previous latest frame,
+	// which the reader either already has swapped out or never will
+	m_back = m_latest.exchange(m_back | m_newFrame, std::memory_order_acq_rel) & m_indexMask;
+}
+
+/*
+ * Write slot definitions
+ */
+
+template<class T>
+inline LatestFrameBuffer<T>::WriteSlot::WriteSlot(WriteSlot&& other) noexcept : m_buffer(other.m_buffer), m_data(other.m_data) {
+	other.m_buffer = nullptr;
+	other.m_data = nullptr;
+}
+
+template<class T>
+inline typename LatestFrameBuffer<T>::WriteSlot& LatestFrameBuffer<T>::WriteSlot::operator=(WriteSlot&& other) noexcept {
+	if (this != &other) {
+		discard();
+		m_buffer = other.m_buffer;
+		m_data = other.m_data;
+		other.m_buffer = nullptr;
+		other.m_data = nullptr;
+	}
+	return *this;
+}
+
+template<class T>
+inline LatestFrameBuffer<T>::WriteSlot::~WriteSlot() {
+	discard();
+}
+
+template<class T>
+inline void LatestFrameBuffer<T>::WriteSlot::commit() noexcept {
+	if (m_buffer) {
+		m_buffer->publish();
+	}
+	m_buffer = nullptr;
+	m_data = nullptr;
+}
+
+template<class T>
+inline void LatestFrameBuffer<T>::WriteSlot::discard() noexcept {
+	m_buffer = nullptr;
+	m_data = nullptr;
+}
+#endif //LATESTFRAMEBUFFER_H
@@ -2,6 +2,9 @@
 #include "BrillouinAcquisition.h"
 #include <QtWidgets/QApplication>
 #include "logger.h"
+#ifdef ACQUISITION_BENCHMARK
+	#include "acquisitionBenchmark.h"
+#endif
 
 #include <QFile>
 #include <QDir>
@@ -28,6 +31,17 @@ int main(int argc, char *argv[]) {
 	#endif // QT_VERSION
 
 	QApplication a(argc, argv);
+
+#ifdef ACQUISITION_BENCHMARK
+	// Run the acquisition benchmark with the mock devices instead of the user interface
+	if (a.arguments().contains("--benchmark")) {
+		m_logFile.reset(new QFile("benchmark.log"));
+		m_logFile.data()->open(QFile::Append | QFile::Text);
+		qInstallMessageHandler(loggingHandler);
+		return AcquisitionBenchmark::run(a.arguments());
+	}
+#endif
+
 	BrillouinAcquisition w;
 
 	w.setStyleSheet("QPushButton.active  {background-color: rgb(0, 59, 206); color: white}");
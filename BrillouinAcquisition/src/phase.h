@@ -6,27 +6,42 @@
 #include <complex>
 #include <utility>
 #include <iterator>
+#include <array>
+#include <chrono>
 
 #include <math.h>
 #include <gsl/gsl>
 #include "simplemath.h"
 
 #include "../external/fftw/fftw3.h"
+#include "fftwPlanCache.h"
 #include "unwrap2Wrapper.h"
 #include "xsample.h"
+#include "threadPool.h"
+
+typedef enum class unwrapMode {
+	DOWNSAMPLED,	// unwrap at a lower resolution and upsample the unwrapped phase
+	PYRAMID,		// unwrap at a lower resolution and use the upsampled result to unwrap the full resolution phase
+	ADAPTIVE,		// pyramid with the resolution chosen to meet the time budget per frame
+	FULL			// unwrap at full resolution
+} UNWRAP_MODE;
+
+struct UNWRAP_SETTINGS {
+	UNWRAP_MODE mode{ UNWRAP_MODE::ADAPTIVE };
+	int downsampling{ 3 };			// [1]	factor of the lower resolution for DOWNSAMPLED and PYRAMID
+	double timeBudget{ 50 };		// [ms]	time per frame the adaptive mode aims for
+};
 
 class phase {
 
 private:
 	fftw_complex* m_background{ nullptr };
-	fftw_complex* m_in_FFT{ nullptr };
-	fftw_complex* m_out_FFT{ nullptr };
-	fftw_complex* m_in_IFFT{ nullptr };
-	fftw_complex* m_out_IFFT{ nullptr };
-	fftw_plan m_FFT{ nullptr };
+	fftw_complex* m_spectrum{ nullptr };	// the real input is transformed in-place to the half spectrum
+	fftw_complex* m_field{ nullptr };		// the masked sideband is transformed in-place to the complex field
+	fftw_plan m_FFT{ nullptr };				// owned by the FFTWPlanCache
 	fftw_plan m_IFFT{ nullptr };
 	int m_dim_x{ 0 }, m_dim_y{ 0 }, m_max_x{ 0 }, m_max_y{ 0 }, m_dim_background_x{ 0 }, m_dim_background_y{ 0 };
-	bool m_initialized{ false };
+	int m_dim_spectrum_x{ 0 };				// [pix]	width of the half spectrum
 
 	double m_pixelSize = 4.8 / (90.4762 * 63 / 100);
 	double m_NA{ 1.2 };
@@ -38,53 +53,50 @@ private:
 	unwrap2Wrapper *m_unwrapper = new unwrap2Wrapper();
 	xsample *m_xsample = new xsample();
 
+	// runs the FFTs and the pixel-wise steps, unwrapping is single-threaded
+	ThreadPool m_threadPool;
+
+	UNWRAP_SETTINGS m_unwrapSettings;
+	// downsampling factors the adaptive mode chooses from
+	static constexpr std::array<int, 7> m_adaptiveFactors{ 1, 2, 3, 4, 6, 8, 12 };
+	gsl::index m_adaptiveLevel{ 2 };
+
 	template <typename T = double>
 	bool sizeMatches(T intensity) {
 		return false;
 	}
 
 	/*
-	 * We have to (re-)initialize the FFT calculation whenever the image size changes
+	 * We have to (re-)initialize the FFT calculation whenever the image size changes,
+	 * the plans for an image size are only created once per session
 	 */
 	void initialize(int dim_x, int dim_y) {
 		if (m_dim_x != dim_x || m_dim_y != dim_y) {
 			m_dim_x = dim_x;
 			m_dim_y = dim_y;
+			m_dim_spectrum_x = dim_x / 2 + 1;
 
 			m_maskRadius = round(m_dim_x * m_pixelSize * m_NA / m_lambda);
 
 			m_mask = createMask(dim_x, dim_y, m_maskRadius);
 
-			int N = m_dim_x * m_dim_y;
-
-			if (m_initialized) {
-				// FFT variables
-				fftw_free(m_in_FFT);
-				fftw_free(m_out_FFT);
-				fftw_destroy_plan(m_FFT);
-
-				// Inverse FFT variables
-				fftw_free(m_in_IFFT);
-				fftw_free(m_out_IFFT);
-				fftw_destroy_plan(m_IFFT);
-			}
+			fftw_free(m_spectrum);
+			fftw_free(m_field);
 
-			m_in_FFT = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-			m_out_FFT = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-			m_in_IFFT = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-			m_out_IFFT = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N);
-			m_FFT = fftw_plan_dft_2d(m_dim_y, m_dim_x, m_in_FFT, m_out_FFT, FFTW_FORWARD, FFTW_ESTIMATE);
-			m_IFFT = fftw_plan_dft_2d(m_dim_y, m_dim_x, m_in_IFFT, m_out_IFFT, FFTW_BACKWARD, FFTW_ESTIMATE);
+			m_spectrum = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * m_dim_spectrum_x * m_dim_y);
+			m_field = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * m_dim_x * m_dim_y);
 
-			m_initialized = true;
+			auto& plans = FFTWPlanCache::instance();
+			m_FFT = plans.getPlan(m_dim_x, m_dim_y, FFT_DIRECTION::FORWARD, m_threadPool.threadCount());
+			m_IFFT = plans.getPlan(m_dim_x, m_dim_y, FFT_DIRECTION::BACKWARD, m_threadPool.threadCount());
 		}
 	}
 
 	std::vector<int> createMask(int dim_x, int dim_y, double maskRadius) {
 		std::vector<int> mask((size_t)dim_x * dim_y, 0);
-		for (gsl::index x{ (int)round(dim_x / 2.0 - m_maskRadius) }; x < round(dim_x / 2.0 + m_maskRadius); x++) {
-			for (gsl::index y{ (int)round(dim_y / 2.0 - m_maskRadius) }; y < round(dim_y / 2.0 + m_maskRadius); y++) {
-				if (sqrt(pow((x - dim_x/2.0), 2) + pow(y - dim_y/2.0, 2)) <= m_maskRadius) {
+		for (gsl::index x{ (int)round(dim_x / 2.0 - maskRadius) }; x < round(dim_x / 2.0 + maskRadius); x++) {
+			for (gsl::index y{ (int)round(dim_y / 2.0 - maskRadius) }; y < round(dim_y / 2.0 + maskRadius); y++) {
+				if (sqrt(pow((x - dim_x/2.0), 2) + pow(y - dim_y/2.0, 2)) <= maskRadius) {
 					mask[x + (size_t)dim_x * y] = 1;
 				}
 			}
@@ -93,43 +105,146 @@ private:
 		return mask;
 	}
 
+	/*
+	 * Calculates the half spectrum of the given real image
+	 */
 	template <typename T_in = double>
-	void copyToInput(fftw_complex* dest, T_in* intensity, int dim_x, int dim_y) {
-		for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
-			dest[i][0] = intensity[i];
-			dest[i][1] = 0.0;
+	void transform(T_in* intensity, int dim_x, int dim_y) {
+		// the rows of the in-place real input are padded to the size of the complex output
+		auto input = reinterpret_cast<double*>(m_spectrum);
+		auto stride = 2 * (gsl::index)m_dim_spectrum_x;
+		m_threadPool.parallelFor(dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				for (gsl::index x{ 0 }; x < dim_x; x++) {
+					input[x + stride * y] = intensity[x + (gsl::index)dim_x * y];
+				}
+			}
+		});
+
+		fftw_execute_dft_r2c(m_FFT, input, m_spectrum);
+	}
+
+	/*
+	 * Value of the full spectrum at (x, y), taken from the half spectrum of the
+	 * real-to-complex transform using F(-x, -y) = conj(F(x, y))
+	 */
+	std::complex<double> spectrumAt(gsl::index x, gsl::index y) const {
+		if (x < m_dim_spectrum_x) {
+			auto& value = m_spectrum[x + m_dim_spectrum_x * y];
+			return { value[0], value[1] };
 		}
+		auto& value = m_spectrum[(m_dim_x - x) + m_dim_spectrum_x * ((m_dim_y - y) % m_dim_y)];
+		return { value[0], -value[1] };
 	}
 
 	void getRawPhase() {
 		// Shift background spectrum to center and mask unwanted regions
-		circshift(m_out_FFT, m_dim_x, m_dim_y, -m_max_x, -m_max_y);
-		for (gsl::index jj{ 0 }; jj < m_dim_x * m_dim_y; jj++) {
-			m_out_FFT[jj][0] *= m_mask[jj];
-			m_out_FFT[jj][1] *= m_mask[jj];
-		}
+		m_threadPool.parallelFor(m_dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			memset(&m_field[m_dim_x * y_begin], 0, sizeof(fftw_complex) * m_dim_x * (y_end - y_begin));
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				auto y_source = ((y + m_max_y) % m_dim_y + m_dim_y) % m_dim_y;
+				for (gsl::index x{ 0 }; x < m_dim_x; x++) {
+					auto jj = x + m_dim_x * y;
+					if (m_mask[jj]) {
+						auto value = spectrumAt(((x + m_max_x) % m_dim_x + m_dim_x) % m_dim_x, y_source);
+						m_field[jj][0] = value.real();
+						m_field[jj][1] = value.imag();
+					}
+				}
+			}
+		});
 
 		// Calculate inverse Fourier transform of shifted and masked background
-		int N = m_dim_x * m_dim_y;
-		memcpy(m_in_IFFT, m_out_FFT, sizeof(fftw_complex) * N);
+		fftw_execute_dft(m_IFFT, m_field, m_field);
+	}
+
+	/*
+	 * Unwraps the phase at a resolution lowered by the given factor. Either the unwrapped
+	 * phase is upsampled, or it is used as an estimate to find the number of 2 pi to add
+	 * to every pixel of the full resolution phase.
+	 */
+	template <typename T_out = double>
+	void unwrap(T_out* phase, int dim_x, int dim_y, int factor, bool correctFullResolution) {
+		factor = std::max(1, factor);
+		int dim_x_new{ dim_x / factor };
+		int dim_y_new{ dim_y / factor };
+		std::vector<float> phase_lowRes;
+		phase_lowRes.resize((size_t)dim_x_new * dim_y_new);
+		if (factor == 1) {
+			std::copy(std::begin(*phase), std::end(*phase), std::begin(phase_lowRes));
+		} else {
+			// Downsample the image to speed up unwrapping
+			m_xsample->resample(&(*phase)[0], &phase_lowRes[0], dim_x, dim_y, dim_x_new, dim_y_new, RESAMPLE_MODE::NEAREST, m_threadPool);
+		}
+
+		std::vector<float> phaseUnwrapped = phase_lowRes;
+		m_unwrapper->unwrap2DWrapped(&phase_lowRes[0], &phaseUnwrapped[0], dim_x_new, dim_y_new, false, false);
+
+		// Subtract median value
+		phase_lowRes = phaseUnwrapped;
+		auto beg = std::begin(phase_lowRes);
+		auto end = std::end(phase_lowRes);
+		auto median = simplemath::median(beg, end);
+
+		if (factor == 1) {
+			m_threadPool.parallelFor((gsl::index)dim_x * dim_y, [&](gsl::index begin, gsl::index end) {
+				for (gsl::index i{ begin }; i < end; i++) {
+					(*phase)[i] = phaseUnwrapped[i] - median;
+				}
+			});
+			return;
+		}
+
+		if (!correctFullResolution) {
+			for (gsl::index i{ 0 }; i < dim_x_new * dim_y_new; i++) {
+				phaseUnwrapped[i] -= median;
+			}
+
+			// Upsample the image to match input resolution
+			m_xsample->resample(&phaseUnwrapped[0], &(*phase)[0], dim_x_new, dim_y_new, dim_x, dim_y, RESAMPLE_MODE::LINEAR, m_threadPool);
+			return;
+		}
+
+		// Add the number of 2 pi which brings every pixel closest to the upsampled estimate
+		std::vector<float> estimate;
+		estimate.resize((size_t)dim_x * dim_y);
+		m_xsample->resample(&phaseUnwrapped[0], &estimate[0], dim_x_new, dim_y_new, dim_x, dim_y, RESAMPLE_MODE::LINEAR, m_threadPool);
+		auto twoPi = 2 * 3.14159265358979323846;
+		m_threadPool.parallelFor((gsl::index)dim_x * dim_y, [&](gsl::index begin, gsl::index end) {
+			for (gsl::index i{ begin }; i < end; i++) {
+				auto wraps = round((estimate[i] - (*phase)[i]) / twoPi);
+				(*phase)[i] += twoPi * wraps - median;
+			}
+		});
+	}
 
-		fftw_execute(m_IFFT);
+	/*
+	 * Chooses the downsampling of the adaptive mode for the next frame. A finer level is
+	 * only chosen if the frame would still meet the budget with the whole frame time scaled
+	 * by the increase in unwrapped pixels.
+	 */
+	void adaptLevel(double frameTime) {
+		auto budget = m_unwrapSettings.timeBudget;
+		auto maxLevel = (gsl::index)m_adaptiveFactors.size() - 1;
+		if (frameTime > budget) {
+			m_adaptiveLevel = std::min(m_adaptiveLevel + 1, maxLevel);
+		} else if (m_adaptiveLevel > 0) {
+			auto ratio = pow((double)m_adaptiveFactors[m_adaptiveLevel] / m_adaptiveFactors[m_adaptiveLevel - 1], 2);
+			if (frameTime * ratio < 0.8 * budget) {
+				m_adaptiveLevel--;
+			}
+		}
 	}
 
 public:
 
 	bool m_updateBackground{ false };
 
-	phase() {}
+	explicit phase(int threadCount = ThreadPool::defaultThreadCount()) : m_threadPool(threadCount) {}
 
 	~phase() {
-		fftw_destroy_plan(m_FFT);
-		fftw_free(m_in_FFT);
-		fftw_free(m_out_FFT);
-
-		fftw_destroy_plan(m_IFFT);
-		fftw_free(m_in_IFFT);
-		fftw_free(m_out_IFFT);
+		fftw_free(m_spectrum);
+		fftw_free(m_field);
 
 		if (m_background != nullptr) {
 			fftw_free(m_background);
@@ -151,18 +266,15 @@ public:
 		// Test whether we have to reinitialize the FFT plan
 		initialize(dim_x, dim_y);
 
-		// Initialize the input array
-		copyToInput(m_in_FFT, intensity, dim_x, dim_y);
-		
 		// Calculate the Fourier transform (FFT)
-		fftw_execute(m_FFT);
+		transform(intensity, dim_x, dim_y);
 
 		background_findCenter(dim_x, dim_y);
 
 		getRawPhase();
 
 		int N = dim_x * dim_y;
-		memcpy(m_background, m_out_IFFT, , sizeof(fftw_complex) * N);
+		memcpy(m_background, m_field, sizeof(fftw_complex) * N);
 	}
 
 	/*
@@ -180,22 +292,18 @@ public:
 		m_dim_background_x = dim_x;
 		m_dim_background_y = dim_y;
 
-		// Calculate magnitude of background image to find the indices of the largest element
-		std::vector<double> background;
-		background.resize((size_t)dim_x * dim_y);
-		for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
-			background[i] = pow(m_out_FFT[i][0], 2) + pow(m_out_FFT[i][1], 2);
-		}
-
-		// Find indices of largest element in given range
+		// Find indices of the largest magnitude of the background spectrum in given range
 		int left = round(dim_y * 0.05) * dim_y;
-		int right = round(dim_y * 0.45) * dim_y;
-		std::vector<double>::iterator itl = std::begin(background);
-		std::vector<double>::iterator itr = std::begin(background);
-		std::advance(itl, left);
-		std::advance(itr, right);
-		std::vector<double>::iterator result = std::max_element(itl, itr);
-		int ind = std::distance(std::begin(background), result);
+		int right = std::min((int)round(dim_y * 0.45) * dim_y, dim_x * dim_y);
+		int ind{ left };
+		auto maximum{ -1.0 };
+		for (gsl::index i{ left }; i < right; i++) {
+			auto value = std::norm(spectrumAt(i % dim_x, i / dim_x));
+			if (value > maximum) {
+				maximum = value;
+				ind = (int)i;
+			}
+		}
 		
 		m_max_y = floor(ind / dim_x);
 		m_max_x = ind - m_max_y * dim_x;
@@ -209,30 +317,30 @@ public:
 		// Test whether we have to reinitialize the FFT plan
 		initialize(dim_x, dim_y);
 
-		// Initialize the input array
-		copyToInput(m_in_FFT, intensity, dim_x, dim_y);
-
 		// Calculate the FFT
-		fftw_execute(m_FFT);
+		transform(intensity, dim_x, dim_y);
 
 		// Calculate the absolute value
-		for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
-			(*spectrum)[i] = log10(sqrt(pow(m_out_FFT[i][0], 2) + pow(m_out_FFT[i][1], 2)) / ((size_t)dim_x * dim_y));
-		}
+		m_threadPool.parallelFor(dim_y, [&](gsl::index y_begin, gsl::index y_end) {
+			for (gsl::index y{ y_begin }; y < y_end; y++) {
+				for (gsl::index x{ 0 }; x < dim_x; x++) {
+					(*spectrum)[x + (gsl::index)dim_x * y] = log10(sqrt(std::norm(spectrumAt(x, y))) / ((size_t)dim_x * dim_y));
+				}
+			}
+		});
 
 		fftshift(&(*spectrum)[0], dim_x, dim_y);
 	}
 
 	template <typename T_in = double, typename T_out = double>
 	void calculatePhase(T_in* intensity, T_out* phase, int dim_x, int dim_y) {
+		auto start = std::chrono::steady_clock::now();
+
 		// Test whether we have to reinitialize the FFT plan
 		initialize(dim_x, dim_y);
 		
-		// Initialize the input array
-		copyToInput(m_in_FFT, intensity, dim_x, dim_y);
-		
 		// Calculate the Fourier transform (FFT)
-		fftw_execute(m_FFT);
+		transform(intensity, dim_x, dim_y);
 
 		// If we have no background yet (or the background does not have the correct size),
 		// we use the intensity image we just got
@@ -248,41 +356,60 @@ public:
 		if (updateBackground || m_updateBackground) {
 			m_updateBackground = false;
 			if (m_background) {
-				memcpy(m_background, m_out_IFFT, sizeof(fftw_complex) * N);
+				memcpy(m_background, m_field, sizeof(fftw_complex) * N);
 			}
 		}
 
 		// Divide by background and calculate the phase angle
-		for (gsl::index i{ 0 }; i < N; i++) {
-			double a = m_out_IFFT[i][0];
-			double b = m_out_IFFT[i][1];
-			double c = m_background[i][0];
-			double d = m_background[i][1];
-			(*phase)[i] = atan2((b * c - a * d), (a * c + b * d));
+		m_threadPool.parallelFor(N, [&](gsl::index begin, gsl::index end) {
+			for (gsl::index i{ begin }; i < end; i++) {
+				double a = m_field[i][0];
+				double b = m_field[i][1];
+				double c = m_background[i][0];
+				double d = m_background[i][1];
+				(*phase)[i] = atan2((b * c - a * d), (a * c + b * d));
+			}
+		});
+
+		switch (m_unwrapSettings.mode) {
+			case UNWRAP_MODE::DOWNSAMPLED:
+				unwrap(phase, dim_x, dim_y, m_unwrapSettings.downsampling, false);
+				break;
+			case UNWRAP_MODE::PYRAMID:
+				unwrap(phase, dim_x, dim_y, m_unwrapSettings.downsampling, true);
+				break;
+			case UNWRAP_MODE::FULL:
+				unwrap(phase, dim_x, dim_y, 1, true);
+				break;
+			case UNWRAP_MODE::ADAPTIVE:
+			default: {
+				unwrap(phase, dim_x, dim_y, m_adaptiveFactors[m_adaptiveLevel], true);
+				auto frameTime = 1e-6 * std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count();
+				adaptLevel(frameTime);
+				break;
+			}
 		}
+	}
 
-		// Downsample the image to speed up unwrapping
-		int dim_x_new{ dim_x / 3 };
-		int dim_y_new{ dim_y / 3 };
-		std::vector<float> phase_lowRes;
-		phase_lowRes.resize((size_t)dim_x_new * dim_y_new);
-		m_xsample->resample(&(*phase)[0], &phase_lowRes[0], dim_x, dim_y, dim_x_new, dim_y_new, RESAMPLE_MODE::NEAREST);
-
-		std::vector<float> phaseUnwrapped = phase_lowRes;
-		m_unwrapper->unwrap2DWrapped(&phase_lowRes[0], &phaseUnwrapped[0], dim_x_new, dim_y_new, false, false);
-
-		// Subtract median value
-		phase_lowRes = phaseUnwrapped;
-		auto beg = std::begin(phase_lowRes);
-		auto end = std::end(phase_lowRes);
-		auto median = simplemath::median(beg, end);
+	void setUnwrapSettings(const UNWRAP_SETTINGS& settings) {
+		m_unwrapSettings = settings;
+	}
 
-		for (gsl::index i{ 0 }; i < dim_x_new * dim_y_new; i++) {
-			phaseUnwrapped[i] -= median;
+	/*
+	 * Downsampling factor the phase of the next frame will be unwrapped at
+	 */
+	int getDownsampling() const {
+		switch (m_unwrapSettings.mode) {
+			case UNWRAP_MODE::DOWNSAMPLED:
+			case UNWRAP_MODE::PYRAMID:
+				return m_unwrapSettings.downsampling;
+			case UNWRAP_MODE::FULL:
+				return 1;
+			case UNWRAP_MODE::ADAPTIVE:
+			default:
+				return m_adaptiveFactors[m_adaptiveLevel];
 		}
-
-		// Upsample the image to match input resolution
-		m_xsample->resample(&phaseUnwrapped[0], &(*phase)[0], dim_x_new, dim_y_new, dim_x, dim_y, RESAMPLE_MODE::LINEAR);
 	}
 
 	template <typename T = double>
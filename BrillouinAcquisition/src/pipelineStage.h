@@ -0,0 +1,107 @@
+#ifndef PIPELINESTAGE_H
+#define PIPELINESTAGE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*
+ * Runs tasks on a single worker thread in the order they were pushed.
+ *
+ * Used by the acquisition modes to overlap work which does not need the hardware
+ * (packaging and queueing a payload) with the next stage move and exposure.
+ * The number of pending tasks is bounded, so a slow stage throttles the producer
+ * instead of piling up frames in memory.
+ */
+class PipelineStage {
+
+public:
+	explicit PipelineStage(int capacity = 4) : m_capacity(capacity) {
+		m_worker = std::thread(&PipelineStage::run, this);
+	};
+
+	~PipelineStage() {
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_stop = true;
+		}
+		m_taskAvailable.notify_all();
+		m_worker.join();
+	};
+
+	PipelineStage(const PipelineStage&) = delete;
+	PipelineStage& operator=(const PipelineStage&) = delete;
+
+	/*
+	 * Queues a task, blocks while the stage holds the maximum number of pending tasks.
+	 */
+	void push(std::function<void()> task) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_spaceAvailable.wait(lock, [this] { return (int)m_tasks.size() < m_capacity; });
+		m_tasks.push_back(std::move(task));
+		lock.unlock();
+		m_taskAvailable.notify_one();
+	}
+
+	/*
+	 * Queues a task if the stage has room for it, never blocks.
+	 */
+	bool tryPush(std::function<void()> task) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if ((int)m_tasks.size() >= m_capacity) {
+			return false;
+		}
+		m_tasks.push_back(std::move(task));
+		lock.unlock();
+		m_taskAvailable.notify_one();
+		return true;
+	}
+
+	/*
+	 * Blocks until all queued tasks have been run.
+	 */
+	void finish() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this] { return m_tasks.empty() && !m_busy; });
+	}
+
+private:
+	void run() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true) {
+			m_taskAvailable.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+			// pending tasks are run before the worker exits
+			if (m_tasks.empty()) {
+				return;
+			}
+			auto task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+			m_busy = true;
+			lock.unlock();
+			m_spaceAvailable.notify_one();
+
+			task();
+
+			lock.lock();
+			m_busy = false;
+			if (m_tasks.empty()) {
+				m_idle.notify_all();
+			}
+		}
+	}
+
+	int m_capacity{ 4 };				// [1]	maximum number of pending tasks
+	std::deque<std::function<void()>> m_tasks;
+	bool m_busy{ false };
+	bool m_stop{ false };
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+	std::condition_variable m_spaceAvailable;
+	std::condition_variable m_idle;
+	std::thread m_worker;
+};
+
+#endif // PIPELINESTAGE_H
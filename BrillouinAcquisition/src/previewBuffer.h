@@ -3,7 +3,7 @@
 
 #include <QtCore>
 #include <gsl/gsl>
-#include "circularBuffer.h"
+#include "latestFrameBuffer.h"
 #include "Devices\Cameras\cameraParameters.h"
 
 struct BUFFER_SETTINGS {
@@ -27,7 +27,7 @@ public:
 
 	std::mutex m_mutex;
 
-	CircularBuffer<T>* m_buffer = new CircularBuffer<T>;
+	LatestFrameBuffer<T>* m_buffer = new LatestFrameBuffer<T>;
 	BUFFER_SETTINGS m_bufferSettings;
 };
 
@@ -58,7 +58,7 @@ void inline PreviewBuffer<T>::initializeBuffer(BUFFER_SETTINGS bufferSettings) {
 		delete m_buffer;
 		m_buffer = nullptr;
 	}
-	m_buffer = new CircularBuffer<T>(m_bufferSettings.bufferNumber, m_bufferSettings.bufferSize);
+	m_buffer = new LatestFrameBuffer<T>(m_bufferSettings.bufferSize);
 }
 
 #endif //PREVIEWBUFFER_H
\ No newline at end of file
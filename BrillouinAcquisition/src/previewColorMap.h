@@ -0,0 +1,76 @@
+#ifndef PREVIEWCOLORMAP_H
+#define PREVIEWCOLORMAP_H
+
+#include <memory>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "external/qcustomplot/qcustomplot.h"
+
+/*
+ * Color map which draws an image rendered by a ColormapRenderer
+ * instead of colorizing its own cells.
+ *
+ * The cells only define where the image is drawn, the color scale and the gradient
+ * are used as before. Setting a new image only swaps the pointer, so the GUI thread
+ * does not touch the pixels until the image is drawn.
+ */
+class PreviewColorMap : public QCPColorMap {
+
+public:
+	PreviewColorMap(QCPAxis* keyAxis, QCPAxis* valueAxis) : QCPColorMap(keyAxis, valueAxis) {};
+
+	void setImage(std::shared_ptr<const QImage> image) {
+		m_image = std::move(image);
+	}
+
+	void clearImage() {
+		m_image.reset();
+	}
+
+	// Palette of the current gradient, as QCPColorGradient::colorize() uses it
+	static std::vector<QRgb> palette(QCPColorGradient gradient) {
+		auto levels = gradient.levelCount();
+		auto palette = std::vector<QRgb>(levels);
+		for (gsl::index i{ 0 }; i < levels; i++) {
+			palette[i] = gradient.color((double)i, QCPRange(0, (double)levels - 1));
+		}
+		return palette;
+	}
+
+protected:
+	void draw(QCPPainter* painter) override {
+		if (!m_image || m_image->isNull() || data()->isEmpty() || !keyAxis() || !valueAxis()) {
+			QCPColorMap::draw(painter);
+			return;
+		}
+		applyDefaultAntialiasingHint(painter);
+
+		auto keyRange = data()->keyRange();
+		auto valueRange = data()->valueRange();
+		auto imageRect = QRectF(coordsToPixels(keyRange.lower, valueRange.lower),
+			coordsToPixels(keyRange.upper, valueRange.upper)).normalized();
+		// the cells are centered on the borders of the map range
+		auto halfCellWidth = m_image->width() > 1 ? 0.5 * imageRect.width() / (m_image->width() - 1) : 0;
+		auto halfCellHeight = m_image->height() > 1 ? 0.5 * imageRect.height() / (m_image->height() - 1) : 0;
+		imageRect.adjust(-halfCellWidth, -halfCellHeight, halfCellWidth, halfCellHeight);
+
+		auto smoothBackup = painter->renderHints().testFlag(QPainter::SmoothPixmapTransform);
+		painter->setRenderHint(QPainter::SmoothPixmapTransform, interpolate());
+		// the first row of the image is the top of the map
+		auto mirrorX = keyAxis()->rangeReversed();
+		auto mirrorY = valueAxis()->rangeReversed();
+		if (mirrorX || mirrorY) {
+			painter->drawImage(imageRect, m_image->mirrored(mirrorX, mirrorY));
+		} else {
+			painter->drawImage(imageRect, *m_image);
+		}
+		painter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
+	}
+
+private:
+	std::shared_ptr<const QImage> m_image{ nullptr };
+};
+
+#endif // PREVIEWCOLORMAP_H
@@ -0,0 +1,118 @@
+#ifndef PREVIEWSCHEDULER_H
+#define PREVIEWSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+struct PREVIEW_STATISTICS {
+	double targetRate{ 0 };						// [Hz]	maximum rate the preview is updated with
+	double displayRate{ 0 };					// [Hz]	rate the preview was updated with
+	double cameraRate{ 0 };						// [Hz]	rate the camera delivered frames with
+	unsigned long long displayedFrames{ 0 };	// [1]	frames shown since the preview buffer was set up
+	unsigned long long droppedFrames{ 0 };		// [1]	frames replaced by a newer one before they were shown
+};
+
+/*
+ * Decides when the preview converts the next frame.
+ *
+ * Every new camera frame requests a conversion, but only the first request is queued
+ * until the conversion starts, later ones are absorbed. The conversion is delayed until
+ * the target period since the previous one passed, so it always takes the latest frame
+ * and the plotting thread never does more work than the display needs.
+ *
+ * request() may be called from any thread, everything else from the plotting thread only.
+ */
+class PreviewScheduler {
+
+public:
+	explicit PreviewScheduler(double targetRate = 30, int reportInterval = 1000) : m_reportInterval(reportInterval) {
+		setTargetRate(targetRate);
+	};
+
+	/*
+	 * [Hz]	maximum rate of the preview, zero for no limit
+	 */
+	void setTargetRate(double targetRate) {
+		auto period = targetRate > 0 ? std::chrono::nanoseconds{ (long long)(1e9 / targetRate) } : std::chrono::nanoseconds{ 0 };
+		m_period.store(period.count(), std::memory_order_relaxed);
+	}
+
+	double getTargetRate() const {
+		auto period = m_period.load(std::memory_order_relaxed);
+		return period > 0 ? 1e9 / period : 0;
+	}
+
+	/*
+	 * Returns true if the caller has to queue a conversion
+	 */
+	bool request() {
+		return !m_requested.exchange(true, std::memory_order_acq_rel);
+	}
+
+	/*
+	 * [ms]	time to wait before the next conversion may start
+	 */
+	int delay() const {
+		auto next = m_lastConversion + std::chrono::nanoseconds{ m_period.load(std::memory_order_relaxed) };
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+		return (int)std::max(remaining.count(), decltype(remaining)::rep{ 0 });
+	}
+
+	/*
+	 * Frames committed from now on request the next conversion
+	 */
+	void beginConversion() {
+		m_lastConversion = std::chrono::steady_clock::now();
+		m_requested.store(false, std::memory_order_release);
+	}
+
+	/*
+	 * Counts a frame that was shown, returns true if new statistics are available
+	 */
+	bool frameShown(unsigned long long frameNumber, unsigned long long droppedFrames) {
+		auto now = std::chrono::steady_clock::now();
+		// the frames are counted anew when the preview buffer is set up again
+		if (m_statistics.displayedFrames == 0 || frameNumber <= m_lastFrameNumber) {
+			m_statistics = PREVIEW_STATISTICS{};
+			m_intervalStart = now;
+			m_intervalFrameNumber = frameNumber - 1;
+			m_intervalDisplayed = 0;
+		}
+		m_lastFrameNumber = frameNumber;
+		m_statistics.displayedFrames++;
+		m_statistics.droppedFrames += droppedFrames;
+		m_intervalDisplayed++;
+
+		auto elapsed = std::chrono::duration<double>(now - m_intervalStart).count();
+		if (elapsed <= 0 || elapsed < 1e-3 * m_reportInterval) {
+			return false;
+		}
+		m_statistics.targetRate = getTargetRate();
+		m_statistics.displayRate = m_intervalDisplayed / elapsed;
+		m_statistics.cameraRate = (frameNumber - m_intervalFrameNumber) / elapsed;
+		m_intervalStart = now;
+		m_intervalFrameNumber = frameNumber;
+		m_intervalDisplayed = 0;
+		return true;
+	}
+
+	PREVIEW_STATISTICS getStatistics() const {
+		return m_statistics;
+	}
+
+private:
+	std::atomic<bool> m_requested{ false };
+	std::atomic<long long> m_period{ 0 };		// [ns]	minimum time between two conversions
+	int m_reportInterval{ 1000 };				// [ms]	minimum time between two reports of the statistics
+
+	std::chrono::steady_clock::time_point m_lastConversion;
+
+	PREVIEW_STATISTICS m_statistics;
+	unsigned long long m_lastFrameNumber{ 0 };
+	std::chrono::steady_clock::time_point m_intervalStart;
+	unsigned long long m_intervalFrameNumber{ 0 };
+	unsigned long long m_intervalDisplayed{ 0 };
+};
+
+#endif // PREVIEWSCHEDULER_H
@@ -0,0 +1,219 @@
+#ifndef SPOTDETECTION_H
+#define SPOTDETECTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "threadPool.h"
+
+typedef enum class spotRefinement {
+	NONE,		// center of the brightest pixel
+	CENTROID,	// intensity weighted centroid around the brightest pixel
+	GAUSSIAN	// Gaussian through the brightest pixel and its direct neighbours
+} SPOT_REFINEMENT;
+
+struct SPOT_SETTINGS {
+	SPOT_REFINEMENT refinement{ SPOT_REFINEMENT::GAUSSIAN };
+	int radius{ 3 };					// [pix]	half width of the window the centroid is calculated in
+	bool subtractBackground{ false };	// [bool]	acquire an image without laser light and subtract it
+};
+
+struct SPOT {
+	double x{ 0 };					// [pix]	column of the spot center
+	double y{ 0 };					// [pix]	row of the spot center
+	double intensity{ 0 };			// [1]		value of the brightest pixel above the background
+};
+
+/*
+ * Locates a single bright spot in a camera image.
+ *
+ * The spot is searched as the brightest 3x3 neighbourhood, so that a single hot pixel
+ * does not outshine a spot spanning a few pixels. The rows are split across a thread pool
+ * and the inner loops only run over contiguous rows, so that the compiler vectorizes them.
+ * The position is then refined to sub-pixel accuracy around the brightest pixel.
+ */
+class spotDetection {
+
+public:
+	explicit spotDetection(int threadCount = ThreadPool::defaultThreadCount()) : m_threadPool(threadCount) {};
+
+	void setSettings(const SPOT_SETTINGS& settings) {
+		m_settings = settings;
+	}
+
+	/*
+	 * Image subtracted from every image before locating the spot
+	 */
+	template <typename T>
+	void setBackground(const T* image, int dim_x, int dim_y) {
+		m_background.assign(image, image + (size_t)dim_x * dim_y);
+		m_background_x = dim_x;
+		m_background_y = dim_y;
+	}
+
+	void clearBackground() {
+		m_background.clear();
+	}
+
+	template <typename T>
+	SPOT locate(const T* image, int dim_x, int dim_y) {
+		auto background = (m_background_x == dim_x && m_background_y == dim_y && !m_background.empty())
+			? &m_background[0] : nullptr;
+		auto value = [&](gsl::index x, gsl::index y) {
+			auto index = x + (gsl::index)dim_x * y;
+			return background ? (float)image[index] - background[index] : (float)image[index];
+		};
+
+		auto maximum = findMaximum(image, background, dim_x, dim_y);
+		// the brightest pixel of the neighbourhood
+		auto center = maximum;
+		for (gsl::index y{ std::max<gsl::index>(center.y - 1, 0) }; y < std::min<gsl::index>(center.y + 2, dim_y); y++) {
+			for (gsl::index x{ std::max<gsl::index>(center.x - 1, 0) }; x < std::min<gsl::index>(center.x + 2, dim_x); x++) {
+				if (value(x, y) > value(maximum.x, maximum.y)) {
+					maximum.x = x;
+					maximum.y = y;
+				}
+			}
+		}
+		auto spot = SPOT{ (double)maximum.x, (double)maximum.y, (double)value(maximum.x, maximum.y) };
+
+		switch (m_settings.refinement) {
+			case SPOT_REFINEMENT::GAUSSIAN: {
+				if (maximum.x > 0 && maximum.x < dim_x - 1 && maximum.y > 0 && maximum.y < dim_y - 1) {
+					spot.x += gaussianOffset(value(maximum.x - 1, maximum.y), spot.intensity, value(maximum.x + 1, maximum.y));
+					spot.y += gaussianOffset(value(maximum.x, maximum.y - 1), spot.intensity, value(maximum.x, maximum.y + 1));
+				}
+				break;
+			}
+			case SPOT_REFINEMENT::CENTROID: {
+				auto x_begin = std::max<gsl::index>(maximum.x - m_settings.radius, 0);
+				auto x_end = std::min<gsl::index>(maximum.x + m_settings.radius + 1, dim_x);
+				auto y_begin = std::max<gsl::index>(maximum.y - m_settings.radius, 0);
+				auto y_end = std::min<gsl::index>(maximum.y + m_settings.radius + 1, dim_y);
+				// the minimum of the window is taken as the local background
+				auto offset = std::numeric_limits<float>::max();
+				for (gsl::index y{ y_begin }; y < y_end; y++) {
+					for (gsl::index x{ x_begin }; x < x_end; x++) {
+						offset = std::min(offset, value(x, y));
+					}
+				}
+				double sum{ 0 };
+				double sum_x{ 0 };
+				double sum_y{ 0 };
+				for (gsl::index y{ y_begin }; y < y_end; y++) {
+					for (gsl::index x{ x_begin }; x < x_end; x++) {
+						auto weight = (double)value(x, y) - offset;
+						sum += weight;
+						sum_x += weight * x;
+						sum_y += weight * y;
+					}
+				}
+				if (sum > 0) {
+					spot.x = sum_x / sum;
+					spot.y = sum_y / sum;
+				}
+				break;
+			}
+			case SPOT_REFINEMENT::NONE:
+			default:
+				break;
+		}
+		return spot;
+	}
+
+private:
+	struct MAXIMUM {
+		float value{ -std::numeric_limits<float>::max() };
+		gsl::index x{ 0 };
+		gsl::index y{ 0 };
+	};
+
+	/*
+	 * Center of the 3x3 neighbourhood with the largest sum
+	 */
+	template <typename T>
+	MAXIMUM findMaximum(const T* image, const float* background, int dim_x, int dim_y) {
+		auto maximum = MAXIMUM{};
+		// too small to have a neighbourhood, search the brightest pixel
+		if (dim_x < 3 || dim_y < 3) {
+			for (gsl::index i{ 0 }; i < (gsl::index)dim_x * dim_y; i++) {
+				auto pixel = background ? (float)image[i] - background[i] : (float)image[i];
+				if (pixel > maximum.value) {
+					maximum = MAXIMUM{ pixel, i % dim_x, i / dim_x };
+				}
+			}
+			return maximum;
+		}
+
+		std::mutex mutex;
+		m_threadPool.parallelFor(dim_y - 2, [&](gsl::index begin, gsl::index end) {
+			auto blockMaximum = MAXIMUM{};
+			auto columnSum = std::vector<float>(dim_x);
+			auto boxSum = std::vector<float>(dim_x);
+			for (gsl::index y{ begin + 1 }; y < end + 1; y++) {
+				auto above = &image[(y - 1) * dim_x];
+				auto row = &image[y * dim_x];
+				auto below = &image[(y + 1) * dim_x];
+				for (gsl::index x{ 0 }; x < dim_x; x++) {
+					columnSum[x] = (float)above[x] + (float)row[x] + (float)below[x];
+				}
+				if (background) {
+					auto backgroundAbove = &background[(y - 1) * dim_x];
+					auto backgroundRow = &background[y * dim_x];
+					auto backgroundBelow = &background[(y + 1) * dim_x];
+					for (gsl::index x{ 0 }; x < dim_x; x++) {
+						columnSum[x] -= backgroundAbove[x] + backgroundRow[x] + backgroundBelow[x];
+					}
+				}
+				auto rowMaximum = -std::numeric_limits<float>::max();
+				for (gsl::index x{ 1 }; x < dim_x - 1; x++) {
+					boxSum[x] = columnSum[x - 1] + columnSum[x] + columnSum[x + 1];
+					rowMaximum = std::max(rowMaximum, boxSum[x]);
+				}
+				// only look for the position if the row contains a new maximum
+				if (rowMaximum > blockMaximum.value) {
+					auto position = std::find(&boxSum[1], &boxSum[dim_x - 1], rowMaximum) - &boxSum[0];
+					blockMaximum = MAXIMUM{ rowMaximum, position, y };
+				}
+			}
+			std::lock_guard<std::mutex> lockGuard(mutex);
+			// the first one of equal maxima wins, independent of the block order
+			if (blockMaximum.value > maximum.value
+				|| (blockMaximum.value == maximum.value && blockMaximum.y < maximum.y)) {
+				maximum = blockMaximum;
+			}
+		});
+		return maximum;
+	}
+
+	/*
+	 * Position of the maximum of a Gaussian through three neighbouring values,
+	 * relative to the center one
+	 */
+	static double gaussianOffset(double left, double center, double right) {
+		if (left <= 0 || center <= 0 || right <= 0) {
+			return 0;
+		}
+		auto logLeft = log(left);
+		auto logCenter = log(center);
+		auto logRight = log(right);
+		auto curvature = logLeft - 2 * logCenter + logRight;
+		if (curvature >= 0) {
+			return 0;
+		}
+		return std::clamp(0.5 * (logLeft - logRight) / curvature, -0.5, 0.5);
+	}
+
+	SPOT_SETTINGS m_settings;
+	ThreadPool m_threadPool;
+	std::vector<float> m_background;
+	int m_background_x{ 0 };
+	int m_background_y{ 0 };
+};
+
+#endif // SPOTDETECTION_H
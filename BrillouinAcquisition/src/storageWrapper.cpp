@@ -2,249 +2,446 @@
 #include "storageWrapper.h"
 #include "logger.h"
 
+#include <cstdio>
+
 
 StorageWrapper::~StorageWrapper() {
-	// clear image queue in case acquisition was aborted
-	// and the queue is still filled
-	if (m_abort) {
-		while (!m_payloadQueueBrillouin_char.isEmpty()) {
-			auto img = m_payloadQueueBrillouin_char.dequeue();
-			delete img;
-		}
-		while (!m_payloadQueueBrillouin_short.isEmpty()) {
-			auto img = m_payloadQueueBrillouin_short.dequeue();
-			delete img;
-		}
-		while (!m_payloadQueueODT_char.isEmpty()) {
-			auto img = m_payloadQueueODT_char.dequeue();
-			delete img;
-		}
-		while (!m_payloadQueueODT_short.isEmpty()) {
-			auto img = m_payloadQueueODT_short.dequeue();
-			delete img;
-		}
-		while (!m_payloadQueueFluorescence_char.isEmpty()) {
-			auto img = m_payloadQueueFluorescence_char.dequeue();
-			delete img;
-		}
-		while (!m_payloadQueueFluorescence_short.isEmpty()) {
-			auto img = m_payloadQueueFluorescence_short.dequeue();
-			delete img;
-		}
-		while (!m_calibrationQueue_char.isEmpty()) {
-			auto cal = m_calibrationQueue_char.dequeue();
-			delete cal;
-		}
-		while (!m_calibrationQueue_short.isEmpty()) {
-			auto cal = m_calibrationQueue_short.dequeue();
-			delete cal;
-		}
-		while (!m_calibrationQueue_int.isEmpty()) {
-			auto cal = m_calibrationQueue_int.dequeue();
-			delete cal;
-		}
-	}
-	if (m_queueTimer) {
-		m_queueTimer->stop();
-		m_queueTimer->deleteLater();
-	}
+	// write the remaining payloads, or discard them
+	// in case acquisition was aborted
+	stopWriter();
+	clearQueue();
 	emit(finished());
 }
 
 void StorageWrapper::init() {
-	m_queueTimer = new QTimer();
-	QMetaObject::Connection connection = QWidget::connect(
-		m_queueTimer,
-		&QTimer::timeout,
-		this,
-		&StorageWrapper::s_writeQueues
-	);
+	// The writer sleeps on a condition variable and wakes up as soon as a payload arrives.
+	m_writerThread = std::thread(&StorageWrapper::runWriter, this);
 }
 
-void StorageWrapper::s_enqueuePayload(IMAGE<unsigned char> *img) {
-	m_payloadQueueBrillouin_char.enqueue(img);
+void StorageWrapper::setStorageSettings(const STORAGE_SETTINGS& settings) {
+	{
+		std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+		m_storageSettings = settings;
+	}
+	// blocked producers might fit into a larger queue now
+	m_spaceAvailable.notify_all();
+}
+
+STORAGE_SETTINGS StorageWrapper::getStorageSettings() {
+	std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+	return m_storageSettings;
+}
+
+STORAGE_STATISTICS StorageWrapper::getStatistics() {
+	std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+	return m_statistics;
+}
+
+std::vector<WRITE_TIMING> StorageWrapper::takeWriteTimings() {
+	std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+	auto timings = std::vector<WRITE_TIMING>{};
+	std::swap(timings, m_writeTimings);
+	return timings;
+}
+
+void StorageWrapper::s_enqueuePayload(IMAGE<unsigned char>* img) {
+	enqueue(img);
 }
 
 void StorageWrapper::s_enqueuePayload(IMAGE<unsigned short>* img) {
-	m_payloadQueueBrillouin_short.enqueue(img);
+	enqueue(img);
 }
 
 void StorageWrapper::s_enqueuePayload(IMAGE<unsigned int>* img) {
-	m_payloadQueueBrillouin_int.enqueue(img);
+	enqueue(img);
 }
 
-void StorageWrapper::s_enqueuePayload(ODTIMAGE<unsigned char>*img) {
-	m_payloadQueueODT_char.enqueue(img);
+void StorageWrapper::s_enqueuePayload(ODTIMAGE<unsigned char>* img) {
+	enqueue(img);
 }
 
 void StorageWrapper::s_enqueuePayload(ODTIMAGE<unsigned short>* img) {
-	m_payloadQueueODT_short.enqueue(img);
+	enqueue(img);
 }
 
-void StorageWrapper::s_enqueuePayload(FLUOIMAGE<unsigned char>*img) {
-	m_payloadQueueFluorescence_char.enqueue(img);
+void StorageWrapper::s_enqueuePayload(FLUOIMAGE<unsigned char>* img) {
+	enqueue(img);
 }
 
 void StorageWrapper::s_enqueuePayload(FLUOIMAGE<unsigned short>* img) {
-	m_payloadQueueFluorescence_short.enqueue(img);
+	enqueue(img);
 }
 
-void StorageWrapper::s_enqueueCalibration(CALIBRATION<unsigned char>*cal) {
-	m_calibrationQueue_char.enqueue(cal);
+void StorageWrapper::s_enqueueCalibration(CALIBRATION<unsigned char>* cal) {
+	enqueue(cal);
 }
 
 void StorageWrapper::s_enqueueCalibration(CALIBRATION<unsigned short>* cal) {
-	m_calibrationQueue_short.enqueue(cal);
+	enqueue(cal);
 }
 
 void StorageWrapper::s_enqueueCalibration(CALIBRATION<unsigned int>* cal) {
-	m_calibrationQueue_int.enqueue(cal);
+	enqueue(cal);
 }
 
 void StorageWrapper::s_finishedQueueing() {
-	m_finishedQueueing = true;
+	{
+		std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+		m_finishedQueueing = true;
+	}
+	m_payloadAvailable.notify_one();
 }
 
 void StorageWrapper::startWritingQueues() {
-	m_observeQueues = true;
-	m_finishedQueueing = false;
+	{
+		// reset together with the queue state, so the writer never sees an aborted new repetition
+		std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+		m_finishedQueueing = false;
+		m_abort = false;
+	}
 	emit(started());
-	m_queueTimer->start(50);
 }
 
+// Discards all payloads not yet written
 void StorageWrapper::stopWritingQueues() {
-	m_observeQueues = false;
-	m_finished = true;
-	m_queueTimer->stop();
-	m_finishedQueueing = true;
-	emit(finished());
+	m_abort = true;
+	s_finishedQueueing();
 }
 
-void StorageWrapper::s_writeQueues() {
-	while (!m_payloadQueueBrillouin_char.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
-		}
-		auto img = m_payloadQueueBrillouin_char.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
+/*
+ * Private definitions
+ */
+
+template <typename P>
+const WRITE_JOB_HANDLER* StorageWrapper::getHandler() {
+	using T = std::remove_reference_t<decltype(std::declval<P>().data[0])>;
+
+	auto kind = PAYLOAD_KIND::BRILLOUIN;
+	if constexpr (std::is_same_v<P, ODTIMAGE<T>>) {
+		kind = PAYLOAD_KIND::ODT;
+	} else if constexpr (std::is_same_v<P, FLUOIMAGE<T>>) {
+		kind = PAYLOAD_KIND::FLUORESCENCE;
+	} else if constexpr (std::is_same_v<P, CALIBRATION<T>>) {
+		kind = PAYLOAD_KIND::CALIBRATION;
 	}
-	while (!m_payloadQueueBrillouin_short.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
-		}
-		auto img = m_payloadQueueBrillouin_short.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
+
+	auto pixelType = PIXEL_TYPE::UNSIGNED_CHAR;
+	if constexpr (std::is_same_v<T, unsigned short>) {
+		pixelType = PIXEL_TYPE::UNSIGNED_SHORT;
+	} else if constexpr (std::is_same_v<T, unsigned int>) {
+		pixelType = PIXEL_TYPE::UNSIGNED_INT;
 	}
-	while (!m_payloadQueueBrillouin_int.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
+
+	static const auto handler = WRITE_JOB_HANDLER{
+		kind,
+		pixelType,
+		[](StorageWrapper* storage, std::vector<WRITE_JOB>& batch) {
+			return storage->writeBatch<P>(batch);
+		},
+		[](StorageWrapper* storage, void* payload) {
+			auto typedPayload = static_cast<P*>(payload);
+			storage->getFramePool<T>().recycle(std::move(typedPayload->data));
+			delete typedPayload;
+		},
+		[](void* payload, long long bytes) {
+			auto& data = static_cast<P*>(payload)->data;
+			if (bytes >= 0) {
+				data.resize(bytes / sizeof(T));
+				data.shrink_to_fit();
+			}
+			return reinterpret_cast<std::byte*>(data.data());
 		}
-		auto img = m_payloadQueueBrillouin_int.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
-	}
+	};
+	return &handler;
+}
 
-	while (!m_payloadQueueODT_char.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
+template <typename P>
+void StorageWrapper::enqueue(P* payload) {
+	auto job = WRITE_JOB{
+		getHandler<P>(),
+		payload,
+		std::chrono::steady_clock::now(),
+		(long long)(payload->data.size() * sizeof(payload->data[0]))
+	};
+
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	auto capacity = 1024LL * 1024 * m_storageSettings.queueCapacity;
+	// A payload larger than the capacity is still accepted by an empty queue, so we cannot deadlock.
+	auto isFull = [&]() {
+		return m_statistics.queuedBytes > 0 && m_statistics.queuedBytes + job.bytes > capacity;
+	};
+
+	if (isFull()) {
+		if (m_storageSettings.policy == BACKPRESSURE_POLICY::SPILL) {
+			m_statistics.spilledPayloads++;
+			m_pendingSpills++;
+			// don't hold the queue while writing to disk, the writer should continue
+			lock.unlock();
+			spill(job);
+			lock.lock();
+			m_pendingSpills--;
+		} else {
+			m_spaceAvailable.wait(lock, [&]() { return !isFull() || m_abort || m_stopWriter; });
 		}
-		auto img = m_payloadQueueODT_char.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
 	}
-	while (!m_payloadQueueODT_short.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
-		}
-		auto img = m_payloadQueueODT_short.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
+
+	if (job.spillOffset < 0) {
+		m_statistics.queuedBytes += job.bytes;
 	}
+	m_writeQueue.enqueue(std::move(job));
+	m_statistics.queueDepth = (int)m_writeQueue.size();
+	m_statistics.maxQueueDepth = std::max(m_statistics.maxQueueDepth, m_statistics.queueDepth);
+	lock.unlock();
+	m_payloadAvailable.notify_one();
+}
 
-	while (!m_payloadQueueFluorescence_char.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
+template <typename P>
+int StorageWrapper::writeBatch(std::vector<WRITE_JOB>& batch) {
+	using T = std::remove_reference_t<decltype(std::declval<P>().data[0])>;
+	if constexpr (std::is_same_v<P, IMAGE<T>>) {
+		if (getStorageSettings().layout == STORAGE_LAYOUT::CHUNKED) {
+			return writeChunked<T>(batch);
 		}
-		auto img = m_payloadQueueFluorescence_char.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
-		delete img;
-		img = nullptr;
 	}
-	while (!m_payloadQueueFluorescence_short.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
+	// H5BM creates one dataset per payload, so only the chunked layout writes a batch at once
+	auto written{ 0 };
+	for (auto& job : batch) {
+		try {
+			writePayload(static_cast<P*>(job.payload));
+			written++;
+		} catch (H5::Exception& exception) {
+			// the payload is lost, it is counted as failed instead of written
+			qWarning(logWarning()) << "Could not write the payload:" << exception.getCDetailMsg();
 		}
-		auto img = m_payloadQueueFluorescence_short.dequeue();
-		setPayloadData(img);
-		//std::string info = "Image written " + std::to_string(m_writtenImagesNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenImagesNr++;
+		// hands the image data back to the frame pool and deletes the payload
+		job.handler->discard(this, job.payload);
+	}
+	return written;
+}
+
+template <typename T>
+int StorageWrapper::writeChunked(std::vector<WRITE_JOB>& batch) {
+	auto images = std::vector<IMAGE<T>*>{};
+	images.reserve(batch.size());
+	for (auto& job : batch) {
+		images.push_back(static_cast<IMAGE<T>*>(job.payload));
+	}
+
+	auto written{ 0 };
+	try {
+		getChunkedPayload().append(images);
+		written = (int)images.size();
+	} catch (H5::Exception& exception) {
+		// the payloads are lost, they are counted as failed instead of written
+		qWarning(logWarning()) << "Could not write" << images.size() << "chunked payloads:" << exception.getCDetailMsg();
+	}
+
+	m_writtenImagesNr += written;
+	for (auto img : images) {
+		getFramePool<T>().recycle(std::move(img->data));
 		delete img;
-		img = nullptr;
 	}
+	return written;
+}
 
-	while (!m_calibrationQueue_char.isEmpty()) {
-		if (m_abort) {
-			stopWritingQueues();
-			return;
+/*
+ * Returns the chunked payload of the current repetition, creates it for the first payload.
+ */
+ChunkedPayload& StorageWrapper::getChunkedPayload() {
+	if (!m_chunkedPayload) {
+		if (!m_chunkedFile) {
+			// HDF5 shares the underlying file with the handle of H5BM
+			m_chunkedFile = std::make_unique<H5::H5File>(m_fullPath, H5F_ACC_RDWR);
 		}
-		auto cal = m_calibrationQueue_char.dequeue();
-		setCalibrationData(cal->index, cal->data, cal->rank, cal->dims, cal->sample, cal->shift, cal->date, cal->exposure, cal->gain, cal->roi);
-		//std::string info = "Calibration written " + std::to_string(m_writtenCalibrationsNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenCalibrationsNr++;
-		delete cal;
-		cal = nullptr;
+		auto group = ChunkedPayload::createRepetition(*m_chunkedFile, "BrillouinChunked", "Brillouin");
+		m_chunkedPayload = std::make_unique<ChunkedPayload>(group, getStorageSettings().compression);
 	}
+	return *m_chunkedPayload;
+}
+
+void StorageWrapper::closeChunkedPayload() {
+	m_chunkedPayload.reset();
+	if (m_chunkedFile) {
+		m_chunkedFile->flush(H5F_SCOPE_LOCAL);
+		m_chunkedFile.reset();
+	}
+}
+
+template <typename T>
+void StorageWrapper::writePayload(IMAGE<T>* img) {
+	setPayloadData(img);
+	m_writtenImagesNr++;
+}
+
+template <typename T>
+void StorageWrapper::writePayload(ODTIMAGE<T>* img) {
+	setPayloadData(img);
+	m_writtenImagesNr++;
+}
+
+template <typename T>
+void StorageWrapper::writePayload(FLUOIMAGE<T>* img) {
+	setPayloadData(img);
+	m_writtenImagesNr++;
+}
+
+template <typename T>
+void StorageWrapper::writePayload(CALIBRATION<T>* cal) {
+	setCalibrationData(cal->index, cal->data, cal->rank, cal->dims, cal->sample, cal->shift, cal->date, cal->exposure, cal->gain, cal->roi);
+	m_writtenCalibrationsNr++;
+}
+
+/*
+ * Moves the image data of a payload to the spill file and releases its memory.
+ */
+void StorageWrapper::spill(WRITE_JOB& job) {
+	std::lock_guard<std::mutex> lockGuard(m_spillMutex);
+	if (!m_spillFile.is_open()) {
+		m_spillFile.open(m_spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+		m_spillFileSize = 0;
+	}
+	m_spillFile.seekp(m_spillFileSize);
+	m_spillFile.write(reinterpret_cast<const char*>(job.handler->data(job.payload, -1)), job.bytes);
+	if (!m_spillFile.good()) {
+		// keep the data in memory if the spill file is not writable
+		m_spillFile.clear();
+		qWarning(logWarning()) << "Could not write to the spill file" << m_spillPath.c_str();
+		return;
+	}
+	job.spillOffset = m_spillFileSize;
+	m_spillFileSize += job.bytes;
+
+	job.handler->data(job.payload, 0);
+}
+
+void StorageWrapper::unspill(WRITE_JOB& job) {
+	auto data = job.handler->data(job.payload, job.bytes);
+
+	std::lock_guard<std::mutex> lockGuard(m_spillMutex);
+	m_spillFile.seekg(job.spillOffset);
+	m_spillFile.read(reinterpret_cast<char*>(data), job.bytes);
+}
+
+/*
+ * Runs on the writer thread until the storage is destroyed.
+ */
+void StorageWrapper::runWriter() {
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	while (true) {
+		m_payloadAvailable.wait(lock, [this]() {
+			return m_stopWriter || m_finishedQueueing || !m_writeQueue.isEmpty();
+		});
 
-	while (!m_calibrationQueue_short.isEmpty()) {
 		if (m_abort) {
-			stopWritingQueues();
+			lock.unlock();
+			clearQueue();
+			m_spaceAvailable.notify_all();
+			lock.lock();
+		}
+
+		while (!m_abort && !m_writeQueue.isEmpty()) {
+			auto batch = takeBatch();
+			lock.unlock();
+
+			for (auto& job : batch) {
+				if (job.spillOffset >= 0) {
+					unspill(job);
+				}
+			}
+			auto written = batch.front().handler->writeBatch(this, batch);
+			auto now = std::chrono::steady_clock::now();
+
+			lock.lock();
+			for (const auto& job : batch) {
+				if (job.spillOffset < 0) {
+					m_statistics.queuedBytes -= job.bytes;
+				}
+				auto latency = 1e-6 * std::chrono::duration_cast<std::chrono::nanoseconds>(now - job.enqueued).count();
+				m_statistics.lastWriteLatency = latency;
+				m_statistics.maxWriteLatency = std::max(m_statistics.maxWriteLatency, latency);
+				m_totalWriteLatency += latency;
+				if (m_storageSettings.recordTimings) {
+					m_writeTimings.push_back({ job.enqueued, now, job.bytes, job.handler->kind });
+				}
+			}
+			m_statistics.writtenPayloads += written;
+			m_statistics.failedPayloads += batch.size() - written;
+			m_statistics.meanWriteLatency = m_totalWriteLatency / (m_statistics.writtenPayloads + m_statistics.failedPayloads);
+			m_statistics.queueDepth = (int)m_writeQueue.size();
+			auto statistics = m_statistics;
+			lock.unlock();
+			m_spaceAvailable.notify_all();
+			emit(s_statisticsChanged(statistics));
+			lock.lock();
+		}
+
+		if (m_writeQueue.isEmpty() && m_pendingSpills == 0) {
+			// all spilled payloads are written, the spill file can be removed
+			std::lock_guard<std::mutex> lockGuard(m_spillMutex);
+			if (m_spillFile.is_open()) {
+				m_spillFile.close();
+				std::remove(m_spillPath.c_str());
+				m_spillFileSize = 0;
+			}
+		}
+
+		if (m_finishedQueueing && (m_writeQueue.isEmpty() || m_abort)) {
+			m_finishedQueueing = false;
+			auto statistics = m_statistics;
+			lock.unlock();
+			// the repetition is complete, the next payload starts a new chunked dataset
+			closeChunkedPayload();
+			auto info = QString("Written %1 payloads, mean latency %2 ms, maximum latency %3 ms, maximum queue depth %4.")
+				.arg(statistics.writtenPayloads)
+				.arg(statistics.meanWriteLatency, 0, 'f', 1)
+				.arg(statistics.maxWriteLatency, 0, 'f', 1)
+				.arg(statistics.maxQueueDepth);
+			qInfo(logInfo()) << info;
+			if (statistics.failedPayloads > 0) {
+				qWarning(logWarning()) << statistics.failedPayloads << "payloads could not be written to" << m_fullPath.c_str();
+			}
+			emit(finished());
+			lock.lock();
+		}
+
+		if (m_stopWriter && (m_writeQueue.isEmpty() || m_abort)) {
 			return;
 		}
-		auto cal = m_calibrationQueue_short.dequeue();
-		setCalibrationData(cal->index, cal->data, cal->rank, cal->dims, cal->sample, cal->shift, cal->date, cal->exposure, cal->gain, cal->roi);
-		//std::string info = "Calibration written " + std::to_string(m_writtenCalibrationsNr);
-		//qInfo(logInfo()) << info.c_str();
-		m_writtenCalibrationsNr++;
-		delete cal;
-		cal = nullptr;
 	}
+}
 
-	if (m_finishedQueueing) {
-		m_queueTimer->stop();
-		emit(finished());
+/*
+ * Takes the consecutive payloads at the head of the queue which go into the same dataset,
+ * expects the queue mutex to be locked.
+ */
+std::vector<WRITE_JOB> StorageWrapper::takeBatch() {
+	auto batch = std::vector<WRITE_JOB>{};
+	batch.push_back(m_writeQueue.dequeue());
+	while (!m_writeQueue.isEmpty() && (int)batch.size() < m_maxBatchSize && m_writeQueue.head().isSameDataset(batch.front())) {
+		batch.push_back(m_writeQueue.dequeue());
 	}
-}
\ No newline at end of file
+	return batch;
+}
+
+void StorageWrapper::clearQueue() {
+	std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+	while (!m_writeQueue.isEmpty()) {
+		auto job = m_writeQueue.dequeue();
+		job.handler->discard(this, job.payload);
+	}
+	m_statistics.queueDepth = 0;
+	m_statistics.queuedBytes = 0;
+}
+
+void StorageWrapper::stopWriter() {
+	{
+		std::lock_guard<std::mutex> lockGuard(m_queueMutex);
+		m_stopWriter = true;
+	}
+	m_payloadAvailable.notify_one();
+	m_spaceAvailable.notify_all();
+	if (m_writerThread.joinable()) {
+		m_writerThread.join();
+	}
+	closeChunkedPayload();
+}
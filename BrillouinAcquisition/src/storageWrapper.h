@@ -2,6 +2,16 @@
 #define STORAGEWRAPPER_H
 
 #include "../external/h5bm/h5bm.h"
+#include "chunkedPayload.h"
+#include "framePool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 class StoragePath {
 public:
@@ -16,6 +26,92 @@ public:
 	}
 };
 
+enum class BACKPRESSURE_POLICY {
+	BLOCK,	// the producer waits until the writer made room
+	SPILL	// the image data is moved to a spill file until it is written
+};
+
+enum class STORAGE_LAYOUT {
+	PER_POSITION,	// one dataset per Brillouin position, as written by H5BM
+	CHUNKED			// one chunked dataset per repetition, see ChunkedPayload
+};
+
+struct STORAGE_SETTINGS {
+	int queueCapacity{ 2048 };							// [MB]	image data held in memory before backpressure applies
+	BACKPRESSURE_POLICY policy{ BACKPRESSURE_POLICY::BLOCK };
+	STORAGE_LAYOUT layout{ STORAGE_LAYOUT::PER_POSITION };
+	int compression{ 0 };								// [1]	deflate level of the chunked layout, 0 disables compression
+	bool recordTimings{ false };						// record the timing of every written payload, see takeWriteTimings
+};
+
+struct STORAGE_STATISTICS {
+	int queueDepth{ 0 };				// [1]	payloads waiting to be written
+	int maxQueueDepth{ 0 };				// [1]	largest number of payloads waiting at once
+	long long queuedBytes{ 0 };			// [B]	image data of the waiting payloads held in memory
+	long long writtenPayloads{ 0 };		// [1]	payloads written to the file
+	long long spilledPayloads{ 0 };		// [1]	payloads moved to the spill file because the queue was full
+	long long failedPayloads{ 0 };		// [1]	payloads which could not be written to the file
+	double lastWriteLatency{ 0 };		// [ms]	time from enqueueing until the last payload was written
+	double meanWriteLatency{ 0 };		// [ms]
+	double maxWriteLatency{ 0 };		// [ms]
+};
+
+enum class PAYLOAD_KIND {
+	BRILLOUIN,
+	ODT,
+	FLUORESCENCE,
+	CALIBRATION
+};
+
+enum class PIXEL_TYPE {
+	UNSIGNED_CHAR,
+	UNSIGNED_SHORT,
+	UNSIGNED_INT
+};
+
+/*
+ * Timing of one written payload
+ */
+struct WRITE_TIMING {
+	std::chrono::steady_clock::time_point enqueued;
+	std::chrono::steady_clock::time_point written;
+	long long bytes{ 0 };				// [B]	size of the image data
+	PAYLOAD_KIND kind;
+};
+
+class StorageWrapper;
+struct WRITE_JOB;
+
+/*
+ * Functions for one payload type, selected when the payload is enqueued.
+ * Jobs sharing the same handler write to the same kind of dataset.
+ */
+struct WRITE_JOB_HANDLER {
+	PAYLOAD_KIND kind;
+	PIXEL_TYPE pixelType;
+	// writes consecutive jobs of this payload type, returns the number of payloads written
+	int (*writeBatch)(StorageWrapper* storage, std::vector<WRITE_JOB>& batch);
+	// deletes a payload which will not be written
+	void (*discard)(StorageWrapper* storage, void* payload);
+	// returns the image data, resized to the given number of bytes if not negative
+	std::byte* (*data)(void* payload, long long bytes);
+};
+
+/*
+ * Type-erased payload waiting in the write queue
+ */
+struct WRITE_JOB {
+	const WRITE_JOB_HANDLER* handler{ nullptr };
+	void* payload{ nullptr };
+	std::chrono::steady_clock::time_point enqueued;
+	long long bytes{ 0 };				// [B]	size of the image data
+	long long spillOffset{ -1 };		// [B]	position of the image data in the spill file, -1 if held in memory
+
+	bool isSameDataset(const WRITE_JOB& job) const {
+		return handler->kind == job.handler->kind && handler->pixelType == job.handler->pixelType;
+	}
+};
+
 class StorageWrapper : public H5BM {
 	Q_OBJECT
 
@@ -24,36 +120,38 @@ public:
 		QObject *parent = nullptr,
 		const std::string& fullPath = StoragePath{}.fullPath(),//"./Brillouin.h5",
 		int flags = H5F_ACC_RDONLY
-	) noexcept : H5BM(parent, fullPath, flags) {};
+	) noexcept : H5BM(parent, fullPath, flags), m_fullPath(fullPath), m_spillPath(fullPath + ".spill") {};
 	~StorageWrapper();
 
-	QQueue<IMAGE<unsigned char>*> m_payloadQueueBrillouin_char;
-	QQueue<IMAGE<unsigned short>*> m_payloadQueueBrillouin_short;
-	QQueue<IMAGE<unsigned int>*> m_payloadQueueBrillouin_int;
-
-	QQueue<ODTIMAGE<unsigned char>*> m_payloadQueueODT_char;
-	QQueue<ODTIMAGE<unsigned short>*> m_payloadQueueODT_short;
+	// Frame buffers are handed back to these pools after they are written
+	FramePool<unsigned char> m_framePool_char;
+	FramePool<unsigned short> m_framePool_short;
+	FramePool<unsigned int> m_framePool_int;
 
-	QQueue<FLUOIMAGE<unsigned char>*> m_payloadQueueFluorescence_char;
-	QQueue<FLUOIMAGE<unsigned short>*> m_payloadQueueFluorescence_short;
+	template <typename T>
+	FramePool<T>& getFramePool();
 
-	QQueue<CALIBRATION<unsigned char>*> m_calibrationQueue_char;
-	QQueue<CALIBRATION<unsigned short>*> m_calibrationQueue_short;
-	QQueue<CALIBRATION<unsigned int>*> m_calibrationQueue_int;
+	void setStorageSettings(const STORAGE_SETTINGS& settings);
+	STORAGE_SETTINGS getStorageSettings();
+	STORAGE_STATISTICS getStatistics();
+	// returns and clears the timings recorded since the last call
+	std::vector<WRITE_TIMING> takeWriteTimings();
 
-	bool m_abort{ false };
+	std::atomic<bool> m_abort{ false };
 
-	int m_writtenImagesNr{ 0 };
-	int m_writtenCalibrationsNr{ 0 };
+	std::atomic<int> m_writtenImagesNr{ 0 };
+	std::atomic<int> m_writtenCalibrationsNr{ 0 };
 
 public slots:
 	void init();
 
+	/*
+	 * startWritingQueues and the enqueue functions are thread-safe and are called directly from the acquisition thread.
+	 * Like this the queues are reset before the first payload arrives and a full queue can block the producer.
+	 */
 	void startWritingQueues();
 	void stopWritingQueues();
 
-	void s_writeQueues();
-
 	void s_enqueuePayload(IMAGE<unsigned char>*);
 	void s_enqueuePayload(IMAGE<unsigned short>*);
 	void s_enqueuePayload(IMAGE<unsigned int>*);
@@ -71,15 +169,83 @@ public slots:
 	void s_finishedQueueing();
 
 private:
-	bool m_finished{ false };
-	bool m_observeQueues{ false };
+	template <typename P>
+	static const WRITE_JOB_HANDLER* getHandler();
+
+	template <typename P>
+	void enqueue(P* payload);
+	template <typename P>
+	int writeBatch(std::vector<WRITE_JOB>& batch);
+	template <typename T>
+	int writeChunked(std::vector<WRITE_JOB>& batch);
+	ChunkedPayload& getChunkedPayload();
+	void closeChunkedPayload();
+
+	// write a single payload, which stays owned by the caller
+	template <typename T>
+	void writePayload(IMAGE<T>* img);
+	template <typename T>
+	void writePayload(ODTIMAGE<T>* img);
+	template <typename T>
+	void writePayload(FLUOIMAGE<T>* img);
+	template <typename T>
+	void writePayload(CALIBRATION<T>* cal);
+
+	void spill(WRITE_JOB& job);
+	void unspill(WRITE_JOB& job);
+
+	void runWriter();
+	std::vector<WRITE_JOB> takeBatch();
+	void clearQueue();
+	void stopWriter();
+
+	// all payloads in the order they were enqueued
+	QQueue<WRITE_JOB> m_writeQueue;
+	int m_maxBatchSize{ 64 };			// [1]	maximum number of payloads written at once
+	std::mutex m_queueMutex;
+	// signals the writer that a payload arrived or queueing finished
+	std::condition_variable m_payloadAvailable;
+	// signals blocked producers that the writer made room
+	std::condition_variable m_spaceAvailable;
+	std::thread m_writerThread;
+	bool m_stopWriter{ false };
 	bool m_finishedQueueing{ false };
+	int m_pendingSpills{ 0 };			// [1]	payloads currently being moved to the spill file
+
+	STORAGE_SETTINGS m_storageSettings;
+	STORAGE_STATISTICS m_statistics;
+	double m_totalWriteLatency{ 0 };	// [ms]
+	std::vector<WRITE_TIMING> m_writeTimings;
+
+	std::string m_fullPath;
+	// second handle on the file for the chunked layout, only used by the writer thread
+	std::unique_ptr<H5::H5File> m_chunkedFile;
+	std::unique_ptr<ChunkedPayload> m_chunkedPayload;
 
-	QTimer* m_queueTimer{ nullptr };
+	std::string m_spillPath;
+	std::mutex m_spillMutex;
+	std::fstream m_spillFile;
+	long long m_spillFileSize{ 0 };		// [B]
 
 signals:
 	void finished();
 	void started();
+	void s_statisticsChanged(STORAGE_STATISTICS);
 };
 
+template <>
+inline FramePool<unsigned char>& StorageWrapper::getFramePool() {
+	return m_framePool_char;
+}
+
+template <>
+inline FramePool<unsigned short>& StorageWrapper::getFramePool() {
+	return m_framePool_short;
+}
+
+template <>
+inline FramePool<unsigned int>& StorageWrapper::getFramePool() {
+	return m_framePool_int;
+}
+
 #endif //STORAGEWRAPPER_H
@@ -0,0 +1,140 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gsl/gsl>
+
+/*
+ * A fixed set of worker threads to split loops over images into blocks.
+ *
+ * parallelFor() blocks until the whole range is processed, the calling thread
+ * works on blocks as well. Only one loop runs on a pool at a time.
+ */
+class ThreadPool {
+
+public:
+	/*
+	 * Number of threads used when none is given, one per hardware thread
+	 */
+	static int defaultThreadCount() {
+		return std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	explicit ThreadPool(int threadCount = defaultThreadCount()) : m_threadCount(std::max(1, threadCount)) {
+		// the calling thread is the first thread of the pool
+		for (gsl::index i{ 1 }; i < m_threadCount; i++) {
+			m_workers.emplace_back(&ThreadPool::run, this);
+		}
+	};
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_stop = true;
+		}
+		m_jobAvailable.notify_all();
+		for (auto& worker : m_workers) {
+			worker.join();
+		}
+	};
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int threadCount() const noexcept {
+		return m_threadCount;
+	}
+
+	/*
+	 * Calls function(begin, end) for contiguous blocks covering [0, count)
+	 */
+	void parallelFor(gsl::index count, const std::function<void(gsl::index, gsl::index)>& function) {
+		if (count <= 0) {
+			return;
+		}
+		if (m_threadCount == 1 || count == 1) {
+			function(0, count);
+			return;
+		}
+
+		std::lock_guard<std::mutex> jobLock(m_jobMutex);
+		// a few blocks per thread even out blocks which take longer than others
+		auto job = std::make_shared<Job>();
+		job->function = &function;
+		job->count = count;
+		job->blocks = std::min(count, (gsl::index)4 * m_threadCount);
+		job->pendingBlocks = job->blocks;
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_job = job;
+		}
+		m_jobAvailable.notify_all();
+
+		runBlocks(*job);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobDone.wait(lock, [&job] { return job->pendingBlocks == 0; });
+		m_job.reset();
+	}
+
+private:
+	struct Job {
+		const std::function<void(gsl::index, gsl::index)>* function{ nullptr };
+		gsl::index count{ 0 };
+		gsl::index blocks{ 0 };
+		std::atomic<gsl::index> nextBlock{ 0 };
+		std::atomic<gsl::index> pendingBlocks{ 0 };
+	};
+
+	void runBlocks(Job& job) {
+		while (true) {
+			auto block = job.nextBlock++;
+			if (block >= job.blocks) {
+				return;
+			}
+			(*job.function)(block * job.count / job.blocks, (block + 1) * job.count / job.blocks);
+			if (--job.pendingBlocks == 0) {
+				std::lock_guard<std::mutex> lockGuard(m_mutex);
+				m_jobDone.notify_all();
+			}
+		}
+	}
+
+	void run() {
+		auto finished = std::shared_ptr<Job>{};
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true) {
+			m_jobAvailable.wait(lock, [this, &finished] { return m_stop || (m_job && m_job != finished); });
+			if (m_stop) {
+				return;
+			}
+			// keeps the job alive, even if the loop is done before this worker gets to it
+			auto job = m_job;
+			lock.unlock();
+			runBlocks(*job);
+			lock.lock();
+			finished = job;
+		}
+	}
+
+	int m_threadCount{ 1 };
+	std::vector<std::thread> m_workers;
+
+	std::shared_ptr<Job> m_job;
+	bool m_stop{ false };
+
+	std::mutex m_jobMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::condition_variable m_jobDone;
+};
+
+#endif // THREADPOOL_H
@@ -2,15 +2,21 @@
 #define UNWRAPPER_H
 
 #include <gsl/gsl>
+#include <vector>
 
 extern "C" {
 	#include "../external/unwrap/unwrap2D.h"
 }
 
+typedef enum class unwrapMethod {
+	QUICKSORT,		// reference implementation, edges sorted by quicker_sort and pixels gathered in linked lists
+	BUCKETSORT		// edges ordered by a counting sort of quantized reliabilities and pixels merged with union-find
+} UNWRAP_METHOD;
+
 class unwrap2Wrapper {
 
 public:
-	unwrap2Wrapper();
+	explicit unwrap2Wrapper(UNWRAP_METHOD method = UNWRAP_METHOD::BUCKETSORT);
 	~unwrap2Wrapper();
 
 	void unwrap2DWrapped(float* wrapped_image, float* UnwrappedImage,
@@ -18,11 +24,36 @@ public:
 		int wrap_around_x, int wrap_around_y);
 
 private:
+	void unwrapQuicksort(float* wrapped_image, float* UnwrappedImage,
+		int image_width, int image_height,
+		int wrap_around_x, int wrap_around_y);
+
+	void unwrapBucketsort(float* wrapped_image, float* UnwrappedImage,
+		int image_width, int image_height,
+		int wrap_around_x, int wrap_around_y);
+
+	void calculateReliability(float* wrapped_image, int image_width, int image_height,
+		int wrap_around_x, int wrap_around_y);
+
+	int findGroup(int pixel, int& increment);
+
+	UNWRAP_METHOD m_method{ UNWRAP_METHOD::BUCKETSORT };
+
 	bool m_initialized{ false };
 	int m_image_size{ 0 };
 	int m_No_of_Edges_initially{ 0 };
 	PIXELM* m_pixel{ nullptr };
 	EDGE* m_edge{ nullptr };
+
+	// buffers of the bucket sort implementation, kept between calls
+	std::vector<float> m_reliability;
+	std::vector<int> m_edges;				// pixel index times two, plus one for vertical edges
+	std::vector<int> m_sortedEdges;
+	std::vector<unsigned short> m_keys;		// quantized edge reliabilities
+	std::vector<int> m_bucketStart;
+	std::vector<int> m_parent;				// union-find forest of the pixel groups
+	std::vector<int> m_increment;			// number of 2 pi to add relative to the parent
+	std::vector<int> m_groupSize;
 };
 
-#endif // UNWRAPPER_H
\ No newline at end of file
+#endif // UNWRAPPER_H
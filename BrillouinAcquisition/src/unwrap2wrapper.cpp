@@ -1,7 +1,9 @@
 #include "stdafx.h"
 #include "unwrap2Wrapper.h"
 
-unwrap2Wrapper::unwrap2Wrapper() {}
+#include <limits>
+
+unwrap2Wrapper::unwrap2Wrapper(UNWRAP_METHOD method) : m_method(method) {}
 
 unwrap2Wrapper::~unwrap2Wrapper() {
 	if (m_pixel) {
@@ -13,6 +15,18 @@ unwrap2Wrapper::~unwrap2Wrapper() {
 }
 
 void unwrap2Wrapper::unwrap2DWrapped(float * wrapped_image, float * UnwrappedImage, int image_width, int image_height, int wrap_around_x, int wrap_around_y) {
+	switch (m_method) {
+		case UNWRAP_METHOD::QUICKSORT:
+			unwrapQuicksort(wrapped_image, UnwrappedImage, image_width, image_height, wrap_around_x, wrap_around_y);
+			break;
+		case UNWRAP_METHOD::BUCKETSORT:
+		default:
+			unwrapBucketsort(wrapped_image, UnwrappedImage, image_width, image_height, wrap_around_x, wrap_around_y);
+			break;
+	}
+}
+
+void unwrap2Wrapper::unwrapQuicksort(float * wrapped_image, float * UnwrappedImage, int image_width, int image_height, int wrap_around_x, int wrap_around_y) {
 	int image_size = image_height * image_width;
 	int No_of_Edges_initially = 2 * image_size;
 	if (m_image_size != image_size) {
@@ -32,3 +46,211 @@ void unwrap2Wrapper::unwrap2DWrapped(float * wrapped_image, float * UnwrappedIma
 	m_initialized = true;
 	unwrap2D(wrapped_image, UnwrappedImage, image_width, image_height, wrap_around_x, wrap_around_y, m_edge, m_pixel);
 }
+
+/*
+ * Same algorithm as unwrap2D (Herraez et al., Applied Optics 41, 7437, 2002), but
+ * - the edges are ordered by a single counting sort pass over the upper 16 bit of their
+ *   reliability, which keeps about 2.5 significant digits, instead of a recursive quicksort
+ * - the pixel groups are a union-find forest with path compression, instead of linked
+ *   lists which have to be walked to relabel a group on every merge
+ * The result only differs from unwrap2D where edges of almost equal reliability are
+ * processed in a different order, and by a constant multiple of 2 pi.
+ */
+void unwrap2Wrapper::unwrapBucketsort(float * wrapped_image, float * UnwrappedImage, int image_width, int image_height, int wrap_around_x, int wrap_around_y) {
+	auto image_size = image_width * image_height;
+	if (image_size <= 0) {
+		return;
+	}
+
+	calculateReliability(wrapped_image, image_width, image_height, wrap_around_x, wrap_around_y);
+
+	// Edges to the right and to the bottom neighbour, encoded as 4 * pixel + kind
+	// kind 0: right, 1: below, 2: right across the border, 3: below across the border
+	m_edges.resize(2 * (size_t)image_size);
+	m_keys.resize(2 * (size_t)image_size);
+	auto no_of_edges{ 0 };
+	auto addEdge = [&](int pixel, int neighbour, int kind) {
+		auto reliability = m_reliability[pixel] + m_reliability[neighbour];
+		unsigned int bits;
+		memcpy(&bits, &reliability, sizeof(bits));
+		// positive floats sort like their bit patterns
+		m_keys[no_of_edges] = (unsigned short)(bits >> 16);
+		m_edges[no_of_edges] = 4 * pixel + kind;
+		no_of_edges++;
+	};
+	for (gsl::index y{ 0 }; y < image_height; y++) {
+		auto row = (int)(y * image_width);
+		for (gsl::index x{ 0 }; x < image_width - 1; x++) {
+			addEdge(row + (int)x, row + (int)x + 1, 0);
+		}
+		if (wrap_around_x) {
+			addEdge(row + image_width - 1, row, 2);
+		}
+	}
+	for (gsl::index y{ 0 }; y < image_height - 1; y++) {
+		auto row = (int)(y * image_width);
+		for (gsl::index x{ 0 }; x < image_width; x++) {
+			addEdge(row + (int)x, row + (int)x + image_width, 1);
+		}
+	}
+	if (wrap_around_y) {
+		auto row = (image_height - 1) * image_width;
+		for (gsl::index x{ 0 }; x < image_width; x++) {
+			addEdge(row + (int)x, (int)x, 3);
+		}
+	}
+
+	// Counting sort of the edges, the most reliable (smallest value) first
+	m_bucketStart.assign(65537, 0);
+	for (gsl::index i{ 0 }; i < no_of_edges; i++) {
+		m_bucketStart[(size_t)m_keys[i] + 1]++;
+	}
+	for (gsl::index i{ 1 }; i < 65537; i++) {
+		m_bucketStart[i] += m_bucketStart[i - 1];
+	}
+	m_sortedEdges.resize(no_of_edges);
+	for (gsl::index i{ 0 }; i < no_of_edges; i++) {
+		m_sortedEdges[m_bucketStart[m_keys[i]]++] = m_edges[i];
+	}
+
+	// Every pixel starts as a group of its own
+	m_parent.resize(image_size);
+	m_increment.assign(image_size, 0);
+	m_groupSize.assign(image_size, 1);
+	for (gsl::index i{ 0 }; i < image_size; i++) {
+		m_parent[i] = (int)i;
+	}
+
+	auto merges{ 0 };
+	for (const auto& edge : m_sortedEdges) {
+		auto pixel1 = edge >> 2;
+		auto pixel2{ 0 };
+		switch (edge & 3) {
+			case 0:
+				pixel2 = pixel1 + 1;
+				break;
+			case 1:
+				pixel2 = pixel1 + image_width;
+				break;
+			case 2:
+				pixel2 = pixel1 - image_width + 1;
+				break;
+			default:
+				pixel2 = pixel1 - (image_height - 1) * image_width;
+				break;
+		}
+
+		auto increment1{ 0 };
+		auto increment2{ 0 };
+		auto group1 = findGroup(pixel1, increment1);
+		auto group2 = findGroup(pixel2, increment2);
+		if (group1 == group2) {
+			continue;
+		}
+
+		// number of 2 pi to add to the second pixel to unwrap it with respect to the first
+		auto difference = wrapped_image[pixel1] - wrapped_image[pixel2];
+		auto wrap = (difference > PI) ? -1 : ((difference < -PI) ? 1 : 0);
+
+		// attach the smaller group to the larger one
+		if (m_groupSize[group1] > m_groupSize[group2]) {
+			m_parent[group2] = group1;
+			m_increment[group2] = increment1 - wrap - increment2;
+			m_groupSize[group1] += m_groupSize[group2];
+		} else {
+			m_parent[group1] = group2;
+			m_increment[group1] = increment2 + wrap - increment1;
+			m_groupSize[group2] += m_groupSize[group1];
+		}
+		// all pixels are connected
+		if (++merges == image_size - 1) {
+			break;
+		}
+	}
+
+	for (gsl::index i{ 0 }; i < image_size; i++) {
+		auto increment{ 0 };
+		findGroup((int)i, increment);
+		UnwrappedImage[i] = wrapped_image[i] + TWOPI * (float)increment;
+	}
+}
+
+/*
+ * Reliability of every pixel from the second differences to its eight neighbours,
+ * pixels without all neighbours are processed last
+ */
+void unwrap2Wrapper::calculateReliability(float* wrapped_image, int image_width, int image_height,
+	int wrap_around_x, int wrap_around_y) {
+
+	m_reliability.assign((size_t)image_width * image_height, std::numeric_limits<float>::max());
+
+	auto wrap = [](float value) {
+		return (value > PI) ? value - TWOPI : ((value < -PI) ? value + TWOPI : value);
+	};
+	auto secondDifference = [&wrap](float previous, float value, float next) {
+		auto difference = wrap(previous - value) - wrap(value - next);
+		return difference * difference;
+	};
+	// neighbours across the border of the image
+	auto at = [&](gsl::index x, gsl::index y) {
+		x = (x + image_width) % image_width;
+		y = (y + image_height) % image_height;
+		return wrapped_image[x + image_width * y];
+	};
+	auto reliabilityAt = [&](gsl::index x, gsl::index y) {
+		auto value = wrapped_image[x + image_width * y];
+		return secondDifference(at(x - 1, y), value, at(x + 1, y))
+			+ secondDifference(at(x, y - 1), value, at(x, y + 1))
+			+ secondDifference(at(x - 1, y - 1), value, at(x + 1, y + 1))
+			+ secondDifference(at(x + 1, y - 1), value, at(x - 1, y + 1));
+	};
+
+	for (gsl::index y{ 1 }; y < image_height - 1; y++) {
+		auto row = &wrapped_image[y * image_width];
+		auto above = row - image_width;
+		auto below = row + image_width;
+		auto reliability = &m_reliability[y * image_width];
+		for (gsl::index x{ 1 }; x < image_width - 1; x++) {
+			reliability[x] = secondDifference(row[x - 1], row[x], row[x + 1])
+				+ secondDifference(above[x], row[x], below[x])
+				+ secondDifference(above[x - 1], row[x], below[x + 1])
+				+ secondDifference(above[x + 1], row[x], below[x - 1]);
+		}
+	}
+
+	if (wrap_around_x) {
+		for (gsl::index y{ 1 }; y < image_height - 1; y++) {
+			m_reliability[y * image_width] = reliabilityAt(0, y);
+			m_reliability[y * image_width + image_width - 1] = reliabilityAt((gsl::index)image_width - 1, y);
+		}
+	}
+	if (wrap_around_y) {
+		for (gsl::index x{ 1 }; x < image_width - 1; x++) {
+			m_reliability[x] = reliabilityAt(x, 0);
+			m_reliability[((gsl::index)image_height - 1) * image_width + x] = reliabilityAt(x, (gsl::index)image_height - 1);
+		}
+	}
+}
+
+/*
+ * Returns the group of the pixel and the number of 2 pi to add to the pixel relative to the group
+ */
+int unwrap2Wrapper::findGroup(int pixel, int& increment) {
+	auto group = pixel;
+	increment = 0;
+	while (m_parent[group] != group) {
+		increment += m_increment[group];
+		group = m_parent[group];
+	}
+	// point all pixels on the path directly to the group
+	auto remaining = increment;
+	while (pixel != group) {
+		auto parent = m_parent[pixel];
+		auto pixelIncrement = m_increment[pixel];
+		m_parent[pixel] = group;
+		m_increment[pixel] = remaining;
+		remaining -= pixelIncrement;
+		pixel = parent;
+	}
+	return group;
+}
@@ -1,6 +1,86 @@
 #include "stdafx.h"
 #include "xsample.h"
 
+#include <math.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define XSAMPLE_SSE2
+#endif
+
 xsample::xsample() {}
 
 xsample::~xsample() {}
+
+RESAMPLE_AXIS xsample::axis(int dim, int dim_new, RESAMPLE_MODE mode) {
+	auto axis = RESAMPLE_AXIS{};
+	if (dim_new % dim == 0) {
+		axis.upsampling = dim_new / dim;
+	}
+	if (dim % dim_new == 0) {
+		axis.downsampling = dim / dim_new;
+	}
+	axis.first.resize(dim_new);
+
+	if (mode == RESAMPLE_MODE::NEAREST) {
+		for (gsl::index x{ 0 }; x < dim_new; x++) {
+			axis.first[x] = (int)round(((double)x + 0.5) * dim / dim_new - 0.5);
+		}
+		return axis;
+	}
+
+	// number of pixels to make up a resampled pixel, for integer upsampling
+	// the first pixel is the one the new pixel lies in, as for NEAREST
+	double scaling = (double)dim / dim_new;
+	axis.count.resize(dim_new);
+	axis.offset.resize(dim_new);
+	for (gsl::index x{ 0 }; x < dim_new; x++) {
+		double xl = x * scaling;
+		int xlInt = (int)floor(xl);
+		double xr = ((double)x + 1) * scaling;
+		int xrInt = std::min((int)ceil(xr), dim);
+		axis.first[x] = xlInt;
+		axis.count[x] = xrInt - xlInt;
+		axis.offset[x] = (int)axis.weights.size();
+		// Overlap of the old pixels with the new one
+		for (gsl::index xd{ xlInt }; xd < xrInt; xd++) {
+			auto dx1 = (xd > xl) ? xd : xl;
+			auto dx2 = ((double)xd + 1 < xr) ? ((double)xd + 1) : xr;
+			axis.weights.push_back(dx2 - dx1);
+		}
+	}
+	return axis;
+}
+
+void xsample::accumulateRow(float* acc, const float* row, float weight, int length) {
+	gsl::index i{ 0 };
+#ifdef XSAMPLE_SSE2
+	auto weights = _mm_set1_ps(weight);
+	for (; i + 4 <= length; i += 4) {
+		auto values = _mm_mul_ps(_mm_loadu_ps(&row[i]), weights);
+		_mm_storeu_ps(&acc[i], _mm_add_ps(_mm_loadu_ps(&acc[i]), values));
+	}
+#endif
+	for (; i < length; i++) {
+		acc[i] += weight * row[i];
+	}
+}
+
+void xsample::accumulateRow(float* acc, const unsigned short* row, float weight, int length) {
+	gsl::index i{ 0 };
+#ifdef XSAMPLE_SSE2
+	auto weights = _mm_set1_ps(weight);
+	auto zero = _mm_setzero_si128();
+	for (; i + 8 <= length; i += 8) {
+		auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row[i]));
+		// widen the eight 16 bit values to two times four floats
+		auto low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero));
+		auto high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(values, zero));
+		_mm_storeu_ps(&acc[i], _mm_add_ps(_mm_loadu_ps(&acc[i]), _mm_mul_ps(low, weights)));
+		_mm_storeu_ps(&acc[i + 4], _mm_add_ps(_mm_loadu_ps(&acc[i + 4]), _mm_mul_ps(high, weights)));
+	}
+#endif
+	for (; i < length; i++) {
+		acc[i] += weight * row[i];
+	}
+}
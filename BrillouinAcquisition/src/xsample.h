@@ -1,13 +1,33 @@
 #ifndef XSAMPLE_H
 #define XSAMPLE_H
 
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <gsl/gsl>
 
+#include "threadPool.h"
+
 typedef enum class resampleMode {
 	LINEAR,
 	NEAREST
 } RESAMPLE_MODE;
 
+/*
+ * Source pixels which make up the pixels along one axis of the resampled image.
+ * The image is resampled separably, first along y, then along x.
+ */
+struct RESAMPLE_AXIS {
+	int downsampling{ 0 };			// [1]	integer factor the axis shrinks by, 0 if there is none
+	int upsampling{ 0 };			// [1]	integer factor the axis grows by, 0 if there is none
+	std::vector<int> first;			// [pix]	first source pixel of every new pixel, the closest one for NEAREST
+	std::vector<int> count;			// [1]	number of source pixels of every new pixel, LINEAR only
+	std::vector<int> offset;		// [1]	position of the first weight of every new pixel, LINEAR only
+	std::vector<double> weights;	// [pix]	overlap of the source pixels with the new pixel, LINEAR only
+};
+
 class xsample {
 
 public:
@@ -17,77 +37,175 @@ public:
 	template <typename T_in = double, typename T_out = double>
 	static void resample(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode);
 
+	// Splits the rows of the resampled image across the threads of the pool
+	template <typename T_in = double, typename T_out = double>
+	static void resample(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode,
+		ThreadPool& threadPool);
+
+	/*
+	 * Calculates which source pixels make up the new pixels along one axis
+	 */
+	static RESAMPLE_AXIS axis(int dim, int dim_new, RESAMPLE_MODE mode);
+
 private:
 
+	// Resample the rows [y_begin, y_end) of the new image
 	template <typename T_in = double, typename T_out = double>
-	static void linear(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new);
+	static void resampleRows(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode,
+		const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end);
 
 	template <typename T_in = double, typename T_out = double>
-	static void nearest(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new);
+	static void linear(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+		const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end);
+
+	// Averages blocks of pixels, if both axes shrink by an integer factor
+	template <typename T_in = double, typename T_out = double>
+	static void box(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+		const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end);
+
+	template <typename T_in = double, typename T_out = double>
+	static void nearest(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+		const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end);
+
+	// acc[i] += weight * row[i], vectorized for float and unsigned short rows
+	template <typename T_acc, typename T>
+	static void accumulateRow(T_acc* acc, const T* row, T_acc weight, int length);
+	static void accumulateRow(float* acc, const float* row, float weight, int length);
+	static void accumulateRow(float* acc, const unsigned short* row, float weight, int length);
 
 };
 
+/*
+ * Type the resampled values are summed up in, double only for double images
+ */
+template <typename T_in>
+using resample_acc_t = std::conditional_t<
+	std::is_same_v<std::remove_cv_t<std::remove_reference_t<decltype(std::declval<T_in>()[0])>>, double>, double, float>;
+
 #endif // XSAMPLE_H
 
 template<typename T_in, typename T_out>
 static inline void xsample::resample(T_in in, T_out out,
 	int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode)
+{
+	auto axis_x = axis(dim_x, dim_x_new, mode);
+	auto axis_y = axis(dim_y, dim_y_new, mode);
+	resampleRows(in, out, dim_x, dim_y, dim_x_new, dim_y_new, mode, axis_x, axis_y, 0, dim_y_new);
+}
+
+template<typename T_in, typename T_out>
+static inline void xsample::resample(T_in in, T_out out,
+	int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode, ThreadPool& threadPool)
+{
+	auto axis_x = axis(dim_x, dim_x_new, mode);
+	auto axis_y = axis(dim_y, dim_y_new, mode);
+	threadPool.parallelFor(dim_y_new, [&](gsl::index y_begin, gsl::index y_end) {
+		resampleRows(in, out, dim_x, dim_y, dim_x_new, dim_y_new, mode, axis_x, axis_y, y_begin, y_end);
+	});
+}
+
+template<typename T_in, typename T_out>
+static inline void xsample::resampleRows(T_in in, T_out out,
+	int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode,
+	const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end)
 {
 	switch (mode) {
 		case RESAMPLE_MODE::NEAREST:
-			nearest(in, out, dim_x, dim_y, dim_x_new, dim_y_new);
+			nearest(in, out, dim_x, dim_y, dim_x_new, dim_y_new, axis_x, axis_y, y_begin, y_end);
 			break;
 		case RESAMPLE_MODE::LINEAR:
 		default:
-			linear(in, out, dim_x, dim_y, dim_x_new, dim_y_new);
+			if (axis_x.upsampling && axis_y.upsampling) {
+				// every new pixel lies within a single source pixel
+				nearest(in, out, dim_x, dim_y, dim_x_new, dim_y_new, axis_x, axis_y, y_begin, y_end);
+			} else if (axis_x.downsampling && axis_y.downsampling) {
+				box(in, out, dim_x, dim_y, dim_x_new, dim_y_new, axis_x, axis_y, y_begin, y_end);
+			} else {
+				linear(in, out, dim_x, dim_y, dim_x_new, dim_y_new, axis_x, axis_y, y_begin, y_end);
+			}
 			break;
 	}
 }
 
 template<typename T_in, typename T_out>
-static inline void xsample::nearest(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new) {
-	for (gsl::index y{ 0 }; y < dim_y_new; y++) {
+static inline void xsample::nearest(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+	const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end) {
+	for (gsl::index y{ y_begin }; y < y_end; y++) {
+		auto row = (gsl::index)dim_x * axis_y.first[y];
 		for (gsl::index x{ 0 }; x < dim_x_new; x++) {
-			double x_old = round(((double)x + 0.5) * dim_x / dim_x_new - 0.5);
-			double y_old = round(((double)y + 0.5) * dim_y / dim_y_new - 0.5);
-
-			out[x + dim_x_new * y] = in[(int)x_old + dim_x * (int)y_old];
+			out[x + dim_x_new * y] = in[row + axis_x.first[x]];
 		}
 	}
 }
 
 template<typename T_in, typename T_out>
-static inline void xsample::linear(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new) {
+static inline void xsample::linear(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+	const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end) {
+	using T_acc = resample_acc_t<T_in>;
 	// number of pixels to make up a resampled pixel
-	double scaling_x = (double)dim_x / dim_x_new;
-	double scaling_y = (double)dim_y / dim_y_new;
-	double pixelArea = scaling_x * scaling_y;
-	for (gsl::index y{ 0 }; y < dim_y_new; y++) {
-		double yt = y * scaling_y;
-		int ytInt = (int)floor(yt);
-		double yb = ((double)y + 1) * scaling_y;
-		int ybInt = (int)ceil(yb);
+	auto pixelArea = (T_acc)(((double)dim_x / dim_x_new) * ((double)dim_y / dim_y_new));
+	// weighted sum of the source rows of the current new row
+	auto rowSum = std::vector<T_acc>(dim_x);
+	for (gsl::index y{ y_begin }; y < y_end; y++) {
+		std::fill(rowSum.begin(), rowSum.end(), (T_acc)0);
+		for (gsl::index yd{ 0 }; yd < axis_y.count[y]; yd++) {
+			auto weight = (T_acc)axis_y.weights[axis_y.offset[y] + yd];
+			accumulateRow(&rowSum[0], &in[(gsl::index)dim_x * (axis_y.first[y] + yd)], weight, dim_x);
+		}
 		for (gsl::index x{ 0 }; x < dim_x_new; x++) {
-			double xl = x * scaling_x;
-			int xlInt = (int)floor(xl);
-			double xr = ((double)x + 1) * scaling_x;
-			int xrInt = (int)ceil(xr);
-			double pixValue{ 0 };
-			// Average old pixels
-			for (gsl::index xd{ xlInt }; xd < xrInt; xd++) {
-				auto dx1 = (xd > xl) ? xd : xl;
-				auto dx2 = ((double)xd + 1 < xr) ? ((double)xd + 1) : xr;
-				double weight_x = dx2 - dx1;
-				for (gsl::index yd{ ytInt }; yd < ybInt; yd++) {
-
-					auto dy1 = (yd > yt) ? yd : yt;
-					auto dy2 = ((double)yd + 1 < yb) ? ((double)yd + 1) : yb;
-					double weight_y = dy2 - dy1;
-
-					pixValue += in[xd + dim_x * yd] * weight_x * weight_y;
-				}
+			auto weights = &axis_x.weights[axis_x.offset[x]];
+			auto values = &rowSum[axis_x.first[x]];
+			T_acc pixValue{ 0 };
+			for (gsl::index xd{ 0 }; xd < axis_x.count[x]; xd++) {
+				pixValue += values[xd] * (T_acc)weights[xd];
 			}
 			out[x + dim_x_new * y] = pixValue / pixelArea;
 		}
 	}
 }
+
+template<typename T_in, typename T_out>
+static inline void xsample::box(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new,
+	const RESAMPLE_AXIS& axis_x, const RESAMPLE_AXIS& axis_y, gsl::index y_begin, gsl::index y_end) {
+	using T_acc = resample_acc_t<T_in>;
+	auto factor_x = axis_x.downsampling;
+	auto factor_y = axis_y.downsampling;
+	auto pixelArea = (T_acc)factor_x * factor_y;
+	auto rowSum = std::vector<T_acc>(dim_x);
+	for (gsl::index y{ y_begin }; y < y_end; y++) {
+		std::fill(rowSum.begin(), rowSum.end(), (T_acc)0);
+		for (gsl::index yd{ 0 }; yd < factor_y; yd++) {
+			accumulateRow(&rowSum[0], &in[(gsl::index)dim_x * (factor_y * y + yd)], (T_acc)1, dim_x);
+		}
+		auto outRow = dim_x_new * y;
+		// the common factors get loops the compiler can unroll
+		switch (factor_x) {
+			case 2:
+				for (gsl::index x{ 0 }; x < dim_x_new; x++) {
+					out[outRow + x] = (rowSum[2 * x] + rowSum[2 * x + 1]) / pixelArea;
+				}
+				break;
+			case 3:
+				for (gsl::index x{ 0 }; x < dim_x_new; x++) {
+					out[outRow + x] = (rowSum[3 * x] + rowSum[3 * x + 1] + rowSum[3 * x + 2]) / pixelArea;
+				}
+				break;
+			default:
+				for (gsl::index x{ 0 }; x < dim_x_new; x++) {
+					T_acc pixValue{ 0 };
+					for (gsl::index xd{ 0 }; xd < factor_x; xd++) {
+						pixValue += rowSum[factor_x * x + xd];
+					}
+					out[outRow + x] = pixValue / pixelArea;
+				}
+				break;
+		}
+	}
+}
+
+template<typename T_acc, typename T>
+static inline void xsample::accumulateRow(T_acc* acc, const T* row, T_acc weight, int length) {
+	for (gsl::index i{ 0 }; i < length; i++) {
+		acc[i] += weight * (T_acc)row[i];
+	}
+}
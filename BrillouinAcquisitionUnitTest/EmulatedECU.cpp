@@ -0,0 +1,122 @@
+#include "stdafx.h"
+#include "EmulatedECU.h"
+
+#include <thread>
+
+EmulatedECU::EmulatedECU(std::chrono::milliseconds latency, std::chrono::milliseconds processingTime)
+	: m_latency(latency), m_processingTime(processingTime) {
+}
+
+qint64 EmulatedECU::writeToDevice(const char* data) {
+	m_requestBuffer += data;
+	size_t end{ 0 };
+	while ((end = m_requestBuffer.find('\r')) != std::string::npos) {
+		auto request = m_requestBuffer.substr(0, end);
+		m_requestBuffer.erase(0, end + 1);
+		m_requestCount++;
+
+		// the device handles one request after another
+		auto now = std::chrono::steady_clock::now();
+		m_busyUntil = std::max(m_busyUntil, now) + m_processingTime;
+		auto reply = answer(request);
+		if (reply.empty()) {
+			continue;
+		}
+		if (m_ignoreRequests > 0) {
+			m_ignoreRequests--;
+			continue;
+		}
+		m_pending.push_back({ m_busyUntil + m_latency, reply });
+	}
+	return strlen(data);
+}
+
+void EmulatedECU::setTimeout(int timeout) {
+	m_timeout = timeout;
+}
+
+void EmulatedECU::setChunkSize(size_t chunkSize) {
+	m_chunkSize = chunkSize;
+}
+
+void EmulatedECU::ignoreRequests(int count) {
+	m_ignoreRequests = count;
+}
+
+int EmulatedECU::requestCount() {
+	return m_requestCount;
+}
+
+int EmulatedECU::elementPosition(const std::string& element) {
+	return m_elements[element];
+}
+
+bool EmulatedECU::waitForData(int timeout) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	if (!m_pending.empty() && m_pending.front().due < deadline) {
+		deadline = m_pending.front().due;
+	}
+	std::this_thread::sleep_until(deadline);
+	return deliverDueAnswers();
+}
+
+std::string EmulatedECU::answer(const std::string& request) {
+	// requests look like <element>P<command>, e.g. NPXp
+	if (request.size() < 3 || request[1] != 'P') {
+		return "";
+	}
+	auto element = request.substr(0, 1);
+	auto command = request.substr(2);
+	auto reply = "P" + element;
+
+	if (command == "Tv") {
+		static const auto versions = std::map<std::string, std::string>{
+			{ "H", "AV_V3_17" },
+			{ "F", "ZM_V2_04" },
+			{ "N", "MC V2.08" }
+		};
+		return reply + versions.at(element) + "\r";
+	}
+	if (element == "N" || element == "F") {
+		auto axis = command.substr(0, 1);
+		auto& position = (axis == "X") ? m_positionX : (axis == "Y") ? m_positionY : m_positionZ;
+		auto operation = command.substr(1, 1);
+		if (operation == "p") {
+			return reply + helper::dec2hex(position, 6) + "\r";
+		}
+		if (operation == "T" || operation == "D") {
+			position = std::stoi(command.substr(2), nullptr, 16);
+		}
+		return "";
+	}
+	// the stand sets with upper case and reads with lower case identifiers, e.g. HPCR1,2 and HPCr1,1
+	if (element == "H" && command.size() > 2 && command[0] == 'C') {
+		auto separator = command.find(',');
+		auto identifier = (char)tolower(command[1]);
+		auto device = identifier + command.substr(2, separator - 2);
+		if (isupper(command[1])) {
+			m_elements[device] = std::stoi(command.substr(separator + 1));
+			return "";
+		}
+		return reply + std::to_string(m_elements[device]) + "\r";
+	}
+	return "";
+}
+
+bool EmulatedECU::deliverDueAnswers() {
+	auto now = std::chrono::steady_clock::now();
+	auto data = std::string{};
+	while (!m_pending.empty() && m_pending.front().due <= now) {
+		data += m_pending.front().answer;
+		m_pending.pop_front();
+	}
+	if (data.empty()) {
+		return false;
+	}
+	auto chunkSize = m_chunkSize ? m_chunkSize : data.size();
+	for (size_t start{ 0 }; start < data.size(); start += chunkSize) {
+		auto chunk = data.substr(start, chunkSize);
+		handleData(QByteArray(chunk.c_str(), (int)chunk.size()));
+	}
+	return true;
+}
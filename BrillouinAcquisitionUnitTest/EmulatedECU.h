@@ -0,0 +1,52 @@
+#include "..\BrillouinAcquisition\src\Devices\ScanControls\ZeissECU.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+
+/*
+ * Stand-in for the ECU of the Zeiss microscope, answers the requests of the stand,
+ * the focus and the stage like the device does. The answers arrive after the set
+ * latency and the device handles one request after another, so the answers arrive in order.
+ */
+class EmulatedECU : public com {
+public:
+	EmulatedECU(std::chrono::milliseconds latency = std::chrono::milliseconds(0), std::chrono::milliseconds processingTime = std::chrono::milliseconds(0));
+
+	qint64 writeToDevice(const char* data) override;
+
+	void setTimeout(int timeout);
+	// Answers are split into chunks of this size, like a serial port delivers them
+	void setChunkSize(size_t chunkSize);
+	// Don't answer the next requests
+	void ignoreRequests(int count);
+
+	int requestCount();
+	int elementPosition(const std::string& element);
+
+protected:
+	bool waitForData(int timeout) override;
+
+private:
+	std::string answer(const std::string& request);
+	bool deliverDueAnswers();
+
+	struct PENDING_ANSWER {
+		std::chrono::steady_clock::time_point due;
+		std::string answer;
+	};
+
+	std::chrono::milliseconds m_latency;
+	std::chrono::milliseconds m_processingTime;
+	std::chrono::steady_clock::time_point m_busyUntil;
+	std::deque<PENDING_ANSWER> m_pending;
+	std::string m_requestBuffer;
+	size_t m_chunkSize{ 0 };
+	int m_ignoreRequests{ 0 };
+	int m_requestCount{ 0 };
+
+	int m_positionX{ 0 };		// [increments]
+	int m_positionY{ 0 };		// [increments]
+	int m_positionZ{ 0 };		// [increments]
+	std::map<std::string, int> m_elements;
+};
@@ -155,6 +155,61 @@ namespace BrillouinAcquisitionUnitTest
 			checkIntegrity(&scaleCalibration);
 		}
 
+		TEST_METHOD(fitCalibrationFromShifts_Rotated) {
+			auto scaleCalibration = ScaleCalibrationData{};
+
+			// Shifts of a rotated and sheared camera image, with an offset common to all of them
+			auto micrometerToPixX = POINT2{ 4.5, 1.2 };
+			auto micrometerToPixY = POINT2{ -0.8, 5.3 };
+			auto offset = POINT2{ 0.3, -0.2 };
+			auto translations = std::vector<POINT2>{ { 0, 0 }, { 10, 0 }, { 0, 10 }, { -10, 0 }, { 0, -10 } };
+			auto shifts = std::vector<POINT2>{};
+			for (const auto& translation : translations) {
+				shifts.push_back(translation.x * micrometerToPixX + translation.y * micrometerToPixY + offset);
+			}
+
+			auto residual = ScaleCalibrationHelper::fitCalibrationFromShifts(&scaleCalibration, translations, shifts);
+
+			Assert::AreEqual(0.0, residual, 1e-10);
+
+			Assert::AreEqual(4.5, scaleCalibration.micrometerToPixX.x, 1e-10);
+			Assert::AreEqual(1.2, scaleCalibration.micrometerToPixX.y, 1e-10);
+
+			Assert::AreEqual(-0.8, scaleCalibration.micrometerToPixY.x, 1e-10);
+			Assert::AreEqual(5.3, scaleCalibration.micrometerToPixY.y, 1e-10);
+
+			checkIntegrity(&scaleCalibration);
+		}
+
+		TEST_METHOD(fitCalibrationFromShifts_Residual) {
+			auto scaleCalibration = ScaleCalibrationData{};
+
+			// Errors of opposite sign in the two x-translations cancel out
+			auto translations = std::vector<POINT2>{ { 0, 0 }, { 10, 0 }, { 0, 10 }, { -10, 0 } };
+			auto shifts = std::vector<POINT2>{ { 0, 0 }, { 50.2, 0 }, { 0, 50 }, { -49.8, 0 } };
+
+			auto residual = ScaleCalibrationHelper::fitCalibrationFromShifts(&scaleCalibration, translations, shifts);
+
+			Assert::AreEqual(5.0, scaleCalibration.micrometerToPixX.x, 1e-10);
+			Assert::AreEqual(5.0, scaleCalibration.micrometerToPixY.y, 1e-10);
+			Assert::IsTrue(residual > 0);
+			Assert::IsTrue(residual < 0.2);
+
+			checkIntegrity(&scaleCalibration);
+		}
+
+		TEST_METHOD(fitCalibrationFromShifts_Collinear) {
+			auto scaleCalibration = ScaleCalibrationData{};
+
+			// Translations along a single direction do not determine the calibration
+			auto translations = std::vector<POINT2>{ { 0, 0 }, { 10, 0 }, { -10, 0 } };
+			auto shifts = std::vector<POINT2>{ { 0, 0 }, { 50, 0 }, { -50, 0 } };
+
+			Assert::ExpectException<std::exception>([&]() {
+				ScaleCalibrationHelper::fitCalibrationFromShifts(&scaleCalibration, translations, shifts);
+			});
+		}
+
 	private:
 		void checkIntegrity(ScaleCalibrationData* scaleCalibration) {
 
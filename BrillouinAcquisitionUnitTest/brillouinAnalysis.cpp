@@ -0,0 +1,235 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\brillouinAnalysis.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Camera frames with a Rayleigh and a Brillouin peak along every row
+	 */
+	std::vector<unsigned short> syntheticSpectra(int frameCount, int dim_x, int dim_y, double rayleigh, double brillouin, double noise = 0) {
+		auto generator = std::mt19937{ 42 };
+		auto distribution = std::normal_distribution<double>{ 0, noise };
+		auto frames = std::vector<unsigned short>((size_t)frameCount * dim_x * dim_y);
+		auto lorentzian = [](double x, double position, double width) {
+			auto u = (x - position) / (width / 2);
+			return 1 / (1 + u * u);
+		};
+		for (gsl::index mm{ 0 }; mm < frameCount; mm++) {
+			for (gsl::index y{ 0 }; y < dim_y; y++) {
+				for (gsl::index x{ 0 }; x < dim_x; x++) {
+					auto value = 100 + 3000 * lorentzian(x, rayleigh, 4) + 800 * lorentzian(x, brillouin, 6);
+					if (noise > 0) {
+						value += distribution(generator);
+					}
+					frames[(mm * dim_y + y) * dim_x + x] = (unsigned short)std::max(0.0, round(value));
+				}
+			}
+		}
+		return frames;
+	}
+
+	TEST_CLASS(TestBrillouinAnalysis) {
+		public:
+			TEST_METHOD(TestSpectrumAlongRow) {
+				auto image = std::vector<unsigned short>(5 * 4);
+				for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i++) {
+					image[i] = (unsigned short)i;
+				}
+				auto settings = BRILLOUIN_ANALYSIS_SETTINGS{};
+				settings.lineWidth = 1;
+				settings.startX = 1;
+				settings.startY = 2;
+				settings.endX = 4;
+				settings.endY = 2;
+				auto line = SpectrumLine{};
+				line.setLine(settings, 5, 4);
+				Assert::AreEqual(4, line.length());
+
+				auto spectrum = std::vector<double>(line.length());
+				line.extract(image.data(), spectrum.data());
+				for (gsl::index i{ 0 }; i < line.length(); i++) {
+					Assert::AreEqual((double)image[2 * 5 + 1 + i], spectrum[i], 1e-4);
+				}
+			}
+
+			TEST_METHOD(TestSpectrumDefaultLine) {
+				auto image = std::vector<unsigned short>(6 * 5);
+				for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i++) {
+					image[i] = (unsigned short)(i / 6);
+				}
+				// the middle row, averaged with the rows above and below
+				auto line = SpectrumLine{};
+				line.setLine(BRILLOUIN_ANALYSIS_SETTINGS{}, 6, 5);
+				Assert::AreEqual(6, line.length());
+
+				auto spectrum = std::vector<double>(line.length());
+				line.extract(image.data(), spectrum.data());
+				for (auto value : spectrum) {
+					Assert::AreEqual(2.0, value, 1e-4);
+				}
+			}
+
+			TEST_METHOD(TestSpectrumAlongDiagonal) {
+				// a linear ramp is reproduced exactly by the bilinear weights
+				auto image = std::vector<unsigned short>(10 * 10);
+				for (gsl::index y{ 0 }; y < 10; y++) {
+					for (gsl::index x{ 0 }; x < 10; x++) {
+						image[y * 10 + x] = (unsigned short)(10 * x + 3 * y);
+					}
+				}
+				auto settings = BRILLOUIN_ANALYSIS_SETTINGS{};
+				settings.lineWidth = 1;
+				settings.startX = 1;
+				settings.startY = 1;
+				settings.endX = 7;
+				settings.endY = 9;
+				auto line = SpectrumLine{};
+				line.setLine(settings, 10, 10);
+				Assert::AreEqual(11, line.length());
+
+				auto spectrum = std::vector<double>(line.length());
+				line.extract(image.data(), spectrum.data());
+				for (gsl::index i{ 0 }; i < line.length(); i++) {
+					auto x = 1 + 0.6 * i;
+					auto y = 1 + 0.8 * i;
+					Assert::AreEqual(10 * x + 3 * y, spectrum[i], 1e-3);
+				}
+			}
+
+			TEST_METHOD(TestFitLorentzian) {
+				auto spectrum = std::vector<double>(60);
+				for (gsl::index i{ 0 }; i < (gsl::index)spectrum.size(); i++) {
+					auto u = (i - 27.3) / 2.5;
+					spectrum[i] = 50 + 400 / (1 + u * u);
+				}
+				auto peak = BrillouinAnalysis::fitLorentzian(spectrum.data(), (int)spectrum.size(), 27, 10);
+				Assert::IsTrue(peak.valid);
+				Assert::AreEqual(27.3, peak.position, 1e-6);
+				Assert::AreEqual(5.0, peak.width, 1e-6);
+				Assert::AreEqual(400.0, peak.amplitude, 1e-4);
+				Assert::AreEqual(50.0, peak.offset, 1e-4);
+			}
+
+			TEST_METHOD(TestFitWithoutPeak) {
+				auto spectrum = std::vector<double>(30, 100.0);
+				auto peak = BrillouinAnalysis::fitLorentzian(spectrum.data(), (int)spectrum.size(), 15, 8);
+				Assert::IsFalse(peak.valid);
+			}
+
+			TEST_METHOD(TestFindPeaks) {
+				auto frames = syntheticSpectra(1, 120, 1, 30.4, 71.8, 5);
+				auto spectrum = std::vector<double>(frames.begin(), frames.end());
+				auto peaks = BrillouinAnalysis::findPeaks(spectrum.data(), (int)spectrum.size(), 8, 10);
+				Assert::IsTrue(peaks.rayleigh.valid);
+				Assert::IsTrue(peaks.brillouin.valid);
+				Assert::AreEqual(30.4, peaks.rayleigh.position, 0.05);
+				Assert::AreEqual(71.8, peaks.brillouin.position, 0.05);
+				Assert::AreEqual(41.4, peaks.distance, 0.1);
+			}
+
+			TEST_METHOD(TestShiftMap) {
+				auto dim_x{ 160 };
+				auto dim_y{ 8 };
+				auto analysis = BrillouinAnalysis{ 2 };
+				auto shifts = std::vector<BRILLOUIN_SHIFT>{};
+				analysis.setCallback([&shifts](const BRILLOUIN_SHIFT& shift) { shifts.push_back(shift); });
+				analysis.reset(2, 3, 1, dim_x, dim_y);
+
+				// the peaks of the calibration sample are 50 pixels apart
+				auto calibration = syntheticSpectra(4, dim_x, dim_y, 40, 90);
+				analysis.calibrate(analysis.extractSpectra(calibration.data(), 4, dim_x, dim_y), 5.0);
+
+				auto sample = syntheticSpectra(2, dim_x, dim_y, 40, 100);
+				Assert::IsTrue(analysis.analyze(INDEX3{ 1, 2, 0 }, analysis.extractSpectra(sample.data(), 2, dim_x, dim_y)));
+				analysis.finish();
+
+				Assert::AreEqual(0.1, analysis.getFrequencyPerPixel(), 1e-3);
+				Assert::AreEqual((size_t)1, shifts.size());
+				Assert::AreEqual(2, shifts[0].validFrames);
+				Assert::AreEqual(6.0, shifts[0].shift, 1e-2);
+
+				auto map = analysis.getShiftMap();
+				Assert::AreEqual(1, map.analyzedPositions);
+				Assert::AreEqual(6.0, map.at(map.shift, INDEX3{ 1, 2, 0 }), 1e-2);
+				// the positions are stored like the positions in the file, z, x, y
+				Assert::AreEqual(6.0, map.shift[(0 * 2 + 1) * 3 + 2], 1e-2);
+				Assert::IsTrue(std::isnan(map.shift[0]));
+
+				// the map is only taken once
+				map = analysis.takeShiftMap();
+				Assert::AreEqual(6, (int)map.shift.size());
+				Assert::AreEqual(6.0, map.at(map.shift, INDEX3{ 1, 2, 0 }), 1e-2);
+				Assert::IsTrue(analysis.takeShiftMap().shift.empty());
+			}
+
+			TEST_METHOD(TestUncalibratedShift) {
+				auto analysis = BrillouinAnalysis{ 1 };
+				analysis.reset(1, 1, 1, 100, 4);
+				auto sample = syntheticSpectra(1, 100, 4, 20, 60);
+				analysis.analyze(INDEX3{ 0, 0, 0 }, analysis.extractSpectra(sample.data(), 1, 100, 4));
+				analysis.finish();
+
+				auto map = analysis.getShiftMap();
+				Assert::AreEqual(1, map.analyzedPositions);
+				Assert::IsTrue(std::isnan(map.shift[0]));
+			}
+	};
+
+	TEST_CLASS(BenchmarkBrillouinAnalysis) {
+		public:
+			/*
+			 * Time to read and fit the spectra of one position, which has to be well below
+			 * the exposure time of 0.1 to 0.5 s, so the analysis keeps up with the scan.
+			 */
+			TEST_METHOD(BenchmarkPosition) {
+				auto dim_x{ 512 };
+				auto dim_y{ 32 };
+				auto frameCount{ 2 };
+				auto positions{ 200 };
+				auto frames = syntheticSpectra(frameCount, dim_x, dim_y, 140.2, 301.7, 20);
+
+				auto analysis = BrillouinAnalysis{};
+				auto settings = BRILLOUIN_ANALYSIS_SETTINGS{};
+				settings.startX = 0;
+				settings.startY = 15;
+				settings.endX = dim_x - 1;
+				settings.endY = 15;
+				settings.lineWidth = 5;
+				settings.queueCapacity = positions;
+				analysis.setSettings(settings);
+				analysis.reset(positions, 1, 1, dim_x, dim_y);
+				analysis.calibrate(analysis.extractSpectra(frames.data(), frameCount, dim_x, dim_y), 5.088);
+				analysis.finish();
+
+				QElapsedTimer timer;
+				timer.start();
+				auto extractionTime{ 0ll };
+				for (gsl::index ll{ 0 }; ll < positions; ll++) {
+					auto start = timer.nsecsElapsed();
+					auto spectra = analysis.extractSpectra(frames.data(), frameCount, dim_x, dim_y);
+					extractionTime += timer.nsecsElapsed() - start;
+					analysis.analyze(INDEX3{ (int)ll, 0, 0 }, std::move(spectra));
+				}
+				analysis.finish();
+				auto perPosition = 1e-6 * timer.nsecsElapsed() / positions;
+
+				auto message = QString("Analyzing %1 frames of %2x%3 pixels: %4 ms per position, of which %5 ms reading the spectra\n")
+					.arg(frameCount)
+					.arg(dim_x)
+					.arg(dim_y)
+					.arg(perPosition, 0, 'f', 3)
+					.arg(1e-6 * extractionTime / positions, 0, 'f', 3);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				auto map = analysis.getShiftMap();
+				Assert::AreEqual(positions, map.analyzedPositions);
+				Assert::AreEqual(5.088, map.shift[positions - 1], 1e-2);
+				Assert::IsTrue(perPosition < 10);
+			}
+	};
+}
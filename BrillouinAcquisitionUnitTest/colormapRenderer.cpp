@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\colormapRenderer.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Palette with a distinct color for every level
+	 */
+	static std::vector<QRgb> createPalette(int levels) {
+		auto palette = std::vector<QRgb>(levels);
+		for (gsl::index i{ 0 }; i < levels; i++) {
+			palette[i] = 0xff000000 | (QRgb)i;
+		}
+		return palette;
+	}
+
+	/*
+	 * Color as QCPColorGradient::colorize() calculates it
+	 */
+	static QRgb referenceColor(double value, double lower, double upper, const std::vector<QRgb>& palette) {
+		auto index = (int)((value - lower) * (palette.size() - 1) / (upper - lower));
+		index = std::clamp(index, 0, (int)palette.size() - 1);
+		return palette[index];
+	}
+
+	template <typename T>
+	static std::vector<T> createFrame(int dim_x, int dim_y, double maximum) {
+		auto frame = std::vector<T>((size_t)dim_x * dim_y);
+		auto generator = std::mt19937{ 42 };
+		auto distribution = std::uniform_real_distribution<double>{ 0, maximum };
+		for (auto& value : frame) {
+			value = (T)distribution(generator);
+		}
+		return frame;
+	}
+
+	TEST_CLASS(TestColormapRenderer) {
+		public:
+			TEST_METHOD(TestLookupTableMatchesGradient) {
+				testColors<unsigned short>(100, 300, 1000);
+				testColors<unsigned short>(0, 65535, 65535);
+				testColors<unsigned char>(10, 200, 255);
+				testColors<unsigned int>(100, 300, 1000);
+			}
+
+			TEST_METHOD(TestFloatMatchesGradient) {
+				auto renderer = ColormapRenderer{ 1 };
+				auto palette = createPalette(350);
+				renderer.setPalette(palette);
+				auto frame = createFrame<float>(64, 48, 10);
+				frame[5] = std::numeric_limits<float>::quiet_NaN();
+				frame[6] = -100;
+				frame[7] = 100;
+
+				auto image = renderer.render(&frame[0], 64, 48, 2.0, 8.0, false);
+				Assert::AreEqual(palette[0], image.image->pixel(5, 0));
+				Assert::AreEqual(palette[0], image.image->pixel(6, 0));
+				Assert::AreEqual(palette[349], image.image->pixel(7, 0));
+				// the indices are calculated in single precision, so they may differ by one
+				for (gsl::index y{ 0 }; y < 48; y++) {
+					for (gsl::index x{ 8 * (y == 0) }; x < 64; x++) {
+						auto expected = (int)(referenceColor(frame[x + 64 * y], 2.0, 8.0, palette) & 0xffffff);
+						auto actual = (int)(image.image->pixel((int)x, (int)y) & 0xffffff);
+						Assert::IsTrue(std::abs(expected - actual) <= 1);
+					}
+				}
+			}
+
+			TEST_METHOD(TestAutoscale) {
+				auto renderer = ColormapRenderer{ 1 };
+				renderer.setPalette(createPalette(256));
+				auto frame = std::vector<unsigned short>((size_t)64 * 48, 500);
+				frame[10] = 3;
+				frame[20] = 2000;
+
+				auto image = renderer.render(&frame[0], 64, 48, 0.0, 1.0, true);
+				Assert::AreEqual(3.0, image.lower);
+				Assert::AreEqual(2000.0, image.upper);
+				Assert::AreEqual(0xff000000, image.image->pixel(10, 0));
+				Assert::AreEqual(0xff0000ff, image.image->pixel(20, 0));
+
+				auto phase = createFrame<float>(64, 48, 1);
+				phase[0] = -3.0f;
+				phase[1] = std::numeric_limits<float>::quiet_NaN();
+				image = renderer.render(&phase[0], 64, 48, 0.0, 1.0, true);
+				Assert::AreEqual(-3.0, image.lower);
+				Assert::IsTrue(image.upper < 1.0);
+			}
+
+			TEST_METHOD(TestImagesAreNotOverwrittenWhileShown) {
+				auto renderer = ColormapRenderer{ 1 };
+				renderer.setPalette(createPalette(256));
+				auto dark = std::vector<unsigned char>((size_t)16 * 16, 0);
+				auto bright = std::vector<unsigned char>((size_t)16 * 16, 255);
+
+				// the GUI keeps the first image
+				auto shown = renderer.render(&dark[0], 16, 16, 0, 255, false);
+				renderer.render(&bright[0], 16, 16, 0, 255, false);
+				auto third = renderer.render(&bright[0], 16, 16, 0, 255, false);
+				Assert::IsTrue(shown.image.get() != third.image.get());
+				Assert::AreEqual(0xff000000, shown.image->pixel(3, 3));
+				Assert::AreEqual(0xff0000ff, third.image->pixel(3, 3));
+
+				// without a reference, the two images are reused alternately
+				shown.image.reset();
+				auto reused = third.image.get();
+				third.image.reset();
+				auto fourth = renderer.render(&dark[0], 16, 16, 0, 255, false).image.get();
+				auto fifth = renderer.render(&dark[0], 16, 16, 0, 255, false).image.get();
+				Assert::IsTrue(fourth != reused);
+				Assert::IsTrue(fifth == reused);
+			}
+
+			TEST_METHOD(TestRerenderWithNewLimits) {
+				auto renderer = ColormapRenderer{ 1 };
+				Assert::IsFalse((bool)renderer.rerender(0, 1, false).image);
+
+				renderer.setPalette(createPalette(256));
+				auto frame = std::vector<unsigned short>((size_t)16 * 16, 500);
+				auto image = renderer.render(&frame[0], 16, 16, 0, 1000, false);
+				Assert::AreEqual(0xff00007f, image.image->pixel(0, 0));
+				// the frame is kept, even if the buffer it came from is reused
+				std::fill(frame.begin(), frame.end(), 0);
+				image = renderer.rerender(0, 500, false);
+				Assert::AreEqual(0xff0000ff, image.image->pixel(0, 0));
+				Assert::AreEqual(500.0, image.upper);
+			}
+
+		private:
+			template <typename T>
+			void testColors(double lower, double upper, double maximum) {
+				auto renderer = ColormapRenderer{ 4 };
+				auto palette = createPalette(350);
+				renderer.setPalette(palette);
+				auto frame = createFrame<T>(123, 77, maximum);
+
+				auto image = renderer.render(&frame[0], 123, 77, lower, upper, false);
+				Assert::AreEqual(123, image.image->width());
+				Assert::AreEqual(77, image.image->height());
+				for (gsl::index y{ 0 }; y < 77; y++) {
+					for (gsl::index x{ 0 }; x < 123; x++) {
+						Assert::AreEqual(referenceColor(frame[x + 123 * y], lower, upper, palette), image.image->pixel((int)x, (int)y));
+					}
+				}
+			}
+	};
+
+	TEST_CLASS(BenchmarkColormapRenderer) {
+		public:
+			/*
+			 * Compare rendering a full Andor frame with the conversion to a float vector
+			 * and the colorization per pixel the preview did before.
+			 */
+			TEST_METHOD(BenchmarkRender) {
+				auto dim_x{ 2048 };
+				auto dim_y{ 2048 };
+				auto frame = createFrame<unsigned short>(dim_x, dim_y, 4000);
+				auto palette = createPalette(350);
+				auto repetitions{ 10 };
+
+				auto timer = QElapsedTimer{};
+				timer.start();
+				auto colors = std::vector<QRgb>((size_t)dim_x * dim_y);
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					auto converted = std::vector<float>(&frame[0], &frame[0] + (size_t)dim_x * dim_y);
+					// the queued signal copied the vector once more
+					auto copy = converted;
+					for (gsl::index j{ 0 }; j < (gsl::index)copy.size(); j++) {
+						colors[j] = referenceColor(copy[j], 100, 3000, palette);
+					}
+				}
+				auto referenceTime = 1e-6 * timer.nsecsElapsed() / repetitions;
+
+				for (auto threads : { 1, ThreadPool::defaultThreadCount() }) {
+					auto renderer = ColormapRenderer{ threads };
+					renderer.setPalette(palette);
+					auto images = std::vector<PREVIEW_IMAGE>{};
+					timer.start();
+					for (gsl::index i{ 0 }; i < repetitions; i++) {
+						// the GUI holds the last image while the next one is rendered
+						images.push_back(renderer.render(&frame[0], dim_x, dim_y, 100, 3000, false));
+						if (images.size() > 1) {
+							images.erase(images.begin());
+						}
+					}
+					auto time = 1e-6 * timer.nsecsElapsed() / repetitions;
+					Logger::WriteMessage(QString("%1x%2, %3 threads: copy and colorize %4 ms, lookup table %5 ms\n")
+						.arg(dim_x).arg(dim_y).arg(threads).arg(referenceTime).arg(time).toStdString().c_str());
+				}
+			}
+	};
+}
@@ -0,0 +1,236 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "EmulatedECU.h"
+#include "..\BrillouinAcquisition\src\Devices\commandQueue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestCommandQueue) {
+		public:
+			TEST_METHOD(TestReplySplitAcrossChunks) {
+				auto queue = CommandQueue{};
+				auto reply = queue.expectReply("PN", std::chrono::milliseconds(1000));
+
+				Assert::AreEqual(0, queue.receive("PN00", 4));
+				Assert::AreEqual(0, queue.receive("01", 2));
+				Assert::AreEqual(1, queue.receive("90\r", 3));
+				Assert::AreEqual(std::string("PN000190\r"), reply.get());
+				Assert::AreEqual((size_t)0, queue.pending());
+			}
+
+			TEST_METHOD(TestSeveralRepliesInOneChunk) {
+				auto queue = CommandQueue{};
+				auto first = queue.expectReply("PN", std::chrono::milliseconds(1000));
+				auto second = queue.expectReply("PF", std::chrono::milliseconds(1000));
+
+				auto data = std::string("PN000001\rPF000002\r");
+				Assert::AreEqual(2, queue.receive(data.c_str(), data.size()));
+				Assert::AreEqual(std::string("PN000001\r"), first.get());
+				Assert::AreEqual(std::string("PF000002\r"), second.get());
+			}
+
+			TEST_METHOD(TestMultiCharacterTerminator) {
+				auto queue = CommandQueue{ "\r\n" };
+				auto reply = queue.expectReply("", std::chrono::milliseconds(1000));
+
+				Assert::AreEqual(0, queue.receive("0PO00\r", 6));
+				Assert::AreEqual(1, queue.receive("\n", 1));
+				Assert::AreEqual(std::string("0PO00\r\n"), reply.get());
+			}
+
+			TEST_METHOD(TestUnexpectedReplyIsDropped) {
+				auto queue = CommandQueue{};
+				auto reply = queue.expectReply("PF", std::chrono::milliseconds(1000));
+
+				// the late reply of a request which timed out
+				auto data = std::string("PN000001\rPF000002\r");
+				Assert::AreEqual(1, queue.receive(data.c_str(), data.size()));
+				Assert::AreEqual(1, queue.droppedReplies());
+				Assert::AreEqual(std::string("PF000002\r"), reply.get());
+
+				// nobody waits for this one
+				Assert::AreEqual(0, queue.receive("PF000003\r", 9));
+				Assert::AreEqual(2, queue.droppedReplies());
+			}
+
+			TEST_METHOD(TestTimeout) {
+				auto queue = CommandQueue{};
+				Assert::AreEqual(-1, queue.timeUntilExpiry());
+
+				auto now = std::chrono::steady_clock::now();
+				auto first = queue.expectReply("PN", std::chrono::milliseconds(100));
+				auto second = queue.expectReply("PF", std::chrono::milliseconds(200));
+				auto remaining = queue.timeUntilExpiry(now);
+				Assert::IsTrue(remaining >= 100 && remaining <= 101);
+
+				queue.receive("PN00", 4);
+				Assert::AreEqual(1, queue.expire(now + std::chrono::milliseconds(150)));
+				Assert::AreEqual(std::string(""), first.get());
+				Assert::AreEqual((size_t)1, queue.pending());
+
+				// the incomplete reply was discarded with the request
+				Assert::AreEqual(1, queue.receive("PF000002\r", 9));
+				Assert::AreEqual(std::string("PF000002\r"), second.get());
+			}
+
+			TEST_METHOD(TestCallbacks) {
+				auto queue = CommandQueue{};
+				auto replies = std::vector<std::string>{};
+				queue.expectReply("PN", std::chrono::milliseconds(1000), [&](const std::string& reply) {
+					replies.push_back(reply);
+					// a callback may already register the next request
+					queue.expectReply("PH", std::chrono::milliseconds(1000), [&](const std::string& reply) {
+						replies.push_back(reply);
+					});
+				});
+
+				auto data = std::string("PN000001\rPH2\r");
+				Assert::AreEqual(2, queue.receive(data.c_str(), data.size()));
+				Assert::AreEqual((size_t)2, replies.size());
+				Assert::AreEqual(std::string("PH2\r"), replies[1]);
+			}
+
+			TEST_METHOD(TestClear) {
+				auto queue = CommandQueue{};
+				auto called{ false };
+				auto reply = queue.expectReply("PN", std::chrono::milliseconds(1000), [&](const std::string& reply) {
+					called = reply.empty();
+				});
+				queue.clear();
+				Assert::IsTrue(called);
+				Assert::AreEqual(std::string(""), reply.get());
+				Assert::AreEqual(-1, queue.timeUntilExpiry());
+			}
+	};
+
+	TEST_CLASS(TestZeissECUCommands) {
+		public:
+			TEST_METHOD(TestCompatibility) {
+				auto ecu = EmulatedECU{};
+				Assert::IsTrue(Stand(&ecu).checkCompatibility());
+				Assert::IsTrue(Focus(&ecu).checkCompatibility());
+				Assert::IsTrue(MCU(&ecu).checkCompatibility());
+			}
+
+			TEST_METHOD(TestPositions) {
+				auto ecu = EmulatedECU{};
+				auto mcu = MCU(&ecu);
+				auto focus = Focus(&ecu);
+
+				mcu.setX(100);
+				mcu.setY(-100);
+				focus.setZ(100);
+				Assert::AreEqual(100.0, mcu.getX(), 1e-6);
+				Assert::AreEqual(-100.0, mcu.getY(), 1e-6);
+				Assert::AreEqual(100.0, focus.getZ(), 1e-6);
+			}
+
+			TEST_METHOD(TestElements) {
+				auto ecu = EmulatedECU{};
+				auto stand = Stand(&ecu);
+
+				stand.setReflector(3);
+				stand.setRLShutter(2);
+				stand.setLamp(40);
+				Assert::AreEqual(3, stand.getReflector());
+				Assert::AreEqual(2, stand.getRLShutter());
+				Assert::AreEqual(102, ecu.elementPosition("v1"));
+				Assert::AreEqual(40, stand.getLamp());
+			}
+
+			TEST_METHOD(TestPipelinedRequests) {
+				auto ecu = EmulatedECU{ std::chrono::milliseconds(5) };
+				ecu.setChunkSize(3);
+				auto mcu = MCU(&ecu);
+				auto focus = Focus(&ecu);
+				auto stand = Stand(&ecu);
+				mcu.setX(10);
+				mcu.setY(20);
+				focus.setZ(30);
+				stand.setObjective(4);
+
+				// all requests are sent before the first answer arrives
+				auto positions = std::vector<double>{};
+				auto objective{ 0 };
+				mcu.getX([&](double position) { positions.push_back(position); });
+				mcu.getY([&](double position) { positions.push_back(position); });
+				focus.getZ([&](double position) { positions.push_back(position); });
+				auto last = stand.getObjective([&](int position) { objective = position; });
+				Assert::IsTrue(ecu.hasPendingReplies());
+				Assert::IsTrue(positions.empty());
+
+				ecu.waitForReply(last);
+				Assert::IsFalse(ecu.hasPendingReplies());
+				Assert::AreEqual((size_t)3, positions.size());
+				Assert::AreEqual(10.0, positions[0], 1e-6);
+				Assert::AreEqual(20.0, positions[1], 1e-6);
+				Assert::AreEqual(30.0, positions[2], 1e-6);
+				Assert::AreEqual(4, objective);
+			}
+
+			TEST_METHOD(TestMissingAnswer) {
+				auto ecu = EmulatedECU{};
+				ecu.setTimeout(20);
+				auto mcu = MCU(&ecu);
+				auto stand = Stand(&ecu);
+				mcu.setX(10);
+
+				ecu.ignoreRequests(2);
+				auto position{ 0.0 };
+				auto reply = mcu.getX([&](double answer) { position = answer; });
+				Assert::AreEqual(std::string(""), ecu.waitForReply(reply));
+				Assert::IsTrue(std::isnan(position));
+				Assert::AreEqual(-1, stand.getMirror());
+
+				// the following requests are not affected
+				Assert::AreEqual(10.0, mcu.getX(), 1e-6);
+			}
+	};
+
+	TEST_CLASS(BenchmarkZeissECUCommands) {
+		public:
+			/*
+			 * Compare reading the position of the stage and the focus one request after another
+			 * with sending all requests at once, for a device with some latency.
+			 */
+			TEST_METHOD(BenchmarkPositionRequests) {
+				auto latency = std::chrono::milliseconds(10);
+				auto processingTime = std::chrono::milliseconds(2);
+				auto repetitions{ 20 };
+				auto ecu = EmulatedECU{ latency, processingTime };
+				auto mcu = MCU(&ecu);
+				auto focus = Focus(&ecu);
+
+				QElapsedTimer timer;
+				timer.start();
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					mcu.getX();
+					mcu.getY();
+					focus.getZ();
+				}
+				auto sequential = (double)timer.elapsed() / repetitions;
+
+				timer.start();
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					mcu.getX([](double) {});
+					mcu.getY([](double) {});
+					auto reply = focus.getZ([](double) {});
+					ecu.waitForReply(reply);
+				}
+				auto pipelined = (double)timer.elapsed() / repetitions;
+
+				// the previous implementation waited another 50 ms after every answer
+				auto message = QString("Reading the position with %1 ms latency: %2 ms one after another, %3 ms pipelined, "
+					"the previous implementation took at least %4 ms\n")
+					.arg(latency.count())
+					.arg(sequential, 0, 'f', 1)
+					.arg(pipelined, 0, 'f', 1)
+					.arg(3 * (latency.count() + processingTime.count() + 50));
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::IsTrue(pipelined < sequential);
+			}
+	};
+}
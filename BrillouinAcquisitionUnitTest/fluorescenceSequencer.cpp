@@ -0,0 +1,236 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Acquisition\AcquisitionModes\FluorescenceSequencer.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Mock camera which counts how often it is armed, can refuse to change the
+	 * exposure while running and returns a number of blank frames
+	 */
+	class SequencerMockCamera : public MockCamera {
+
+	public:
+		int getMaximumAcquisitionImages() override {
+			return m_maximumImages;
+		}
+
+		int changeExposureDuringAcquisition(double exposureTime, double gain) override {
+			Assert::IsTrue(m_isAcquisitionRunning);
+			if (!m_canChangeExposure) {
+				return -1;
+			}
+			m_exposureChanges++;
+			return MockCamera::changeExposureDuringAcquisition(exposureTime, gain);
+		}
+
+		void startAcquisition(const CAMERA_SETTINGS& settings) override {
+			Assert::IsFalse(m_isAcquisitionRunning);
+			MockCamera::startAcquisition(settings);
+			m_starts++;
+			m_images = 0;
+		}
+
+		void getImageForAcquisition(std::byte* buffer, bool preview = true) override {
+			Assert::IsTrue(m_isAcquisitionRunning);
+			MockCamera::getImageForAcquisition(buffer, preview);
+			if (buffer != nullptr && m_blankFrames > 0) {
+				memset(buffer, 0, getSettings().roi.bytesPerFrame);
+				m_blankFrames--;
+			}
+			m_images++;
+			m_totalImages++;
+			if (m_maximumImages > 0) {
+				Assert::IsTrue(m_images <= m_maximumImages);
+			}
+		}
+
+		bool m_canChangeExposure{ true };
+		int m_maximumImages{ 0 };
+		int m_blankFrames{ 0 };
+		int m_starts{ 0 };
+		int m_exposureChanges{ 0 };
+		int m_images{ 0 };
+		int m_totalImages{ 0 };
+	};
+
+	static CAMERA_SETTINGS configureSequencerCamera(MockCamera* camera) {
+		camera->connectDevice();
+
+		auto settings = CAMERA_SETTINGS{ 0.01, 0 };
+		settings.roi.width_physical = 200;
+		settings.roi.height_physical = 100;
+		settings.frameCount = 1;
+		settings.readout.pixelEncoding = L"16 bit";
+		camera->setSettings(settings);
+		camera->setMaxRate(true);
+		return camera->getSettings();
+	}
+
+	/*
+	 * Acquires one image per channel in the order of the sequencer
+	 */
+	static void acquireChannels(FluorescenceSequencer& sequencer, const CAMERA_SETTINGS& settings, const std::vector<CHANNEL_EXPOSURE>& channels) {
+		sequencer.start(settings);
+		for (auto index : FluorescenceSequencer::acquisitionOrder(channels)) {
+			sequencer.setExposure(channels[index]);
+			auto image = std::vector<unsigned short>((size_t)sequencer.getSettings().roi.bytesPerFrame / sizeof(unsigned short));
+			sequencer.acquire(image.data(), (gsl::index)image.size());
+			Assert::IsFalse(FluorescenceSequencer::isBlank(image.data(), (gsl::index)image.size()));
+			Assert::AreEqual(channels[index].exposureTime, sequencer.getSettings().exposureTime);
+		}
+		sequencer.stop();
+	}
+
+	TEST_CLASS(TestFluorescenceSequencer) {
+		public:
+			TEST_METHOD(TestAcquisitionOrder) {
+				// blue, green and red share the exposure, brightfield is in between
+				auto channels = std::vector<CHANNEL_EXPOSURE>{ { 0.9, 10 }, { 0.004, 0 }, { 0.9, 10 }, { 0.5, 10 }, { 0.9, 10 } };
+				auto order = FluorescenceSequencer::acquisitionOrder(channels);
+				auto expected = std::vector<gsl::index>{ 0, 2, 4, 1, 3 };
+				Assert::IsTrue(expected == order);
+			}
+
+			TEST_METHOD(TestIsBlank) {
+				auto image = std::vector<unsigned char>(1000 * 1000, 0);
+				Assert::IsTrue(FluorescenceSequencer::isBlank(image.data(), (gsl::index)image.size()));
+
+				// a dark image still has signal at the sampled pixels
+				for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i += 7) {
+					image[i] = 3;
+				}
+				Assert::IsFalse(FluorescenceSequencer::isBlank(image.data(), (gsl::index)image.size()));
+
+				// small images are checked completely
+				auto small = std::vector<unsigned short>(100, 0);
+				small[99] = 1;
+				Assert::IsFalse(FluorescenceSequencer::isBlank(small.data(), (gsl::index)small.size()));
+			}
+
+			TEST_METHOD(TestCameraStaysArmed) {
+				auto camera = new SequencerMockCamera();
+				auto settings = configureSequencerCamera(camera);
+				auto sequencer = FluorescenceSequencer{ camera };
+
+				auto channels = std::vector<CHANNEL_EXPOSURE>{ { 0.9, 10 }, { 0.004, 0 }, { 0.9, 10 }, { 0.9, 10 } };
+				acquireChannels(sequencer, settings, channels);
+
+				Assert::AreEqual(1, camera->m_starts);
+				Assert::AreEqual(0, sequencer.restarts());
+				// the first exposure is set when the camera is armed
+				Assert::AreEqual(1, camera->m_exposureChanges);
+				Assert::AreEqual(2, sequencer.discardedFrames());
+				Assert::IsFalse(camera->m_isAcquisitionRunning);
+
+				delete camera;
+			}
+
+			TEST_METHOD(TestRestartWithoutExposureChange) {
+				auto camera = new SequencerMockCamera();
+				camera->m_canChangeExposure = false;
+				auto settings = configureSequencerCamera(camera);
+				auto sequencer = FluorescenceSequencer{ camera };
+
+				auto channels = std::vector<CHANNEL_EXPOSURE>{ { 0.9, 10 }, { 0.004, 0 }, { 0.9, 10 }, { 0.9, 10 } };
+				acquireChannels(sequencer, settings, channels);
+
+				// only the change from the fluorescence to the brightfield channels restarts the camera
+				Assert::AreEqual(2, camera->m_starts);
+				Assert::AreEqual(1, sequencer.restarts());
+				Assert::AreEqual(4, sequencer.discardedFrames());
+				Assert::AreEqual(4 + 4, camera->m_totalImages);
+
+				delete camera;
+			}
+
+			TEST_METHOD(TestMaximumImages) {
+				auto camera = new SequencerMockCamera();
+				camera->m_maximumImages = 2;
+				auto settings = configureSequencerCamera(camera);
+				auto sequencer = FluorescenceSequencer{ camera };
+
+				auto channels = std::vector<CHANNEL_EXPOSURE>(5, { 0.01, 0 });
+				acquireChannels(sequencer, settings, channels);
+
+				Assert::AreEqual(3, camera->m_starts);
+				Assert::AreEqual(0, sequencer.discardedFrames());
+
+				delete camera;
+			}
+
+			TEST_METHOD(TestBlankFramesAreRepeated) {
+				auto camera = new SequencerMockCamera();
+				camera->m_blankFrames = 2;
+				auto settings = configureSequencerCamera(camera);
+				auto sequencer = FluorescenceSequencer{ camera };
+
+				acquireChannels(sequencer, settings, { { 0.01, 0 } });
+
+				Assert::AreEqual(2, sequencer.blankFrames());
+				Assert::AreEqual(3, camera->m_totalImages);
+
+				delete camera;
+			}
+	};
+
+	TEST_CLASS(BenchmarkFluorescenceSequencer) {
+		public:
+			/*
+			 * Four channels as acquired before, restarting the camera for every channel with a
+			 * separate acquisition to discard two frames whenever the exposure changes, and with the sequencer.
+			 */
+			TEST_METHOD(BenchmarkFourChannels) {
+				auto startDelay{ 100 };
+				auto channels = std::vector<CHANNEL_EXPOSURE>{ { 0.05, 10 }, { 0.05, 10 }, { 0.05, 10 }, { 0.004, 0 } };
+
+				auto camera = new SequencerMockCamera();
+				auto settings = configureSequencerCamera(camera);
+				camera->setMaxRate(false);
+				camera->setStartDelay(startDelay);
+				auto image = std::vector<unsigned short>((size_t)settings.roi.bytesPerFrame / sizeof(unsigned short));
+
+				QElapsedTimer timer;
+				timer.start();
+				auto current = settings;
+				for (const auto& channel : channels) {
+					auto changed = !FluorescenceSequencer::isEqual({ current.exposureTime, current.gain }, channel);
+					current.exposureTime = channel.exposureTime;
+					current.gain = channel.gain;
+					if (changed) {
+						camera->startAcquisition(current);
+						camera->getImageForAcquisition(nullptr, false);
+						camera->getImageForAcquisition(nullptr, false);
+						camera->stopAcquisition();
+					}
+					camera->startAcquisition(current);
+					camera->getImageForAcquisition(reinterpret_cast<std::byte*>(image.data()), true);
+					camera->stopAcquisition();
+				}
+				auto restarting = 1e-6 * timer.nsecsElapsed();
+				auto restartingStarts = camera->m_starts;
+
+				camera->m_starts = 0;
+				auto sequencer = FluorescenceSequencer{ camera };
+				timer.start();
+				acquireChannels(sequencer, settings, channels);
+				auto sequenced = 1e-6 * timer.nsecsElapsed();
+
+				auto message = QString("Four channels with %1 ms camera start: %2 ms restarting per channel (%3 starts), %4 ms sequenced (%5 starts)\n")
+					.arg(startDelay)
+					.arg(restarting, 0, 'f', 1)
+					.arg(restartingStarts)
+					.arg(sequenced, 0, 'f', 1)
+					.arg(camera->m_starts);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::AreEqual(1, camera->m_starts);
+				Assert::IsTrue(sequenced < restarting / 2);
+
+				delete camera;
+			}
+	};
+}
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\framePool.h"
+#include "..\BrillouinAcquisition\src\storageWrapper.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestFramePool) {
+		public:
+			TEST_METHOD(TestFrameIsReused) {
+				auto pool = FramePool<unsigned short>{};
+				auto frame = pool.get(100);
+				Assert::AreEqual((size_t)100, frame.size());
+				auto data = frame.data();
+
+				pool.recycle(std::move(frame));
+				auto frame2 = pool.get(100);
+				// the same memory has to be handed out again
+				Assert::IsTrue(data == frame2.data());
+
+				auto statistics = pool.getStatistics();
+				Assert::AreEqual(1LL, statistics.allocatedFrames);
+				Assert::AreEqual(1LL, statistics.reusedFrames);
+				Assert::AreEqual(200LL, statistics.allocatedBytes);
+			}
+
+			TEST_METHOD(TestFrameSizeMismatch) {
+				auto pool = FramePool<unsigned char>{};
+				pool.recycle(std::vector<unsigned char>(50));
+				auto frame = pool.get(100);
+				Assert::AreEqual((size_t)100, frame.size());
+
+				auto statistics = pool.getStatistics();
+				Assert::AreEqual(1LL, statistics.allocatedFrames);
+				Assert::AreEqual(0LL, statistics.reusedFrames);
+				Assert::AreEqual(1, statistics.pooledFrames);
+			}
+
+			TEST_METHOD(TestPoolIsBounded) {
+				auto pool = FramePool<unsigned char>{ 2 };
+				for (gsl::index i{ 0 }; i < 5; i++) {
+					pool.recycle(std::vector<unsigned char>(10));
+				}
+				Assert::AreEqual(2, pool.getStatistics().pooledFrames);
+			}
+	};
+
+	TEST_CLASS(BenchmarkFramePath) {
+		public:
+			/*
+			 * Count the bytes written per Brillouin frame from the camera into the payload,
+			 * once for the previous path (fresh vector per position, copy into the payload)
+			 * and once for the pooled path (buffer is moved into the payload and recycled).
+			 */
+			TEST_METHOD(BenchmarkBytesCopiedPerFrame) {
+				auto camera = new MockCamera();
+				camera->connectDevice();
+
+				auto settings = CAMERA_SETTINGS{ 0, 0 };
+				settings.roi.width_physical = 1000;
+				settings.roi.height_physical = 1000;
+				settings.frameCount = 2;
+				settings.readout.pixelEncoding = L"16 bit";
+				camera->setSettings(settings);
+				camera->setCalibrationExposureTime(0);
+				settings = camera->getSettings();
+
+				auto positions{ 20 };
+				auto bytesPerFrame = (long long)settings.roi.bytesPerFrame;
+				auto bytesPerImage = bytesPerFrame * settings.frameCount;
+				hsize_t dims[3] = { (hsize_t)settings.frameCount, (hsize_t)settings.roi.height_binned, (hsize_t)settings.roi.width_binned };
+				auto date = std::string{ "2020-11-02T12:00:00.000+01:00" };
+
+				/*
+				 * Previous path
+				 */
+				long long bytesCopiedPrevious{ 0 };
+				for (gsl::index ll{ 0 }; ll < positions; ll++) {
+					auto images = std::vector<unsigned short>(bytesPerImage / sizeof(unsigned short));
+					// the new vector is zero-initialized
+					bytesCopiedPrevious += bytesPerImage;
+					auto buffer = reinterpret_cast<std::byte*>(images.data());
+					for (gsl::index mm{ 0 }; mm < settings.frameCount; mm++) {
+						camera->getImageForAcquisition(&buffer[bytesPerFrame * mm], false);
+						bytesCopiedPrevious += bytesPerFrame;
+					}
+					auto img = new IMAGE<unsigned short>(0, 0, 0, 3, dims, date, images, settings.exposureTime, settings.gain, settings.roi);
+					if (img->data.data() != images.data()) {
+						bytesCopiedPrevious += bytesPerImage;
+					}
+					delete img;
+				}
+
+				/*
+				 * Pooled path
+				 */
+				auto pool = FramePool<unsigned short>{};
+				long long bytesCopiedPooled{ 0 };
+				for (gsl::index ll{ 0 }; ll < positions; ll++) {
+					auto images = pool.get(bytesPerImage / sizeof(unsigned short));
+					auto data = images.data();
+					auto buffer = reinterpret_cast<std::byte*>(data);
+					for (gsl::index mm{ 0 }; mm < settings.frameCount; mm++) {
+						camera->getImageForAcquisition(&buffer[bytesPerFrame * mm], false);
+						bytesCopiedPooled += bytesPerFrame;
+					}
+					auto img = new IMAGE<unsigned short>(0, 0, 0, 3, dims, date, std::move(images), settings.exposureTime, settings.gain, settings.roi);
+					if (img->data.data() != data) {
+						bytesCopiedPooled += bytesPerImage;
+					}
+					// this is what the storage does after writing the payload
+					pool.recycle(std::move(img->data));
+					delete img;
+				}
+				bytesCopiedPooled += pool.getStatistics().allocatedBytes;
+
+				auto frames = positions * settings.frameCount;
+				auto message = QString("Bytes written per frame: previous %1, pooled %2\n")
+					.arg(bytesCopiedPrevious / frames)
+					.arg(bytesCopiedPooled / frames);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::IsTrue(bytesCopiedPooled * 2 <= bytesCopiedPrevious);
+
+				delete camera;
+			}
+	};
+}
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\imageRegistration.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Randomly placed blobs, with the content shifted by (shift_x, shift_y) pixels
+	 */
+	std::vector<unsigned char> syntheticStructures(int dim_x, int dim_y, double shift_x, double shift_y, double noise = 0, int seed = 42) {
+		auto generator = std::mt19937{ (unsigned int)seed };
+		auto position_x = std::uniform_real_distribution<double>{ -100, dim_x + 100.0 };
+		auto position_y = std::uniform_real_distribution<double>{ -100, dim_y + 100.0 };
+		auto brightness = std::uniform_real_distribution<double>{ 20, 60 };
+		struct BLOB {
+			double x;
+			double y;
+			double amplitude;
+		};
+		auto blobs = std::vector<BLOB>((size_t)(dim_x + 200) * (dim_y + 200) / 150);
+		for (auto& blob : blobs) {
+			blob = { position_x(generator), position_y(generator), brightness(generator) };
+		}
+
+		auto intensity = std::vector<double>((size_t)dim_x * dim_y, 40);
+		for (const auto& blob : blobs) {
+			auto center_x = blob.x + shift_x;
+			auto center_y = blob.y + shift_y;
+			for (gsl::index y{ std::max(0, (int)center_y - 10) }; y < std::min(dim_y, (int)center_y + 11); y++) {
+				for (gsl::index x{ std::max(0, (int)center_x - 10) }; x < std::min(dim_x, (int)center_x + 11); x++) {
+					auto distance = pow(x - center_x, 2) + pow(y - center_y, 2);
+					intensity[x + (gsl::index)dim_x * y] += blob.amplitude * exp(-distance / (2 * 2.5 * 2.5));
+				}
+			}
+		}
+
+		auto noiseGenerator = std::mt19937{ (unsigned int)(seed + 1000 * shift_x + shift_y) };
+		auto distribution = std::normal_distribution<double>{ 0, std::max(noise, 1e-9) };
+		auto image = std::vector<unsigned char>(intensity.size());
+		for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i++) {
+			auto value = intensity[i] + (noise > 0 ? distribution(noiseGenerator) : 0);
+			image[i] = (unsigned char)std::clamp(round(value), 0.0, 255.0);
+		}
+		return image;
+	}
+
+	TEST_CLASS(TestImageRegistration) {
+		public:
+			TEST_METHOD(TestNoShift) {
+				auto image = syntheticStructures(128, 96, 0, 0);
+				auto registration = ImageRegistration{ 1 };
+				registration.setReference(image.data(), 128, 96);
+				auto shift = registration.measureShift(image.data(), 128, 96);
+				Assert::AreEqual(0.0, shift.x, 1e-6);
+				Assert::AreEqual(0.0, shift.y, 1e-6);
+				Assert::IsTrue(shift.confidence > 20);
+			}
+
+			TEST_METHOD(TestIntegerShift) {
+				auto reference = syntheticStructures(128, 128, 0, 0);
+				auto shifted = syntheticStructures(128, 128, 7, -12);
+				auto registration = ImageRegistration{ 2 };
+				registration.setReference(reference.data(), 128, 128);
+				auto shift = registration.measureShift(shifted.data(), 128, 128);
+				Assert::AreEqual(7.0, shift.x, 0.05);
+				Assert::AreEqual(-12.0, shift.y, 0.05);
+			}
+
+			TEST_METHOD(TestSubpixelShift) {
+				auto reference = syntheticStructures(160, 128, 0, 0, 1);
+				auto registration = ImageRegistration{ 2 };
+				registration.setReference(reference.data(), 160, 128);
+				auto expected = std::vector<std::pair<double, double>>{ { 0.3, 0 }, { -2.5, 1.75 }, { 15.6, -8.2 }, { -30.4, 21.9 } };
+				for (const auto& [shift_x, shift_y] : expected) {
+					auto shifted = syntheticStructures(160, 128, shift_x, shift_y, 1);
+					auto shift = registration.measureShift(shifted.data(), 160, 128);
+					Assert::AreEqual(shift_x, shift.x, 0.05);
+					Assert::AreEqual(shift_y, shift.y, 0.05);
+					Assert::IsTrue(shift.confidence > 10);
+				}
+			}
+
+			TEST_METHOD(TestConfidenceWithoutStructure) {
+				// two images of different structures do not correlate
+				auto reference = syntheticStructures(128, 128, 0, 0, 2, 1);
+				auto other = syntheticStructures(128, 128, 0, 0, 2, 2);
+				auto registration = ImageRegistration{ 1 };
+				registration.setReference(reference.data(), 128, 128);
+				auto shift = registration.measureShift(other.data(), 128, 128);
+				Assert::IsTrue(shift.confidence < 10);
+			}
+
+			TEST_METHOD(TestSizeMismatch) {
+				auto image = syntheticStructures(64, 64, 0, 0);
+				auto registration = ImageRegistration{ 1 };
+				Assert::ExpectException<std::logic_error>([&]() { registration.measureShift(image.data(), 64, 64); });
+				registration.setReference(image.data(), 64, 64);
+				Assert::ExpectException<std::invalid_argument>([&]() { registration.measureShift(image.data(), 32, 64); });
+			}
+	};
+
+	TEST_CLASS(BenchmarkImageRegistration) {
+		public:
+			/*
+			 * Time to register an image of the size the scale calibration acquires
+			 */
+			TEST_METHOD(BenchmarkRegistration) {
+				auto dim{ 1000 };
+				auto repetitions{ 10 };
+				auto reference = syntheticStructures(dim, dim, 0, 0, 2);
+				auto shifted = syntheticStructures(dim, dim, 48.3, -61.7, 2);
+
+				auto registration = ImageRegistration{};
+				registration.setReference(reference.data(), dim, dim);
+				// the first registration creates the plans
+				auto shift = registration.measureShift(shifted.data(), dim, dim);
+
+				QElapsedTimer timer;
+				timer.start();
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					shift = registration.measureShift(shifted.data(), dim, dim);
+				}
+				auto perImage = 1e-6 * timer.nsecsElapsed() / repetitions;
+
+				auto message = QString("Registering a %1x%2 pixel image: %3 ms, shift (%4, %5) pix, confidence %6\n")
+					.arg(dim)
+					.arg(dim)
+					.arg(perImage, 0, 'f', 3)
+					.arg(shift.x, 0, 'f', 3)
+					.arg(shift.y, 0, 'f', 3)
+					.arg(shift.confidence, 0, 'f', 1);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::AreEqual(48.3, shift.x, 0.05);
+				Assert::AreEqual(-61.7, shift.y, 0.05);
+			}
+	};
+}
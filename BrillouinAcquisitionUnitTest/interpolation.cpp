@@ -2,10 +2,46 @@
 #include "CppUnitTest.h"
 #include "..\BrillouinAcquisition\src\interpolation.h"
 
+#include <array>
+#include <random>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace BrillouinAcquisitionUnitTest {
 
+	/*
+	 * Positions and values of calibration points on a distorted grid
+	 */
+	std::array<std::vector<double>, 3> createPoints(int dim) {
+		auto generator = std::mt19937{ 7 };
+		auto jitter = std::uniform_real_distribution<double>{ -0.2, 0.2 };
+		auto points = std::array<std::vector<double>, 3>{};
+		for (gsl::index i{ 0 }; i < dim * dim; i++) {
+			auto x = (double)(i % dim) + jitter(generator);
+			auto y = (double)(i / dim) + jitter(generator);
+			points[0].push_back(x);
+			points[1].push_back(y);
+			points[2].push_back(0.3 * x + 0.01 * x * y - 0.002 * y * y);
+		}
+		return points;
+	}
+
+	WEIGHTS<double> calculateWeights(std::vector<double> x, std::vector<double> y, std::vector<double> values) {
+		return interpolation::biharmonic_spline_calculate_weights(
+			Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>(Eigen::Map<Eigen::ArrayXd>(x.data(), x.size())),
+			Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>(Eigen::Map<Eigen::ArrayXd>(y.data(), y.size())),
+			Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>(Eigen::Map<Eigen::ArrayXd>(values.data(), values.size()))
+		);
+	}
+
+	/*
+	 * Calibration points on a distorted grid, like the spots of a voltage calibration
+	 */
+	WEIGHTS<double> createCalibration(int dim) {
+		auto points = createPoints(dim);
+		return calculateWeights(points[0], points[1], points[2]);
+	}
+
 	TEST_CLASS(TestInterpolation) {
 		public:
 			// Tests for biharmonic_spline()
@@ -38,4 +74,179 @@ namespace BrillouinAcquisitionUnitTest {
 				Assert::IsTrue(res < 1e-10);
 			}
 	};
-}
\ No newline at end of file
+
+	TEST_CLASS(TestBiharmonicSplineFitter) {
+		public:
+			TEST_METHOD(TestMatchesInterpolation) {
+				auto points = createPoints(8);
+				auto fitter = BiharmonicSplineFitter<double>{ points[0], points[1] };
+				auto weights = fitter.fit(points[2]);
+
+				auto expected = calculateWeights(points[0], points[1], points[2]);
+				Assert::IsTrue((expected.weights - weights.weights).cwiseAbs().maxCoeff() < 1e-8);
+				Assert::IsTrue(expected.xy_vec == weights.xy_vec);
+			}
+
+			TEST_METHOD(TestAddAndRemovePoints) {
+				auto points = createPoints(8);
+				auto x = points[0];
+				auto y = points[1];
+				auto values = points[2];
+				auto fitter = BiharmonicSplineFitter<double>{
+					std::vector<double>(x.begin(), x.end() - 3),
+					std::vector<double>(y.begin(), y.end() - 3)
+				};
+				for (gsl::index i{ (gsl::index)x.size() - 3 }; i < (gsl::index)x.size(); i++) {
+					fitter.addPoint(x[i], y[i]);
+				}
+				auto expected = calculateWeights(x, y, values);
+				Assert::IsTrue((expected.weights - fitter.fit(values).weights).cwiseAbs().maxCoeff() < 1e-6);
+
+				// remove a point in the middle
+				fitter.removePoint(20);
+				x.erase(x.begin() + 20);
+				y.erase(y.begin() + 20);
+				values.erase(values.begin() + 20);
+				expected = calculateWeights(x, y, values);
+				Assert::IsTrue((expected.weights - fitter.fit(values).weights).cwiseAbs().maxCoeff() < 1e-6);
+			}
+
+			TEST_METHOD(TestDuplicatePoints) {
+				// two voltages can end up at the same pixel
+				auto x = std::vector<double>{ 1, 2, 3, 1, 2, 3, 2 };
+				auto y = std::vector<double>{ 1, 1, 1, 2, 2, 2, 1 };
+				auto values = std::vector<double>{ 1, 2, 3, 4, 5, 6, 2 };
+				auto fitter = BiharmonicSplineFitter<double>{ x, y };
+				auto spline = BiharmonicSpline<double>{ fitter.fit(values) };
+				Assert::AreEqual(2.0, spline(2, 1), 1e-6);
+				Assert::AreEqual(5.0, spline(2, 2), 1e-6);
+
+				fitter.addPoint(3, 2);
+				values.push_back(6);
+				spline = BiharmonicSpline<double>{ fitter.fit(values) };
+				Assert::AreEqual(6.0, spline(3, 2), 1e-6);
+			}
+
+			TEST_METHOD(TestWrongNumberOfValues) {
+				auto fitter = BiharmonicSplineFitter<double>{ { 1, 2 }, { 1, 2 } };
+				Assert::ExpectException<std::invalid_argument>([&fitter]() { fitter.fit({ 1, 2, 3 }); });
+			}
+	};
+
+	TEST_CLASS(TestBiharmonicSpline) {
+		public:
+			TEST_METHOD(TestMatchesInterpolation) {
+				auto weights = createCalibration(10);
+				auto spline = BiharmonicSpline<double>{ weights };
+				auto generator = std::mt19937{ 3 };
+				auto position = std::uniform_real_distribution<double>{ -1, 10 };
+				for (gsl::index i{ 0 }; i < 100; i++) {
+					auto x = position(generator);
+					auto y = position(generator);
+					auto expected = interpolation::biharmonic_spline_calculate_values(weights, x, y);
+					Assert::AreEqual(expected, spline(x, y), 1e-9 * (1 + std::abs(expected)));
+				}
+				// exactly at a calibration point
+				auto x = weights.xy_vec(11).real();
+				auto y = weights.xy_vec(11).imag();
+				Assert::AreEqual(interpolation::biharmonic_spline_calculate_values(weights, x, y), spline(x, y), 1e-9);
+			}
+
+			TEST_METHOD(TestBatchEvaluation) {
+				auto weights = createCalibration(5);
+				auto spline = BiharmonicSpline<double>{ weights };
+				Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> xr(2, 2);
+				xr << 1.5, 2.5, 3.5, 4.5;
+				Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> yr = xr.transpose();
+				auto expected = interpolation::biharmonic_spline_calculate_values(weights, xr, yr);
+				auto values = spline.evaluate(xr, yr);
+				Assert::IsTrue((expected - values).abs().maxCoeff() < 1e-9);
+			}
+
+			TEST_METHOD(TestEmptySpline) {
+				auto spline = BiharmonicSpline<double>{};
+				Assert::AreEqual(0.0, spline(1, 2));
+			}
+	};
+
+	TEST_CLASS(BenchmarkBiharmonicSpline) {
+		public:
+			/*
+			 * Compare fitting the four weights of a voltage calibration with the QR
+			 * decomposition per weight and with the shared factorization
+			 */
+			TEST_METHOD(BenchmarkFitting) {
+				for (auto dim : { 10, 20, 40 }) {
+					auto points = createPoints(dim);
+					auto values2 = points[2];
+					for (auto& value : values2) {
+						value *= 2;
+					}
+
+					auto timer = QElapsedTimer{};
+					timer.start();
+					for (gsl::index i{ 0 }; i < 2; i++) {
+						calculateWeights(points[0], points[1], points[2]);
+						calculateWeights(points[0], points[1], values2);
+					}
+					auto interpolationTime = 1e-6 * timer.nsecsElapsed();
+
+					timer.start();
+					for (gsl::index i{ 0 }; i < 2; i++) {
+						auto fitter = BiharmonicSplineFitter<double>{ points[0], points[1] };
+						fitter.fit(points[2]);
+						fitter.fit(values2);
+					}
+					auto fitterTime = 1e-6 * timer.nsecsElapsed();
+
+					// the first update inverts the factorized matrix
+					auto fitter = BiharmonicSplineFitter<double>{ points[0], points[1] };
+					fitter.removePoint(0);
+					fitter.addPoint(points[0][0], points[1][0]);
+					timer.start();
+					fitter.removePoint(0);
+					fitter.addPoint(points[0][0], points[1][0]);
+					auto updateTime = 1e-6 * timer.nsecsElapsed();
+
+					auto message = QString("Fitting a calibration with %1 points: interpolation %2 ms, fitter %3 ms, removing and adding a point %4 ms\n")
+						.arg(dim * dim)
+						.arg(interpolationTime, 0, 'f', 1)
+						.arg(fitterTime, 0, 'f', 1)
+						.arg(updateTime, 0, 'f', 1);
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+
+			TEST_METHOD(BenchmarkEvaluation) {
+				for (auto dim : { 5, 20, 50 }) {
+					auto weights = createCalibration(dim);
+					auto spline = BiharmonicSpline<double>{ weights };
+					auto queries{ 2000 };
+					auto x = std::vector<double>(queries);
+					auto y = std::vector<double>(queries);
+					for (gsl::index i{ 0 }; i < queries; i++) {
+						x[i] = (double)(dim - 1) * i / queries;
+						y[i] = (double)(dim - 1) * (queries - i) / queries;
+					}
+					auto values = std::vector<double>(queries);
+
+					auto timer = QElapsedTimer{};
+					timer.start();
+					for (gsl::index i{ 0 }; i < queries; i++) {
+						values[i] = interpolation::biharmonic_spline_calculate_values(weights, x[i], y[i]);
+					}
+					auto interpolationTime = 1e-3 * timer.nsecsElapsed() / queries;
+
+					timer.start();
+					spline.evaluate(x.data(), y.data(), values.data(), queries);
+					auto splineTime = 1e-3 * timer.nsecsElapsed() / queries;
+
+					auto message = QString("Biharmonic spline with %1 points: interpolation %2 us, evaluator %3 us per query\n")
+						.arg(dim * dim)
+						.arg(interpolationTime, 0, 'f', 3)
+						.arg(splineTime, 0, 'f', 3);
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+	};
+}
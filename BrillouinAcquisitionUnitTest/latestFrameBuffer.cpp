@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\latestFrameBuffer.h"
+#include "..\BrillouinAcquisition\src\previewScheduler.h"
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestLatestFrameBuffer) {
+		public:
+			TEST_METHOD(TestEmptyBuffer) {
+				auto buffer = LatestFrameBuffer<int>{};
+				Assert::IsFalse((bool)buffer.tryWrite());
+				Assert::IsFalse((bool)buffer.tryRead());
+			}
+
+			TEST_METHOD(TestFrameIsPublishedOnCommit) {
+				auto buffer = LatestFrameBuffer<int>(1);
+				Assert::AreEqual(1, buffer.bufferSize());
+				{
+					auto slot = buffer.tryWrite();
+					Assert::IsTrue((bool)slot);
+					slot.get()[0] = 42;
+					// not published before the commit
+					Assert::IsFalse((bool)buffer.tryRead());
+					slot.commit();
+				}
+				auto slot = buffer.tryRead();
+				Assert::IsTrue((bool)slot);
+				Assert::AreEqual(42, slot.get()[0]);
+				Assert::AreEqual(1ull, slot.frameNumber());
+				Assert::AreEqual(0ull, slot.droppedFrames());
+				// a frame is only read once
+				Assert::IsFalse((bool)buffer.tryRead());
+			}
+
+			TEST_METHOD(TestDiscardedFrameIsNotPublished) {
+				auto buffer = LatestFrameBuffer<int>(1);
+				{
+					auto slot = buffer.tryWrite();
+					slot.discard();
+				}
+				Assert::IsFalse((bool)buffer.tryRead());
+
+				// a partially written frame is abandoned if the slot goes out of scope without a commit
+				{
+					auto slot = buffer.tryWrite();
+					slot.get()[0] = 1;
+					slot.commit();
+				}
+				{
+					auto slot = buffer.tryWrite();
+					slot.get()[0] = 2;
+				}
+				auto slot = buffer.tryRead();
+				Assert::AreEqual(1, slot.get()[0]);
+				Assert::AreEqual(1ull, slot.frameNumber());
+				Assert::IsFalse((bool)buffer.tryRead());
+			}
+
+			TEST_METHOD(TestWriterNeverBlocks) {
+				auto buffer = LatestFrameBuffer<int>(1);
+				for (gsl::index i{ 0 }; i < 10; i++) {
+					auto slot = buffer.tryWrite();
+					Assert::IsTrue((bool)slot);
+					slot.get()[0] = (int)i;
+					slot.commit();
+				}
+				// only the latest frame is kept, the others are counted as dropped
+				auto slot = buffer.tryRead();
+				Assert::AreEqual(9, slot.get()[0]);
+				Assert::AreEqual(10ull, slot.frameNumber());
+				Assert::AreEqual(9ull, slot.droppedFrames());
+			}
+
+			TEST_METHOD(TestReadFrameIsNotOverwritten) {
+				auto buffer = LatestFrameBuffer<int>(1);
+				{
+					auto slot = buffer.tryWrite();
+					slot.get()[0] = 1;
+					slot.commit();
+				}
+				auto read = buffer.tryRead();
+				for (gsl::index i{ 2 }; i < 10; i++) {
+					auto slot = buffer.tryWrite();
+					Assert::IsTrue(slot.get() != read.get());
+					slot.get()[0] = (int)i;
+					slot.commit();
+				}
+				Assert::AreEqual(1, read.get()[0]);
+
+				read = buffer.tryRead();
+				Assert::AreEqual(9, read.get()[0]);
+				Assert::AreEqual(7ull, read.droppedFrames());
+			}
+
+			TEST_METHOD(TestStressSingleProducerSingleConsumer) {
+				auto frameCount = 200000u;
+				auto frameSize = 64;
+				auto buffer = LatestFrameBuffer<unsigned int>(frameSize);
+				auto done = std::atomic<bool>{ false };
+
+				auto producer = std::thread([&]() {
+					for (unsigned int frame{ 1 }; frame <= frameCount; frame++) {
+						auto slot = buffer.tryWrite();
+						for (gsl::index i{ 0 }; i < frameSize; i++) {
+							slot.get()[i] = frame;
+						}
+						slot.commit();
+					}
+					done = true;
+				});
+
+				auto errors{ 0 };
+				auto framesRead{ 0ull };
+				auto framesDropped{ 0ull };
+				auto lastFrame{ 0u };
+				while (true) {
+					auto finished = done.load();
+					auto slot = buffer.tryRead();
+					if (!slot) {
+						if (finished) {
+							break;
+						}
+						std::this_thread::yield();
+						continue;
+					}
+					// frames have to be newer than the previous one and must not be torn
+					auto frame = slot.get()[0];
+					if (frame <= lastFrame || frame != slot.frameNumber()) {
+						errors++;
+					}
+					for (gsl::index i{ 0 }; i < frameSize; i++) {
+						if (slot.get()[i] != frame) {
+							errors++;
+							break;
+						}
+					}
+					lastFrame = frame;
+					framesRead++;
+					framesDropped += slot.droppedFrames();
+				}
+				producer.join();
+
+				Assert::AreEqual(0, errors);
+				// the last frame is always delivered
+				Assert::AreEqual(frameCount, lastFrame);
+				Assert::AreEqual((unsigned long long)frameCount, framesRead + framesDropped);
+			}
+	};
+
+	TEST_CLASS(TestPreviewScheduler) {
+		public:
+			TEST_METHOD(TestRequestsAreCoalesced) {
+				auto scheduler = PreviewScheduler{ 0 };
+				Assert::IsTrue(scheduler.request());
+				Assert::IsFalse(scheduler.request());
+				Assert::IsFalse(scheduler.request());
+
+				scheduler.beginConversion();
+				Assert::IsTrue(scheduler.request());
+			}
+
+			TEST_METHOD(TestTargetRate) {
+				auto scheduler = PreviewScheduler{ 20 };
+				Assert::AreEqual(20.0, scheduler.getTargetRate(), 1e-9);
+				Assert::AreEqual(0, scheduler.delay());
+
+				scheduler.beginConversion();
+				auto delay = scheduler.delay();
+				Assert::IsTrue(delay > 40 && delay <= 50);
+
+				scheduler.setTargetRate(0);
+				Assert::AreEqual(0, scheduler.delay());
+			}
+
+			TEST_METHOD(TestStatistics) {
+				auto scheduler = PreviewScheduler{ 0, 0 };
+				// the first frame starts the interval
+				Assert::IsFalse(scheduler.frameShown(3, 2));
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				Assert::IsTrue(scheduler.frameShown(10, 6));
+
+				auto statistics = scheduler.getStatistics();
+				Assert::AreEqual(2ull, statistics.displayedFrames);
+				Assert::AreEqual(8ull, statistics.droppedFrames);
+				// eight frames from the camera in the interval, two of them shown
+				Assert::AreEqual(4.0, statistics.cameraRate / statistics.displayRate, 1e-9);
+
+				// a new preview buffer starts counting again
+				scheduler.frameShown(1, 0);
+				statistics = scheduler.getStatistics();
+				Assert::AreEqual(1ull, statistics.displayedFrames);
+				Assert::AreEqual(0ull, statistics.droppedFrames);
+			}
+	};
+
+	TEST_CLASS(BenchmarkLatestFrameBuffer) {
+		public:
+			/*
+			 * Measure how old the frames are the preview shows, if the conversion is slower than the camera.
+			 * A buffer which queues the frames would show frames several conversions old.
+			 */
+			TEST_METHOD(BenchmarkPreviewLatency) {
+				auto frameSize{ 1024 };
+				auto conversionTime = std::chrono::milliseconds(20);
+				auto cameraPeriod = std::chrono::milliseconds(2);
+				auto duration = std::chrono::milliseconds(1000);
+
+				auto buffer = LatestFrameBuffer<long long>(frameSize);
+				auto [age, rejected] = measureLatency(buffer, frameSize, cameraPeriod, conversionTime, duration);
+
+				auto message = QString("Preview with %1 ms conversion and %2 ms camera period: %3 ms old frames, %4 frames rejected\n")
+					.arg(conversionTime.count())
+					.arg(cameraPeriod.count())
+					.arg(age, 0, 'f', 1)
+					.arg(rejected);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::AreEqual(0, rejected);
+				Assert::IsTrue(age < conversionTime.count());
+			}
+
+		private:
+			/*
+			 * Returns the mean age of a frame when its conversion starts [ms]
+			 * and how often the camera could not write a frame
+			 */
+			std::pair<double, int> measureLatency(LatestFrameBuffer<long long>& buffer, int frameSize, std::chrono::milliseconds cameraPeriod,
+				std::chrono::milliseconds conversionTime, std::chrono::milliseconds duration) {
+
+				auto timestamp = []() {
+					return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+				};
+				auto start = std::chrono::steady_clock::now();
+				auto done = std::atomic<bool>{ false };
+				auto rejected{ 0 };
+				auto producer = std::thread([&]() {
+					auto next = start;
+					while (next - start < duration) {
+						std::this_thread::sleep_until(next);
+						next += cameraPeriod;
+						auto slot = buffer.tryWrite();
+						if (!slot) {
+							rejected++;
+							continue;
+						}
+						std::fill_n(slot.get(), frameSize, timestamp());
+						slot.commit();
+					}
+					done = true;
+				});
+
+				auto age{ 0.0 };
+				auto converted{ 0 };
+				while (!done) {
+					auto slot = buffer.tryRead();
+					if (!slot) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						continue;
+					}
+					age += 1e-6 * (timestamp() - slot.get()[0]);
+					converted++;
+					std::this_thread::sleep_for(conversionTime);
+				}
+				producer.join();
+				return { age / std::max(converted, 1), rejected };
+			}
+	};
+}
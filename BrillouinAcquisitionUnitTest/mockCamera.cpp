@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	static CAMERA_SETTINGS configureMockCamera(MockCamera* camera, int width, int height) {
+		camera->connectDevice();
+
+		auto settings = CAMERA_SETTINGS{ 0, 0 };
+		settings.roi.width_physical = width;
+		settings.roi.height_physical = height;
+		settings.frameCount = 1;
+		settings.readout.pixelEncoding = L"16 bit";
+		camera->setSettings(settings);
+		camera->setMaxRate(true);
+		return camera->getSettings();
+	}
+
+	TEST_CLASS(TestMockCamera) {
+		public:
+			TEST_METHOD(TestFramesAreReproducibleFromSeed) {
+				auto first = new MockCamera();
+				auto second = new MockCamera();
+				auto settings = configureMockCamera(first, 200, 100);
+				configureMockCamera(second, 200, 100);
+				first->setSeed(42);
+				second->setSeed(42);
+
+				auto size = (size_t)settings.roi.bytesPerFrame / sizeof(unsigned short);
+				auto imageFirst = std::vector<unsigned short>(size);
+				auto imageSecond = std::vector<unsigned short>(size);
+				auto previous = std::vector<unsigned short>{};
+				for (gsl::index i{ 0 }; i < 3; i++) {
+					first->getImageForAcquisition(reinterpret_cast<std::byte*>(imageFirst.data()), false);
+					second->getImageForAcquisition(reinterpret_cast<std::byte*>(imageSecond.data()), false);
+					Assert::IsTrue(imageFirst == imageSecond);
+					// consecutive frames have different noise
+					Assert::IsTrue(imageFirst != previous);
+					previous = imageFirst;
+				}
+
+				// a different seed gives different frames
+				second->setSeed(43);
+				first->setSeed(42);
+				first->getImageForAcquisition(reinterpret_cast<std::byte*>(imageFirst.data()), false);
+				second->getImageForAcquisition(reinterpret_cast<std::byte*>(imageSecond.data()), false);
+				Assert::IsTrue(imageFirst != imageSecond);
+
+				delete first;
+				delete second;
+			}
+
+			TEST_METHOD(TestBrillouinSpectrum) {
+				auto camera = new MockCamera();
+				auto settings = configureMockCamera(camera, 1000, 1000);
+				camera->setImageType(MOCK_IMAGE_TYPE::BRILLOUIN);
+
+				auto image = std::vector<unsigned short>((size_t)settings.roi.bytesPerFrame / sizeof(unsigned short));
+				camera->getImageForAcquisition(reinterpret_cast<std::byte*>(image.data()), false);
+
+				// the center row shows the Rayleigh peaks at 20 % and 80 % of the sensor width
+				// and the Stokes and anti-Stokes peaks at 38 % and 62 %
+				auto row = &image[500 * settings.roi.width_binned];
+				auto background = row[100];
+				Assert::IsTrue(row[200] > 5 * background);
+				Assert::IsTrue(row[800] > 5 * background);
+				Assert::IsTrue(row[380] > 2 * background);
+				Assert::IsTrue(row[620] > 2 * background);
+				Assert::IsTrue(row[200] > row[380]);
+				Assert::IsTrue(row[500] < row[380]);
+
+				delete camera;
+			}
+	};
+
+	TEST_CLASS(BenchmarkMockCamera) {
+		public:
+			TEST_METHOD(BenchmarkFrameRate) {
+				auto camera = new MockCamera();
+				auto settings = configureMockCamera(camera, 1000, 1000);
+
+				auto image = std::vector<unsigned short>((size_t)settings.roi.bytesPerFrame / sizeof(unsigned short));
+				auto frames{ 200 };
+				auto timer = QElapsedTimer{};
+				timer.start();
+				for (gsl::index i{ 0 }; i < frames; i++) {
+					camera->getImageForAcquisition(reinterpret_cast<std::byte*>(image.data()), false);
+				}
+				auto seconds = 1e-9 * timer.nsecsElapsed();
+
+				auto message = QString("Mock camera 1000x1000 16 bit: %1 frames/s\n")
+					.arg(frames / seconds, 0, 'f', 1);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				delete camera;
+			}
+	};
+}
@@ -0,0 +1,31 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Devices\ScanControls\MockScanControl.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestMockScanControl) {
+		public:
+			TEST_METHOD(TestMoveTakesTime) {
+				auto scanControl = MockScanControl{};
+				scanControl.connectDevice();
+				// 1 micrometer per ms, 5 ms settle time
+				scanControl.setMoveTimes(1, 5);
+
+				auto target = POINT3{ 20, 0, 0 };
+				auto timer = QElapsedTimer{};
+				timer.start();
+				scanControl.setPosition(target);
+				Assert::IsTrue(scanControl.waitForPosition(target));
+				Assert::IsTrue(timer.elapsed() >= 20);
+				Assert::AreEqual(20.0, scanControl.getPosition().x, 1e-6);
+
+				// a move which takes longer than the timeout is reported
+				target = POINT3{ 520, 0, 0 };
+				scanControl.setPosition(target);
+				Assert::IsFalse(scanControl.waitForPosition(target, 10));
+			}
+	};
+}
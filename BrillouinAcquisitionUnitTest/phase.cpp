@@ -189,4 +189,232 @@ namespace BrillouinAcquisitionUnitTest {
 			//	Assert::IsTrue(expected == output);
 			//}
 	};
+
+	/*
+	 * Off-axis hologram with a Gaussian phase bump of the given amplitude in the center
+	 */
+	static std::vector<unsigned short> createHologram(int dim_x, int dim_y, double amplitude) {
+		auto hologram = std::vector<unsigned short>((size_t)dim_x * dim_y);
+		for (gsl::index y{ 0 }; y < dim_y; y++) {
+			for (gsl::index x{ 0 }; x < dim_x; x++) {
+				auto r2 = pow(x - dim_x / 2.0, 2) + pow(y - dim_y / 2.0, 2);
+				auto phi = amplitude * exp(-r2 / (0.02 * dim_x * dim_y));
+				hologram[x + (size_t)dim_x * y] = (unsigned short)(1000 + 500 * cos(2 * M_PI * (0.21 * x + 0.27 * y) + phi));
+			}
+		}
+		return hologram;
+	}
+
+	TEST_CLASS(TestPhaseReconstruction) {
+		public:
+			TEST_METHOD(TestRecoversPhase) {
+				// square, non power of two and non-square images
+				for (const auto& [dim_x, dim_y] : std::vector<std::pair<int, int>>{ { 256, 256 }, { 300, 300 }, { 320, 240 } }) {
+					auto phaseCalculation = phase{};
+					auto background = createHologram(dim_x, dim_y, 0);
+					auto hologram = createHologram(dim_x, dim_y, 2);
+					auto result = std::vector<float>((size_t)dim_x * dim_y);
+					phaseCalculation.calculatePhase(&background[0], &result, dim_x, dim_y);
+					phaseCalculation.calculatePhase(&hologram[0], &result, dim_x, dim_y);
+					Assert::AreEqual(2.0, result[dim_x / 2 + (size_t)dim_x * (dim_y / 2)], 0.05);
+					Assert::AreEqual(0.0, result[10 + (size_t)dim_x * 10], 0.05);
+				}
+			}
+
+			TEST_METHOD(TestPlansAreReused) {
+				auto& plans = FFTWPlanCache::instance();
+				auto forward = plans.getPlan(128, 96, FFT_DIRECTION::FORWARD);
+				auto backward = plans.getPlan(128, 96, FFT_DIRECTION::BACKWARD);
+				Assert::IsTrue(forward != backward);
+				Assert::IsTrue(forward == plans.getPlan(128, 96, FFT_DIRECTION::FORWARD));
+				Assert::IsTrue(backward == plans.getPlan(128, 96, FFT_DIRECTION::BACKWARD));
+				Assert::IsTrue(forward != plans.getPlan(96, 128, FFT_DIRECTION::FORWARD));
+			}
+
+			TEST_METHOD(TestThreadsGiveSameResult) {
+				auto dim_x{ 320 };
+				auto dim_y{ 240 };
+				auto background = createHologram(dim_x, dim_y, 0);
+				auto hologram = createHologram(dim_x, dim_y, 2);
+				auto results = std::vector<std::vector<float>>{};
+				for (auto threads : { 1, 4 }) {
+					auto phaseCalculation = phase{ threads };
+					phaseCalculation.setUnwrapSettings({ UNWRAP_MODE::PYRAMID, 3 });
+					auto result = std::vector<float>((size_t)dim_x * dim_y);
+					phaseCalculation.calculatePhase(&background[0], &result, dim_x, dim_y);
+					phaseCalculation.calculatePhase(&hologram[0], &result, dim_x, dim_y);
+					results.push_back(result);
+				}
+				// the threaded FFT may round differently
+				for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
+					Assert::AreEqual(results[0][i], results[1][i], 1e-4f);
+				}
+			}
+	};
+
+	TEST_CLASS(TestUnwrapModes) {
+		public:
+			TEST_METHOD(TestModesRecoverPhase) {
+				auto dim_x{ 300 };
+				auto dim_y{ 240 };
+				auto background = createHologram(dim_x, dim_y, 0);
+				auto hologram = createHologram(dim_x, dim_y, 8);
+				auto modes = { UNWRAP_MODE::DOWNSAMPLED, UNWRAP_MODE::PYRAMID, UNWRAP_MODE::ADAPTIVE, UNWRAP_MODE::FULL };
+				for (auto mode : modes) {
+					auto phaseCalculation = phase{};
+					phaseCalculation.setUnwrapSettings({ mode, 3 });
+					auto result = std::vector<float>((size_t)dim_x * dim_y);
+					phaseCalculation.calculatePhase(&background[0], &result, dim_x, dim_y);
+					phaseCalculation.calculatePhase(&hologram[0], &result, dim_x, dim_y);
+					Assert::AreEqual(8.0, result[dim_x / 2 + (size_t)dim_x * (dim_y / 2)], 0.1);
+					Assert::AreEqual(0.0, result[10 + (size_t)dim_x * 10], 0.1);
+				}
+			}
+
+			TEST_METHOD(TestPyramidMatchesFullResolution) {
+				auto dim_x{ 320 };
+				auto dim_y{ 240 };
+				auto background = createHologram(dim_x, dim_y, 0);
+				auto hologram = createHologram(dim_x, dim_y, 8);
+				auto results = std::vector<std::vector<float>>{};
+				for (auto mode : { UNWRAP_MODE::FULL, UNWRAP_MODE::PYRAMID }) {
+					auto phaseCalculation = phase{};
+					phaseCalculation.setUnwrapSettings({ mode, 4 });
+					auto result = std::vector<float>((size_t)dim_x * dim_y);
+					phaseCalculation.calculatePhase(&background[0], &result, dim_x, dim_y);
+					phaseCalculation.calculatePhase(&hologram[0], &result, dim_x, dim_y);
+					results.push_back(result);
+				}
+				// both only differ by the median subtracted
+				auto offset = results[0][0] - results[1][0];
+				for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
+					Assert::AreEqual(results[0][i], results[1][i] + offset, 0.05f);
+				}
+			}
+
+			TEST_METHOD(TestAdaptiveFollowsBudget) {
+				auto size{ 256 };
+				auto hologram = createHologram(size, size, 2);
+				auto result = std::vector<float>((size_t)size * size);
+				auto phaseCalculation = phase{};
+
+				// a budget no frame can meet leads to the coarsest level
+				phaseCalculation.setUnwrapSettings({ UNWRAP_MODE::ADAPTIVE, 3, 1e-6 });
+				for (gsl::index i{ 0 }; i < 10; i++) {
+					phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+				}
+				Assert::AreEqual(12, phaseCalculation.getDownsampling());
+
+				// every frame meets a generous budget, so full resolution is reached
+				phaseCalculation.setUnwrapSettings({ UNWRAP_MODE::ADAPTIVE, 3, 1e6 });
+				for (gsl::index i{ 0 }; i < 10; i++) {
+					phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+				}
+				Assert::AreEqual(1, phaseCalculation.getDownsampling());
+			}
+	};
+
+	TEST_CLASS(BenchmarkPhaseReconstruction) {
+		public:
+			/*
+			 * Time of the first frame after an ROI change, which includes planning, and
+			 * of the following frames of the live phase preview
+			 */
+			TEST_METHOD(BenchmarkPhasePreview) {
+				for (auto size : { 256, 600, 1000 }) {
+					auto phaseCalculation = phase{};
+					auto hologram = createHologram(size, size, 2);
+					auto result = std::vector<float>((size_t)size * size);
+
+					auto timer = QElapsedTimer{};
+					timer.start();
+					phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+					auto first = 1e-6 * timer.nsecsElapsed();
+
+					auto frames{ 20 };
+					timer.start();
+					for (gsl::index i{ 0 }; i < frames; i++) {
+						phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+					}
+					auto phaseTime = 1e-6 * timer.nsecsElapsed() / frames;
+
+					timer.start();
+					for (gsl::index i{ 0 }; i < frames; i++) {
+						phaseCalculation.calculateSpectrum(&hologram[0], &result, size, size);
+					}
+					auto spectrumTime = 1e-6 * timer.nsecsElapsed() / frames;
+
+					auto message = QString("Phase %1x%1: first frame %2 ms, phase %3 ms, spectrum %4 ms\n")
+						.arg(size)
+						.arg(first, 0, 'f', 1)
+						.arg(phaseTime, 0, 'f', 2)
+						.arg(spectrumTime, 0, 'f', 2);
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+
+			/*
+			 * Frames per second of the live phase preview for 1024x1024 brightfield frames,
+			 * single-threaded and with one thread per core
+			 */
+			TEST_METHOD(BenchmarkPhaseThreads) {
+				auto size{ 1024 };
+				auto hologram = createHologram(size, size, 2);
+				auto result = std::vector<float>((size_t)size * size);
+				for (auto threads : { 1, ThreadPool::defaultThreadCount() }) {
+					auto phaseCalculation = phase{ threads };
+					// the first frame includes planning
+					phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+
+					auto frames{ 20 };
+					auto timer = QElapsedTimer{};
+					timer.start();
+					for (gsl::index i{ 0 }; i < frames; i++) {
+						phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+					}
+					auto seconds = 1e-9 * timer.nsecsElapsed();
+
+					auto message = QString("Phase %1x%1 with %2 threads: %3 frames/s\n")
+						.arg(size)
+						.arg(threads)
+						.arg(frames / seconds, 0, 'f', 1);
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+
+			/*
+			 * Time per 1024x1024 phase frame for every unwrapping mode
+			 */
+			TEST_METHOD(BenchmarkUnwrapModes) {
+				auto size{ 1024 };
+				auto hologram = createHologram(size, size, 2);
+				auto result = std::vector<float>((size_t)size * size);
+				auto modes = std::vector<std::pair<QString, UNWRAP_SETTINGS>>{
+					{ "downsampled by 3", { UNWRAP_MODE::DOWNSAMPLED, 3 } },
+					{ "pyramid from 3", { UNWRAP_MODE::PYRAMID, 3 } },
+					{ "adaptive, 50 ms budget", { UNWRAP_MODE::ADAPTIVE, 3, 50 } },
+					{ "full resolution", { UNWRAP_MODE::FULL } }
+				};
+				for (const auto& [name, settings] : modes) {
+					auto phaseCalculation = phase{};
+					phaseCalculation.setUnwrapSettings(settings);
+					phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+
+					auto frames{ 20 };
+					auto timer = QElapsedTimer{};
+					timer.start();
+					for (gsl::index i{ 0 }; i < frames; i++) {
+						phaseCalculation.calculatePhase(&hologram[0], &result, size, size);
+					}
+					auto phaseTime = 1e-6 * timer.nsecsElapsed() / frames;
+
+					auto message = QString("Phase %1x%1 %2: %3 ms per frame, downsampling %4\n")
+						.arg(size)
+						.arg(name)
+						.arg(phaseTime, 0, 'f', 1)
+						.arg(phaseCalculation.getDownsampling());
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\pipelineStage.h"
+#include "..\BrillouinAcquisition\src\storageWrapper.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+#include "..\BrillouinAcquisition\src\Devices\ScanControls\MockScanControl.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestPipelineStage) {
+		public:
+			TEST_METHOD(TestTasksRunInOrder) {
+				auto order = std::vector<int>{};
+				{
+					auto stage = PipelineStage{ 2 };
+					for (gsl::index i{ 0 }; i < 1000; i++) {
+						stage.push([&order, i]() { order.push_back((int)i); });
+					}
+					stage.finish();
+					Assert::AreEqual((size_t)1000, order.size());
+					for (gsl::index i{ 0 }; i < 1000; i++) {
+						Assert::AreEqual((int)i, order[i]);
+					}
+				}
+			}
+
+			TEST_METHOD(TestPendingTasksRunOnDestruction) {
+				auto count = std::atomic<int>{ 0 };
+				{
+					auto stage = PipelineStage{ 4 };
+					for (gsl::index i{ 0 }; i < 10; i++) {
+						stage.push([&count]() {
+							std::this_thread::sleep_for(std::chrono::milliseconds(1));
+							count++;
+						});
+					}
+				}
+				Assert::AreEqual(10, count.load());
+			}
+
+			TEST_METHOD(TestPushBlocksAtCapacity) {
+				auto release = std::atomic<bool>{ false };
+				auto stage = PipelineStage{ 1 };
+				// the first task occupies the worker, the second one fills the queue
+				stage.push([&release]() { while (!release) { std::this_thread::yield(); } });
+				stage.push([]() {});
+
+				auto pushed = std::atomic<bool>{ false };
+				auto producer = std::thread([&]() {
+					stage.push([]() {});
+					pushed = true;
+				});
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				Assert::IsFalse(pushed.load());
+
+				release = true;
+				producer.join();
+				stage.finish();
+				Assert::IsTrue(pushed.load());
+			}
+
+			TEST_METHOD(TestTryPushDoesNotBlock) {
+				auto started = std::atomic<bool>{ false };
+				auto release = std::atomic<bool>{ false };
+				auto stage = PipelineStage{ 1 };
+				stage.push([&]() {
+					started = true;
+					while (!release) { std::this_thread::yield(); }
+				});
+				while (!started) {
+					std::this_thread::yield();
+				}
+				Assert::IsTrue(stage.tryPush([]() {}));
+				// the queue is full
+				Assert::IsFalse(stage.tryPush([]() {}));
+
+				release = true;
+				stage.finish();
+				Assert::IsTrue(stage.tryPush([]() {}));
+				stage.finish();
+			}
+	};
+
+	TEST_CLASS(BenchmarkPipelinedAcquisition) {
+		public:
+			/*
+			 * Measure the dead time per position, i.e. the time per position which is not
+			 * spent exposing, once with the stage moved after the payload was handled and
+			 * once with the move overlapped with packaging the payload.
+			 */
+			TEST_METHOD(BenchmarkDeadTimePerPosition) {
+				auto camera = new MockCamera();
+				camera->connectDevice();
+
+				auto settings = CAMERA_SETTINGS{ 0, 0 };
+				settings.roi.width_physical = 200;
+				settings.roi.height_physical = 200;
+				settings.frameCount = 2;
+				settings.readout.pixelEncoding = L"16 bit";
+				camera->setSettings(settings);
+				camera->setCalibrationExposureTime(0);
+				settings = camera->getSettings();
+
+				auto scanControl = MockScanControl{};
+				scanControl.connectDevice();
+				// 0.5 micrometer per ms, 2 ms settle time, 1 micrometer steps
+				scanControl.setMoveTimes(0.5, 2);
+
+				auto positions{ 100 };
+				auto bytesPerImage = (long long)settings.roi.bytesPerFrame * settings.frameCount;
+				hsize_t dims[3] = { (hsize_t)settings.frameCount, (hsize_t)settings.roi.height_binned, (hsize_t)settings.roi.width_binned };
+				auto path = QDir::tempPath().toStdString() + "/BenchmarkDeadTimePerPosition.h5";
+
+				auto acquire = [&](bool pipelined) {
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.init();
+					storage.startWritingQueues();
+
+					// packages the images and hands them to the storage, as the Brillouin mode does
+					auto handlePayload = [&](gsl::index ll, std::vector<unsigned short> images) {
+						auto date = QDateTime::currentDateTime().toOffsetFromUtc(QDateTime::currentDateTime().offsetFromUtc())
+							.toString(Qt::ISODateWithMs).toStdString();
+						auto img = new IMAGE<unsigned short>((int)ll, 0, 0, 3, dims, date, std::move(images),
+							settings.exposureTime, settings.gain, settings.roi);
+						storage.s_enqueuePayload(img);
+					};
+
+					auto exposureTime = 0LL;
+					auto timer = QElapsedTimer{};
+					timer.start();
+					{
+						auto stage = PipelineStage{};
+						scanControl.setPosition(POINT3{ 0, 0, 0 });
+						for (gsl::index ll{ 0 }; ll < positions; ll++) {
+							scanControl.waitForPosition(POINT3{ (double)ll, 0, 0 });
+
+							auto exposure = QElapsedTimer{};
+							exposure.start();
+							auto images = std::vector<unsigned short>(bytesPerImage / sizeof(unsigned short));
+							auto buffer = reinterpret_cast<std::byte*>(images.data());
+							for (gsl::index mm{ 0 }; mm < settings.frameCount; mm++) {
+								camera->getImageForAcquisition(&buffer[settings.roi.bytesPerFrame * mm], false);
+							}
+							exposureTime += exposure.nsecsElapsed();
+
+							auto next = POINT3{ (double)ll + 1, 0, 0 };
+							if (pipelined) {
+								scanControl.setPosition(next);
+								stage.push([&, ll, images = std::move(images)]() mutable { handlePayload(ll, std::move(images)); });
+							} else {
+								handlePayload(ll, std::move(images));
+								scanControl.setPosition(next);
+							}
+						}
+					}
+					auto deadTime = 1e-6 * (timer.nsecsElapsed() - exposureTime) / positions;
+
+					storage.s_finishedQueueing();
+					while (storage.getStatistics().writtenPayloads < positions) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+					return deadTime;
+				};
+
+				auto sequential = acquire(false);
+				auto pipelined = acquire(true);
+
+				auto message = QString("Dead time per position: sequential %1 ms, pipelined %2 ms\n")
+					.arg(sequential, 0, 'f', 2)
+					.arg(pipelined, 0, 'f', 2);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::IsTrue(pipelined < sequential);
+
+				QFile::remove(QString::fromStdString(path));
+				delete camera;
+			}
+	};
+}
@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Acquisition\AcquisitionModes\ScanMask.h"
+#include "..\BrillouinAcquisition\src\Acquisition\AcquisitionModes\ScanPathPlanner.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Mask covering an image of (width, height) pixels, the first row is the top of the image as in the preview
+	 */
+	static SCAN_MASK emptyMask(int width, int height) {
+		auto mask = SCAN_MASK{};
+		mask.width = width;
+		mask.height = height;
+		mask.first = POINT2{ 0, height - 1.0 };
+		mask.last = POINT2{ width - 1.0, 0 };
+		mask.micrometerToPixX = POINT2{ 1, 0 };
+		mask.micrometerToPixY = POINT2{ 0, 1 };
+		return mask;
+	}
+
+	/*
+	 * Background with deterministic noise and a disk of another value
+	 */
+	static std::vector<double> diskImage(int width, int height, POINT2 center, double radius, double background, double disk, double noise) {
+		auto image = std::vector<double>((size_t)width * height);
+		for (gsl::index y{ 0 }; y < height; y++) {
+			for (gsl::index x{ 0 }; x < width; x++) {
+				auto inside = pow(x - center.x, 2) + pow(y - center.y, 2) < radius * radius;
+				auto pseudoRandom = ((x * 7919 + y * 104729) % 201) / 100.0 - 1;
+				image[y * width + x] = (inside ? disk : background) + noise * pseudoRandom;
+			}
+		}
+		return image;
+	}
+
+	static int countPixels(const SCAN_MASK& mask) {
+		return (int)std::count(mask.pixels.begin(), mask.pixels.end(), (unsigned char)1);
+	}
+
+	TEST_CLASS(TestScanMask) {
+		public:
+			TEST_METHOD(TestPolygon) {
+				auto mask = emptyMask(10, 10);
+				Assert::IsTrue(ScanMask::isEmpty(mask));
+
+				ScanMask::fillPolygon(mask, { { 1, 1 }, { 8, 1 }, { 8, 3 }, { 1, 3 } });
+				Assert::IsFalse(ScanMask::isEmpty(mask));
+				Assert::IsTrue(ScanMask::contains(mask, { 4, 2 }));
+				Assert::IsFalse(ScanMask::contains(mask, { 4, 7 }));
+				Assert::IsFalse(ScanMask::contains(mask, { 9, 2 }));
+				// pixels outside of the image are outside of the mask
+				Assert::IsFalse(ScanMask::contains(mask, { -20, 2 }));
+				// the rows are flipped, camera pixel y = 2 is the row 7 of the mask
+				Assert::AreEqual((unsigned char)1, mask.pixels[7 * 10 + 4]);
+				Assert::AreEqual((unsigned char)0, mask.pixels[2 * 10 + 4]);
+
+				// a triangle
+				ScanMask::fillPolygon(mask, { { 0, 0 }, { 9, 0 }, { 0, 9 } });
+				Assert::IsTrue(ScanMask::contains(mask, { 2, 2 }));
+				Assert::IsFalse(ScanMask::contains(mask, { 7, 7 }));
+
+				// less than three vertices do not enclose anything
+				ScanMask::fillPolygon(mask, { { 0, 0 }, { 9, 9 } });
+				Assert::IsTrue(ScanMask::isEmpty(mask));
+			}
+
+			TEST_METHOD(TestThresholdDarkCell) {
+				// a cell darker than the background in brightfield
+				auto mask = emptyMask(200, 150);
+				auto image = diskImage(200, 150, { 80, 70 }, 30, 100, 60, 15);
+				ScanMask::threshold(mask, image.data());
+
+				Assert::IsTrue(ScanMask::contains(mask, { 80, 150 - 1 - 70 }));
+				Assert::IsFalse(ScanMask::contains(mask, { 5, 5 }));
+				auto area = 3.14159 * 30 * 30;
+				Assert::AreEqual(area, (double)countPixels(mask), 0.1 * area);
+			}
+
+			TEST_METHOD(TestThresholdPhase) {
+				// a cell with a larger phase than the background, with pixels which are not a number
+				auto mask = emptyMask(120, 100);
+				auto image = diskImage(120, 100, { 60, 50 }, 20, 0, 2, 0.3);
+				for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i += 97) {
+					image[i] = NAN;
+				}
+				ScanMask::threshold(mask, image.data());
+
+				Assert::IsTrue(ScanMask::contains(mask, { 60, 49 }));
+				auto area = 3.14159 * 20 * 20;
+				Assert::AreEqual(area, (double)countPixels(mask), 0.1 * area);
+
+				// an image without structure does not throw
+				auto uniform = std::vector<unsigned short>(120 * 100, 100);
+				ScanMask::threshold(mask, uniform.data());
+			}
+
+			TEST_METHOD(TestSelect) {
+				auto mask = emptyMask(100, 100);
+				// 2 pix per micrometer, the start position is at the center of the image
+				mask.micrometerToPixX = POINT2{ 2, 0 };
+				mask.micrometerToPixY = POINT2{ 0, 2 };
+				mask.originPix = POINT2{ 50, 50 };
+				ScanMask::fillPolygon(mask, { { 40, 40 }, { 70, 40 }, { 70, 60 }, { 40, 60 } });
+
+				auto positions = std::vector<POINT3>{ { 0, 0, 0 }, { 8, 0, 5 }, { -8, 0, 0 }, { 0, 8, 0 }, { 0, -4, 10 } };
+				auto selected = ScanMask::select(mask, positions);
+				auto expected = std::vector<bool>{ true, true, false, false, true };
+				Assert::IsTrue(expected == selected);
+			}
+	};
+
+	TEST_CLASS(BenchmarkScanMask) {
+		public:
+			/*
+			 * A single cell in the center of a map, the mask is derived from the brightfield image
+			 */
+			TEST_METHOD(BenchmarkSingleCell) {
+				auto width{ 1000 };
+				auto height{ 1000 };
+				auto steps{ 20 };
+				auto mask = emptyMask(width, height);
+				// 10 pix per micrometer, the map covers 40 x 40 micrometer around the center of the image
+				mask.micrometerToPixX = POINT2{ 10, 0 };
+				mask.micrometerToPixY = POINT2{ 0, 10 };
+				mask.originPix = POINT2{ width / 2.0, height / 2.0 };
+				auto image = diskImage(width, height, { width / 2.0, height / 2.0 }, 140, 100, 70, 20);
+
+				QElapsedTimer timer;
+				timer.start();
+				ScanMask::threshold(mask, image.data());
+				auto thresholdTime = 1e-6 * timer.nsecsElapsed();
+
+				auto x = std::vector<double>(steps);
+				for (gsl::index i{ 0 }; i < steps; i++) {
+					x[i] = -20 + 40.0 * i / (steps - 1.0);
+				}
+				auto model = MOTION_MODEL{ { 1, 50 }, { 1, 50 }, { 0.5, 50 } };
+				auto path = ScanPathPlanner::plan(x, x, { 0 }, SCAN_ORDER{}, SCAN_PATH_SETTINGS{});
+				auto sparse = ScanPathPlanner::select(path, ScanMask::select(mask, path.positions), SCAN_PATH_SETTINGS{});
+				auto fullCost = ScanPathPlanner::estimateCost(path, model);
+				auto sparseCost = ScanPathPlanner::estimateCost(sparse, model);
+				auto skipped = 1 - (double)sparse.positions.size() / path.positions.size();
+
+				auto message = QString("Thresholding a %1x%2 pixel image: %3 ms, the sparse scan acquires %4 of %5 positions (%6 % skipped), travel %7 s instead of %8 s\n")
+					.arg(width)
+					.arg(height)
+					.arg(thresholdTime, 0, 'f', 1)
+					.arg(sparse.positions.size())
+					.arg(path.positions.size())
+					.arg(100 * skipped, 0, 'f', 0)
+					.arg(sparseCost.travelTime, 0, 'f', 1)
+					.arg(fullCost.travelTime, 0, 'f', 1);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::IsTrue(skipped > 0.5 && skipped < 0.8);
+				Assert::IsTrue(sparseCost.travelTime < fullCost.travelTime);
+			}
+	};
+}
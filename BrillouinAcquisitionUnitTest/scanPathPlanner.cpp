@@ -0,0 +1,219 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Acquisition\AcquisitionModes\ScanPathPlanner.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	static std::vector<double> coordinates(double min, double max, int steps) {
+		auto values = std::vector<double>(steps, min);
+		for (gsl::index i{ 1 }; i < steps; i++) {
+			values[i] = min + (max - min) * i / (steps - 1.0);
+		}
+		return values;
+	}
+
+	/*
+	 * Every grid point is visited exactly once and the vectors of the path have the same length
+	 */
+	static void assertComplete(const SCAN_PATH& path, int xSteps, int ySteps, int zSteps) {
+		auto nrPositions = (size_t)xSteps * ySteps * zSteps;
+		Assert::AreEqual(nrPositions, path.positions.size());
+		Assert::AreEqual(nrPositions, path.approachPositions.size());
+		Assert::AreEqual(nrPositions, path.indices.size());
+		Assert::AreEqual(nrPositions, path.calibrationAllowed.size());
+
+		auto visited = std::vector<bool>(nrPositions, false);
+		for (const auto& index : path.indices) {
+			auto linear = ((size_t)index.z * ySteps + index.y) * xSteps + index.x;
+			Assert::IsFalse(visited[linear]);
+			visited[linear] = true;
+		}
+	}
+
+	static SCAN_PATH_SETTINGS serpentine() {
+		auto settings = SCAN_PATH_SETTINGS{};
+		settings.pattern = SCAN_PATTERN::SERPENTINE;
+		return settings;
+	}
+
+	TEST_CLASS(TestScanPathPlanner) {
+		public:
+			TEST_METHOD(TestRaster) {
+				// raster is the default
+				auto settings = SCAN_PATH_SETTINGS{};
+				Assert::IsTrue(settings.pattern == SCAN_PATTERN::RASTER);
+				Assert::IsFalse(settings.unidirectionalApproach);
+				auto path = ScanPathPlanner::plan(coordinates(0, 2, 3), coordinates(0, 10, 2), { 5 }, SCAN_ORDER{}, settings);
+				assertComplete(path, 3, 2, 1);
+
+				// every line starts at the minimum of x
+				auto expected = std::vector<int>{ 0, 1, 2, 0, 1, 2 };
+				for (gsl::index ll{ 0 }; ll < (gsl::index)expected.size(); ll++) {
+					Assert::AreEqual(expected[ll], path.indices[ll].x);
+					Assert::AreEqual((double)expected[ll], path.positions[ll].x);
+					Assert::AreEqual(10.0 * path.indices[ll].y, path.positions[ll].y);
+					Assert::AreEqual(5.0, path.positions[ll].z);
+					Assert::AreEqual(expected[ll] == 0, (bool)path.calibrationAllowed[ll]);
+				}
+			}
+
+			TEST_METHOD(TestSerpentine) {
+				auto path = ScanPathPlanner::plan(coordinates(0, 2, 3), coordinates(0, 2, 3), { 0 }, SCAN_ORDER{}, serpentine());
+				assertComplete(path, 3, 3, 1);
+
+				auto expected = std::vector<int>{ 0, 1, 2, 2, 1, 0, 0, 1, 2 };
+				for (gsl::index ll{ 0 }; ll < (gsl::index)expected.size(); ll++) {
+					Assert::AreEqual(expected[ll], path.indices[ll].x);
+					Assert::AreEqual((int)ll / 3, path.indices[ll].y);
+					// a calibration is allowed at the start of every line, also of the reversed ones
+					Assert::AreEqual(ll % 3 == 0, (bool)path.calibrationAllowed[ll]);
+				}
+			}
+
+			TEST_METHOD(TestSerpentineAcrossPlanes) {
+				// y is scanned first, then x, then z
+				auto order = SCAN_ORDER{ false, 1, 0, 2 };
+				auto path = ScanPathPlanner::plan(coordinates(0, 3, 4), coordinates(0, 2, 3), coordinates(0, 1, 2), order, serpentine());
+				assertComplete(path, 4, 3, 2);
+
+				// consecutive positions are neighbours on the grid
+				for (gsl::index ll{ 1 }; ll < (gsl::index)path.indices.size(); ll++) {
+					auto step = std::abs(path.indices[ll].x - path.indices[ll - 1].x)
+						+ std::abs(path.indices[ll].y - path.indices[ll - 1].y)
+						+ std::abs(path.indices[ll].z - path.indices[ll - 1].z);
+					Assert::AreEqual(1, step);
+				}
+				Assert::AreEqual(1, path.indices[1].y);
+				Assert::AreEqual(0, path.indices[1].x);
+			}
+
+			TEST_METHOD(TestUnidirectionalApproach) {
+				auto settings = serpentine();
+				settings.unidirectionalApproach = true;
+				settings.hysteresisCompensation = 5;
+				auto path = ScanPathPlanner::plan(coordinates(0, 2, 3), coordinates(-1, 1, 2), { 0 }, SCAN_ORDER{}, settings);
+
+				// the first position lies below the start position in y, the second line is scanned towards lower x
+				auto expectedX = std::vector<double>{ 0, 1, 2, 2, -4, -5 };
+				auto expectedY = std::vector<double>{ -6, -1, -1, 1, 1, 1 };
+				for (gsl::index ll{ 0 }; ll < (gsl::index)expectedX.size(); ll++) {
+					Assert::AreEqual(expectedX[ll], path.approachPositions[ll].x, 1e-9);
+					Assert::AreEqual(expectedY[ll], path.approachPositions[ll].y, 1e-9);
+					Assert::AreEqual(path.positions[ll].z, path.approachPositions[ll].z);
+				}
+			}
+
+			TEST_METHOD(TestSelect) {
+				auto settings = serpentine();
+				settings.unidirectionalApproach = true;
+				settings.hysteresisCompensation = 5;
+				auto path = ScanPathPlanner::plan(coordinates(0, 3, 4), coordinates(0, 2, 3), { 0 }, SCAN_ORDER{}, settings);
+
+				// skip the first position of the second line and the whole third line
+				auto selected = std::vector<bool>{ true, true, true, true, false, true, true, true, false, false, false, false };
+				auto selection = ScanPathPlanner::select(path, selected, settings);
+				Assert::AreEqual((size_t)7, selection.positions.size());
+				Assert::AreEqual(selection.positions.size(), selection.approachPositions.size());
+				Assert::AreEqual(selection.positions.size(), selection.indices.size());
+				Assert::AreEqual(selection.positions.size(), selection.calibrationAllowed.size());
+
+				auto expectedX = std::vector<int>{ 0, 1, 2, 3, 2, 1, 0 };
+				auto expectedCalibration = std::vector<bool>{ true, false, false, false, true, false, false };
+				for (gsl::index ll{ 0 }; ll < (gsl::index)expectedX.size(); ll++) {
+					Assert::AreEqual(expectedX[ll], selection.indices[ll].x);
+					Assert::AreEqual((double)expectedX[ll], selection.positions[ll].x);
+					Assert::AreEqual((bool)expectedCalibration[ll], (bool)selection.calibrationAllowed[ll]);
+				}
+
+				// the approach depends on the previous selected position
+				Assert::AreEqual(1.0 - 5.0, path.approachPositions[6].x, 1e-9);
+				selected = std::vector<bool>(path.positions.size(), false);
+				selected[0] = true;
+				selected[6] = true;
+				selection = ScanPathPlanner::select(path, selected, settings);
+				Assert::AreEqual(1, selection.indices[1].x);
+				Assert::AreEqual(1.0, selection.approachPositions[1].x, 1e-9);
+				Assert::IsTrue(selection.calibrationAllowed[1]);
+			}
+
+			TEST_METHOD(TestCost) {
+				auto model = MOTION_MODEL{ { 1, 10 }, { 1, 10 }, { 1, 10 } };
+				auto raster = SCAN_PATH_SETTINGS{};
+				raster.pattern = SCAN_PATTERN::RASTER;
+				auto cost = ScanPathPlanner::estimateCost(
+					ScanPathPlanner::plan(coordinates(0, 2, 3), coordinates(0, 1, 2), { 0 }, SCAN_ORDER{}, raster), model);
+				Assert::AreEqual(6, cost.positions);
+				Assert::AreEqual(6, cost.moves);
+				Assert::AreEqual(0.068, cost.travelTime, 1e-9);
+
+				// the fly-back is replaced by a step of the slow axis
+				cost = ScanPathPlanner::estimateCost(
+					ScanPathPlanner::plan(coordinates(0, 2, 3), coordinates(0, 1, 2), { 0 }, SCAN_ORDER{}, serpentine()), model);
+				Assert::AreEqual(6, cost.moves);
+				Assert::AreEqual(0.066, cost.travelTime, 1e-9);
+				Assert::AreEqual(6.0, cost.distance, 1e-9);
+			}
+
+			TEST_METHOD(TestFastestOrder) {
+				auto model = MOTION_MODEL{ { 1, 0 }, { 1, 0 }, { 1, 0 } };
+				auto preferred = SCAN_ORDER{ true, 0, 1, 2 };
+
+				// long lines along x with many steps are slower than scanning the short y-direction first
+				auto order = ScanPathPlanner::fastestOrder(coordinates(0, 100, 10), coordinates(0, 5, 3), { 0 }, preferred, serpentine(), model);
+				Assert::AreEqual(1, order.x);
+				Assert::AreEqual(0, order.y);
+				Assert::AreEqual(2, order.z);
+				Assert::IsTrue(order.automatical);
+
+				// a symmetric grid keeps the preferred order
+				order = ScanPathPlanner::fastestOrder(coordinates(0, 10, 3), coordinates(0, 10, 3), { 0 }, preferred, serpentine(), model);
+				Assert::AreEqual(0, order.x);
+				Assert::AreEqual(1, order.y);
+				Assert::AreEqual(2, order.z);
+			}
+	};
+
+	TEST_CLASS(BenchmarkScanPathPlanner) {
+		public:
+			/*
+			 * Estimated travel time of a map with a raster and a serpentine, and the time it takes to
+			 * find the fastest order, which is done whenever the area of interest changes.
+			 */
+			TEST_METHOD(BenchmarkMap) {
+				auto steps{ 50 };
+				auto model = MOTION_MODEL{ { 1, 50 }, { 1, 50 }, { 0.5, 50 } };
+				auto x = coordinates(0, 49, steps);
+				auto y = coordinates(0, 49, steps);
+				auto z = std::vector<double>{ 0 };
+
+				auto raster = SCAN_PATH_SETTINGS{};
+				raster.pattern = SCAN_PATTERN::RASTER;
+				auto rasterCost = ScanPathPlanner::estimateCost(ScanPathPlanner::plan(x, y, z, SCAN_ORDER{}, raster), model);
+				auto serpentineCost = ScanPathPlanner::estimateCost(ScanPathPlanner::plan(x, y, z, SCAN_ORDER{}, serpentine()), model);
+
+				QElapsedTimer timer;
+				timer.start();
+				auto order = ScanPathPlanner::fastestOrder(x, y, coordinates(0, 9, 10), SCAN_ORDER{}, serpentine(), model);
+				auto planningTime = 1e-6 * timer.nsecsElapsed();
+
+				auto message = QString("%1x%2 map: raster %3 s travel (%4 mm), serpentine %5 s travel (%6 mm), fastest order (%7, %8, %9) of %10 positions found in %11 ms\n")
+					.arg(steps)
+					.arg(steps)
+					.arg(rasterCost.travelTime, 0, 'f', 1)
+					.arg(1e-3 * rasterCost.distance, 0, 'f', 2)
+					.arg(serpentineCost.travelTime, 0, 'f', 1)
+					.arg(1e-3 * serpentineCost.distance, 0, 'f', 2)
+					.arg(order.x)
+					.arg(order.y)
+					.arg(order.z)
+					.arg(10 * steps * steps)
+					.arg(planningTime, 0, 'f', 1);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::AreEqual(rasterCost.moves, serpentineCost.moves);
+				Assert::IsTrue(serpentineCost.travelTime < rasterCost.travelTime);
+			}
+	};
+}
@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\spotDetection.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Camera image with a Gaussian spot on a constant offset and a little noise
+	 */
+	template <typename T>
+	std::vector<T> createSpot(int dim_x, int dim_y, double x0, double y0, double sigma, double amplitude,
+		double offset = 20, double noise = 2) {
+		auto image = std::vector<T>((size_t)dim_x * dim_y);
+		auto generator = std::mt19937{ 42 };
+		auto distribution = std::normal_distribution<double>{ 0, noise };
+		for (gsl::index y{ 0 }; y < dim_y; y++) {
+			for (gsl::index x{ 0 }; x < dim_x; x++) {
+				auto r2 = pow(x - x0, 2) + pow(y - y0, 2);
+				auto value = offset + amplitude * exp(-r2 / (2 * sigma * sigma)) + distribution(generator);
+				image[x + dim_x * y] = (T)std::clamp(round(value), 0.0, (double)std::numeric_limits<T>::max());
+			}
+		}
+		return image;
+	}
+
+	TEST_CLASS(TestSpotDetection) {
+		public:
+			TEST_METHOD(TestGaussianSubPixel) {
+				auto detection = spotDetection{ 1 };
+				for (auto [x0, y0] : { std::make_pair(100.3, 50.7), std::make_pair(20.5, 120.0), std::make_pair(200.8, 10.2) }) {
+					auto image = createSpot<unsigned short>(256, 128, x0, y0, 1.5, 2000);
+					auto spot = detection.locate(&image[0], 256, 128);
+					Assert::AreEqual(x0, spot.x, 0.1);
+					Assert::AreEqual(y0, spot.y, 0.1);
+				}
+			}
+
+			TEST_METHOD(TestCentroidSubPixel) {
+				auto detection = spotDetection{ 1 };
+				auto settings = SPOT_SETTINGS{};
+				settings.refinement = SPOT_REFINEMENT::CENTROID;
+				settings.radius = 5;
+				detection.setSettings(settings);
+				auto image = createSpot<unsigned short>(256, 128, 100.3, 50.7, 1.5, 2000);
+				auto spot = detection.locate(&image[0], 256, 128);
+				Assert::AreEqual(100.3, spot.x, 0.1);
+				Assert::AreEqual(50.7, spot.y, 0.1);
+			}
+
+			TEST_METHOD(TestNoRefinement) {
+				auto detection = spotDetection{ 1 };
+				auto settings = SPOT_SETTINGS{};
+				settings.refinement = SPOT_REFINEMENT::NONE;
+				detection.setSettings(settings);
+				auto image = createSpot<unsigned char>(64, 64, 30.2, 40.9, 1.0, 200, 10, 0);
+				auto spot = detection.locate(&image[0], 64, 64);
+				Assert::AreEqual(30.0, spot.x);
+				Assert::AreEqual(41.0, spot.y);
+				Assert::AreEqual((double)image[30 + 64 * 41], spot.intensity);
+			}
+
+			/*
+			 * A single hot pixel brighter than the spot must not be taken for the spot
+			 */
+			TEST_METHOD(TestHotPixelIsIgnored) {
+				auto detection = spotDetection{ 1 };
+				auto image = createSpot<unsigned short>(256, 128, 100.3, 50.7, 1.5, 2000);
+				image[10 + 256 * 10] = 4000;
+				auto spot = detection.locate(&image[0], 256, 128);
+				Assert::AreEqual(100.3, spot.x, 0.1);
+				Assert::AreEqual(50.7, spot.y, 0.1);
+			}
+
+			TEST_METHOD(TestBackgroundSubtraction) {
+				auto detection = spotDetection{ 1 };
+				// a bright gradient outshines the spot without background subtraction
+				auto background = std::vector<unsigned short>((size_t)256 * 128);
+				for (gsl::index y{ 0 }; y < 128; y++) {
+					for (gsl::index x{ 0 }; x < 256; x++) {
+						background[x + 256 * y] = (unsigned short)(10 * x);
+					}
+				}
+				auto image = createSpot<unsigned short>(256, 128, 60.4, 70.6, 1.5, 1000, 0, 0);
+				for (gsl::index i{ 0 }; i < (gsl::index)image.size(); i++) {
+					image[i] += background[i];
+				}
+				auto spot = detection.locate(&image[0], 256, 128);
+				Assert::IsTrue(spot.x > 200);
+
+				detection.setBackground(&background[0], 256, 128);
+				spot = detection.locate(&image[0], 256, 128);
+				Assert::AreEqual(60.4, spot.x, 0.1);
+				Assert::AreEqual(70.6, spot.y, 0.1);
+				Assert::AreEqual(1000.0, spot.intensity, 100.0);
+
+				// a background of another size is not applied
+				spot = detection.locate(&image[0], 128, 256);
+				Assert::IsTrue(spot.intensity > 2000);
+
+				detection.clearBackground();
+				spot = detection.locate(&image[0], 256, 128);
+				Assert::IsTrue(spot.x > 200);
+			}
+
+			TEST_METHOD(TestSpotAtTheBorder) {
+				auto detection = spotDetection{ 1 };
+				auto image = createSpot<unsigned short>(64, 64, 0, 63, 1.0, 2000, 20, 0);
+				auto spot = detection.locate(&image[0], 64, 64);
+				Assert::AreEqual(0.0, spot.x);
+				Assert::AreEqual(63.0, spot.y);
+
+				// images too small for a neighbourhood
+				auto line = std::vector<unsigned short>{ 1, 5, 3, 2 };
+				spot = detection.locate(&line[0], 4, 1);
+				Assert::AreEqual(1.0, spot.x);
+				Assert::AreEqual(0.0, spot.y);
+			}
+
+			TEST_METHOD(TestThreadsGiveSameResult) {
+				auto single = spotDetection{ 1 };
+				auto multiple = spotDetection{ 4 };
+				// two equally bright spots, the first one has to win independent of the blocks
+				auto image = std::vector<unsigned short>((size_t)640 * 480, 10);
+				for (auto [x0, y0] : { std::make_pair(300, 400), std::make_pair(100, 50) }) {
+					for (gsl::index y{ y0 - 1 }; y <= y0 + 1; y++) {
+						for (gsl::index x{ x0 - 1 }; x <= x0 + 1; x++) {
+							image[x + 640 * y] = (x == x0 && y == y0) ? 1000 : 500;
+						}
+					}
+				}
+				auto spotSingle = single.locate(&image[0], 640, 480);
+				auto spotMultiple = multiple.locate(&image[0], 640, 480);
+				Assert::AreEqual(100.0, spotSingle.x, 0.5);
+				Assert::AreEqual(50.0, spotSingle.y, 0.5);
+				Assert::AreEqual(spotSingle.x, spotMultiple.x);
+				Assert::AreEqual(spotSingle.y, spotMultiple.y);
+				Assert::AreEqual(spotSingle.intensity, spotMultiple.intensity);
+			}
+	};
+
+	TEST_CLASS(BenchmarkSpotDetection) {
+		public:
+			/*
+			 * Compare the spot detection with the plain maximum search it replaced
+			 */
+			TEST_METHOD(BenchmarkLocate) {
+				benchmark<unsigned short>(1280, 1024);
+				benchmark<unsigned short>(640, 480);
+				benchmark<unsigned char>(1280, 1024);
+			}
+
+		private:
+			template <typename T>
+			void benchmark(int dim_x, int dim_y) {
+				auto image = createSpot<T>(dim_x, dim_y, dim_x / 3.0, dim_y / 4.0, 2.0, 200);
+				auto repetitions{ 50 };
+
+				auto timer = QElapsedTimer{};
+				timer.start();
+				size_t index{ 0 };
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					index += std::distance(image.begin(), std::max_element(image.begin(), image.end()));
+				}
+				auto referenceTime = 1e-6 * timer.nsecsElapsed() / repetitions;
+
+				for (auto threads : { 1, ThreadPool::defaultThreadCount() }) {
+					auto detection = spotDetection{ threads };
+					timer.start();
+					for (gsl::index i{ 0 }; i < repetitions; i++) {
+						auto spot = detection.locate(&image[0], dim_x, dim_y);
+						index += (size_t)spot.x;
+					}
+					auto time = 1e-6 * timer.nsecsElapsed() / repetitions;
+					Logger::WriteMessage(QString("%1x%2 (%3 bytes), %4 threads: max_element %5 ms, spot detection %6 ms")
+						.arg(dim_x).arg(dim_y).arg(sizeof(T)).arg(threads).arg(referenceTime).arg(time).toStdString().c_str());
+				}
+				Assert::IsTrue(index > 0);
+			}
+	};
+}
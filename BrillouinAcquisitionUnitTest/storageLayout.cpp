@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\storageWrapper.h"
+#include "..\BrillouinAcquisition\src\chunkedPayload.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Waits until the writer wrote the given number of payloads, returns false after the timeout
+	 */
+	static bool waitForWritten(StorageWrapper& storage, long long count, int timeout = 10000) {
+		auto timer = QElapsedTimer{};
+		timer.start();
+		while (storage.getStatistics().writtenPayloads < count) {
+			if (timer.elapsed() > timeout) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	TEST_CLASS(TestStorageLayout) {
+		public:
+			/*
+			 * Write a Brillouin repetition with the chunked layout and read it back through the repetition
+			 */
+			TEST_METHOD(TestChunkedReadBack) {
+				auto positions{ 5 };
+				hsize_t dims[3] = { 2, 3, 4 };
+				auto date = std::string{ "2020-11-02T12:00:00.000+01:00" };
+				auto roi = CAMERA_ROI{};
+				auto path = QDir::tempPath().toStdString() + "/TestStorageLayout.h5";
+				{
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					storage.setStorageSettings({ 16, BACKPRESSURE_POLICY::BLOCK, STORAGE_LAYOUT::CHUNKED, 1 });
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.init();
+					storage.startWritingQueues();
+					for (gsl::index ll{ 0 }; ll < positions; ll++) {
+						// every position gets its own values
+						auto data = std::vector<unsigned short>(2 * 3 * 4);
+						for (gsl::index i{ 0 }; i < (gsl::index)data.size(); i++) {
+							data[i] = (unsigned short)(100 * ll + i);
+						}
+						storage.s_enqueuePayload(new IMAGE<unsigned short>((int)ll, 2 * (int)ll, 1, 3, dims, date, data, 0.5, 1, roi));
+					}
+					storage.s_finishedQueueing();
+					Assert::IsTrue(waitForWritten(storage, positions));
+					Assert::AreEqual(0LL, storage.getStatistics().failedPayloads);
+				}
+
+				{
+					auto file = H5::H5File(path, H5F_ACC_RDONLY);
+					auto repetition = file.openGroup("/Brillouin/0");
+					auto version{ 0 };
+					repetition.openAttribute("layoutVersion").read(H5::PredType::NATIVE_INT, &version);
+					Assert::AreEqual(ChunkedPayload::LAYOUT_VERSION, version);
+
+					auto dataset = file.openDataSet("/Brillouin/0/payloadChunked/data");
+					hsize_t size[4];
+					Assert::AreEqual(4, dataset.getSpace().getSimpleExtentDims(size));
+					Assert::AreEqual((hsize_t)positions, size[0]);
+					Assert::AreEqual(dims[0], size[1]);
+					Assert::AreEqual(dims[1], size[2]);
+					Assert::AreEqual(dims[2], size[3]);
+
+					auto data = std::vector<unsigned short>(positions * 2 * 3 * 4);
+					dataset.read(data.data(), H5::PredType::NATIVE_USHORT);
+					auto indices = std::vector<int>(3 * positions);
+					file.openDataSet("/Brillouin/0/payloadChunked/indices").read(indices.data(), H5::PredType::NATIVE_INT);
+
+					// the writer keeps the order of the queue
+					for (gsl::index ll{ 0 }; ll < positions; ll++) {
+						Assert::AreEqual((int)ll, indices[3 * ll]);
+						Assert::AreEqual(2 * (int)ll, indices[3 * ll + 1]);
+						Assert::AreEqual(1, indices[3 * ll + 2]);
+						for (gsl::index i{ 0 }; i < 2 * 3 * 4; i++) {
+							Assert::AreEqual((unsigned short)(100 * ll + i), data[ll * 2 * 3 * 4 + i]);
+						}
+					}
+				}
+				QFile::remove(QString::fromStdString(path));
+			}
+	};
+
+	TEST_CLASS(BenchmarkStorageLayout) {
+		public:
+			/*
+			 * Write the same Brillouin repetition with the per-position and the chunked layout
+			 * and compare throughput and file size.
+			 */
+			TEST_METHOD(BenchmarkPerPositionVsChunked) {
+				auto camera = new MockCamera();
+				camera->connectDevice();
+
+				auto settings = CAMERA_SETTINGS{ 0, 0 };
+				settings.roi.width_physical = 64;
+				settings.roi.height_physical = 64;
+				settings.frameCount = 2;
+				settings.readout.pixelEncoding = L"16 bit";
+				camera->setSettings(settings);
+				camera->setCalibrationExposureTime(0);
+				settings = camera->getSettings();
+
+				// acquire the images once, so that only writing is measured
+				auto positions{ 2000 };
+				auto bytesPerImage = (long long)settings.roi.bytesPerFrame * settings.frameCount;
+				auto images = std::vector<std::vector<unsigned short>>(positions);
+				for (auto& image : images) {
+					image.resize(bytesPerImage / sizeof(unsigned short));
+					auto buffer = reinterpret_cast<std::byte*>(image.data());
+					for (gsl::index mm{ 0 }; mm < settings.frameCount; mm++) {
+						camera->getImageForAcquisition(&buffer[settings.roi.bytesPerFrame * mm], false);
+					}
+				}
+				hsize_t dims[3] = { (hsize_t)settings.frameCount, (hsize_t)settings.roi.height_binned, (hsize_t)settings.roi.width_binned };
+				auto date = std::string{ "2020-11-02T12:00:00.000+01:00" };
+
+				auto layouts = std::vector<std::pair<std::string, STORAGE_SETTINGS>>{
+					{ "per position", { 2048, BACKPRESSURE_POLICY::BLOCK, STORAGE_LAYOUT::PER_POSITION, 0 } },
+					{ "chunked", { 2048, BACKPRESSURE_POLICY::BLOCK, STORAGE_LAYOUT::CHUNKED, 0 } },
+					{ "chunked, compressed", { 2048, BACKPRESSURE_POLICY::BLOCK, STORAGE_LAYOUT::CHUNKED, 1 } }
+				};
+				auto fileSizes = std::vector<qint64>{};
+				for (const auto& [name, storageSettings] : layouts) {
+					auto path = QDir::tempPath().toStdString() + "/BenchmarkStorageLayout.h5";
+					auto timer = QElapsedTimer{};
+					timer.start();
+					{
+						auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+						storage.setStorageSettings(storageSettings);
+						storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+						storage.init();
+						storage.startWritingQueues();
+						for (gsl::index ll{ 0 }; ll < positions; ll++) {
+							auto img = new IMAGE<unsigned short>((int)(ll % 100), (int)(ll / 100), 0, 3, dims, date, images[ll],
+								settings.exposureTime, settings.gain, settings.roi);
+							storage.s_enqueuePayload(img);
+						}
+						storage.s_finishedQueueing();
+						Assert::IsTrue(waitForWritten(storage, positions, 120000));
+					}
+					auto seconds = 1e-9 * timer.nsecsElapsed();
+					auto fileSize = QFileInfo(QString::fromStdString(path)).size();
+					fileSizes.push_back(fileSize);
+
+					auto message = QString("Storage layout %1: %2 MB/s, file size %3 MB\n")
+						.arg(QString::fromStdString(name))
+						.arg(1e-6 * bytesPerImage * positions / seconds, 0, 'f', 1)
+						.arg(1e-6 * fileSize, 0, 'f', 1);
+					Logger::WriteMessage(message.toStdString().c_str());
+					QFile::remove(QString::fromStdString(path));
+				}
+
+				// the chunked layout must not carry the metadata overhead of one dataset per position
+				Assert::IsTrue(fileSizes[1] < fileSizes[0]);
+				Assert::IsTrue(fileSizes[2] < fileSizes[1]);
+
+				delete camera;
+			}
+	};
+}
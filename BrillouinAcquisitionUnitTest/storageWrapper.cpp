@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\storageWrapper.h"
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Image of about 600 kB, the values depend on the index of the position
+	 */
+	static IMAGE<unsigned short>* testImage(int index) {
+		hsize_t dims[3] = { 1, 512, 600 };
+		auto data = std::vector<unsigned short>(1 * 512 * 600);
+		for (gsl::index i{ 0 }; i < (gsl::index)data.size(); i++) {
+			data[i] = (unsigned short)(index + i);
+		}
+		auto date = std::string{ "2020-11-02T12:00:00.000+01:00" };
+		return new IMAGE<unsigned short>(index, 0, 0, 3, dims, date, data, 0.5, 1, CAMERA_ROI{});
+	}
+
+	/*
+	 * Waits until the writer wrote the given number of payloads, returns false after ten seconds
+	 */
+	static bool waitForWritten(StorageWrapper& storage, long long count) {
+		auto timer = QElapsedTimer{};
+		timer.start();
+		while (storage.getStatistics().writtenPayloads < count) {
+			if (timer.elapsed() > 10000) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	TEST_CLASS(TestStorageWrapper) {
+		public:
+			TEST_METHOD(TestWriterThread) {
+				auto path = QDir::tempPath().toStdString() + "/TestStorageWrapper.h5";
+				{
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.init();
+					storage.startWritingQueues();
+					for (gsl::index ll{ 0 }; ll < 10; ll++) {
+						storage.s_enqueuePayload(testImage((int)ll));
+					}
+					storage.s_finishedQueueing();
+					Assert::IsTrue(waitForWritten(storage, 10));
+
+					auto statistics = storage.getStatistics();
+					Assert::AreEqual(10, storage.m_writtenImagesNr.load());
+					Assert::AreEqual(0, statistics.queueDepth);
+					Assert::AreEqual(0LL, statistics.queuedBytes);
+					Assert::AreEqual(0LL, statistics.failedPayloads);
+				}
+				QFile::remove(QString::fromStdString(path));
+			}
+
+			TEST_METHOD(TestBackpressureBlocks) {
+				auto path = QDir::tempPath().toStdString() + "/TestStorageWrapper.h5";
+				{
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					// room for a single image
+					storage.setStorageSettings({ 1, BACKPRESSURE_POLICY::BLOCK });
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.startWritingQueues();
+
+					auto producer = std::thread([&storage]() {
+						for (gsl::index ll{ 0 }; ll < 5; ll++) {
+							storage.s_enqueuePayload(testImage((int)ll));
+						}
+						storage.s_finishedQueueing();
+					});
+
+					// the writer is not running yet, so the producer waits behind the first image
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+					Assert::AreEqual(1, storage.getStatistics().queueDepth);
+
+					storage.init();
+					producer.join();
+					Assert::IsTrue(waitForWritten(storage, 5));
+
+					auto statistics = storage.getStatistics();
+					Assert::AreEqual(1, statistics.maxQueueDepth);
+					Assert::AreEqual(0LL, statistics.spilledPayloads);
+				}
+				QFile::remove(QString::fromStdString(path));
+			}
+
+			TEST_METHOD(TestBackpressureSpills) {
+				auto path = QDir::tempPath().toStdString() + "/TestStorageWrapper.h5";
+				auto count{ 5 };
+				{
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					storage.setStorageSettings({ 1, BACKPRESSURE_POLICY::SPILL, STORAGE_LAYOUT::CHUNKED });
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.startWritingQueues();
+
+					// the writer is not running yet, all images but the first one are spilled without blocking
+					for (gsl::index ll{ 0 }; ll < count; ll++) {
+						storage.s_enqueuePayload(testImage((int)ll));
+					}
+					auto statistics = storage.getStatistics();
+					Assert::AreEqual(count, statistics.queueDepth);
+					Assert::AreEqual(count - 1LL, statistics.spilledPayloads);
+					Assert::IsTrue(QFile::exists(QString::fromStdString(path + ".spill")));
+
+					storage.init();
+					storage.s_finishedQueueing();
+					Assert::IsTrue(waitForWritten(storage, count));
+				}
+				// the spill file is removed once all payloads are written
+				Assert::IsFalse(QFile::exists(QString::fromStdString(path + ".spill")));
+
+				// the spilled image data arrives unchanged in the file
+				{
+					auto file = H5::H5File(path, H5F_ACC_RDONLY);
+					auto dataset = file.openDataSet("/Brillouin/0/payloadChunked/data");
+					auto data = std::vector<unsigned short>((size_t)count * 512 * 600);
+					dataset.read(data.data(), H5::PredType::NATIVE_USHORT);
+					for (gsl::index ll{ 0 }; ll < count; ll++) {
+						auto expected = testImage((int)ll);
+						Assert::IsTrue(std::equal(expected->data.begin(), expected->data.end(), data.begin() + ll * 512 * 600));
+						delete expected;
+					}
+				}
+				QFile::remove(QString::fromStdString(path));
+			}
+
+			TEST_METHOD(TestStartAfterAbort) {
+				auto path = QDir::tempPath().toStdString() + "/TestStorageWrapper.h5";
+				{
+					auto storage = StorageWrapper{ nullptr, path, H5F_ACC_TRUNC };
+					storage.newRepetition(ACQUISITION_MODE::BRILLOUIN);
+					storage.startWritingQueues();
+					for (gsl::index ll{ 0 }; ll < 3; ll++) {
+						storage.s_enqueuePayload(testImage((int)ll));
+					}
+					// the aborted payloads are discarded
+					storage.stopWritingQueues();
+					storage.init();
+					auto timer = QElapsedTimer{};
+					timer.start();
+					while (storage.getStatistics().queueDepth > 0 && timer.elapsed() < 10000) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+					Assert::AreEqual(0, storage.getStatistics().queueDepth);
+					Assert::AreEqual(0LL, storage.getStatistics().writtenPayloads);
+
+					// payloads enqueued right after starting again are written
+					storage.startWritingQueues();
+					for (gsl::index ll{ 0 }; ll < 3; ll++) {
+						storage.s_enqueuePayload(testImage((int)ll));
+					}
+					storage.s_finishedQueueing();
+					Assert::IsTrue(waitForWritten(storage, 3));
+				}
+				QFile::remove(QString::fromStdString(path));
+			}
+	};
+}
@@ -0,0 +1,47 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\threadPool.h"
+
+#include <atomic>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	TEST_CLASS(TestThreadPool) {
+		public:
+			TEST_METHOD(TestEveryIndexIsVisitedOnce) {
+				for (auto threads : { 1, 2, 4, 8 }) {
+					auto pool = ThreadPool{ threads };
+					Assert::AreEqual(threads, pool.threadCount());
+					for (auto count : { 0, 1, 7, 1000, 1023 }) {
+						auto visits = std::vector<int>(count, 0);
+						pool.parallelFor(count, [&visits](gsl::index begin, gsl::index end) {
+							for (gsl::index i{ begin }; i < end; i++) {
+								visits[i]++;
+							}
+						});
+						for (const auto& visit : visits) {
+							Assert::AreEqual(1, visit);
+						}
+					}
+				}
+			}
+
+			TEST_METHOD(TestLoopsFromSeveralThreads) {
+				auto pool = ThreadPool{ 4 };
+				auto sum = std::atomic<long long>{ 0 };
+				auto loop = [&]() {
+					for (gsl::index i{ 0 }; i < 100; i++) {
+						pool.parallelFor(100, [&sum](gsl::index begin, gsl::index end) {
+							sum += end - begin;
+						});
+					}
+				};
+				auto other = std::thread(loop);
+				loop();
+				other.join();
+				Assert::AreEqual(20000LL, sum.load());
+			}
+	};
+}
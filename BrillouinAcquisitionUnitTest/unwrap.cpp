@@ -3,6 +3,8 @@
 #include "..\BrillouinAcquisition\src\unwrap2Wrapper.h"
 #include "..\BrillouinAcquisition\src\simplemath.h"
 
+#include <random>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace BrillouinAcquisitionUnitTest {
@@ -54,4 +56,85 @@ namespace BrillouinAcquisitionUnitTest {
 				Assert::IsTrue(sum < 1e-5*dim_x*dim_y);
 			}
 	};
+
+	/*
+	 * Smooth phase with a peak of about 3 wraps on a tilt, optionally with noise
+	 */
+	static std::vector<float> createWrappedPhase(int dim_x, int dim_y, float noise) {
+		auto generator = std::mt19937{ 1 };
+		auto distribution = std::normal_distribution<float>{ 0, noise };
+		auto wrapped = std::vector<float>((size_t)dim_x * dim_y);
+		for (gsl::index y{ 0 }; y < dim_y; y++) {
+			for (gsl::index x{ 0 }; x < dim_x; x++) {
+				auto r2 = pow(x - dim_x / 2.0, 2) + pow(y - dim_y / 3.0, 2);
+				auto value = 20 * exp(-r2 / (0.05 * dim_x * dim_y)) + x / 30.0 + distribution(generator);
+				wrapped[x + (size_t)dim_x * y] = (float)atan2(sin(value), cos(value));
+			}
+		}
+		return wrapped;
+	}
+
+	TEST_CLASS(TestUnwrapMethods) {
+		public:
+			TEST_METHOD(TestBucketsortMatchesQuicksort) {
+				int dim_x{ 300 };
+				int dim_y{ 200 };
+				for (auto noise : { 0.0f, 0.3f }) {
+					auto wrapped = createWrappedPhase(dim_x, dim_y, noise);
+					auto reference = std::vector<float>(wrapped.size());
+					auto output = std::vector<float>(wrapped.size());
+					unwrap2Wrapper{ UNWRAP_METHOD::QUICKSORT }.unwrap2DWrapped(&wrapped[0], &reference[0], dim_x, dim_y, false, false);
+					unwrap2Wrapper{ UNWRAP_METHOD::BUCKETSORT }.unwrap2DWrapped(&wrapped[0], &output[0], dim_x, dim_y, false, false);
+
+					// the results may differ by a constant multiple of 2 pi
+					auto offset = round((reference[0] - output[0]) / (2 * PI)) * 2 * PI;
+					for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
+						Assert::AreEqual(reference[i], output[i] + offset, 1e-3f);
+					}
+				}
+			}
+
+			TEST_METHOD(TestWrapAround) {
+				int dim_x{ 200 };
+				int dim_y{ 200 };
+				auto wrapped = std::vector<float>((size_t)dim_x * dim_y);
+				for (gsl::index y{ 0 }; y < dim_y; y++) {
+					for (gsl::index x{ 0 }; x < dim_x; x++) {
+						wrapped[x + (size_t)dim_x * y] = (float)remainder(3 * sin(2 * PI * x / dim_x) + 6 * cos(2 * PI * y / dim_y), 2 * PI);
+					}
+				}
+				auto reference = std::vector<float>(wrapped.size());
+				auto output = std::vector<float>(wrapped.size());
+				unwrap2Wrapper{ UNWRAP_METHOD::QUICKSORT }.unwrap2DWrapped(&wrapped[0], &reference[0], dim_x, dim_y, true, true);
+				unwrap2Wrapper{ UNWRAP_METHOD::BUCKETSORT }.unwrap2DWrapped(&wrapped[0], &output[0], dim_x, dim_y, true, true);
+
+				auto offset = round((reference[0] - output[0]) / (2 * PI)) * 2 * PI;
+				for (gsl::index i{ 0 }; i < dim_x * dim_y; i++) {
+					Assert::AreEqual(reference[i], output[i] + offset, 1e-3f);
+				}
+			}
+	};
+
+	TEST_CLASS(BenchmarkUnwrap) {
+		public:
+			TEST_METHOD(BenchmarkUnwrapMethods) {
+				for (auto size : { 300, 1000 }) {
+					auto wrapped = createWrappedPhase(size, size, 0.3f);
+					auto output = std::vector<float>(wrapped.size());
+					auto times = std::vector<double>{};
+					for (auto method : { UNWRAP_METHOD::QUICKSORT, UNWRAP_METHOD::BUCKETSORT }) {
+						auto unwrapper = unwrap2Wrapper{ method };
+						auto timer = QElapsedTimer{};
+						timer.start();
+						unwrapper.unwrap2DWrapped(&wrapped[0], &output[0], size, size, false, false);
+						times.push_back(1e-6 * timer.nsecsElapsed());
+					}
+					auto message = QString("Unwrap %1x%1: quicksort %2 ms, bucket sort %3 ms\n")
+						.arg(size)
+						.arg(times[0], 0, 'f', 1)
+						.arg(times[1], 0, 'f', 1);
+					Logger::WriteMessage(message.toStdString().c_str());
+				}
+			}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "..\BrillouinAcquisition\src\Acquisition\AcquisitionModes\VoltageCalibrationRunner.h"
+#include "..\BrillouinAcquisition\src\Devices\Cameras\MockCamera.h"
+#include "..\BrillouinAcquisition\src\Devices\ScanControls\MockScanControl.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BrillouinAcquisitionUnitTest {
+
+	/*
+	 * Mock camera which counts how often it is armed and
+	 * can only take a limited number of images per acquisition
+	 */
+	class LimitedMockCamera : public MockCamera {
+
+	public:
+		int getMaximumAcquisitionImages() override {
+			return m_maximumImages;
+		}
+
+		void startAcquisition(const CAMERA_SETTINGS& settings) override {
+			MockCamera::startAcquisition(settings);
+			m_starts++;
+			m_images = 0;
+		}
+
+		void restartAcquisition(const CAMERA_SETTINGS& settings) override {
+			MockCamera::restartAcquisition(settings);
+			m_restarts++;
+		}
+
+		void getImageForAcquisition(std::byte* buffer, bool preview = true) override {
+			Assert::IsTrue(m_isAcquisitionRunning);
+			MockCamera::getImageForAcquisition(buffer, preview);
+			m_images++;
+			if (m_maximumImages > 0) {
+				Assert::IsTrue(m_images <= m_maximumImages);
+			}
+		}
+
+		int m_maximumImages{ 0 };
+		int m_starts{ 0 };
+		int m_restarts{ 0 };
+		int m_images{ 0 };
+	};
+
+	/*
+	 * Mock scan control which records the voltages it is given
+	 */
+	class RecordingMockScanControl : public MockScanControl {
+
+	public:
+		void setVoltage(VOLTAGE2 voltages) override {
+			MockScanControl::setVoltage(voltages);
+			m_setVoltages.push_back(voltages);
+		}
+
+		void setAcquisitionVoltages(ACQ_VOLTAGES voltages) override {
+			MockScanControl::setAcquisitionVoltages(voltages);
+			m_waveforms.push_back(voltages);
+		}
+
+		std::vector<VOLTAGE2> m_setVoltages;
+		std::vector<ACQ_VOLTAGES> m_waveforms;
+	};
+
+	static CAMERA_SETTINGS configureCalibrationCamera(MockCamera* camera) {
+		camera->connectDevice();
+
+		auto settings = CAMERA_SETTINGS{ 0, 0 };
+		settings.roi.width_physical = 64;
+		settings.roi.height_physical = 48;
+		settings.frameCount = 1;
+		settings.readout.pixelEncoding = L"16 bit";
+		camera->setSettings(settings);
+		camera->setMaxRate(true);
+		return camera->getSettings();
+	}
+
+	static std::vector<VOLTAGE2> createCalibrationVoltages(int count) {
+		auto voltages = std::vector<VOLTAGE2>{};
+		for (gsl::index i{ 0 }; i < count; i++) {
+			voltages.push_back({ 0.001 * i, -0.001 * i });
+		}
+		return voltages;
+	}
+
+	TEST_CLASS(TestVoltageCalibrationRunner) {
+		public:
+			TEST_METHOD(TestChunkWaveforms) {
+				auto voltages = createCalibrationVoltages(250);
+				auto chunks = VoltageCalibrationRunner::createChunks(voltages, 100);
+				auto samples = VoltageCalibrationRunner::samplesPerVoltage;
+
+				Assert::AreEqual((size_t)3, chunks.size());
+				Assert::AreEqual((gsl::index)200, chunks[2].begin);
+				Assert::AreEqual((gsl::index)250, chunks[2].end);
+				Assert::AreEqual(50 * samples, chunks[2].voltages.numberSamples);
+				for (const auto& chunk : chunks) {
+					auto count = chunk.end - chunk.begin;
+					auto triggers = std::count(chunk.voltages.trigger.begin(), chunk.voltages.trigger.end(), 1);
+					Assert::AreEqual(2 * count, (gsl::index)triggers);
+					for (gsl::index i{ 0 }; i < count; i++) {
+						// the mirror is at the voltage of the image when the camera is triggered
+						Assert::AreEqual(1, (int)chunk.voltages.trigger[i * samples + 2]);
+						Assert::AreEqual(voltages[chunk.begin + i].Ux, chunk.voltages.mirror[i * samples + 2]);
+						Assert::AreEqual(voltages[chunk.begin + i].Uy, chunk.voltages.mirror[(count + i) * samples + 2]);
+					}
+				}
+			}
+
+			TEST_METHOD(TestCameraStaysArmed) {
+				auto camera = new LimitedMockCamera();
+				auto settings = configureCalibrationCamera(camera);
+				auto scanControl = RecordingMockScanControl{};
+				scanControl.connectDevice();
+
+				auto runner = VoltageCalibrationRunner{ camera, &scanControl };
+				runner.setSettleTime(0);
+				auto voltages = createCalibrationVoltages(250);
+				auto indices = std::vector<gsl::index>{};
+				auto abort{ false };
+				auto completed = runner.run(settings, voltages, [&indices, &settings](gsl::index index, std::vector<std::byte> image) {
+					Assert::AreEqual((size_t)settings.roi.bytesPerFrame, image.size());
+					indices.push_back(index);
+				}, abort);
+
+				Assert::IsTrue(completed);
+				Assert::AreEqual(1, camera->m_starts);
+				Assert::IsFalse(camera->m_isAcquisitionRunning);
+				Assert::AreEqual((size_t)250, indices.size());
+				for (gsl::index i{ 0 }; i < 250; i++) {
+					Assert::AreEqual(i, indices[i]);
+				}
+				// the mirror is only moved to the first voltage, the chunks follow each other directly
+				Assert::AreEqual((size_t)1, scanControl.m_setVoltages.size());
+				Assert::AreEqual(voltages[0].Ux, scanControl.m_setVoltages[0].Ux);
+				Assert::AreEqual((size_t)3, scanControl.m_waveforms.size());
+
+				delete camera;
+			}
+
+			TEST_METHOD(TestCameraRestartsAtLimit) {
+				auto camera = new LimitedMockCamera();
+				camera->m_maximumImages = 60;
+				auto settings = configureCalibrationCamera(camera);
+				auto scanControl = RecordingMockScanControl{};
+				scanControl.connectDevice();
+
+				auto runner = VoltageCalibrationRunner{ camera, &scanControl };
+				runner.setSettleTime(0);
+				auto count{ 0 };
+				auto abort{ false };
+				auto completed = runner.run(settings, createCalibrationVoltages(250),
+					[&count](gsl::index, std::vector<std::byte>) { count++; }, abort);
+
+				Assert::IsTrue(completed);
+				Assert::AreEqual(250, count);
+				// the chunks shrink to the number of images the camera can take
+				Assert::AreEqual((size_t)5, scanControl.m_waveforms.size());
+				Assert::AreEqual(5, camera->m_starts);
+				Assert::AreEqual(4, camera->m_restarts);
+				Assert::IsFalse(camera->m_isAcquisitionRunning);
+
+				delete camera;
+			}
+
+			TEST_METHOD(TestAbortStopsCamera) {
+				auto camera = new LimitedMockCamera();
+				auto settings = configureCalibrationCamera(camera);
+				auto scanControl = RecordingMockScanControl{};
+				scanControl.connectDevice();
+
+				auto runner = VoltageCalibrationRunner{ camera, &scanControl };
+				runner.setSettleTime(0);
+				auto count{ 0 };
+				auto abort{ false };
+				auto completed = runner.run(settings, createCalibrationVoltages(250), [&count, &abort](gsl::index, std::vector<std::byte>) {
+					abort = ++count == 10;
+				}, abort);
+
+				Assert::IsFalse(completed);
+				Assert::AreEqual(10, count);
+				Assert::IsFalse(camera->m_isAcquisitionRunning);
+
+				delete camera;
+			}
+	};
+
+	TEST_CLASS(BenchmarkVoltageCalibrationRunner) {
+		public:
+			/*
+			 * Compare the time around the images of a calibration with the camera and the mirror
+			 * restarted for every chunk, as it was done before, with the pipelined runner.
+			 */
+			TEST_METHOD(BenchmarkDeadTime) {
+				auto camera = new LimitedMockCamera();
+				auto settings = configureCalibrationCamera(camera);
+				auto scanControl = MockScanControl{};
+				scanControl.connectDevice();
+				auto voltages = createCalibrationVoltages(400);
+				auto settleTime{ 100 };
+				auto chunkSize{ 100 };
+				auto abort{ false };
+
+				auto timer = QElapsedTimer{};
+				timer.start();
+				for (gsl::index begin{ 0 }; begin < (gsl::index)voltages.size(); begin += chunkSize) {
+					auto end = std::min(begin + chunkSize, (gsl::index)voltages.size());
+					camera->startAcquisition(settings);
+					scanControl.setVoltage(voltages[begin]);
+					std::this_thread::sleep_for(std::chrono::milliseconds(settleTime));
+					scanControl.setAcquisitionVoltages(VoltageCalibrationRunner::createAcquisitionVoltages(voltages, begin, end));
+					for (gsl::index i{ begin }; i < end; i++) {
+						auto image = std::vector<std::byte>(settings.roi.bytesPerFrame);
+						camera->getImageForAcquisition(&image[0], false);
+					}
+					camera->stopAcquisition();
+				}
+				auto sequentialTime = 1e-6 * timer.nsecsElapsed();
+
+				auto runner = VoltageCalibrationRunner{ camera, &scanControl };
+				runner.setChunkSize(chunkSize);
+				runner.setSettleTime(settleTime);
+				timer.start();
+				runner.run(settings, voltages, [](gsl::index, std::vector<std::byte>) {}, abort);
+				auto pipelinedTime = 1e-6 * timer.nsecsElapsed();
+
+				auto message = QString("Calibration of %1 voltages: restarted chunks %2 ms, pipelined chunks %3 ms\n")
+					.arg(voltages.size())
+					.arg(sequentialTime, 0, 'f', 1)
+					.arg(pipelinedTime, 0, 'f', 1);
+				Logger::WriteMessage(message.toStdString().c_str());
+
+				Assert::IsTrue(pipelinedTime < sequentialTime);
+
+				delete camera;
+			}
+	};
+}
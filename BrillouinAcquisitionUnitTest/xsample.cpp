@@ -3,10 +3,92 @@
 #include "..\BrillouinAcquisition\src\xsample.h"
 #include "..\BrillouinAcquisition\src\simplemath.h"
 
+#include <array>
+#include <random>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace BrillouinAcquisitionUnitTest {
 
+	/*
+	 * The per-pixel implementations xsample used before the separable one,
+	 * the separable implementation is compared against them.
+	 */
+	template <typename T_in, typename T_out>
+	void referenceNearest(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new) {
+		for (gsl::index y{ 0 }; y < dim_y_new; y++) {
+			for (gsl::index x{ 0 }; x < dim_x_new; x++) {
+				double x_old = round(((double)x + 0.5) * dim_x / dim_x_new - 0.5);
+				double y_old = round(((double)y + 0.5) * dim_y / dim_y_new - 0.5);
+
+				out[x + dim_x_new * y] = in[(int)x_old + dim_x * (int)y_old];
+			}
+		}
+	}
+
+	template <typename T_in, typename T_out>
+	void referenceLinear(T_in in, T_out out, int dim_x, int dim_y, int dim_x_new, int dim_y_new) {
+		double scaling_x = (double)dim_x / dim_x_new;
+		double scaling_y = (double)dim_y / dim_y_new;
+		double pixelArea = scaling_x * scaling_y;
+		for (gsl::index y{ 0 }; y < dim_y_new; y++) {
+			double yt = y * scaling_y;
+			int ytInt = (int)floor(yt);
+			double yb = ((double)y + 1) * scaling_y;
+			int ybInt = (int)ceil(yb);
+			for (gsl::index x{ 0 }; x < dim_x_new; x++) {
+				double xl = x * scaling_x;
+				int xlInt = (int)floor(xl);
+				double xr = ((double)x + 1) * scaling_x;
+				int xrInt = (int)ceil(xr);
+				double pixValue{ 0 };
+				for (gsl::index xd{ xlInt }; xd < xrInt; xd++) {
+					auto dx1 = (xd > xl) ? xd : xl;
+					auto dx2 = ((double)xd + 1 < xr) ? ((double)xd + 1) : xr;
+					double weight_x = dx2 - dx1;
+					for (gsl::index yd{ ytInt }; yd < ybInt; yd++) {
+						auto dy1 = (yd > yt) ? yd : yt;
+						auto dy2 = ((double)yd + 1 < yb) ? ((double)yd + 1) : yb;
+						double weight_y = dy2 - dy1;
+
+						pixValue += in[xd + dim_x * yd] * weight_x * weight_y;
+					}
+				}
+				out[x + dim_x_new * y] = pixValue / pixelArea;
+			}
+		}
+	}
+
+	template <typename T>
+	std::vector<T> createNoise(int dim_x, int dim_y) {
+		auto generator = std::mt19937{ 42 };
+		auto distribution = std::uniform_int_distribution<int>{ 0, 4095 };
+		auto image = std::vector<T>((size_t)dim_x * dim_y);
+		for (auto& value : image) {
+			value = (T)distribution(generator);
+		}
+		return image;
+	}
+
+	template <typename T, typename T_out = float>
+	double maxDifferenceToReference(int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode) {
+		auto input = createNoise<T>(dim_x, dim_y);
+		auto expected = std::vector<T_out>((size_t)dim_x_new * dim_y_new);
+		auto output = std::vector<T_out>((size_t)dim_x_new * dim_y_new);
+		if (mode == RESAMPLE_MODE::LINEAR) {
+			referenceLinear(&input[0], &expected[0], dim_x, dim_y, dim_x_new, dim_y_new);
+		} else {
+			referenceNearest(&input[0], &expected[0], dim_x, dim_y, dim_x_new, dim_y_new);
+		}
+		xsample::resample(&input[0], &output[0], dim_x, dim_y, dim_x_new, dim_y_new, mode);
+
+		double difference{ 0 };
+		for (gsl::index i{ 0 }; i < (gsl::index)output.size(); i++) {
+			difference = std::max(difference, (double)abs(output[i] - expected[i]));
+		}
+		return difference;
+	}
+
 	TEST_CLASS(TestDownSample) {
 		public:
 			// Test linear resampling
@@ -379,4 +461,96 @@ namespace BrillouinAcquisitionUnitTest {
 				Assert::IsTrue(sum < 1e-5);
 			}
 	};
-}
\ No newline at end of file
+
+	TEST_CLASS(TestSeparableResampling) {
+		public:
+			TEST_METHOD(TestMatchesReference) {
+				// integer factors, arbitrary factors and different factors per axis
+				auto sizes = std::vector<std::array<int, 4>>{
+					{ 640, 512, 320, 256 },
+					{ 300, 240, 100, 80 },
+					{ 1024, 1024, 341, 341 },
+					{ 341, 341, 1024, 1024 },
+					{ 100, 80, 300, 240 },
+					{ 17, 13, 5, 7 },
+					{ 5, 7, 17, 13 },
+					{ 64, 48, 32, 97 },
+					{ 106, 80, 320, 240 }
+				};
+				for (const auto& size : sizes) {
+					for (auto mode : { RESAMPLE_MODE::LINEAR, RESAMPLE_MODE::NEAREST }) {
+						// the 4096 grey values are summed up in float for float and uint16 images, double images are resampled to double
+						Assert::AreEqual(0.0, maxDifferenceToReference<float>(size[0], size[1], size[2], size[3], mode), 4096 * 1e-6);
+						Assert::AreEqual(0.0, maxDifferenceToReference<unsigned short>(size[0], size[1], size[2], size[3], mode), 4096 * 1e-6);
+						Assert::AreEqual(0.0, maxDifferenceToReference<double, double>(size[0], size[1], size[2], size[3], mode), 1e-9);
+					}
+				}
+			}
+
+			TEST_METHOD(TestThreadsGiveSameResult) {
+				auto input = createNoise<float>(1024, 1024);
+				auto threadPool = ThreadPool{ 4 };
+				for (auto mode : { RESAMPLE_MODE::LINEAR, RESAMPLE_MODE::NEAREST }) {
+					auto expected = std::vector<float>(341 * 341);
+					auto output = std::vector<float>(341 * 341);
+					xsample::resample(&input[0], &expected[0], 1024, 1024, 341, 341, mode);
+					xsample::resample(&input[0], &output[0], 1024, 1024, 341, 341, mode, threadPool);
+					Assert::IsTrue(expected == output);
+				}
+			}
+	};
+
+	TEST_CLASS(BenchmarkResampling) {
+		public:
+			/*
+			 * Compare the separable implementation with the per-pixel one it replaced,
+			 * for the sizes the phase preview resamples.
+			 */
+			TEST_METHOD(BenchmarkSeparableAgainstReference) {
+				benchmark<float>(1024, 1024, 341, 341, RESAMPLE_MODE::NEAREST);
+				benchmark<float>(341, 341, 1024, 1024, RESAMPLE_MODE::LINEAR);
+				benchmark<float>(1024, 1024, 512, 512, RESAMPLE_MODE::LINEAR);
+				benchmark<float>(1023, 1023, 341, 341, RESAMPLE_MODE::LINEAR);
+				benchmark<float>(1000, 1000, 341, 341, RESAMPLE_MODE::LINEAR);
+				benchmark<unsigned short>(1024, 1024, 512, 512, RESAMPLE_MODE::LINEAR);
+				benchmark<unsigned short>(1000, 1000, 341, 341, RESAMPLE_MODE::LINEAR);
+				benchmark<unsigned short>(1024, 1024, 341, 341, RESAMPLE_MODE::NEAREST);
+			}
+
+		private:
+			template <typename T>
+			void benchmark(int dim_x, int dim_y, int dim_x_new, int dim_y_new, RESAMPLE_MODE mode) {
+				auto input = createNoise<T>(dim_x, dim_y);
+				auto output = std::vector<float>((size_t)dim_x_new * dim_y_new);
+				auto repetitions{ 20 };
+
+				auto timer = QElapsedTimer{};
+				timer.start();
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					if (mode == RESAMPLE_MODE::LINEAR) {
+						referenceLinear(&input[0], &output[0], dim_x, dim_y, dim_x_new, dim_y_new);
+					} else {
+						referenceNearest(&input[0], &output[0], dim_x, dim_y, dim_x_new, dim_y_new);
+					}
+				}
+				auto referenceTime = 1e-6 * timer.nsecsElapsed() / repetitions;
+
+				timer.start();
+				for (gsl::index i{ 0 }; i < repetitions; i++) {
+					xsample::resample(&input[0], &output[0], dim_x, dim_y, dim_x_new, dim_y_new, mode);
+				}
+				auto separableTime = 1e-6 * timer.nsecsElapsed() / repetitions;
+
+				auto message = QString("Resample %1 %2x%3 to %4x%5, %6 bytes per pixel: per-pixel %7 ms, separable %8 ms\n")
+					.arg(mode == RESAMPLE_MODE::LINEAR ? "linear" : "nearest")
+					.arg(dim_x)
+					.arg(dim_y)
+					.arg(dim_x_new)
+					.arg(dim_y_new)
+					.arg(sizeof(T))
+					.arg(referenceTime, 0, 'f', 2)
+					.arg(separableTime, 0, 'f', 2);
+				Logger::WriteMessage(message.toStdString().c_str());
+			}
+	};
+}